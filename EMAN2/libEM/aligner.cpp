@@ -29,6 +29,14 @@
  *
  * */
 #include <random>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #include "emfft.h"
 #include "cmp.h"
@@ -54,6 +62,246 @@
 
 using namespace EMAN;
 
+namespace {
+	/** Calls fn(item,thread) for every item in [0,n) using up to nthreads threads. Items are handed out
+	 * dynamically, so callers must store results by item index to stay deterministic. Item 0 always runs
+	 * on the calling thread before any other thread starts, so the lazily built factories and lookup
+	 * tables used by the processors and comparators are complete before they can be contended.
+	 * The first exception thrown by any item is rethrown after all threads have finished.
+	 */
+	void parallel_items(const int n, int nthreads, const std::function<void(int,int)>& fn)
+	{
+		if (n<=0) return;
+		fn(0,0);
+
+		if (nthreads>n-1) nthreads=n-1;
+		if (nthreads<=1) {
+			for (int i=1; i<n; i++) fn(i,0);
+			return;
+		}
+
+		std::atomic<int> next(1);
+		std::exception_ptr err;
+		std::mutex errmutex;
+		auto worker=[&](int thr) {
+			try {
+				for (int i=next++; i<n; i=next++) fn(i,thr);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(errmutex);
+				if (!err) err=std::current_exception();
+				next=n;
+			}
+		};
+
+		vector<std::thread> threads;
+		for (int thr=1; thr<nthreads; thr++) threads.push_back(std::thread(worker,thr));
+		worker(0);
+		for (size_t i=0; i<threads.size(); i++) threads[i].join();
+		if (err) std::rethrow_exception(err);
+	}
+
+	/** All the images of an xform_align_nbest_batch() call must have the size of to_img, since the volumes
+	 * derived from to_img are prepared for the first image and then reused
+	 */
+	void check_batch_sizes(const vector<EMData*>& this_imgs, EMData *to, const string& name)
+	{
+		for (size_t i=0; i<this_imgs.size(); i++) {
+			if (this_imgs[i]->get_xsize()!=to->get_xsize() || this_imgs[i]->get_ysize()!=to->get_ysize()
+				|| this_imgs[i]->get_zsize()!=to->get_zsize()) throw ImageDimensionException("ERROR ("+name+"): all images in a batch must have the same size as to_img");
+		}
+	}
+
+	/** The references of an align_batch() call, one set per thread, plus anything an aligner derives from
+	 * each of them (T). Images are not safe to share between threads, even when only read, since the
+	 * statistics, the cached rotational footprint and the array offsets used by fourierproduct() are updated
+	 * lazily. Thread 0 uses the original references, the copies are made up front on the calling thread.
+	 */
+	template<class T> class ThreadReferences
+	{
+	  public:
+		ThreadReferences(const vector<EMData*>& refs, int nthreads) :
+			imgs(nthreads,refs), prep(nthreads,vector<T*>(refs.size(),(T*)0))
+		{
+			for (int thr=1; thr<nthreads; thr++) {
+				for (size_t j=0; j<refs.size(); j++) imgs[thr][j]=refs[j]->copy();
+			}
+		}
+
+		~ThreadReferences()
+		{
+			for (size_t thr=0; thr<imgs.size(); thr++) {
+				for (size_t j=0; j<imgs[thr].size(); j++) {
+					if (thr>0) delete imgs[thr][j];
+					delete prep[thr][j];
+				}
+			}
+		}
+
+		EMData *get(int thr, size_t j) { return imgs[thr][j]; }
+
+		/** Whatever the aligner prepares for reference j, initially 0. Deleted with the references */
+		T *&prepared(int thr, size_t j) { return prep[thr][j]; }
+
+	  private:
+		vector< vector<EMData*> > imgs;
+		vector< vector<T*> > prep;
+	};
+
+	/** Number of threads parallel_items() will actually use for n items */
+	int batch_threads(int nthreads, size_t n)
+	{
+		if (nthreads>(int)n-1) nthreads=(int)n-1;
+		return nthreads<1 ? 1 : nthreads;
+	}
+
+	Dict batch_result(EMData *ali, float score)
+	{
+		Transform *t=ali->get_attr("xform.align2d");
+		Dict ret("xform.align2d",t,"score",score);
+		delete t;
+		return ret;
+	}
+}
+
+namespace EMAN {
+	/** Volumes derived from the 'to' volume of the 3D tree aligners, shared between the images of one
+	 * xform_align_nbest_batch() call. For each level it keeps the cropped and filtered volume, and it keeps
+	 * that volume rotated to each orientation of the global search grid. slot distinguishes several
+	 * volumes at one level (eg - RT3DLocalTreeAligner also rotates the squared volume).
+	 * Rotated volumes are limited to maxbytes and the least recently used ones are evicted first. Volumes
+	 * used by the current image are never evicted, since the grid is scanned in the same order for every
+	 * image and would otherwise evict each entry just before it is needed again. Thread safe.
+	 */
+	class RT3DReferenceCache
+	{
+	  public:
+		RT3DReferenceCache(size_t maxbytes) : maxbytes(maxbytes), nbytes(0), item(0)
+		{
+		}
+
+		~RT3DReferenceCache()
+		{
+			for (std::map< std::pair<int,int>,EMData* >::iterator it=levels.begin(); it!=levels.end(); ++it) delete it->second;
+			for (std::list<Entry>::iterator it=rotated.begin(); it!=rotated.end(); ++it) delete it->img;
+		}
+
+		/** Call before aligning each image */
+		void next_item()
+		{
+			std::lock_guard<std::mutex> lock(rotmutex);
+			item++;
+		}
+
+		/** Volume for level ss, made by make() the first time. The cache keeps ownership */
+		EMData *get_level(int ss, int slot, const std::function<EMData*()>& make)
+		{
+			std::lock_guard<std::recursive_mutex> lock(levelmutex);	// make() may request another level
+			EMData *&img=levels[std::make_pair(ss,slot)];
+			if (!img) img=make();
+			return img;
+		}
+
+		/** Returns src rotated by the pure rotation t, as the "xform" processor with zerocorners=1 would.
+		 * The caller owns the returned image
+		 */
+		EMData *get_rotated(EMData *src, int ss, int slot, const Transform& t)
+		{
+			Key key;
+			key.ss=ss;
+			key.slot=slot;
+			vector<float> m=t.get_matrix();
+			for (int i=0; i<12; i++) key.m[i]=m[i];
+
+			{
+				std::lock_guard<std::mutex> lock(rotmutex);
+				std::unordered_map<Key,std::list<Entry>::iterator,KeyHash>::iterator hit=index.find(key);
+				if (hit!=index.end()) {
+					rotated.splice(rotated.begin(),rotated,hit->second);
+					hit->second->item=item;
+					return hit->second->img->copy();
+				}
+			}
+
+			// rotate outside the lock, if two threads miss on the same key the second result is just not stored
+			Transform tt(t);
+			EMData *ret=src->process("xform",Dict("transform",EMObject(&tt),"zerocorners",1));
+			size_t bytes=(size_t)ret->get_xsize()*ret->get_ysize()*ret->get_zsize()*sizeof(float);
+
+			std::lock_guard<std::mutex> lock(rotmutex);
+			if (index.count(key)) return ret;
+			while (nbytes+bytes>maxbytes && !rotated.empty() && rotated.back().item!=item) {
+				nbytes-=rotated.back().bytes;
+				index.erase(rotated.back().key);
+				delete rotated.back().img;
+				rotated.pop_back();
+			}
+			if (nbytes+bytes>maxbytes) return ret;
+
+			Entry ent;
+			ent.key=key;
+			ent.img=ret->copy();
+			ent.bytes=bytes;
+			ent.item=item;
+			rotated.push_front(ent);
+			index[key]=rotated.begin();
+			nbytes+=bytes;
+			return ret;
+		}
+
+	  private:
+		struct Key {
+			int ss,slot;
+			float m[12];
+			bool operator==(const Key& k) const {
+				return ss==k.ss && slot==k.slot && memcmp(m,k.m,sizeof(m))==0;
+			}
+		};
+		struct KeyHash {
+			size_t operator()(const Key& k) const {
+				size_t h=std::hash<int>()(k.ss*31+k.slot);
+				for (int i=0; i<12; i++) h=h*1000003u ^ std::hash<float>()(k.m[i]);
+				return h;
+			}
+		};
+		struct Entry {
+			Key key;
+			EMData *img;
+			size_t bytes;
+			long item;
+		};
+
+		size_t maxbytes;
+		size_t nbytes;
+		long item;
+		std::list<Entry> rotated;		// most recently used first
+		std::unordered_map<Key,std::list<Entry>::iterator,KeyHash> index;
+		std::map< std::pair<int,int>,EMData* > levels;
+		std::mutex rotmutex;
+		std::recursive_mutex levelmutex;
+	};
+
+	/** The 'to' side of RT2DTreeAligner::xform_align_nbest(), kept between calls by align_batch().
+	 * levels is keyed by box size and lowpass cutoff
+	 */
+	class RT2DTreeReference
+	{
+	  public:
+		RT2DTreeReference() : base(0)
+		{
+		}
+
+		~RT2DTreeReference()
+		{
+			for (std::map< std::pair<int,float>,EMData* >::iterator it=levels.begin(); it!=levels.end(); ++it) delete it->second;
+			delete base;
+		}
+
+		EMData *base;
+		std::map< std::pair<int,float>,EMData* > levels;
+	};
+}
+
 const string TranslationalAligner::NAME = "translational";
 const string RotationalAligner::NAME = "rotational";
 const string RotationalAlignerBispec::NAME = "rotational_bispec";
@@ -138,6 +386,26 @@ vector<Dict> Aligner::xform_align_nbest(EMData *, EMData *, const unsigned int,
 	return solns;
 }
 
+vector< vector<Dict> > Aligner::xform_align_nbest_batch(const vector<EMData*> & this_imgs, EMData * to_img, const unsigned int nsoln, const string & cmp_name, const Dict& cmp_params) const
+{
+	vector< vector<Dict> > solns;
+	for (size_t i=0; i<this_imgs.size(); i++) solns.push_back(xform_align_nbest(this_imgs[i],to_img,nsoln,cmp_name,cmp_params));
+	return solns;
+}
+
+vector< vector<Dict> > Aligner::align_batch(const vector<EMData*> & this_imgs, const vector<EMData*> & to_imgs, const string & cmp_name, const Dict& cmp_params) const
+{
+	vector< vector<Dict> > ret(this_imgs.size());
+	for (size_t i=0; i<this_imgs.size(); i++) {
+		for (size_t j=0; j<to_imgs.size(); j++) {
+			EMData *ali=align(this_imgs[i],to_imgs[j],cmp_name,cmp_params);
+			ret[i].push_back(batch_result(ali,ali->cmp(cmp_name,to_imgs[j],cmp_params)));
+			delete ali;
+		}
+	}
+	return ret;
+}
+
 EMData* ScaleAlignerABS::align_using_base(EMData * this_img, EMData * to,
 			const string & cmp_name, const Dict& cmp_params) const
 {
@@ -766,6 +1034,34 @@ EMData *RotateTranslateAlignerPawel::align(EMData * this_img, EMData *to,
 EMData *RotateTranslateAligner::align(EMData * this_img, EMData *to,
 			const string & cmp_name, const Dict& cmp_params) const
 {
+	float score;
+	return align_scored(this_img,to,cmp_name,cmp_params,score);
+}
+
+// Each particle is aligned to all of the references by a single thread, so the rotational footprint cached in
+// the particle is made once and only ever touched by that thread. Each thread has its own copy of the references,
+// which cache their own footprints the first time they are used. Missing params are added by particle 0, which
+// parallel_items() runs before starting any other thread
+vector< vector<Dict> > RotateTranslateAligner::align_batch(const vector<EMData*> & this_imgs, const vector<EMData*> & to_imgs, const string & cmp_name, const Dict& cmp_params) const
+{
+	int nthreads=batch_threads(params.set_default("threads",1),this_imgs.size());
+
+	vector< vector<Dict> > ret(this_imgs.size(),vector<Dict>(to_imgs.size()));
+	ThreadReferences<EMData> refs(to_imgs,nthreads);
+	parallel_items((int)this_imgs.size(),nthreads,[&](int i,int thr) {
+		for (size_t j=0; j<to_imgs.size(); j++) {
+			float score;
+			EMData *ali=align_scored(this_imgs[i],refs.get(thr,j),cmp_name,cmp_params,score);
+			ret[i][j]=batch_result(ali,score);
+			delete ali;
+		}
+	});
+	return ret;
+}
+
+EMData *RotateTranslateAligner::align_scored(EMData * this_img, EMData *to,
+			const string & cmp_name, const Dict& cmp_params, float &score) const
+{
 
 #ifdef EMAN2_USING_CUDA
 	if(EMData::usecuda == 1) {
@@ -816,6 +1112,7 @@ EMData *RotateTranslateAligner::align(EMData * this_img, EMData *to,
 			rot_180_trans = 0;
 		}
 		result = rot_trans;
+		score = cmp1;
 	}
 	else {
 		if( rot_trans )	{
@@ -823,6 +1120,7 @@ EMData *RotateTranslateAligner::align(EMData * this_img, EMData *to,
 			rot_trans = 0;
 		}
 		result = rot_180_trans;
+		score = cmp2;
 		rotate_angle_solution -= 180.f;
 	}
 
@@ -891,6 +1189,45 @@ EMData* RotateTranslateFlipAligner::align(EMData * this_img, EMData *to, const s
 		delete_flag = true;
 	}
 
+	float score;
+	EMData *result = align_scored(this_img,to,flipped,cmp_name,cmp_params,score);
+
+	if (delete_flag){
+		if(flipped) {
+			delete flipped;
+			flipped = 0;
+		}
+	}
+
+	return result;
+}
+
+// As RotateTranslateAligner::align_batch(), the flipped copy of each reference is also made once per thread
+vector< vector<Dict> > RotateTranslateFlipAligner::align_batch(const vector<EMData*> & this_imgs, const vector<EMData*> & to_imgs, const string & cmp_name, const Dict& cmp_params) const
+{
+	int nthreads=batch_threads(params.set_default("threads",1),this_imgs.size());
+	EMData *flip = params.set_default("flip", (EMData *) 0);
+	if (flip != 0) throw InvalidParameterException("ERROR (RotateTranslateFlipAligner): align_batch does not accept a 'flip' image, it flips each reference itself");
+
+	vector< vector<Dict> > ret(this_imgs.size(),vector<Dict>(to_imgs.size()));
+	ThreadReferences<EMData> refs(to_imgs,nthreads);
+	parallel_items((int)this_imgs.size(),nthreads,[&](int i,int thr) {
+		for (size_t j=0; j<to_imgs.size(); j++) {
+			EMData *to=refs.get(thr,j);
+			EMData *&flipped=refs.prepared(thr,j);
+			if (!flipped) flipped=to->process("xform.flip", Dict("axis", "x"));
+
+			float score;
+			EMData *ali=align_scored(this_imgs[i],to,flipped,cmp_name,cmp_params,score);
+			ret[i][j]=batch_result(ali,score);
+			delete ali;
+		}
+	});
+	return ret;
+}
+
+EMData* RotateTranslateFlipAligner::align_scored(EMData * this_img, EMData *to, EMData *flipped, const string & cmp_name, const Dict& cmp_params, float &score) const
+{
 	EMData *rot_trans_align_flip=0;
 	EMData *rot_trans_align=0;
 	int usebispec=params.set_default("usebispec",0);
@@ -926,13 +1263,6 @@ EMData* RotateTranslateFlipAligner::align(EMData * this_img, EMData *to, const s
 	float cmp1 = rot_trans_align->cmp(cmp_name, to, cmp_params);
 	float cmp2 = rot_trans_align_flip->cmp(cmp_name, flipped, cmp_params);
 
-	if (delete_flag){
-		if(flipped) {
-			delete flipped;
-			flipped = 0;
-		}
-	}
-
 	EMData *result = 0;
 	if (cmp1 < cmp2 )  {
 
@@ -941,6 +1271,7 @@ EMData* RotateTranslateFlipAligner::align(EMData * this_img, EMData *to, const s
 			rot_trans_align_flip = 0;
 		}
 		result = rot_trans_align;
+		score = cmp1;
 	}
 	else {
 		if( rot_trans_align ) {
@@ -949,6 +1280,7 @@ EMData* RotateTranslateFlipAligner::align(EMData * this_img, EMData *to, const s
 		}
 		result = rot_trans_align_flip;
 		result->process_inplace("xform.flip",Dict("axis","x"));
+		score = cmp2;
 	}
 
 	return result;
@@ -1646,7 +1978,7 @@ EMData* SymAlignProcessor::align(EMData * this_img, EMData *to, const string & c
 	vector<Transform> transforms = sym->gen_orientations((string)params.set_default("orientgen","eman"),d);
 
 	//Genrate symmetry related orritenations
-	vector<Transform> syms = Symmetry3D::get_symmetries((string)params["sym"]);
+	const vector<Transform>& syms = Symmetry3D::get_symmetry_ops((string)params["sym"]).syms;
 
 	float bestquality = 0.0f;
 	EMData* bestimage = 0;
@@ -2729,6 +3061,36 @@ EMData* RT2DTreeAligner::align(EMData * this_img, EMData *to, const string & cmp
 }
 
 vector<Dict> RT2DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to, const unsigned int nrsoln, const string & cmp_name, const Dict& cmp_params) const {
+	RT2DTreeReference prep;
+	return xform_align_nbest_prepared(this_img,to,nrsoln,prep);
+}
+
+// align() uses the best of 2 solutions, the batch does the same so the results match
+vector< vector<Dict> > RT2DTreeAligner::align_batch(const vector<EMData*> & this_imgs, const vector<EMData*> & to_imgs, const string & cmp_name, const Dict& cmp_params) const
+{
+	int nthreads=batch_threads(params.set_default("threads",1),this_imgs.size());
+	params.set_default("verbose",0);
+	params.set_default("maxshift",-1);
+	params.set_default("flip",1);
+	params.set_default("maxres",-1.0f);
+
+	vector< vector<Dict> > ret(this_imgs.size(),vector<Dict>(to_imgs.size()));
+	ThreadReferences<RT2DTreeReference> refs(to_imgs,nthreads);
+	parallel_items((int)this_imgs.size(),nthreads,[&](int i,int thr) {
+		for (size_t j=0; j<to_imgs.size(); j++) {
+			RT2DTreeReference *&prep=refs.prepared(thr,j);
+			if (!prep) prep=new RT2DTreeReference();
+
+			vector<Dict> alis=xform_align_nbest_prepared(this_imgs[i],refs.get(thr,j),2,*prep);
+			ret[i][j]["xform.align2d"]=alis[0]["xform.align2d"];
+			ret[i][j]["score"]=alis[0]["score"];
+		}
+	});
+	return ret;
+}
+
+// prep holds everything derived from 'to', so it can be reused for another this_img
+vector<Dict> RT2DTreeAligner::xform_align_nbest_prepared(EMData * this_img, EMData * to, const unsigned int nrsoln, RT2DTreeReference &prep) const {
 	if (nrsoln == 0) throw InvalidParameterException("ERROR (RT2DTreeAligner): nsoln must be >0"); // What was the user thinking?
 
 	int nsoln = nrsoln*2;
@@ -2737,18 +3099,21 @@ vector<Dict> RT2DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 	// !!!!!! IMPORTANT NOTE - we are inverting the order of 'this' and 'to' here to match convention in other aligners, to compensate
 	// the Transform is inverted before being returned
 	EMData *base_this;
-	EMData *base_to;
 	if (this_img->is_complex()) base_this=this_img->copy();
 	else {
 		base_this=this_img->do_fft();
 		base_this->process_inplace("xform.phaseorigin.tocorner");		// This was originally .tocorner, taken from RT3DTree, but I think that's probably wrong...
 	}
 
-	if (to->is_complex()) base_to=to->copy();
-	else {
-		base_to=to->do_fft();
-		base_to->process_inplace("xform.phaseorigin.tocorner");
+	if (!prep.base) {
+		if (to->is_complex()) prep.base=to->copy();
+		else {
+			prep.base=to->do_fft();
+			prep.base->process_inplace("xform.phaseorigin.tocorner");
+		}
+		prep.base->process_inplace("xform.fourierorigin.tocenter");
 	}
+	EMData *base_to=prep.base;
 
 	int verbose = params.set_default("verbose",0);
 	int maxshift = params.set_default("maxshift",-1);
@@ -2759,7 +3124,6 @@ vector<Dict> RT2DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 	if (base_this->get_xsize()!=base_this->get_ysize()+2 || base_to->get_xsize()!=base_to->get_ysize()+2 ) throw InvalidCallException("ERROR (RT2DTreeAligner): requires cubic images with even numbered box sizes");
 
 	base_this->process_inplace("xform.fourierorigin.tocenter");		// easier to chop out Fourier subvolumes
-	base_to->process_inplace("xform.fourierorigin.tocenter");
 
 	float apix=(float)this_img->get_attr("apix_x");
 	int ny=this_img->get_ysize();
@@ -2786,15 +3150,18 @@ vector<Dict> RT2DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 		//ss=good_size(ny/ds);
 		// Clearly these regions will be messed up on x=nyquist edge, but we are zeroing that pixel during rotation anyway
 		EMData *small_this=base_this->get_clip(Region(0,(ny-ss)/2,ss+2,ss));
-		EMData *small_to=  base_to->  get_clip(Region(0,(ny-ss)/2,ss+2,ss));
 		small_this->process_inplace("xform.fourierorigin.tocorner");					// after clipping back to canonical form
 		float cut2=0.33*ny;
 		if (maxs<cut2) cut2=maxs;
 		small_this->process_inplace("filter.highpass.gauss",Dict("cutoff_pixels",3));
 		small_this->process_inplace("filter.lowpass.gauss",Dict("cutoff_pixels",cut2));
-		small_to->process_inplace("xform.fourierorigin.tocorner");
-		small_to->process_inplace("filter.highpass.gauss",Dict("cutoff_pixels",3));
-		small_to->process_inplace("filter.lowpass.gauss",Dict("cutoff_pixels",cut2));
+		EMData *&small_to=prep.levels[std::make_pair(ss,cut2)];		// owned by prep
+		if (!small_to) {
+			small_to=base_to->get_clip(Region(0,(ny-ss)/2,ss+2,ss));
+			small_to->process_inplace("xform.fourierorigin.tocorner");
+			small_to->process_inplace("filter.highpass.gauss",Dict("cutoff_pixels",3));
+			small_to->process_inplace("filter.lowpass.gauss",Dict("cutoff_pixels",cut2));
+		}
 
 		// This is a solid estimate for very complete searching
 		float astep = 360.0/int(M_PI/atan(1.25/ss));		// Decent angular step in degrees
@@ -2940,12 +3307,10 @@ vector<Dict> RT2DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 
 
 		delete small_this;
-		delete small_to;
 		if (ss==ny) break;
 	}
 
 	delete base_this;
-	delete base_to;
 
 
 	// initialize results
@@ -3421,6 +3786,26 @@ EMData* RT3DTreeAligner::align(EMData * this_img, EMData *to, const string & cmp
 // to the symmetry axes (ie - the reference). this is confusing as it is inverted internally in the algorithm, so the passed in 
 // "this" becomes "to" in the code to conform to the way the other aligners work.
 vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to, const unsigned int nrsoln, const string & cmp_name, const Dict& cmp_params) const {
+	return xform_align_nbest_cached(this_img,to,nrsoln,0);
+}
+
+vector< vector<Dict> > RT3DTreeAligner::xform_align_nbest_batch(const vector<EMData*> & this_imgs, EMData * to, const unsigned int nrsoln, const string & cmp_name, const Dict& cmp_params) const {
+	int refcache=params.set_default("refcache",1024);
+	if (refcache<=0) return Aligner::xform_align_nbest_batch(this_imgs,to,nrsoln,cmp_name,cmp_params);
+	check_batch_sizes(this_imgs,to,"RT3DTreeAligner");
+
+	RT3DReferenceCache cache((size_t)refcache<<20);
+	vector< vector<Dict> > solns;
+	for (size_t i=0; i<this_imgs.size(); i++) {
+		cache.next_item();
+		solns.push_back(xform_align_nbest_cached(this_imgs[i],to,nrsoln,&cache));
+	}
+	return solns;
+}
+
+// refcache is only set by xform_align_nbest_batch(). Everything derived from 'to' (base_this/small_this and its
+// rotations over the stage 1 grid) then comes from the cache and belongs to it
+vector<Dict> RT3DTreeAligner::xform_align_nbest_cached(EMData * this_img, EMData * to, const unsigned int nrsoln, RT3DReferenceCache *refcache) const {
 	if (nrsoln == 0) throw InvalidParameterException("ERROR (RT3DTreeAligner): nsoln must be >0"); // What was the user thinking?
 
 	int nsoln = nrsoln*2;
@@ -3431,6 +3816,11 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 	int verbose = params.set_default("verbose",0);
 	float maxres = params.set_default("maxres",-1.0f);
 	EMData *mask = params.set_default("mask",(EMData *)0);
+	int nthreads = params.set_default("threads",1);
+	if (nthreads<1) nthreads=1;
+	// testort() reads these from worker threads, so make sure the defaults exist before any start
+	params.set_default("randphi",false);
+	params.set_default("rand180",false);
 	
 	// !!!!!! IMPORTANT NOTE - we are inverting the order of this and to here to match convention in other aligners, to compensate
 	// the Transform is inverted before being returned
@@ -3451,14 +3841,6 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 			base_to->process_inplace("xform.phaseorigin.tocorner");
 			delete tmp;
 		}
-
-		if (to->is_complex()) {
-			base_this=to->copy();
-		}
-		else {
-			base_this=to->do_fft();
-			base_this->process_inplace("xform.phaseorigin.tocorner");
-		}
 	}
 	else {
 		if (this_img->is_complex()) base_to=this_img->copy();
@@ -3466,13 +3848,19 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 			base_to=this_img->do_fft();
 			base_to->process_inplace("xform.phaseorigin.tocorner");
 		}
+	}
 
-		if (to->is_complex()) base_this=to->copy();
+	auto make_base_this=[&]() {
+		EMData *ret;
+		if (to->is_complex()) ret=to->copy();
 		else {
-			base_this=to->do_fft();
-			base_this->process_inplace("xform.phaseorigin.tocorner");
+			ret=to->do_fft();
+			ret->process_inplace("xform.phaseorigin.tocorner");
 		}
-	}
+		ret->process_inplace("xform.fourierorigin.tocenter");		// easier to chop out Fourier subvolumes
+		return ret;
+	};
+	base_this = refcache ? refcache->get_level(0,0,make_base_this) : make_base_this();
 
 
 	if (base_this->get_xsize()!=base_this->get_ysize()+2 || base_this->get_ysize()!=base_this->get_zsize()
@@ -3482,8 +3870,7 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 // 	base_to->process_inplace("mask.wedgefill", Dict("thresh_sigma", sigmato));
 	
 	
-	base_this->process_inplace("xform.fourierorigin.tocenter");		// easier to chop out Fourier subvolumes
-	base_to->process_inplace("xform.fourierorigin.tocenter");
+	base_to->process_inplace("xform.fourierorigin.tocenter");		// easier to chop out Fourier subvolumes
 
 	float apix=(float)this_img->get_attr("apix_x");
 	int ny=this_img->get_ysize();
@@ -3528,8 +3915,9 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 		sexp_start=5;
 	}
 		
-	int maxshift00=(int)params.set_default("maxshift",ny/4);
-	float maxang=params.set_default("maxang",-1.0);
+	// read without inserting, params is shared by every particle in xform_align_nbest_batch()
+	int maxshift00=params.has_key("maxshift")?(int)params["maxshift"]:ny/4;
+	float maxang=params.has_key("maxang")?(float)params["maxang"]:-1.0f;
 
 //	float dstep[3] = {7.5,7.5,7.5};		// we take  steps for each of the 3 angles, may be positive or negative
 	string axname[] = {"az","alt","phi"};
@@ -3548,18 +3936,30 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 		if (maxshift00<0) maxshift=-1;
 		
 		//ss=good_size(ny/ds);
-		EMData *small_this=base_this->get_clip(Region(0,(ny-ss)/2,(ny-ss)/2,ss+2,ss,ss));
+		auto make_small_this=[&]() {
+			EMData *ret=base_this->get_clip(Region(0,(ny-ss)/2,(ny-ss)/2,ss+2,ss,ss));
+			ret->process_inplace("xform.fourierorigin.tocorner");
+			ret->process_inplace("filter.highpass.gauss",Dict("cutoff_pixels",4));
+			if (ss<maxny) ret->process_inplace("filter.lowpass.gauss",Dict("cutoff_abs",0.33f));	// skip lp filter at full sampling seems to help..
+			return ret;
+		};
+		EMData *small_this = refcache ? refcache->get_level(ss,0,make_small_this) : make_small_this();
 		EMData *small_to=  base_to->  get_clip(Region(0,(ny-ss)/2,(ny-ss)/2,ss+2,ss,ss));
-		small_this->process_inplace("xform.fourierorigin.tocorner");
-		small_this->process_inplace("filter.highpass.gauss",Dict("cutoff_pixels",4));
 		small_to->process_inplace("xform.fourierorigin.tocorner");
 		small_to->process_inplace("filter.highpass.gauss",Dict("cutoff_pixels",4));
-		
-		if (ss<maxny){
-			// skip lp filter at full sampling seems to help..
-			small_this->process_inplace("filter.lowpass.gauss",Dict("cutoff_abs",0.33f));
-			small_to->process_inplace("filter.lowpass.gauss",Dict("cutoff_abs",0.33f));
-		}
+		if (ss<maxny) small_to->process_inplace("filter.lowpass.gauss",Dict("cutoff_abs",0.33f));
+
+		// Worker threads each get a private copy of the small volumes, thread 0 uses the originals.
+		// Made on demand, after the early 'continue' below
+		vector<EMData*> thr_this, thr_to;
+		auto make_thread_copies=[&]() {
+			thr_this.assign(1,small_this);
+			thr_to.assign(1,small_to);
+			for (int thr=1; thr<nthreads; thr++) {
+				thr_this.push_back(small_this->copy());
+				thr_to.push_back(small_to->copy());
+			}
+		};
 
 		// these are cached for speed in the comparator
 		vector<float>sigmathisv=small_this->calc_radial_dist(ss/2,0,1,4);
@@ -3600,6 +4000,54 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 			if (transforms.size()<30) continue; // for very high symmetries we will go up to 32 instead of 24
 
 			// We iterate over all orientations in an asym triangle (alt & az) then deal with phi ourselves
+			// Every (orientation,phi) pair is scored independently on the thread pool, then the candidate
+			// list is updated in the original serial order, so the result does not depend on the thread count
+			vector<float> phis;
+			for (float phi=0; phi<360.0; phi+=astep) phis.push_back(phi);
+			const int nphi=(int)phis.size();
+			const int ntest=(int)transforms.size()*nphi;
+			vector<Transform> o_xform(ntest);
+			vector<float> o_score(ntest);
+			vector<float> o_coverage(ntest);
+
+			make_thread_copies();
+			parallel_items(ntest,nthreads,[&](int k,int thr) {
+				EMData *my_this=thr_this[thr];
+				EMData *my_to=thr_to[thr];
+				Transform t = transforms[k/nphi];
+				Dict aap=t.get_params("eman");
+				aap["phi"]=phis[k%nphi];
+				aap["tx"]=0;
+				aap["ty"]=0;
+				aap["tz"]=0;
+				t.set_params(aap);
+				t.invert();
+				aap=t.get_params("eman");
+
+				// somewhat strangely, rotations are actually much more expensive than FFTs, so we use a CCF for translation
+				// t is still a pure rotation from the fixed grid here, so in a batch it only needs to be done once
+				EMData *stt=refcache ? refcache->get_rotated(my_this,ss,0,t) : my_this->process("xform",Dict("transform",EMObject(&t),"zerocorners",1));
+				EMData *ccf=my_to->calc_ccf(stt);
+				IntPoint ml=ccf->calc_max_location_wrap();
+
+				aap["tx"]=(int)ml[0];
+				aap["ty"]=(int)ml[1];
+				aap["tz"]=(int)ml[2];
+				t.set_params(aap);
+				delete stt;
+				delete ccf;
+				stt=my_this->process("xform",Dict("transform",EMObject(&t),"zerocorners",1));	// we have to do 1 slow transform here now that we have the translation
+
+//				float sim=stt->cmp("ccc.tomo.thresh",small_to,Dict("sigmaimg",sigmathis,"sigmawith",sigmato));
+				o_score[k]=stt->cmp("ccc.tomo.thresh",my_to);
+				o_coverage[k]=stt->get_attr("fft_overlap");
+				o_xform[k]=t;
+
+//				float sim=stt->cmp("fsc.tomo.auto",small_to,Dict("sigmaimg",sigmathisv,"sigmawith",sigmatov));
+//				float sim=stt->cmp("fsc.tomo.auto",small_to);
+				delete stt;
+			});
+
 //			for (std::vector<Transform>::iterator t = transforms.begin(); t!=transforms.end(); ++t) {    // iterator form was causing all sorts of problems
 			for (unsigned int it=0; it<transforms.size(); it++) {
 				
@@ -3607,35 +4055,10 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 					printf("  %d/%lu \r",it,transforms.size());
 					fflush(stdout);
 				}
-				for (float phi=0; phi<360.0; phi+=astep) {
-					Transform t = transforms[it];
-					Dict aap=t.get_params("eman");
-					aap["phi"]=phi;
-					aap["tx"]=0;
-					aap["ty"]=0;
-					aap["tz"]=0;
-					t.set_params(aap);
-					t.invert();
-					aap=t.get_params("eman");
-
-					// somewhat strangely, rotations are actually much more expensive than FFTs, so we use a CCF for translation
-					EMData *stt=small_this->process("xform",Dict("transform",EMObject(&t),"zerocorners",1));
-					EMData *ccf=small_to->calc_ccf(stt);
-					IntPoint ml=ccf->calc_max_location_wrap();
-
-					aap["tx"]=(int)ml[0];
-					aap["ty"]=(int)ml[1];
-					aap["tz"]=(int)ml[2];
-					t.set_params(aap);
-					delete stt;
-					delete ccf;
-					stt=small_this->process("xform",Dict("transform",EMObject(&t),"zerocorners",1));	// we have to do 1 slow transform here now that we have the translation
-
-//					float sim=stt->cmp("ccc.tomo.thresh",small_to,Dict("sigmaimg",sigmathis,"sigmawith",sigmato));
-					float sim=stt->cmp("ccc.tomo.thresh",small_to);
-					
-//					float sim=stt->cmp("fsc.tomo.auto",small_to,Dict("sigmaimg",sigmathisv,"sigmawith",sigmatov));
-//					float sim=stt->cmp("fsc.tomo.auto",small_to);
+				for (int iphi=0; iphi<nphi; iphi++) {
+					const int k=it*nphi+iphi;
+					const Transform &t=o_xform[k];
+					float sim=o_score[k];
 
 					// We want to make sure our starting points are somewhat separated from each other, so we replace any angles too close to an existing angle
 					// If we find an existing 'best' angle within range, then we either replace it or skip
@@ -3666,11 +4089,10 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 					// displace it. Note that there is no sorting performed here
 					if (sim<s_score[worst]) {
 						s_score[worst]=sim;
-						s_coverage[worst]=stt->get_attr("fft_overlap");
+						s_coverage[worst]=o_coverage[k];
 						s_xform[worst]=t;
 						//printf("%f\t%f\t%d\n",s_score[worst],s_coverage[worst],worst);
 					}
-					delete stt;
 				}
 			}
 			if (verbose>2) printf("\n");
@@ -3691,7 +4113,12 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 				nsoln+=1;
 			}
 			
-			for (int i=0; i<nsoln; i++) {
+			// Each solution is refined independently and only touches its own entries in the s_ vectors,
+			// so they can be spread over the thread pool without changing the outcome
+			make_thread_copies();
+			parallel_items(nsoln,nthreads,[&](int i,int thr) {
+				EMData *my_this=thr_this[thr];
+				EMData *my_to=thr_to[thr];
 
 				if (verbose>2) {
 					printf("  %d\t%d\r",i,nsoln);
@@ -3700,7 +4127,7 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 				// We work an axis at a time until we get where we want to be. Somewhat like a simplex
 				int changed=1;
 				Dict upd;
-				testort(small_this,small_to,sigmathisv,sigmatov,s_score,s_coverage,s_xform,i,upd, initxf, maxshift,mask);
+				testort(my_this,my_to,sigmathisv,sigmatov,s_score,s_coverage,s_xform,i,upd, initxf, maxshift,mask);
 				while (changed) {
 					changed=0;
 					for (int axis=0; axis<3; axis++) {
@@ -3710,7 +4137,7 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 						// phi continues to move independently. I believe this should produce a more monotonic energy surface
 						if (axis==0) upd[axname[2]]=-s_step[i*3+axis];
 
-						int r=testort(small_this,small_to,sigmathisv,sigmatov,s_score,s_coverage,s_xform,i,upd, initxf, maxshift,mask);
+						int r=testort(my_this,my_to,sigmathisv,sigmatov,s_score,s_coverage,s_xform,i,upd, initxf, maxshift,mask);
 
 						// If we fail, we reverse direction with a slightly smaller step and try that
 						// Whether this fails or not, we move on to the next axis
@@ -3718,7 +4145,7 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 						else {
 							s_step[i*3+axis]*=-0.75;
 							upd[axname[axis]]=s_step[i*3+axis];
-							r=testort(small_this,small_to,sigmathisv,sigmatov,s_score,s_coverage,s_xform,i,upd, initxf, maxshift,mask);
+							r=testort(my_this,my_to,sigmathisv,sigmatov,s_score,s_coverage,s_xform,i,upd, initxf, maxshift,mask);
 							if (r) changed=1;
 						}
 						if (verbose>4) printf("\nX %1.3f\t%1.3f\t%1.3f\t%d\t",s_step[i*3],s_step[i*3+1],s_step[i*3+2],changed);
@@ -3747,7 +4174,7 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 // 						}
 // 					}
 // 				}
-			}
+			});
 		}
 		// lazy earlier in defining s_ vectors, so lazy here too and inefficiently sorting
 		// We are sorting inside the outermost loop so we can decrease the number of solutions
@@ -3768,14 +4195,18 @@ vector<Dict> RT3DTreeAligner::xform_align_nbest(EMData * this_img, EMData * to,
 		if (nsoln<nrsoln) nsoln=nrsoln;
 
 
-		delete small_this;
+		for (size_t thr=1; thr<thr_this.size(); thr++) {
+			delete thr_this[thr];
+			delete thr_to[thr];
+		}
+		if (!refcache) delete small_this;
 		delete small_to;
 		
 		lastss=ss;
 		if (ss>=maxny && curiter>0) break;
 	}
 
-	delete base_this;
+	if (!refcache) delete base_this;
 	delete base_to;
 	
 	// note the translations are wrong when the alignment stops before ss==ny
@@ -3817,7 +4248,7 @@ bool RT3DTreeAligner::testort(EMData *small_this,EMData *small_to,vector<float>
 	}
 
 	t.set_params(aap);
-	float maxang=params.set_default("maxang",-1.0);
+	float maxang=params.has_key("maxang")?(float)params["maxang"]:-1.0f;
 	bool randphi=params.set_default("randphi",false);
 	bool rand180=params.set_default("rand180",false);
 	
@@ -3906,6 +4337,25 @@ EMData* RT3DLocalTreeAligner::align(EMData * this_img, EMData *to, const string
 // to the symmetry axes (ie - the reference). this is confusing as it is inverted internally in the algorithm, so the passed in 
 // "this" becomes "to" in the code to conform to the way the other aligners work.
 vector<Dict> RT3DLocalTreeAligner::xform_align_nbest(EMData * this_img, EMData * to, const unsigned int nrsoln, const string & cmp_name, const Dict& cmp_params) const {
+	return xform_align_nbest_cached(this_img,to,nrsoln,0);
+}
+
+vector< vector<Dict> > RT3DLocalTreeAligner::xform_align_nbest_batch(const vector<EMData*> & this_imgs, EMData * to, const unsigned int nrsoln, const string & cmp_name, const Dict& cmp_params) const {
+	int refcache=params.set_default("refcache",1024);
+	if (refcache<=0) return Aligner::xform_align_nbest_batch(this_imgs,to,nrsoln,cmp_name,cmp_params);
+	check_batch_sizes(this_imgs,to,"RT3DLocalTreeAligner");
+
+	RT3DReferenceCache cache((size_t)refcache<<20);
+	vector< vector<Dict> > solns;
+	for (size_t i=0; i<this_imgs.size(); i++) {
+		cache.next_item();
+		solns.push_back(xform_align_nbest_cached(this_imgs[i],to,nrsoln,&cache));
+	}
+	return solns;
+}
+
+// As RT3DTreeAligner, the volumes derived from 'to' belong to refcache when it is set. Slot 0 is 'to', slot 1 its square
+vector<Dict> RT3DLocalTreeAligner::xform_align_nbest_cached(EMData * this_img, EMData * to, const unsigned int nrsoln, RT3DReferenceCache *refcache) const {
 	if (nrsoln == 0) throw InvalidParameterException("ERROR (RT3DTreeAligner): nsoln must be >0"); // What was the user thinking?
 
 	int nsoln = nrsoln*2;
@@ -3915,7 +4365,7 @@ vector<Dict> RT3DLocalTreeAligner::xform_align_nbest(EMData * this_img, EMData *
 	// the Transform is inverted before being returned
 	EMData *base_this;
 	EMData *base_to;
-	EMData *base_thissq;
+	EMData *base_thissq=0;
 	EMData *base_mask;
 	
 	if (this_img->is_complex()) {
@@ -3933,20 +4383,32 @@ vector<Dict> RT3DLocalTreeAligner::xform_align_nbest(EMData * this_img, EMData *
 		delete tmp;
 	}
 
-	if (to->is_complex()) {
-		base_this=to->copy();
-		EMData *tmp = base_this->do_ift();
-		tmp->process_inplace("math.squared");
-		base_thissq = tmp->do_fft();
-		delete tmp;
-	}
-	else {
-		base_this=to->do_fft();
-		base_this->process_inplace("xform.phaseorigin.tocorner");
-		EMData *tmp = base_this->process("math.squared");
-		base_thissq = tmp->do_fft();
-		delete tmp;
+	// base_thissq is made together with base_this
+	auto make_base_this=[&]() {
+		EMData *ret;
+		if (to->is_complex()) {
+			ret=to->copy();
+			EMData *tmp = ret->do_ift();
+			tmp->process_inplace("math.squared");
+			base_thissq = tmp->do_fft();
+			delete tmp;
+		}
+		else {
+			ret=to->do_fft();
+			ret->process_inplace("xform.phaseorigin.tocorner");
+			EMData *tmp = ret->process("math.squared");
+			base_thissq = tmp->do_fft();
+			delete tmp;
+		}
+		ret->process_inplace("xform.fourierorigin.tocenter");		// easier to chop out Fourier subvolumes
+		base_thissq->process_inplace("xform.fourierorigin.tocenter");
+		return ret;
+	};
+	if (refcache) {
+		base_this=refcache->get_level(0,0,make_base_this);
+		base_thissq=refcache->get_level(0,1,[&]() { return base_thissq; });	// only made on the first call, which also set base_thissq
 	}
+	else base_this=make_base_this();
 
 	float sigmathis = params.set_default("sigmathis",0.01f);
 	float sigmato = params.set_default("sigmato",0.01f);
@@ -3960,15 +4422,14 @@ vector<Dict> RT3DLocalTreeAligner::xform_align_nbest(EMData * this_img, EMData *
 // 	base_to->process_inplace("mask.wedgefill", Dict("thresh_sigma", sigmato));
 	
 	
-	base_this->process_inplace("xform.fourierorigin.tocenter");		// easier to chop out Fourier subvolumes
-	base_to->process_inplace("xform.fourierorigin.tocenter");
-	base_thissq->process_inplace("xform.fourierorigin.tocenter");
+	base_to->process_inplace("xform.fourierorigin.tocenter");		// easier to chop out Fourier subvolumes
 	base_mask->process_inplace("xform.fourierorigin.tocenter");
 
 	float apix=(float)this_img->get_attr("apix_x");
 	int ny=this_img->get_ysize();
 	params["boxsize"]=ny;
-	int maxshift00=(int)params.set_default("maxshift",ny/4);
+	// read without inserting, params is shared by every particle in xform_align_nbest_batch()
+	int maxshift00=params.has_key("maxshift")?(int)params["maxshift"]:ny/4;
 
 	int maxny=ny;
 	if (0)//maxres>0)
@@ -3976,7 +4437,7 @@ vector<Dict> RT3DLocalTreeAligner::xform_align_nbest(EMData * this_img, EMData *
 		if (verbose>0)
 			printf("\n\n*******\nmax resolution %1.2f, box size %d\n", maxres, maxny);
 	
-	float maxang=params.set_default("maxang",-1.0);
+	float maxang=params.has_key("maxang")?(float)params["maxang"]:-1.0f;
 	Transform initxf;
 	
 //	int downsample=floor(ny/20);		// Minimum shrunken box size is 20^3
@@ -4022,24 +4483,28 @@ vector<Dict> RT3DLocalTreeAligner::xform_align_nbest(EMData * this_img, EMData *
 		if (maxshift00<0) maxshift=-1;
 		
 		//ss=good_size(ny/ds);
-		EMData *small_this=base_this->get_clip(Region(0,(ny-ss)/2,(ny-ss)/2,ss+2,ss,ss));
+		auto make_small_this=[&]() {
+			EMData *ret=base_this->get_clip(Region(0,(ny-ss)/2,(ny-ss)/2,ss+2,ss,ss));
+			ret->process_inplace("xform.fourierorigin.tocorner");
+			ret->process_inplace("filter.highpass.gauss",Dict("cutoff_pixels",4));
+			if (ss<maxny) ret->process_inplace("filter.lowpass.gauss",Dict("cutoff_abs",0.33f));	// skip lp filter at full sampling seems to help..
+			return ret;
+		};
+		auto make_small_thissq=[&]() {
+			EMData *ret=base_thissq->get_clip(Region(0,(ny-ss)/2,(ny-ss)/2,ss+2,ss,ss));
+			ret->process_inplace("xform.fourierorigin.tocorner");
+			ret->process_inplace("filter.highpass.gauss",Dict("cutoff_pixels",4));
+			return ret;
+		};
+		EMData *small_this = refcache ? refcache->get_level(ss,0,make_small_this) : make_small_this();
+		EMData *small_thissq = refcache ? refcache->get_level(ss,1,make_small_thissq) : make_small_thissq();
 		EMData *small_to=  base_to->  get_clip(Region(0,(ny-ss)/2,(ny-ss)/2,ss+2,ss,ss));
-		EMData *small_thissq=base_thissq->get_clip(Region(0,(ny-ss)/2,(ny-ss)/2,ss+2,ss,ss));
 		EMData *small_mask=  base_mask->  get_clip(Region(0,(ny-ss)/2,(ny-ss)/2,ss+2,ss,ss));
-		small_this->process_inplace("xform.fourierorigin.tocorner");
-		small_this->process_inplace("filter.highpass.gauss",Dict("cutoff_pixels",4));
 		small_to->process_inplace("xform.fourierorigin.tocorner");
 		small_to->process_inplace("filter.highpass.gauss",Dict("cutoff_pixels",4));
 		small_mask->process_inplace("xform.fourierorigin.tocorner");
 		small_mask->process_inplace("filter.highpass.gauss",Dict("cutoff_pixels",4));
-		small_thissq->process_inplace("xform.fourierorigin.tocorner");
-		small_thissq->process_inplace("filter.highpass.gauss",Dict("cutoff_pixels",4));
-		
-		if (ss<maxny){
-			// skip lp filter at full sampling seems to help..
-			small_this->process_inplace("filter.lowpass.gauss",Dict("cutoff_abs",0.33f));
-			small_to->process_inplace("filter.lowpass.gauss",Dict("cutoff_abs",0.33f));
-		}
+		if (ss<maxny) small_to->process_inplace("filter.lowpass.gauss",Dict("cutoff_abs",0.33f));
 
 		// these are cached for speed in the comparator
 		vector<float>sigmathisv=small_this->calc_radial_dist(ss/2,0,1,4);
@@ -4099,8 +4564,16 @@ vector<Dict> RT3DLocalTreeAligner::xform_align_nbest(EMData * this_img, EMData *
 					aap=t.get_params("eman");
 
 					// somewhat strangely, rotations are actually much more expensive than FFTs, so we use a CCF for translation
-					EMData *stt=small_this->process("xform",Dict("transform",EMObject(&t),"zerocorners",1));
-					EMData *sttsq=small_thissq->process("xform",Dict("transform",EMObject(&t),"zerocorners",1));
+					// t is still a pure rotation from the fixed grid here, so in a batch it only needs to be done once
+					EMData *stt, *sttsq;
+					if (refcache) {
+						stt=refcache->get_rotated(small_this,ss,0,t);
+						sttsq=refcache->get_rotated(small_thissq,ss,1,t);
+					}
+					else {
+						stt=small_this->process("xform",Dict("transform",EMObject(&t),"zerocorners",1));
+						sttsq=small_thissq->process("xform",Dict("transform",EMObject(&t),"zerocorners",1));
+					}
 //					EMData *ccf=small_to->calc_ccf(stt);
 					EMData *ccf=small_to->calc_ccf_masked(stt,sttsq,small_mask);
 					IntPoint ml=ccf->calc_max_location_wrap();
@@ -4251,18 +4724,22 @@ vector<Dict> RT3DLocalTreeAligner::xform_align_nbest(EMData * this_img, EMData *
 		if (nsoln<nrsoln) nsoln=nrsoln;
 
 
-		delete small_this;
+		if (!refcache) {
+			delete small_this;
+			delete small_thissq;
+		}
 		delete small_to;
-		delete small_thissq;
 		delete small_mask;
 		
 		lastss=ss;
 		if (ss>=maxny && curiter>0) break;
 	}
 
-	delete base_this;
+	if (!refcache) {
+		delete base_this;
+		delete base_thissq;
+	}
 	delete base_to;
-	delete base_thissq;
 	delete base_mask;
 	
 	// note the translations are wrong when the alignment stops before ss==ny
@@ -4304,7 +4781,7 @@ bool RT3DLocalTreeAligner::testort(EMData *small_this,EMData *small_to,EMData *s
 	}
 
 	t.set_params(aap);
-	float maxang=params.set_default("maxang",-1.0);
+	float maxang=params.has_key("maxang")?(float)params["maxang"]:-1.0f;
 	bool randphi=params.set_default("randphi",false);
 	bool rand180=params.set_default("rand180",false);
 	
@@ -4620,7 +5097,7 @@ vector<Dict> RT3DSymmetryAligner::xform_align_nbest(EMData * this_img, EMData *
 	#endif
 
 	//Generate symmetry related orientations
-	vector<Transform> syms = Symmetry3D::get_symmetries((string)params.set_default("sym","icos"));
+	const vector<Transform>& syms = Symmetry3D::get_symmetry_ops((string)params.set_default("sym","icos")).syms;
 	Cmp* c = Factory <Cmp>::get(cmp_name, cmp_params);
 
 	float score = 0.0f;
@@ -40,6 +40,8 @@ namespace EMAN
 {
 	class EMData;
 	class Cmp;
+	class RT3DReferenceCache;
+	class RT2DTreeReference;
 
 	/** Aligner class defines image alignment method. It aligns 2
 	 * images based on a user-given comparison method.
@@ -138,6 +140,28 @@ namespace EMAN
 		 * @return an ordered vector of Dicts of length nsoln. The Dicts in the vector have keys "score" (i.e. correlation score) and "xform.align3d" (Transform containing the alignment)
 		 */
 		virtual vector<Dict> xform_align_nbest(EMData * this_img, EMData * to_img, const unsigned int nsoln, const string & cmp_name, const Dict& cmp_params) const;
+
+		/** Aligns each image in this_imgs to the same to_img, as xform_align_nbest() would. Aligners which can reuse
+		 * work on to_img between calls override this, the default just calls xform_align_nbest() for each image.
+		 * @param this_imgs the images that will be aligned to to_img
+		 * @param to_img the image shared by all alignments
+		 * @param nsoln the number of solutions you want for each image
+		 * @param cmp_name the name of a comparator - may be unused
+		 * @param cmp_params the params of the comparator - may be unused
+		 * @return one xform_align_nbest() result per image in this_imgs, in the same order
+		 */
+		virtual vector< vector<Dict> > xform_align_nbest_batch(const vector<EMData*> & this_imgs, EMData * to_img, const unsigned int nsoln, const string & cmp_name, const Dict& cmp_params) const;
+
+		/** Aligns every image in this_imgs to every image in to_imgs. Aligners which can prepare each reference
+		 * once and share the work between threads override this, the default calls align() for each pair.
+		 * @param this_imgs the images that will be aligned (the particles)
+		 * @param to_imgs the images they are aligned to (the references)
+		 * @param cmp_name The comparison method used to compare the images
+		 * @param cmp_params The parameter dictionary for comparison method
+		 * @return result[i][j] is the alignment of this_imgs[i] to to_imgs[j], a Dict with "xform.align2d" (the Transform
+		 * align() would have stored in its result) and "score" (smaller is better)
+		 */
+		virtual vector< vector<Dict> > align_batch(const vector<EMData*> & this_imgs, const vector<EMData*> & to_imgs, const string & cmp_name, const Dict& cmp_params) const;
 //		{
 //			vector<Dict> solns;
 //			return solns;
@@ -459,6 +483,11 @@ namespace EMAN
 			return align(this_img, to_img, "sqeuclidean", Dict());
 		}
 
+		/** See Aligner comments. Uses up to 'threads' threads, the rotational footprint of each
+		 * reference is computed once per thread
+		 */
+		virtual vector< vector<Dict> > align_batch(const vector<EMData*> & this_imgs, const vector<EMData*> & to_imgs, const string & cmp_name, const Dict& cmp_params) const;
+
 		virtual string get_name() const
 		{
 			return NAME;
@@ -483,10 +512,15 @@ namespace EMAN
 			d.put("rfp_mode", EMObject::INT,"Either 0,1 or 2. A temporary flag for testing the rotational foot print");
 			d.put("useflcf", EMObject::INT,"Use Fast Local Correlation Function rather than CCF for translational alignment");
 			d.put("zscore", EMObject::INT,"Either 0 or 1. This option is passed directly to the rotational aligner (default=false)");
+			d.put("threads", EMObject::INT,"Number of threads used by align_batch. Default 1");
 			return d;
 		}
 
 		static const string NAME;
+
+	  private:
+		/** align() which also returns the comparator score of the solution */
+		EMData *align_scored(EMData * this_img, EMData * to_img, const string & cmp_name, const Dict& cmp_params, float &score) const;
 	};
 
 	/** rotational, translational alignment
@@ -896,6 +930,7 @@ namespace EMAN
 	 * @param usedot
 	 * @param maxshift Maximum translation in pixels
 	 * @param rfp_mode Either 0,1 or 2. A temporary flag for testing the rotational foot print
+	 * @param threads Number of threads used by align_batch
 	*/
 	class RotateTranslateFlipAligner:public Aligner
 	{
@@ -907,6 +942,11 @@ namespace EMAN
 			return align(this_img, to_img, "sqeuclidean", Dict());
 		}
 
+		/** See Aligner comments. Uses up to 'threads' threads, the flipped reference and the rotational
+		 * footprints are computed once per reference and thread
+		 */
+		virtual vector< vector<Dict> > align_batch(const vector<EMData*> & this_imgs, const vector<EMData*> & to_imgs, const string & cmp_name, const Dict& cmp_params) const;
+
 		virtual string get_name() const
 		{
 			return NAME;
@@ -938,10 +978,15 @@ namespace EMAN
 			d.put("useharmonic", EMObject::INT,"Uses rotate_translate_bispec in harmonic mode for alignments and ignores rfp_mode.");
 			d.put("useflcf", EMObject::INT,"Use Fast Local Correlation Function rather than CCF for translational alignment");
 			d.put("zscore", EMObject::INT,"Either 0 or 1. This option is passed directly to the rotational aligner (default=false)");
+			d.put("threads", EMObject::INT,"Number of threads used by align_batch. Default 1");
 			return d;
 		}
 
 		static const string NAME;
+
+	  private:
+		/** align() with the flipped reference supplied by the caller, also returns the comparator score of the solution */
+		EMData *align_scored(EMData * this_img, EMData * to_img, EMData * flipped, const string & cmp_name, const Dict& cmp_params, float &score) const;
 	};
 
 	/** rotational, translational, flip, scaling alignment
@@ -1756,6 +1801,7 @@ namespace EMAN
 	/** 2D rotational and translational alignment using a hierarchical method with gradually decreasing downsampling in Fourier space.
 	 * In theory, very fast, and without need for a "refine" aligner. Comparator is ignored. Uses an inbuilt comparison.
 	 * @param verbose Turn this on to have useful information printed to standard out
+	 * @param threads Number of threads used by align_batch
 	 * @author Steve Ludtke
 	 * @date July 2016
 	 */
@@ -1778,6 +1824,11 @@ namespace EMAN
 			 */
 			virtual vector<Dict> xform_align_nbest(EMData * this_img, EMData * to_img, const unsigned int nsoln, const string & cmp_name, const Dict& cmp_params) const;
 
+			/** See Aligner comments for more details. Uses up to 'threads' threads, the Fourier transformed and
+			 * filtered reference at each level is computed once per reference and thread
+			 */
+			virtual vector< vector<Dict> > align_batch(const vector<EMData*> & this_imgs, const vector<EMData*> & to_imgs, const string & cmp_name, const Dict& cmp_params) const;
+
 			virtual string get_name() const
 			{
 				return NAME;
@@ -1803,12 +1854,14 @@ namespace EMAN
 				d.put("verbose", EMObject::INT,"Turn this on to have useful information printed to standard out.");
 				d.put("maxshift", EMObject::INT,"Maximum acceptable translation. Used only approximately.");
  				d.put("maxres", EMObject::FLOAT,"Maximum resolution to consider when full sampling is used");
+				d.put("threads", EMObject::INT,"Number of threads used by align_batch. Default 1");
 				return d;
 			}
 
 			static const string NAME;
 
 		private:
+			vector<Dict> xform_align_nbest_prepared(EMData * this_img, EMData * to_img, const unsigned int nsoln, RT2DTreeReference &prep) const;
 			bool testort(EMData *small_this, EMData *small_to,vector<float> &sigmathisv,vector<float> &sigmatov, vector<float> &s_score, vector<float> &s_coverage,vector<Transform> &s_xform,int i,Dict &upd) const;
 
 	};
@@ -1883,6 +1936,8 @@ namespace EMAN
 	 * In theory, very fast, and without need for a "refine" aligner. Comparator is ignored. Uses an inbuilt comparison.
 	 * @param sym The symmtery to use as the basis of the spherical sampling
 	 * @param verbose Turn this on to have useful information printed to standard out
+	 * @param threads Number of threads for the orientation search, the result does not depend on it
+	 * @param refcache Memory limit in MB for the rotated 'to' volumes shared between images by xform_align_nbest_batch(), 0 disables
 	 * @author Steve Ludtke
 	 * @date April 2015
 	 */
@@ -1905,6 +1960,11 @@ namespace EMAN
 			 */
 			virtual vector<Dict> xform_align_nbest(EMData * this_img, EMData * to_img, const unsigned int nsoln, const string & cmp_name, const Dict& cmp_params) const;
 
+			/** Aligns every image in this_imgs to to_img. The cropped and filtered to_img at each level, and its rotations
+			 * over the global orientation grid, are computed once and reused for the following images
+			 */
+			virtual vector< vector<Dict> > xform_align_nbest_batch(const vector<EMData*> & this_imgs, EMData * to_img, const unsigned int nsoln, const string & cmp_name, const Dict& cmp_params) const;
+
 			virtual string get_name() const
 			{
 				return NAME;
@@ -1937,12 +1997,15 @@ namespace EMAN
 				d.put("randphi", EMObject::BOOL,"Ignore phi constraint for refine search");
 				d.put("rand180", EMObject::BOOL,"Ignore 180 rotation for refine search");
 				d.put("verbose", EMObject::BOOL,"Turn this on to have useful information printed to standard out.");
+				d.put("threads", EMObject::INT,"Number of threads used to score orientations and refine solutions. The result does not depend on it. Default 1");
+				d.put("refcache", EMObject::INT,"Memory limit in MB for rotated volumes reused between images by xform_align_nbest_batch. 0 disables the cache. Default 1024");
 				return d;
 			}
 
 			static const string NAME;
 
 		private:
+			vector<Dict> xform_align_nbest_cached(EMData * this_img, EMData * to_img, const unsigned int nsoln, RT3DReferenceCache *refcache) const;
 			bool testort(EMData *small_this, EMData *small_to,vector<float> &sigmathisv,vector<float> &sigmatov, vector<float> &s_score, vector<float> &s_coverage,vector<Transform> &s_xform,int i,Dict &upd, Transform initxf, int maxshift,EMData *mask) const;
 
 	};
@@ -1953,6 +2016,7 @@ namespace EMAN
 	 * but doing this slows things down.
 	 * @param sym The symmtery to use as the basis of the spherical sampling
 	 * @param verbose Turn this on to have useful information printed to standard out
+	 * @param refcache Memory limit in MB for the rotated 'to' volumes shared between images by xform_align_nbest_batch(), 0 disables
 	 * @author Steve Ludtke
 	 * @date April 2015
 	 */
@@ -1975,6 +2039,11 @@ namespace EMAN
 			 */
 			virtual vector<Dict> xform_align_nbest(EMData * this_img, EMData * to_img, const unsigned int nsoln, const string & cmp_name, const Dict& cmp_params) const;
 
+			/** Aligns every image in this_imgs to to_img. The cropped and filtered to_img at each level, and its rotations
+			 * over the global orientation grid, are computed once and reused for the following images
+			 */
+			virtual vector< vector<Dict> > xform_align_nbest_batch(const vector<EMData*> & this_imgs, EMData * to_img, const unsigned int nsoln, const string & cmp_name, const Dict& cmp_params) const;
+
 			virtual string get_name() const
 			{
 				return NAME;
@@ -2006,12 +2075,14 @@ namespace EMAN
 				d.put("randphi", EMObject::BOOL,"Ignore phi constraint for refine search");
 				d.put("rand180", EMObject::BOOL,"Ignore 180 rotation for refine search");
 				d.put("verbose", EMObject::BOOL,"Turn this on to have useful information printed to standard out.");
+				d.put("refcache", EMObject::INT,"Memory limit in MB for rotated volumes reused between images by xform_align_nbest_batch. 0 disables the cache. Default 1024");
 				return d;
 			}
 
 			static const string NAME;
 
 		private:
+			vector<Dict> xform_align_nbest_cached(EMData * this_img, EMData * to_img, const unsigned int nsoln, RT3DReferenceCache *refcache) const;
 			bool testort(EMData *small_this, EMData *small_to,EMData *small_mask,EMData *small_thissq,vector<float> &sigmathisv,vector<float> &sigmatov, vector<float> &s_score, vector<float> &s_coverage,vector<Transform> &s_xform,int i,Dict &upd, Transform initxf, int maxshift) const;
 
 	};
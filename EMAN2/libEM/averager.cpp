@@ -1017,6 +1017,25 @@ EMData *MedianAverager::finish()
 	return ret;
 }
 
+// Fills snr with CTF_SNR and ctfi with CTF_AMP, in a single pass for EMAN2Ctf
+static void compute_snr_amp(Ctf *ctf, EMData *snr, EMData *ctfi)
+{
+	EMAN2Ctf *ctf2 = dynamic_cast<EMAN2Ctf *>(ctf);
+	if (ctf2) {
+		vector<EMData *> images(2);
+		images[0] = snr;
+		images[1] = ctfi;
+		vector<Ctf::CtfType> types(2);
+		types[0] = Ctf::CTF_SNR;
+		types[1] = Ctf::CTF_AMP;
+		ctf2->compute_2d_complex_multi(images, types);
+	}
+	else {
+		ctf->compute_2d_complex(snr,Ctf::CTF_SNR);
+		ctf->compute_2d_complex(ctfi,Ctf::CTF_AMP);
+	}
+}
+
 CtfCWautoAverager::CtfCWautoAverager()
 	: nimg(0)
 {
@@ -1056,10 +1075,9 @@ void CtfCWautoAverager::add_image(EMData * image)
 //	if (nimg==1) unlink("snr.hdf");
 
 	EMData *snr = result -> copy();
-	ctf->compute_2d_complex(snr,Ctf::CTF_SNR);
-//	snr->write_image("snr.hdf",-1);
 	EMData *ctfi = result-> copy();
-	ctf->compute_2d_complex(ctfi,Ctf::CTF_AMP);
+	compute_snr_amp(ctf,snr,ctfi);
+//	snr->write_image("snr.hdf",-1);
 
 	ctf->bfactor=b;	// return to its original value
 
@@ -1169,9 +1187,8 @@ void CtfCAutoAverager::add_image(EMData * image)
 	ctf->bfactor=0;			// NO B-FACTOR CORRECTION !
 
 	EMData *snr = result -> copy();
-	ctf->compute_2d_complex(snr,Ctf::CTF_SNR);
 	EMData *ctfi = result-> copy();
-	ctf->compute_2d_complex(ctfi,Ctf::CTF_AMP);
+	compute_snr_amp(ctf,snr,ctfi);
 
 	ctf->bfactor=b;	// return to its original value
 
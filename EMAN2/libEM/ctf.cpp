@@ -33,9 +33,65 @@
 #include "emdata.h"
 #include "xydata.h"
 #include "emassert.h"
+#include <list>
+#include <memory>
+#include <mutex>
 
 using namespace EMAN;
 
+namespace {
+	/** Geometry of the stored half of a (nx, ny) complex image, which only
+	 * depends on the box size and so is shared by every 2D CTF evaluation.
+	 * For each complex pixel, in storage order: the radius in Fourier pixels
+	 * and cos/sin of twice its angle from the x axis.
+	 */
+	struct CtfGeometry
+	{
+		int nx, ny;
+		vector<float> r;
+		vector<float> cos2;
+		vector<float> sin2;
+	};
+
+	std::shared_ptr<const CtfGeometry> ctf_geometry(int nx, int ny)
+	{
+		static std::mutex mutex;
+		static std::list< std::shared_ptr<const CtfGeometry> > cache;	// most recently used first
+		const size_t max_cached = 8;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto it = cache.begin(); it != cache.end(); ++it) {
+			if ((*it)->nx == nx && (*it)->ny == ny) {
+				cache.splice(cache.begin(), cache, it);
+				return cache.front();
+			}
+		}
+
+		std::shared_ptr<CtfGeometry> g(new CtfGeometry);
+		g->nx = nx;
+		g->ny = ny;
+		const int nhx = nx / 2;
+		const size_t n = (size_t)nhx * ny;
+		g->r.resize(n);
+		g->cos2.resize(n);
+		g->sin2.resize(n);
+		for (int y = -ny/2; y < ny/2; y++) {
+			size_t row = (size_t)((y + ny) % ny) * nhx;
+			for (int x = 0; x < nhx; x++) {
+				float r2 = (float)(x * x + y * y);
+				g->r[row + x] = sqrt(r2);
+				// double angle identities, the origin uses atan2(0,0)=0
+				g->cos2[row + x] = r2 == 0 ? 1.0f : (x * x - y * y) / r2;
+				g->sin2[row + x] = r2 == 0 ? 0.0f : 2.0f * x * y / r2;
+			}
+		}
+
+		cache.push_front(g);
+		if (cache.size() > max_cached) cache.pop_back();
+		return g;
+	}
+}
+
 EMAN1Ctf::EMAN1Ctf()
 {
 	defocus = 0;
@@ -982,256 +1038,235 @@ void EMAN2Ctf::compute_2d_complex(EMData * image, CtfType type, XYData * sf)
 		return;
 	}
 
-	float ds = 1.0f / (apix * ny);
 	image->to_one();
 
 	float *d = image->get_data();
-	float g1=M_PI/2.0*cs*1.0e7*pow(lambda(),3.0f);	// s^4 coefficient for gamma, cached in a variable for simplicity (maybe speed? depends on the compiler)
-	float g2=M_PI*lambda()*10000.0;					// s^2 coefficient for gamma 
-//	float acac=acos(ampcont/100.0);					// instead of ac*cos(g)+sqrt(1-ac^2)*sin(g), we can use cos(g-acos(ac)) and save a trig op
-	float acac=M_PI/2.0-get_phase();
+	compute_2d_complex_rows(&d, &type, 1, nx, ny);
 
-	if (type == CTF_BACKGROUND) {
-		for (int y = -ny/2; y < ny/2; y++) {
-			int y2=(y+ny)%ny;
-			int ynx = y2 * nx;
+	image->update();
+}
 
-			for (int x = 0; x < nx / 2; x++) {
-				float s = (float) Util::hypot_fast(x, y ) * ds;
-				d[x * 2 + ynx] = calc_noise(s);
-				d[x * 2 + ynx + 1] = 0;			// The phase is somewhat arbitrary
-			}
-		}
+void EMAN2Ctf::compute_2d_complex_multi(const vector<EMData *> & images, const vector<CtfType> & types)
+{
+	if (images.size() != types.size())
+		throw InvalidParameterException("compute_2d_complex_multi needs one CtfType per image");
+	if (images.empty()) return;
+
+	for (size_t i = 0; i < images.size(); i++) {
+		if (!images[i]) throw NullPointerException("compute_2d_complex_multi image");
+		if (!images[i]->is_complex())
+			throw ImageFormatException("compute_2d_complex_multi can only work on complex images");
 	}
-	else if (type == CTF_AMP) {
-		for (int y = -ny/2; y < ny/2; y++) {
-			int y2=(y+ny)%ny;
-			int ynx = y2 * nx;
 
-			for (int x = 0; x < nx / 2; x++) {
-				float s = (float)Util::hypot_fast(x,y ) * ds;
-				float gam;
-				if (dfdiff==0) gam=-g1*s*s*s*s+g2*defocus*s*s;
-				else gam=-g1*s*s*s*s+g2*df(atan2((float)y,(float)x))*s*s;
-				float v = cos(gam-acac)*exp(-(bfactor/4.0f * s*s));
-				d[x * 2 + ynx] = v;
-				d[x * 2 + ynx + 1] = 0;
-			}
-		}
+	int nx = images[0]->get_xsize();
+	int ny = images[0]->get_ysize();
+	if ((ny%2==1 && nx!=ny+1) || (ny%2==0 && nx != ny + 2))
+		throw ImageDimensionException("compute_2d_complex_multi only works on (nx, nx-2) images");
+
+	vector<float *> d(images.size());
+	for (size_t i = 0; i < images.size(); i++) {
+		if (images[i]->get_xsize() != nx || images[i]->get_ysize() != ny || images[i]->get_zsize() != 1)
+			throw ImageDimensionException("compute_2d_complex_multi images must all be the same size");
+		images[i]->to_one();
+		d[i] = images[i]->get_data();
 	}
-	else if (type == CTF_ABS) {
-		for (int y = -ny/2; y < ny/2; y++) {
-			int y2=(y+ny)%ny;
-			int ynx = y2 * nx;
 
-			for (int x = 0; x < nx / 2; x++) {
-				float s = (float)Util::hypot_fast(x,y ) * ds;
-				float gam;
-				if (dfdiff==0) gam=-g1*s*s*s*s+g2*defocus*s*s;
-				else gam=-g1*s*s*s*s+g2*df(atan2((float)y,(float)x))*s*s;
-				float v = cos(gam-acac)*exp(-(bfactor/4.0f * s*s));
-				d[x * 2 + ynx] = fabs(v);
-				d[x * 2 + ynx + 1] = 0;
-			}
-		}
-	}
-	else if (type == CTF_INTEN) {
-		for (int y = -ny/2; y < ny/2; y++) {
-			int y2=(y+ny)%ny;
-			int ynx = y2 * nx;
+	compute_2d_complex_rows(&d[0], &types[0], (int)types.size(), nx, ny);
 
-			for (int x = 0; x < nx / 2; x++) {
-				float s = (float)Util::hypot_fast(x,y ) * ds;
-				float gam;
-				if (dfdiff==0) gam=-g1*s*s*s*s+g2*defocus*s*s;
-				else gam=-g1*s*s*s*s+g2*df(atan2((float)y,(float)x))*s*s;
-				float v = cos(gam-acac)*exp(-(bfactor/4.0f * s*s));
-				d[x * 2 + ynx] = v*v;
-				d[x * 2 + ynx + 1] = 0;
-			}
-		}
-	}
-	else if (type == CTF_POWEVAL) {
-		for (int y = -ny/2; y < ny/2; y++) {
-			int y2=(y+ny)%ny;
-			int ynx = y2 * nx;
+	for (size_t i = 0; i < images.size(); i++) images[i]->update();
+}
 
-			for (int x = 0; x < nx / 2; x++) {
-				float s = (float)Util::hypot_fast(x,y ) * ds;
-				float gam;
-				// mf is used to gradually "turn on" the curve as we approach 20 A
-				float mf=1.0;
-				if (s<.04) mf=0.0;
-				else if (s<.05) mf=1.0-exp(-pow((s-.04f)*300.0f,2.0f));
-				if (dfdiff==0) gam=-g1*s*s*s*s+g2*defocus*s*s;
-				else gam=-g1*s*s*s*s+g2*df(atan2((float)y,(float)x))*s*s;
-				float v = cos(gam-acac);
-				if (v>0.9) v=exp(-(50.0f/4.0f * s*s));
-				else v=0;
-				d[x * 2 + ynx] = mf*v*v;
-				d[x * 2 + ynx + 1] = 0;
-			}
-		}
-	}
-	else if (type == CTF_SIGN) {
-		for (int y = -ny/2; y < ny/2; y++) {
-			int y2=(y+ny)%ny;
-			int ynx = y2 * nx;
-			for (int x = 0; x < nx / 2; x++) {
-				float s = (float)Util::hypot_fast(x,y ) * ds;
-				float gam;
-				if (dfdiff==0) gam=-g1*s*s*s*s+g2*defocus*s*s;
-				else gam=-g1*s*s*s*s+g2*df(atan2((float)y,(float)x))*s*s;
-				float v = cos(gam-acac);
-				d[x * 2 + ynx] = v<0?-1.0:1.0;
-				d[x * 2 + ynx + 1] = 0;
-			}
-		}
-	}
-	else if (type == CTF_FITREF) {
-		for (int y = -ny/2; y < ny/2; y++) {
-			int y2=(y+ny)%ny;
-			int ynx = y2 * nx;
+// Fills the stored half of each output with the requested CTF curve. The terms the
+// curves share (s^2, gamma, cos(gamma-phase), B-factor envelope) are evaluated once
+// per row into contiguous buffers, in loops simple enough for the compiler to vectorize.
+void EMAN2Ctf::compute_2d_complex_rows(float **outs, const CtfType *types, int ntypes, int nx, int ny)
+{
+	std::shared_ptr<const CtfGeometry> geom = ctf_geometry(nx, ny);
+	const int nhx = nx / 2;
 
-			for (int x = 0; x < nx / 2; x++) {
-				float s = (float)Util::hypot_fast(x,y ) * ds;
-				// We exclude very low frequencies from consideration due to the strong structure factor
-				if (s<.04) {
-					d[x * 2 + ynx] = 0;
-					d[x * 2 + ynx + 1] = 0;
-					continue;
-				}
-				// Rather than suddenly "turning on" the CTF, we do it gradually
-				float mf=1.0;
-				if (s<.05) {
-					mf=1.0-exp(-pow((s-.04f)*300.0f,2.0f));
-				}
-				float gam;
-				if (dfdiff==0) gam=-g1*s*s*s*s+g2*defocus*s*s;
-				else gam=-g1*s*s*s*s+g2*df(atan2((float)y,(float)x))*s*s;
-				float v = cos(gam-acac)*exp(-(bfactor/4.0f * s*s));
-				d[x * 2 + ynx] = mf*v*v;
-				d[x * 2 + ynx + 1] = 0;
-			}
+	float ds = 1.0f / (apix * ny);
+	float g1=M_PI/2.0*cs*1.0e7*pow(lambda(),3.0f);	// s^4 coefficient for gamma, cached in a variable for simplicity (maybe speed? depends on the compiler)
+	float g2=M_PI*lambda()*10000.0;					// s^2 coefficient for gamma
+//	float acac=acos(ampcont/100.0);					// instead of ac*cos(g)+sqrt(1-ac^2)*sin(g), we can use cos(g-acos(ac)) and save a trig op
+	float acac=M_PI/2.0-get_phase();
+	// df(ang) = defocus + dfdiff/2*cos(2 ang - 2 dfang), expanded so the per pixel angle terms come from the table
+	float hdd = dfdiff / 2.0f;
+	float ca = cos(2.0f*M_PI/180.0f*dfang);
+	float sa = sin(2.0f*M_PI/180.0f*dfang);
+	float benv = bfactor / 4.0f;
+
+	bool need_ctf = false, need_env = false;
+	for (int t = 0; t < ntypes; t++) {
+		switch (types[t]) {
+		case CTF_AMP: case CTF_ABS: case CTF_INTEN: case CTF_FITREF: case CTF_TOTAL: case CTF_ALIFILT:
+			need_env = true;
+			need_ctf = true;
+		break;
+		case CTF_POWEVAL: case CTF_SIGN:
+			need_ctf = true;
+		break;
+		case CTF_WIENER_FILTER:
+			if (dsbg==0) printf("Warning, DSBG set to 0\n");
+		break;
+		default:
+		break;
 		}
 	}
-	else if (type == CTF_SNR) {
 
-		for (int y = -ny/2; y < ny/2; y++) {
-			int y2=(y+ny)%ny;
-			int ynx = y2 * nx;
+	vector<float> sv(nhx), s2v(nhx), gam(nhx), ctf(nhx), env(nhx);
 
-			for (int x = 0; x < nx / 2; x++) {
+	for (int y = 0; y < ny; y++) {
+		// same rows as the y = -ny/2 .. ny/2-1 loops this replaced
+		if (ny%2==1 && y == ny/2) continue;
+		const size_t row = (size_t)y * nhx;
+		const float *r = &geom->r[row];
+		const float *c2 = &geom->cos2[row];
+		const float *sn2 = &geom->sin2[row];
+		const int ynx = y * nx;
 
-				float s = (float)Util::hypot_fast(x,y ) * ds;
-				float f = s/dsbg;
-				int j = (int)floor(f);
-				f-=j;
-				if (j>(int)snr.size()-2) d[x*2+ynx]=snr.back();
-				else d[x*2+ynx]=snr[j]*(1.0f-f)+snr[j+1]*f;
-				d[x * 2 + ynx + 1] = 0;
-			}
+		for (int x = 0; x < nhx; x++) {
+			sv[x] = r[x] * ds;
+			s2v[x] = sv[x] * sv[x];
 		}
-		d[0]=0;
-	}
-	else if (type == CTF_SNR_SMOOTH) {
-		for (int y = -ny/2; y < ny/2; y++) {
-			int y2=(y+ny)%ny;
-			int ynx = y2 * nx;
-
-			for (int x = 0; x < nx / 2; x++) {
-
-				float s = (float)Util::hypot_fast(x,y ) * ds;
-				float f = s/dsbg;
-				int j = (int)floor(f);
-				f-=j;
-				if (j>(int)snr.size()-2) d[x*2+ynx]=snr.back();
-				else d[x*2+ynx]=snr[j]*(1.0f-f)+snr[j+1]*f;
-				d[x * 2 + ynx + 1] = 0;
+		if (need_ctf) {
+			for (int x = 0; x < nhx; x++) {
+				float dfv = defocus + hdd * (c2[x] * ca + sn2[x] * sa);
+				gam[x] = -g1 * s2v[x] * s2v[x] + g2 * dfv * s2v[x];
 			}
+			for (int x = 0; x < nhx; x++) ctf[x] = cos(gam[x] - acac);
+		}
+		if (need_env) {
+			for (int x = 0; x < nhx; x++) env[x] = exp(-(benv * s2v[x]));
 		}
-		d[0]=0;
-	}
-	else if (type == CTF_WIENER_FILTER) {
-		if (dsbg==0) printf("Warning, DSBG set to 0\n");
-		for (int y = -ny/2; y < ny/2; y++) {
-			int y2=(y+ny)%ny;
-			int ynx = y2 * nx;
-
-			for (int x = 0; x < nx / 2; x++) {
 
-				float s = (float)Util::hypot_fast(x,y ) * ds;
-				float f = s/dsbg;
-				int j = (int)floor(f);
-				float bg,snrf;
-				f-=j;
-				if (j>(int)snr.size()-2) {
-/*					bg=background.back();
-					d[x*2+ynx]=snr.back()/(snr.back()+1.0);*/
-					d[x*2+ynx]=0;
+		for (int t = 0; t < ntypes; t++) {
+			float *d = outs[t] + ynx;
+			switch (types[t]) {
+			case CTF_BACKGROUND:
+				for (int x = 0; x < nhx; x++) {
+					d[x * 2] = calc_noise(sv[x]);
+					d[x * 2 + 1] = 0;			// The phase is somewhat arbitrary
 				}
-				else {
-					bg=background[j]*(1.0f-f)+background[j+1]*f;
-					snrf=snr[j]*(1.0f-f)+snr[j+1]*f;
-
-//					printf("%d\t%f\n",x,sqrt(snrf/bg)/(snrf+1.0));
-					if (snrf<0) snrf=0.0;
-//					d[x*2+ynx]=sqrt(snrf/bg)/(snrf+1.0);	// Note that this is a Wiener filter with a 1/CTF term to compensate for the filtration already applied, but needs to be multiplied by the structure factor
-					d[x*2+ynx]=snrf/(snrf+1);	// This is just the simple Wiener filter
-
+			break;
+			case CTF_AMP:
+				for (int x = 0; x < nhx; x++) {
+					d[x * 2] = ctf[x] * env[x];
+					d[x * 2 + 1] = 0;
 				}
-				d[x * 2 + ynx + 1] = 0;
-			}
-		}
-		d[0]=0;
-	}
-	else if (type == CTF_TOTAL) {
-
-		for (int y = -ny/2; y < ny/2; y++) {
-			int y2=(y+ny)%ny;
-			int ynx = y2 * nx;
-
-			for (int x = 0; x < nx / 2; x++) {
-				float s = (float)Util::hypot_fast(x,y ) * ds;
-				float gam;
-				if (dfdiff==0) gam=-g1*s*s*s*s+g2*defocus*s*s;
-				else gam=-g1*s*s*s*s+g2*df(atan2((float)y,(float)x))*s*s;
-				float v = cos(gam-acac)*exp(-(bfactor/4.0f * s*s));
-				d[x * 2 + ynx] = v*v+calc_noise(s);
-				d[x * 2 + ynx + 1] = 0;
-//				if ((x==101||x==100) && y2==79) printf("%f %f %f %f\n",s,gam,v,d[x * 2 + ynx]);
+			break;
+			case CTF_ABS:
+				for (int x = 0; x < nhx; x++) {
+					d[x * 2] = fabs(ctf[x] * env[x]);
+					d[x * 2 + 1] = 0;
+				}
+			break;
+			case CTF_INTEN:
+				for (int x = 0; x < nhx; x++) {
+					float v = ctf[x] * env[x];
+					d[x * 2] = v * v;
+					d[x * 2 + 1] = 0;
+				}
+			break;
+			case CTF_POWEVAL:
+				for (int x = 0; x < nhx; x++) {
+					float s = sv[x];
+					// mf is used to gradually "turn on" the curve as we approach 20 A
+					float mf=1.0;
+					if (s<.04) mf=0.0;
+					else if (s<.05) mf=1.0-exp(-pow((s-.04f)*300.0f,2.0f));
+					float v = ctf[x];
+					if (v>0.9) v=exp(-(50.0f/4.0f * s*s));
+					else v=0;
+					d[x * 2] = mf*v*v;
+					d[x * 2 + 1] = 0;
+				}
+			break;
+			case CTF_SIGN:
+				for (int x = 0; x < nhx; x++) {
+					d[x * 2] = ctf[x]<0?-1.0:1.0;
+					d[x * 2 + 1] = 0;
+				}
+			break;
+			case CTF_FITREF:
+				for (int x = 0; x < nhx; x++) {
+					float s = sv[x];
+					// We exclude very low frequencies from consideration due to the strong structure factor
+					if (s<.04) {
+						d[x * 2] = 0;
+						d[x * 2 + 1] = 0;
+						continue;
+					}
+					// Rather than suddenly "turning on" the CTF, we do it gradually
+					float mf=1.0;
+					if (s<.05) {
+						mf=1.0-exp(-pow((s-.04f)*300.0f,2.0f));
+					}
+					float v = ctf[x] * env[x];
+					d[x * 2] = mf*v*v;
+					d[x * 2 + 1] = 0;
+				}
+			break;
+			case CTF_SNR:
+			case CTF_SNR_SMOOTH:
+				for (int x = 0; x < nhx; x++) {
+					float f = sv[x]/dsbg;
+					int j = (int)floor(f);
+					f-=j;
+					if (j>(int)snr.size()-2) d[x*2]=snr.back();
+					else d[x*2]=snr[j]*(1.0f-f)+snr[j+1]*f;
+					d[x * 2 + 1] = 0;
+				}
+			break;
+			case CTF_WIENER_FILTER:
+				for (int x = 0; x < nhx; x++) {
+					float f = sv[x]/dsbg;
+					int j = (int)floor(f);
+					f-=j;
+					if (j>(int)snr.size()-2) {
+						d[x*2]=0;
+					}
+					else {
+						float snrf=snr[j]*(1.0f-f)+snr[j+1]*f;
+						if (snrf<0) snrf=0.0;
+//						d[x*2]=sqrt(snrf/bg)/(snrf+1.0);	// Note that this is a Wiener filter with a 1/CTF term to compensate for the filtration already applied, but needs to be multiplied by the structure factor
+						d[x*2]=snrf/(snrf+1);	// This is just the simple Wiener filter
+					}
+					d[x * 2 + 1] = 0;
+				}
+			break;
+			case CTF_TOTAL:
+				for (int x = 0; x < nhx; x++) {
+					float v = ctf[x] * env[x];
+					d[x * 2] = v*v+calc_noise(sv[x]);
+					d[x * 2 + 1] = 0;
+				}
+			break;
+			case CTF_ALIFILT:
+				// Basically just a CTF weight
+				for (int x = 0; x < nhx; x++) {
+					d[x * 2] = ctf[x] * ctf[x] * env[x];
+					d[x * 2 + 1] = 0;
+				}
+			break;
+			default:
+			break;
 			}
 		}
 	}
-	else if (type == CTF_ALIFILT) {
-		double vt=0;
-		for (int y = -ny/2; y < ny/2; y++) {
-			int y2=(y+ny)%ny;
-			int ynx = y2 * nx;
 
-			for (int x = 0; x < nx / 2; x++) {
-				float s = (float)Util::hypot_fast(x,y ) * ds;
-				float gam;
-				if (dfdiff==0) gam=-g1*s*s*s*s+g2*defocus*s*s;
-				else gam=-g1*s*s*s*s+g2*df(atan2((float)y,(float)x))*s*s;
-				// this make values near the zero crossings negative to cancel out 0,0 correlation
-//				float v = (pow(cos(gam-acac),2.0)-0.5)*exp(-(bfactor/4.0f * s*s));
-				// Basically just a CTF weight
-				float v = (pow((float)cos(gam-acac),2.0f))*exp(-(bfactor/4.0f * s*s));
-				//v*=v;
-				//v=fabs(v);
-				d[x * 2 + ynx] = v;
-				d[x * 2 + ynx + 1] = 0;
-				vt+=v;
-			}
+	for (int t = 0; t < ntypes; t++) {
+		switch (types[t]) {
+		case CTF_SNR: case CTF_SNR_SMOOTH: case CTF_WIENER_FILTER:
+			outs[t][0]=0;
+		break;
+		case CTF_BACKGROUND: case CTF_AMP: case CTF_ABS: case CTF_INTEN: case CTF_POWEVAL:
+		case CTF_SIGN: case CTF_FITREF: case CTF_TOTAL: case CTF_ALIFILT:
+		break;
+		default:
+			printf("Unknown CTF image mode\n");
+		break;
 		}
-		vt/=nx*ny/2;
-//		for (size_t i=0; i<image->get_xsize()*image->get_ysize(); i+=2) d[i]=(d[i]-vt)<0?-1.0:1.0;
-//		for (size_t i=0; i<image->get_xsize()*image->get_ysize(); i+=2) d[i]=(d[i]-vt);
 	}
-	else printf("Unknown CTF image mode\n");
-
-	image->update();
 }
 
 
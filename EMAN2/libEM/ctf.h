@@ -263,6 +263,13 @@ namespace EMAN
 		void compute_2d_real(EMData * image, CtfType type, XYData * struct_factor = 0);
 		void compute_2d_complex(EMData * image, CtfType type, XYData * struct_factor = 0);
 
+		/** Computes several CTF curves into complex images in a single pass, so the
+		 * terms they share are evaluated once. images[i] receives types[i], as
+		 * compute_2d_complex(images[i], types[i]) would produce it. All images must
+		 * have the same (nx, nx-2) size.
+		 */
+		void compute_2d_complex_multi(const vector<EMData *> & images, const vector<CtfType> & types);
+
 		int from_string(const string & ctf);
 		string to_string() const;
 
@@ -289,6 +296,8 @@ namespace EMAN
 		void set_phase(float phase);
 		private:
 
+		void compute_2d_complex_rows(float **outs, const CtfType *types, int ntypes, int nx, int ny);
+
 		// Electron wavelength in A
 		inline float lambda() const
 		{
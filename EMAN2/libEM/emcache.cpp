@@ -36,181 +36,308 @@
 #include "imageio.h"
 #include "util.h"
 #include <stdio.h>
-#include <pthread.h>
+#include <functional>
 using namespace EMAN;
 
-void *thread_clean( void *ptr ) {
-    while (1) {
-        sleep(1);
-        GlobalCache::instance()->clean();
-    }
-}
-void thread_start() {
-    pthread_t thread1;
-    pthread_create(&thread1,NULL,&thread_clean,NULL);
-}
+namespace {
+	// a handle opened read-write can also serve readers
+	bool mode_serves(int current, int request)
+	{
+		return current == request || (current == ImageIO::READ_WRITE && request == ImageIO::READ_ONLY);
+	}
 
+	void delete_all(vector<ImageIO*> & ios)
+	{
+		for (size_t i = 0; i < ios.size(); i++) delete ios[i];
+		ios.clear();
+	}
+}
 
 // GlobalCache
-GlobalCache *GlobalCache::global_cache = 0;
-
 GlobalCache::GlobalCache()
+:	ntimers(0), tick(0), epoch(clock::now()), stopping(false)
 {
-    // pthread_mutex_init(&mutex, NULL);
-    thread_start();
 }
 
 GlobalCache::~GlobalCache()
 {
-    clean();
-    pthread_mutex_destroy(&mutex);
+	{
+		std::lock_guard<std::mutex> lock(timer_mutex);
+		stopping = true;
+	}
+	timer_cv.notify_one();
+	if (timer_thread.joinable()) timer_thread.join();
+	clean();
 }
 
 GlobalCache *GlobalCache::instance()
 {
-	if (!global_cache) {
-		global_cache = new GlobalCache();
-	}
+	static GlobalCache *global_cache = new GlobalCache();
 	return global_cache;
 }
 
+GlobalCache::Shard & GlobalCache::shard_for(const string & filename)
+{
+	return shards[std::hash<string>()(filename) % NSHARDS];
+}
+
+long GlobalCache::current_tick() const
+{
+	return (long)std::chrono::duration_cast<std::chrono::seconds>(clock::now() - epoch).count();
+}
+
+// Closes the idle handles in slots that cannot serve mode rw (all of them if rw<0) and
+// marks busy ones stale so they close when released. Caller holds the shard lock
+// and deletes the returned ios after dropping it.
+void GlobalCache::retire_idle(vector<Slot> & slots, vector<ImageIO*> & closed, int rw)
+{
+	for (size_t i = 0; i < slots.size(); ) {
+		Slot & s = slots[i];
+		if (rw >= 0 && mode_serves(s.rw, rw)) {
+			i++;
+		}
+		else if (s.refs > 0) {
+			s.stale = true;
+			i++;
+		}
+		else {
+			closed.push_back(s.io);
+			slots.erase(slots.begin() + i);
+		}
+	}
+}
+
 ImageIO *GlobalCache::get_imageio(const string & filename, int rw)
 {
-    pthread_mutex_lock(&mutex);
+	Shard & shard = shard_for(filename);
+	vector<ImageIO*> closed;
+	ImageIO *io = 0;
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
 #ifdef DEBUG_CACHE
-    printf("get_imageio: filename: %s, rw: %d\n", filename.c_str(), rw);
+		printf("get_imageio: filename: %s, rw: %d\n", filename.c_str(), rw);
 #endif
+		map < string, vector<Slot> >::iterator it = shard.files.find(filename);
+		if (it == shard.files.end()) return 0;
+
+		vector<Slot> & slots = it->second;
+		// a handle in another mode must not stay open beside the one about to be opened,
+		// e.g. a truncating write, and read-only handles would not see what is written
+		retire_idle(slots, closed, rw);
 
-    if (file_imageio.count(filename) == 0) {
-        // printf("get_imageio: no cached imageio!\n");
-        pthread_mutex_unlock(&mutex);
-        return 0;        
-    }     
-    
-    ImageIO *io = file_imageio[filename];    
+		// prefer a handle this thread already holds, then an idle one
+		std::thread::id me = std::this_thread::get_id();
+		Slot *use = 0;
+		for (size_t i = 0; i < slots.size() && !use; i++) {
+			if (!slots[i].stale && slots[i].refs > 0 && slots[i].owner == me && mode_serves(slots[i].rw, rw)) use = &slots[i];
+		}
+		for (size_t i = 0; i < slots.size() && !use; i++) {
+			if (!slots[i].stale && slots[i].refs == 0 && mode_serves(slots[i].rw, rw)) use = &slots[i];
+		}
+
+		if (use) {
+			use->refs++;
+			use->owner = me;
+			use->gen = ++shard.next_gen;
+			io = use->io;
 #ifdef DEBUG_CACHE
-    printf("get_imageio:      found cached; refs: %d, current rw: %d, request rw: %d\n", file_ref[filename], file_rw[filename], rw);
+			printf("get_imageio:      found cached; refs: %d, rw: %d\n", use->refs, use->rw);
 #endif
-    time_t t = time(0);
-    file_time[filename] = time(0);
-    // printf("get_imageio:      updated time\n");
-    if (file_rw[filename] == rw) {
-        // current == request
-        file_ref[filename]++;
-        // printf("get_imageio:      ref += 1 to %d\n", file_ref[filename]);
-    } else if (file_rw[filename] == 2 && rw == 1) {
-        // current == read_write, request == read
-        file_ref[filename]++;
-        // printf("get_imageio:      ref += 1 to %d (passing write mode to read request)\n", file_ref[filename]);
-    } else if (file_ref[filename] == 0) {
-        // current != request, no open handles
-        // printf("get_imageio:      re-opening in mode %d\n", rw);
-        this->delete_imageio(filename);
-        io = 0;        
-    } else {
-        // current != request, open handles
-        // current is read, request is write -- we can't make this change with open handles. How to fail?
-        file_ref[filename]++;
-        printf("GlobalCache::get_imageio: %s: Cannot switch mode %d to %d with open references!\n", filename.c_str(), file_rw[filename], rw);
-    }
-    pthread_mutex_unlock(&mutex);
-    return io;
-}
-
-void GlobalCache::delete_imageio(const string & filename) {
-    // Lock acquired in caller
-    if (file_imageio.count(filename) == 0) {
-        // printf("delete_imageio: Not in cache\n");
-    } else if (file_ref[filename] == 0) {
-        ImageIO *io = file_imageio[filename];
-        file_imageio.erase(filename);
-        delete io;
-    }
-}
-
-void GlobalCache::close_imageio(const string & filename) {
-    pthread_mutex_lock(&mutex);
+		}
+		if (slots.empty()) shard.files.erase(it);
+	}
+	delete_all(closed);
+	return io;
+}
+
+void GlobalCache::add_imageio(const string & filename, int rw, int persist, ImageIO * io)
+{
+	if (!io || persist <= 0) return;
+
+	Shard & shard = shard_for(filename);
+	vector<ImageIO*> closed;
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
 #ifdef DEBUG_CACHE
-    printf("close_imageio: filename: %s\n", filename.c_str());
+		printf("add_imageio: filename %s, rw %d, persist %d\n", filename.c_str(), rw, persist);
 #endif
-    if (file_imageio.count(filename) > 0) {
-        ImageIO *io = file_imageio[filename];
-        // Decrement the reference and update the access time.
-        file_ref[filename]--;
-        file_time[filename] = time(0);
-        // printf("close_imageio:      ref -= 1 to %d\n", file_ref[filename]);
-        if (file_ref[filename] == 0 && file_persist[filename] == 0) {
-            // printf("close_imageio:      auto closing!\n");
-            this->delete_imageio(filename);
-        }
-    } else {
-        // printf("close_imageio:      No ImageIO to close!\n");
-    }
-    pthread_mutex_unlock(&mutex);
+		vector<Slot> & slots = shard.files[filename];
+		retire_idle(slots, closed, rw);
+
+		bool present = false;
+		for (size_t i = 0; i < slots.size(); i++) {
+			if (slots[i].io == io) present = true;
+		}
+		if (!present && (int)slots.size() < MAX_SLOTS) {
+			Slot s;
+			s.io = io;
+			s.rw = rw;
+			s.refs = 1;
+			s.persist = persist;
+			s.gen = ++shard.next_gen;
+			s.stale = false;
+			s.owner = std::this_thread::get_id();
+			slots.push_back(s);
+		}
+		if (slots.empty()) shard.files.erase(filename);
+	}
+	delete_all(closed);
 }
 
-void GlobalCache::add_imageio(const string & filename, int rw, int persist, ImageIO * io)
+bool GlobalCache::close_imageio(const string & filename, const ImageIO * io)
 {
-    pthread_mutex_lock(&mutex);    
+	Shard & shard = shard_for(filename);
+	ImageIO *closed = 0;
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
 #ifdef DEBUG_CACHE
-    printf("add_imageio: filename %s, rw %d, persist %d\n", filename.c_str(), rw, persist);
+		printf("close_imageio: filename: %s\n", filename.c_str());
 #endif
-    if (file_imageio.count(filename) > 0) {
-        // Todo: How to handle error if file is already in cache?
-        // printf("File already in cache.")
-    } else if (io && persist > 0) {
-        // Todo: Make a class to hold all these values and the ImageIO.
-        file_imageio[filename] = io;
-        file_ref[filename] = 1;
-		file_rw[filename] = rw;
-        file_time[filename] = time(0);
-        file_persist[filename] = persist;
+		map < string, vector<Slot> >::iterator it = shard.files.find(filename);
+		if (it == shard.files.end()) return false;
+
+		vector<Slot> & slots = it->second;
+		size_t i = 0;
+		while (i < slots.size() && slots[i].io != io) i++;
+		if (i == slots.size()) return false;
+
+		Slot & s = slots[i];
+		if (--s.refs > 0) return true;
+
+		if (s.stale) {
+			closed = s.io;
+			slots.erase(slots.begin() + i);
+			if (slots.empty()) shard.files.erase(it);
+		}
+		else {
+			schedule(filename, s.io, s.gen, s.persist);
+		}
+	}
+	delete closed;
+	return true;
+}
+
+void GlobalCache::delete_imageio(const string & filename)
+{
+	Shard & shard = shard_for(filename);
+	vector<ImageIO*> closed;
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		map < string, vector<Slot> >::iterator it = shard.files.find(filename);
+		if (it == shard.files.end()) return;
+		retire_idle(it->second, closed, -1);
+		if (it->second.empty()) shard.files.erase(it);
 	}
-    pthread_mutex_unlock(&mutex);
+	delete_all(closed);
 }
 
-int GlobalCache::contains(const string & filename) {
-    pthread_mutex_lock(&mutex);
-    int ret = 0;
-    if (file_imageio.count(filename) > 0) {
-        ret = 1;
-    }
-    pthread_mutex_unlock(&mutex);    
-    return ret;
+int GlobalCache::contains(const string & filename)
+{
+	Shard & shard = shard_for(filename);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	return shard.files.count(filename) > 0 ? 1 : 0;
 }
 
-void GlobalCache::clean() {
-    pthread_mutex_lock(&mutex);    
+void GlobalCache::clean()
+{
+	vector<ImageIO*> closed;
+	for (int n = 0; n < NSHARDS; n++) {
+		Shard & shard = shards[n];
+		std::lock_guard<std::mutex> lock(shard.mutex);
 #ifdef DEBUG_CACHE
-    printf("clean: %ld items in cache\n", file_imageio.size());
+		printf("clean: %ld files in shard %d\n", shard.files.size(), n);
 #endif
-    
-    // Find cached items to close
-    vector<string> toclose;
-    time_t now = time(0);
-    int seconds;
-    string filename;
-    for (map<string, ImageIO*>::iterator iter=file_imageio.begin(); iter!=file_imageio.end(); ++iter) {
-        filename = iter->first;
-        seconds = int(difftime(now, file_time[filename]));
+		map < string, vector<Slot> >::iterator it = shard.files.begin();
+		while (it != shard.files.end()) {
+			retire_idle(it->second, closed, -1);
+			if (it->second.empty()) shard.files.erase(it++);
+			else ++it;
+		}
+	}
+	delete_all(closed);
+}
+
+// Called with the owning shard locked (lock order is always shard, then timer)
+void GlobalCache::schedule(const string & filename, const ImageIO * io, unsigned long gen, int seconds)
+{
+	std::lock_guard<std::mutex> lock(timer_mutex);
+	long now = current_tick();
+	if (ntimers == 0) tick = now;
+
+	Timer t;
+	t.filename = filename;
+	t.io = io;
+	t.gen = gen;
+	t.deadline = now + seconds;
+	wheel[t.deadline % WHEEL_SIZE].push_back(t);
+	ntimers++;
+
+	if (!timer_thread.joinable()) timer_thread = std::thread(&GlobalCache::run_timers, this);
+	else if (ntimers == 1) timer_cv.notify_one();
+}
+
+// Sleeps until the next tick while timers are pending, and indefinitely otherwise.
+// Timers due at each tick are collected under the timer lock and expired after it
+// is dropped.
+void GlobalCache::run_timers()
+{
+	std::unique_lock<std::mutex> lock(timer_mutex);
+	while (!stopping) {
+		if (ntimers == 0) {
+			timer_cv.wait(lock);
+			continue;
+		}
+		timer_cv.wait_until(lock, epoch + std::chrono::seconds(tick + 1));
+
+		long now = current_tick();
+		if (now - tick > WHEEL_SIZE) tick = now - WHEEL_SIZE;	// every bucket is visited once at most
+
+		vector<Timer> due;
+		while (tick < now) {
+			tick++;
+			vector<Timer> & bucket = wheel[tick % WHEEL_SIZE];
+			for (size_t i = 0; i < bucket.size(); ) {
+				if (bucket[i].deadline <= now) {
+					due.push_back(bucket[i]);
+					bucket[i] = bucket.back();
+					bucket.pop_back();
+				}
+				else i++;		// a later turn of the wheel
+			}
+		}
+		if (due.empty()) continue;
+		ntimers -= due.size();
+
+		lock.unlock();
+		for (size_t i = 0; i < due.size(); i++) expire(due[i]);
+		lock.lock();
+	}
+}
+
+// A timer only closes the handle if it has stayed idle since it was scheduled
+void GlobalCache::expire(const Timer & t)
+{
+	Shard & shard = shard_for(t.filename);
+	ImageIO *closed = 0;
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		map < string, vector<Slot> >::iterator it = shard.files.find(t.filename);
+		if (it == shard.files.end()) return;
+
+		vector<Slot> & slots = it->second;
+		for (size_t i = 0; i < slots.size(); i++) {
+			if (slots[i].io == t.io && slots[i].gen == t.gen && slots[i].refs == 0) {
 #ifdef DEBUG_CACHE
-        printf("clean:       filename: %s, rw: %d, ref: %d, last access: %d, persist: %d\n", filename.c_str(), file_rw[filename], file_ref[filename], seconds, file_persist[filename]);
+				printf("clean:       closing %s, rw: %d\n", t.filename.c_str(), slots[i].rw);
 #endif
-        if (seconds >= file_persist[filename]) {
-            // printf("clean:      marking to close %s...\n", filename.c_str());
-            toclose.push_back(filename);
-        }
-    }
-    
-    // Close the selected items
-    for(vector<string>::iterator iter=toclose.begin(); iter!=toclose.end(); iter++) {
-        filename = *iter;
-        // printf("clean: closing %s...\n", filename.c_str());        
-        this->delete_imageio(filename);
-    }
-    
-    pthread_mutex_unlock(&mutex);
+				closed = slots[i].io;
+				slots.erase(slots.begin() + i);
+				break;
+			}
+		}
+		if (slots.empty()) shard.files.erase(it);
+	}
+	delete closed;
 }
 
 #endif // IMAGEIO_CACHE
-
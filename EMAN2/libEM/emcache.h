@@ -37,37 +37,111 @@
 #include <cstdlib>
 #include <string>
 #include <map>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
 using std::string;
 using std::map;
+using std::vector;
 
 namespace EMAN
 {
 	class ImageIO;
 
-	/* GlobalCache is a Singleton class that handles cache across EMAN. */
+	/* GlobalCache is a Singleton class that keeps ImageIO objects open across EMAN.
+	 *
+	 * Files are spread over NSHARDS independently locked shards, so threads working
+	 * on different files never wait on each other. Each file may have up to
+	 * MAX_SLOTS open handles. A handle is lent to one thread at a time (nested use
+	 * by the same thread shares it); a second thread reading the same stack gets
+	 * an idle handle or opens its own, rather than sharing non thread-safe reader
+	 * state. Opening a file in one mode retires its handles that cannot serve that
+	 * mode (a read-write handle also serves readers), so e.g. a truncating write
+	 * never finds the file still open in another mode.
+	 *
+	 * A handle whose last reference is released stays open for 'persist' seconds.
+	 * Expiry is driven by a timer wheel with 1 second ticks, serviced by a thread
+	 * that sleeps until the next deadline and not at all while nothing is idle.
+	 */
 	class GlobalCache
 	{
 	  public:
 		static GlobalCache *instance();
+
+		/** @return A cached handle usable by the calling thread in mode rw, with
+		 * a reference taken, or 0 if the caller should open its own. */
 		ImageIO *get_imageio(const string & filename, int rw);
-        int contains(const string & filename);
+		int contains(const string & filename);
+
+		/** Cache a newly opened io, holding one reference for the caller.
+		 * Ignored if persist is 0 or the file already has MAX_SLOTS handles. */
 		void add_imageio(const string & filename, int rw, int persist, ImageIO * io);
-        void close_imageio(const string & filename);
-        void delete_imageio(const string & filename);
-        void clean();
+
+		/** Release a reference taken by get_imageio/add_imageio.
+		 * @return false if io is not cached, in which case the caller owns it. */
+		bool close_imageio(const string & filename, const ImageIO * io);
+
+		/** Close the idle handles of filename; busy ones close when released. */
+		void delete_imageio(const string & filename);
+
+		/** Close every idle handle now. */
+		void clean();
 
 	  private:
-        pthread_mutex_t mutex;          
-		static GlobalCache *global_cache;
-		map < string, ImageIO* >file_imageio;
-		map < string, int >file_rw;
-        map < string, int >file_ref;
-        map < string, int >file_time;
-        map < string, int >file_persist;
+		typedef std::chrono::steady_clock clock;
+
+		static const int NSHARDS = 16;
+		static const int MAX_SLOTS = 4;
+		static const int WHEEL_SIZE = 64;
+
+		struct Slot {
+			ImageIO *io;
+			int rw;
+			int refs;
+			int persist;
+			unsigned long gen;		// renewed on every acquire, invalidates pending timers
+			bool stale;				// close on release instead of going idle
+			std::thread::id owner;
+		};
+
+		struct Shard {
+			std::mutex mutex;
+			map < string, vector<Slot> > files;
+			unsigned long next_gen;
+			Shard() : next_gen(0) {}
+		};
+
+		struct Timer {
+			string filename;
+			const ImageIO *io;
+			unsigned long gen;
+			long deadline;			// tick
+		};
+
+		Shard shards[NSHARDS];
+
+		std::mutex timer_mutex;
+		std::condition_variable timer_cv;
+		vector<Timer> wheel[WHEEL_SIZE];
+		size_t ntimers;
+		long tick;					// last tick serviced
+		clock::time_point epoch;
+		bool stopping;
+		std::thread timer_thread;
+
+		Shard & shard_for(const string & filename);
+		long current_tick() const;
+		void schedule(const string & filename, const ImageIO * io, unsigned long gen, int seconds);
+		void run_timers();
+		void expire(const Timer & t);
+		static void retire_idle(vector<Slot> & slots, vector<ImageIO*> & closed, int rw);
 
 		GlobalCache();
 		~GlobalCache();
-
+		GlobalCache(const GlobalCache &);
+		GlobalCache & operator=(const GlobalCache &);
 	};
 
 }
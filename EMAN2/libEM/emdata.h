@@ -63,6 +63,7 @@ namespace EMAN
 	class XYData;
 	class Transform;
 	class GLUtil;
+	class ImageStackReader;
 	class EMBytes: public std::string {};
 
 	typedef boost::multi_array_ref<float, 2> MArray2D;
@@ -81,6 +82,8 @@ namespace EMAN
 	class EMData
 	{
 		friend class GLUtil;
+		friend class ImageStackReader;
+		friend class ImageStackWriter;
 
 		/** For all image I/O */
 		#include "emdata_io.h"
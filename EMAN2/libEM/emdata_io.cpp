@@ -39,7 +39,12 @@
 using std::cout;
 using std::endl;
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <memory>
+#include <set>
+#include <thread>
 #include <sys/stat.h>
 
 using std::shared_ptr;
@@ -121,10 +126,297 @@ void EMData::read_image(const string & filename, int img_index, bool nodata,
 	EXITFUNC;
 }
 
-void EMData::read_binedimage(const string & filename, int img_index, int binfactor, bool fast, bool is_3d)
+namespace {
+	/** Runs worker(t) for t in [0, nthreads), worker(0) on the calling thread, and rethrows
+	 * the first exception any of them raised */
+	template<class F>
+	void run_workers(int nthreads, F worker)
+	{
+		vector<std::exception_ptr> errs(nthreads);
+		auto guarded = [&](int t) {
+			try { worker(t); }
+			catch (...) { errs[t] = std::current_exception(); }
+		};
+
+		vector<std::thread> threads;
+		for (int t = 1; t < nthreads; t++) threads.push_back(std::thread(guarded, t));
+		guarded(0);
+		for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+		for (int t = 0; t < nthreads; t++) {
+			if (errs[t]) std::rethrow_exception(errs[t]);
+		}
+	}
+
+	/** Reads frames [f0, f1) through imageio and adds them into dst */
+	void add_frames(ImageIO *imageio, int f0, int f1, float *dst, vector<float> & frame)
+	{
+		const size_t imgsize = frame.size();
+		Dict hdr;
+		for (int f = f0; f < f1; f++) {
+			if (imageio->read_header(hdr, f))
+				throw ImageReadException(imageio->get_filename(), "imageio read header failed");
+			if ((size_t)(int)hdr["nx"] * (int)hdr["ny"] * (int)hdr["nz"] != imgsize)
+				throw ImageDimensionException("movie frames differ in size");
+			if (imageio->read_data(&frame[0], f))
+				throw ImageReadException(imageio->get_filename(), "imageio read data failed");
+			for (size_t i = 0; i < imgsize; i++) dst[i] += frame[i];
+		}
+	}
+
+	/** Whether reading frames [first, first + count) goes through HDF5, either because the
+	 * movie is HDF or because it is a LST/LSX list referencing HDF images */
+	bool reads_hdf(ImageIO *imageio, const string & filename, EMUtil::ImageType type, int first, int count)
+	{
+		if (type == EMUtil::IMAGE_HDF) return true;
+		if (type != EMUtil::IMAGE_LST && type != EMUtil::IMAGE_LSTFAST) return false;
+
+		vector<int> indices(count);
+		for (int i = 0; i < count; i++) indices[i] = first + i;
+		vector<EMObject> src = imageio->read_header_column(type == EMUtil::IMAGE_LST ? "source_path" : "data_source", indices);
+
+		std::set<string> checked;
+		for (size_t i = 0; i < src.size(); i++) {
+			if (src[i].is_null()) continue;
+			string path = (const char *)src[i];
+			if (!checked.insert(path).second) continue;
+			if (EMUtil::get_image_type(path) == EMUtil::IMAGE_HDF) return true;
+		}
+		return false;
+	}
+
+	/** Sums frames [first, first + count) in consecutive groups of group frames, group g into
+	 * sums[g], each imgsize floats. EER frames are decoded in parallel by EerIO. Otherwise every
+	 * thread reads through its own ImageIO, so TIFF, DM4, SER, MRC, ... movies are read in
+	 * parallel; the caller's imageio is used on the calling thread. Whole groups are handed
+	 * out to threads when there are enough of them, else the frames of each group are split
+	 * between threads summing into private buffers. */
+	void sum_frame_groups(ImageIO *imageio, const string & filename, EMUtil::ImageType imgtype,
+						  int first, int count, int group, const vector<float *> & sums,
+						  size_t imgsize, int nthreads)
+	{
+		const int ngroups = (int)sums.size();
+		const int last = first + count;
+
+		EerIO *eerio = dynamic_cast<EerIO *>(imageio);
+		if (eerio) {
+			for (int g = 0; g < ngroups; g++) {
+				int f0 = first + g * group;
+				eerio->read_frames(sums[g], f0, std::min(group, last - f0), nthreads);
+			}
+			return;
+		}
+
+		for (int g = 0; g < ngroups; g++) std::fill(sums[g], sums[g] + imgsize, 0.0f);
+
+		// HDF5 is not thread safe
+		EMUtil::ImageType type = imgtype != EMUtil::IMAGE_UNKNOWN ? imgtype : EMUtil::get_image_type(filename);
+		if (nthreads != 1 && reads_hdf(imageio, filename, type, first, count)) nthreads = 1;
+
+		if (nthreads <= 0) nthreads = (int)std::thread::hardware_concurrency();
+		if (nthreads > count) nthreads = count;
+		if (nthreads < 1) nthreads = 1;
+
+		if (ngroups >= nthreads) {
+			std::atomic<int> next(0);
+			run_workers(nthreads, [&](int t) {
+				std::unique_ptr<ImageIOHandle> own(t ? new ImageIOHandle(filename, ImageIO::READ_ONLY, imgtype) : 0);
+				ImageIO *io = own ? own->get() : imageio;
+				if (!io) throw ImageFormatException("cannot create an image io");
+
+				vector<float> frame(imgsize);
+				for (int g = next++; g < ngroups; g = next++) {
+					int f0 = first + g * group;
+					add_frames(io, f0, std::min(f0 + group, last), sums[g], frame);
+				}
+			});
+			return;
+		}
+
+		// as in EerIO::read_frames, keep the private sums under ~1 GB
+		size_t max_extra = ((size_t)1 << 30) / (imgsize * sizeof(float));
+		if ((size_t)nthreads > max_extra + 1) nthreads = (int)max_extra + 1;
+
+		vector<vector<float>> partial(nthreads - 1, vector<float>(imgsize));
+		for (int g = 0; g < ngroups; g++) {
+			const int f0 = first + g * group;
+			const int n = std::min(group, last - f0);
+			const int nt = std::min(nthreads, n);
+
+			run_workers(nt, [&](int t) {
+				std::unique_ptr<ImageIOHandle> own(t ? new ImageIOHandle(filename, ImageIO::READ_ONLY, imgtype) : 0);
+				ImageIO *io = own ? own->get() : imageio;
+				if (!io) throw ImageFormatException("cannot create an image io");
+
+				float *dst = sums[g];
+				if (t) {
+					dst = &partial[t - 1][0];
+					std::fill(dst, dst + imgsize, 0.0f);
+				}
+				vector<float> frame(imgsize);
+				add_frames(io, f0 + n * t / nt, f0 + n * (t + 1) / nt, dst, frame);
+			});
+
+			for (int t = 1; t < nt; t++) {
+				const float *p = &partial[t - 1][0];
+				float *s = sums[g];
+				for (size_t i = 0; i < imgsize; i++) s[i] += p[i];
+			}
+		}
+	}
+
+	void check_gain(const EMData *gain, int nx, int ny, int nz)
+	{
+		if (gain && (gain->get_xsize() != nx || gain->get_ysize() != ny || gain->get_zsize() != nz))
+			throw ImageDimensionException("gain reference and movie frames differ in size");
+	}
+
+	void apply_gain(const EMData *gain, float *data, size_t imgsize)
+	{
+		if (!gain) return;
+		const float *g = gain->get_const_data();
+		for (size_t i = 0; i < imgsize; i++) data[i] *= g[i];
+	}
+}
+
+void EMData::read_frame_sum(const string & filename, int first, int count, int nthreads,
+							EMUtil::ImageType imgtype, const EMData * gain)
 {
 	ENTERFUNC;
 
+	ImageIOHandle imageio(filename, ImageIO::READ_ONLY, imgtype);
+
+	if (!imageio)
+		throw ImageFormatException("cannot create an image io");
+
+	int nimg = imageio->get_nimg();
+	if (first < 0 || count < 1 || first + count > nimg)
+		throw OutofRangeException(0, nimg - 1, first + count - 1, "frame index");
+
+	_read_image(imageio.get(), first, true);
+	check_gain(gain, nx, ny, nz);
+	set_size(nx, ny, nz);
+
+	const size_t imgsize = (size_t)nx * ny * nz;
+	sum_frame_groups(imageio.get(), filename, imgtype, first, count, count,
+					 vector<float *>(1, get_data()), imgsize, nthreads);
+	apply_gain(gain, get_data(), imgsize);
+	update();
+
+	EXITFUNC;
+}
+
+vector<std::shared_ptr<EMData>> EMData::read_frame_sums(const string & filename, int first, int count,
+												int group, int nthreads, EMUtil::ImageType imgtype,
+												const EMData * gain)
+{
+	ENTERFUNC;
+
+	if (group < 1)
+		throw InvalidValueException(group, "frame group size must be positive");
+
+	ImageIOHandle imageio(filename, ImageIO::READ_ONLY, imgtype);
+
+	if (!imageio)
+		throw ImageFormatException("cannot create an image io");
+
+	int nimg = imageio->get_nimg();
+	if (first < 0 || count < 1 || first + count > nimg)
+		throw OutofRangeException(0, nimg - 1, first + count - 1, "frame index");
+
+	// each sum carries the header of its first frame
+	const int ngroups = (count + group - 1) / group;
+	vector<std::shared_ptr<EMData>> sums(ngroups);
+	vector<float *> data(ngroups);
+	for (int g = 0; g < ngroups; g++) {
+		EMData *sum = new EMData();
+		sums[g] = std::shared_ptr<EMData>(sum);
+		sum->_read_image(imageio.get(), first + g * group, true);
+		check_gain(gain, sum->nx, sum->ny, sum->nz);
+		sum->set_size(sum->nx, sum->ny, sum->nz);
+		data[g] = sum->get_data();
+	}
+
+	const size_t imgsize = (size_t)sums[0]->nx * sums[0]->ny * sums[0]->nz;
+	sum_frame_groups(imageio.get(), filename, imgtype, first, count, group, data, imgsize, nthreads);
+	for (int g = 0; g < ngroups; g++) {
+		apply_gain(gain, data[g], imgsize);
+		sums[g]->update();
+	}
+
+	EXITFUNC;
+
+	return sums;
+}
+
+namespace {
+	/** Mean-shrinks one slab of zbin full slices (nx x ny) into out (nx/bin x ny/bin), splitting the
+	 * output rows between nthreads threads */
+	void meanshrink_slab(const float *slab, int nx, int ny, int zbin, int bin, float *out, int nthreads)
+	{
+		const int bnx = nx / bin;
+		const int bny = ny / bin;
+		const float norm = 1.0f / ((float)bin * bin * zbin);
+
+		auto rows = [&](int y0, int y1) {
+			vector<float> acc(bnx);
+			for (int by = y0; by < y1; by++) {
+				std::fill(acc.begin(), acc.end(), 0.0f);
+				for (int z = 0; z < zbin; z++) {
+					for (int y = by * bin; y < (by + 1) * bin; y++) {
+						const float *row = slab + ((size_t)z * ny + y) * nx;
+						for (int bx = 0; bx < bnx; bx++) {
+							const float *p = row + bx * bin;
+							float s = 0;
+							for (int x = 0; x < bin; x++) s += p[x];
+							acc[bx] += s;
+						}
+					}
+				}
+				float *o = out + (size_t)by * bnx;
+				for (int bx = 0; bx < bnx; bx++) o[bx] = acc[bx] * norm;
+			}
+		};
+
+		if (nthreads > bny) nthreads = bny;
+		if (nthreads <= 1) {
+			rows(0, bny);
+			return;
+		}
+
+		vector<std::thread> threads;
+		for (int t = 1; t < nthreads; t++) threads.push_back(std::thread(rows, bny * t / nthreads, bny * (t + 1) / nthreads));
+		rows(0, bny / nthreads);
+		for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+	}
+
+	/** Fourier crops each of the zbin slices of a slab to nx/bin x ny/bin and averages them into out */
+	void fouriershrink_slab(const float *slab, int nx, int ny, int zbin, int bin, float *out)
+	{
+		const int bnx = nx / bin;
+		const int bny = ny / bin;
+		const size_t bsize = (size_t)bnx * bny;
+
+		std::fill(out, out + bsize, 0.0f);
+		EMData slice(nx, ny);
+		for (int z = 0; z < zbin; z++) {
+			memcpy(slice.get_data(), slab + (size_t)z * nx * ny, (size_t)nx * ny * sizeof(float));
+			slice.update();
+			EMData *small = slice.FourTruncate(bnx, bny, 1, true, false);
+			const float *s = small->get_data();
+			for (size_t i = 0; i < bsize; i++) out[i] += s[i] / zbin;
+			delete small;
+		}
+	}
+}
+
+void EMData::read_binedimage(const string & filename, int img_index, int binfactor, bool fast, bool is_3d,
+							 bool fourier, int nthreads)
+{
+	ENTERFUNC;
+
+	if (binfactor < 1) throw InvalidValueException(binfactor, "binfactor must be at least 1");
+
 	ImageIO *imageio = EMUtil::get_imageio(filename, ImageIO::READ_ONLY);
 
 	if (!imageio) {
@@ -150,44 +442,67 @@ void EMData::read_binedimage(const string & filename, int img_index, int binfact
 			}
 			save_byteorder_to_dict(imageio);
 
-			int ori_nx = nx = attr_dict["nx"];
-			int ori_ny = ny = attr_dict["ny"];
-			int ori_nz = nz = attr_dict["nz"];
-			if (!fast) ori_nz-=ori_nz%binfactor;	// makes sure Z is a multiple of binfactor, hack to fix the poor logic in the original routine
+			int ori_nx = attr_dict["nx"];
+			int ori_ny = attr_dict["ny"];
+			int ori_nz = attr_dict["nz"];
 			attr_dict.erase("nx");
 			attr_dict.erase("ny");
 			attr_dict.erase("nz");
 
-			// At this point nx, ny and nz are all reduced by binfactor
-			set_size(nx/binfactor, ny/binfactor, nz/binfactor);
-
-			//here is where we read in the binned data
-			EMData* tempdata = new EMData();
-			size_t sizeofslice = nx*ny*sizeof(float);
-
-			//zbin factor use 1 to speed binning(but don't benfit by averaging in Z)
-			int zbin = binfactor;
-			if(fast) zbin = 1;
-			//verbose
-			float percent = 0.1f;
-			for(int k = 0; k < ori_nz; k+=binfactor){
-				if(k > ori_nz*percent){
-					printf("%1.0f %% Done\n",100.0*float(k)/float(ori_nz));
-					percent+=0.1f;
+			// fast only samples every binfactor-th slice rather than averaging in Z
+			int zbin = (fast ? 1 : binfactor);
+			int bnz = ori_nz / binfactor;
+			if (bnz < 1) bnz = 1;
+			if (zbin > ori_nz) zbin = ori_nz;
+
+			set_size(ori_nx / binfactor, ori_ny / binfactor, bnz);
+
+			if (nthreads <= 0) nthreads = (int)std::thread::hardware_concurrency();
+			if (nthreads < 1) nthreads = 1;
+
+			// The slabs are read straight from the open imageio into two reused buffers, so
+			// the next slab is read while the current one is being reduced
+			size_t slabsize = (size_t)ori_nx * ori_ny * zbin;
+			vector<float> cur(slabsize), next(slabsize);
+
+			auto read_slab = [&](int bz, float *buf) {
+				Region slab(0, 0, bz * binfactor, ori_nx, ori_ny, zbin);
+				if (imageio->read_data(buf, img_index, &slab, is_3d)) {
+					throw ImageReadException(filename, "imageio read data failed");
 				}
-				// read in a slice region
-//				printf("%d %d %d %d\n",k,ori_nx,ori_ny,zbin);
-				const Region* binregion = new Region(0,0,k,ori_nx,ori_ny,zbin);
-				tempdata->read_image(filename, 0, false, binregion);
-				// shrink the slice
-				if (binfactor > 1) tempdata->process_inplace("math.meanshrink",Dict("n",binfactor));
-				size_t offset = nx*ny*k/binfactor;
-				//add slice to total
-				EMUtil::em_memcpy(get_data()+offset,tempdata->get_data(),sizeofslice);
-				delete binregion;
+			};
+
+			read_slab(0, cur.data());
+			for (int bz = 0; bz < bnz; bz++) {
+				std::exception_ptr readerr;
+				std::thread reader;
+				if (bz + 1 < bnz) {
+					reader = std::thread([&]() {
+						try {
+							read_slab(bz + 1, next.data());
+						}
+						catch (...) {
+							readerr = std::current_exception();
+						}
+					});
+				}
+
+				// the reader must be joined on every path, a joinable std::thread would terminate on unwinding
+				try {
+					float *out = get_data() + (size_t)nx * ny * bz;
+					if (fourier && binfactor > 1) fouriershrink_slab(cur.data(), ori_nx, ori_ny, zbin, binfactor, out);
+					else meanshrink_slab(cur.data(), ori_nx, ori_ny, zbin, binfactor, out, nthreads);
+				}
+				catch (...) {
+					if (reader.joinable()) reader.join();
+					throw;
+				}
+
+				if (reader.joinable()) reader.join();
+				if (readerr) std::rethrow_exception(readerr);
+				cur.swap(next);
 			}
 
-			delete tempdata;
 			update();
 		}
 	}
@@ -201,11 +516,20 @@ void EMData::_write_image(ImageIO *imageio, int img_index,
 						 EMUtil::ImageType imgtype,
 						 bool header_only, const Region * region,
 						 EMUtil::EMDataType filestoragetype,
-						 bool use_host_endian)
+						 bool use_host_endian, bool flush)
 {
 	if (!imageio)
 		throw ImageFormatException("cannot create an image io");
 	else {
+		if (is_complex() && is_shuffled())
+			fft_shuffle();
+
+		//set "nx", "ny", "nz" and "changecount" in attr_dict, since they are taken out of attribute dictionary
+		attr_dict["nx"] = nx;
+		attr_dict["ny"] = ny;
+		attr_dict["nz"] = nz;
+		attr_dict["changecount"] = changecount;
+
 		update_stat();
 		/* Let each image format decide how to deal with negative image_index*/
 //		if (img_index < 0) {
@@ -301,7 +625,7 @@ void EMData::_write_image(ImageIO *imageio, int img_index,
 		}
 	}
 	//PNG image already do cleaning in write_data function.
-	if (imgtype != EMUtil::IMAGE_PNG)
+	if (flush && imgtype != EMUtil::IMAGE_PNG)
 		imageio->flush();
 }
 
@@ -316,9 +640,6 @@ void EMData::write_image(const string & filename, int img_index,
 	struct stat fileinfo;
 	if ( region && stat(filename.c_str(),&fileinfo) != 0 ) throw UnexpectedBehaviorException("To write an image using a region the file must already exist and be the correct dimensions");
 
-	if (is_complex() && is_shuffled())
-		fft_shuffle();
-
 	if (imgtype == EMUtil::IMAGE_UNKNOWN) {
 		auto pos = filename.rfind('.');
 		if (pos != string::npos)
@@ -326,12 +647,6 @@ void EMData::write_image(const string & filename, int img_index,
 	}
 	ImageIO::IOMode rwmode = ImageIO::READ_WRITE;
 
-	//set "nx", "ny", "nz" and "changecount" in attr_dict, since they are taken out of attribute dictionary
-	attr_dict["nx"] = nx;
-	attr_dict["ny"] = ny;
-	attr_dict["nz"] = nz;
-	attr_dict["changecount"] = changecount;
-
     // Check if this is a write only format.
     if (Util::is_file_exist(filename) && (!header_only && region == 0)) {
             ImageIO * tmp_imageio = EMUtil::get_imageio(filename, ImageIO::READ_ONLY, imgtype);
@@ -391,6 +706,51 @@ vector<shared_ptr<EMData>> EMData::read_images(const string & filename, vector<i
 	ImageIO *imageio = EMUtil::get_imageio(filename, ImageIO::READ_ONLY, imgtype);
 
 	vector<shared_ptr<EMData>> v;
+
+#ifdef USE_HDF5
+	// packed HDF stacks can return a run of consecutive images with a single read
+	HdfIO2 *hdfio = dynamic_cast<HdfIO2 *>(imageio);
+	if (hdfio && !header_only && hdfio->is_packed()) {
+		size_t j = 0;
+		while (j < n) {
+			size_t k = (num_img == 0 ? j : img_indices[j]);
+			size_t run = 1;
+			while (j + run < n && run < 256 && (num_img == 0 || img_indices[j + run] == (int)(k + run))) run++;
+
+			vector<shared_ptr<EMData>> batch;
+			for (size_t i = 0; i < run; i++) {
+				shared_ptr<EMData> d(new EMData());
+				d->_read_image(imageio, (int)(k + i), true);
+				batch.push_back(d);
+			}
+
+			size_t imgsize = (size_t)batch[0]->nx * batch[0]->ny * batch[0]->nz;
+			float *buf = (float *)EMUtil::em_malloc(imgsize * run * sizeof(float));
+			if (!buf || hdfio->read_data_range(buf, (int)k, (int)run)) {
+				if (buf) EMUtil::em_free(buf);
+				throw ImageReadException(filename, "imageio read data failed");
+			}
+
+			for (size_t i = 0; i < run; i++) {
+				EMData *d = batch[i].get();
+				d->set_size(d->nx, d->ny, d->nz);
+				memcpy(d->get_data(), buf + i * imgsize, imgsize * sizeof(float));
+				d->update();
+				v.push_back(batch[i]);
+			}
+
+			EMUtil::em_free(buf);
+			j += run;
+		}
+
+		EMUtil::close_imageio(filename, imageio);
+		imageio = 0;
+
+		EXITFUNC;
+		return v;
+	}
+#endif
+
 	for (size_t j = 0; j < n; j++) {
 		shared_ptr<EMData> d(new EMData());
 		size_t k = (num_img == 0 ? j : img_indices[j]);
@@ -419,27 +779,31 @@ bool EMData::write_images(const string & filename, vector<std::shared_ptr<EMData
 						  bool header_only,
 						  const Region * region,
 						  EMUtil::EMDataType filestoragetype,
-						  bool use_host_endian)
+						  bool use_host_endian,
+						  int first_index)
 {
 	ENTERFUNC;
 
-	ImageIO *imageio = EMUtil::get_imageio(filename, ImageIO::WRITE_ONLY);
+	ImageIO::IOMode rwmode = (first_index == 0 ? ImageIO::WRITE_ONLY : ImageIO::READ_WRITE);
+	ImageIOHandle imageio(filename, rwmode, imgtype);
+
+	if (!imageio)
+		throw ImageFormatException("cannot create an image io");
+
+	if (imgtype == EMUtil::IMAGE_UNKNOWN) {
+		auto pos = filename.rfind('.');
+		if (pos != string::npos)
+			imgtype = EMUtil::get_image_ext_type(filename.substr(pos+1));
+	}
 
+	// the file is flushed once, after the last image
 	auto num_imgs = imgs.size();
 	for (size_t i = 0; i < num_imgs; i++) {
-		auto d = imgs[i].get();
-		try {
-			d->_write_image(imageio, (int)i, imgtype, header_only, region, filestoragetype, use_host_endian);
-		}
-		catch(E2Exception &e) {
-			throw(e);
-		}
+		int idx = (first_index < 0 ? -1 : first_index + (int)i);
+		imgs[i]->_write_image(imageio.get(), idx, imgtype, header_only, region, filestoragetype,
+							  use_host_endian, i + 1 == num_imgs);
 	}
 
-	EMUtil::close_imageio(filename, imageio);
-	imageio = 0;
-
-
 	EXITFUNC;
 	return true;
 }
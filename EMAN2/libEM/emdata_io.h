@@ -49,7 +49,7 @@ void _write_image(ImageIO *imageio,
 				 bool header_only = false,
 				 const Region * region = 0,
 				 EMUtil::EMDataType filestoragetype = EMUtil::EM_FLOAT,
-				 bool use_host_endian = true);
+				 bool use_host_endian = true, bool flush = true);
 
 public:
 /** read an image file and stores its information to this
@@ -76,6 +76,7 @@ void read_image(const string & filename, int img_index = 0,
 				EMUtil::ImageType imgtype = EMUtil::IMAGE_UNKNOWN);
 
 /** read in a binned image, bin while reading. For use in huge files(tomograms)
+ * The file is read in slabs of binfactor slices, each reduced while the next is read.
  * @param filename The image file name.
  * @param img_index The nth image you want to read.
  * @param binfactor The amout you want to bin by. Must be an integer
@@ -83,10 +84,57 @@ void read_image(const string & filename, int img_index = 0,
  * @param is_3d  Whether to treat the image as a single 3D or a
  *   set of 2Ds. This is a hint for certain image formats which
  *   has no difference between 3D image and set of 2Ds.
+ * @param fourier Bin each slice in XY by Fourier cropping rather than by averaging
+ * @param nthreads Threads used to reduce each slab, 0 for all cores
+ * @exception ImageFormatException
+ * @exception ImageReadException
+ * @exception InvalidValueException
+ */
+void read_binedimage(const string & filename, int img_index = 0, int binfactor=1, bool fast = false, bool is_3d = false,
+					 bool fourier = false, int nthreads = 0);
+
+/** read the sum of a group of consecutive frames of a movie, e.g. to
+ * group EER frames into dose fractions. EER frames are decoded straight
+ * into the sum on several threads; other formats are read on several
+ * threads, each through its own file handle (HDF is read on one).
+ * The header is that of the first frame.
+ * @param filename The image file name.
+ * @param first The first frame to include.
+ * @param count The number of frames to sum.
+ * @param nthreads Threads used to read the frames, 0 for all cores.
+ * @param imgtype Read as this image type, e.g. IMAGE_EER2X for an 8k grid.
+ * @param gain If given, the sum is multiplied by this gain reference,
+ *        which may be zero at defective pixels.
+ * @exception ImageFormatException
+ * @exception ImageReadException
+ * @exception ImageDimensionException
+ * @exception OutofRangeException
+ */
+void read_frame_sum(const string & filename, int first, int count, int nthreads = 0,
+					EMUtil::ImageType imgtype = EMUtil::IMAGE_UNKNOWN, const EMData * gain = 0);
+
+/** read a frame range of a movie as sums of consecutive groups of
+ * frames in one pass, e.g. all the dose fractions of a movie. The
+ * frames are read as by read_frame_sum(). With group = 1 this reads the
+ * frames themselves.
+ * @param filename The image file name.
+ * @param first The first frame to include.
+ * @param count The number of frames to include.
+ * @param group Frames per sum; the last sum may have fewer.
+ * @param nthreads Threads used to read the frames, 0 for all cores.
+ * @param imgtype Read as this image type, e.g. IMAGE_EER2X for an 8k grid.
+ * @param gain If given, every sum is multiplied by this gain reference.
+ * @return ceil(count / group) images, each with the header of its first frame.
  * @exception ImageFormatException
  * @exception ImageReadException
+ * @exception ImageDimensionException
+ * @exception InvalidValueException
+ * @exception OutofRangeException
  */
-void read_binedimage(const string & filename, int img_index = 0, int binfactor=0, bool fast = false, bool is_3d = false);
+static vector<std::shared_ptr<EMData>> read_frame_sums(const string & filename, int first, int count,
+											int group = 1, int nthreads = 0,
+											EMUtil::ImageType imgtype = EMUtil::IMAGE_UNKNOWN,
+											const EMData * gain = 0);
 
 
 /** write the header and data out to an image.
@@ -160,7 +208,10 @@ static vector<std::shared_ptr<EMData>> read_images(const string & filename,
 									  bool header_only = false);
 
 /** Write a set of images to file specified by 'filename'.
- * Which images are written is set by 'imgs'.
+ * Which images are written is set by 'imgs'. The file is opened once
+ * and flushed once after the last image, rather than per image as a
+ * loop over write_image() would. See ImageStackWriter for writing
+ * from a background thread while the images are still being made.
  * @param filename The image file name.
  * @param imgs Which images are written.
  * @param imgtype Write to the given image format type. if not
@@ -169,6 +220,8 @@ static vector<std::shared_ptr<EMData>> read_images(const string & filename,
  * @param region Define the region to write to.
  * @param filestoragetype The image data type used in the output file.
  * @param use_host_endian To write in the host computer byte order.
+ * @param first_index File index of imgs[0]; the others follow it. -1
+ *        appends every image to the end of the file.
  * @return True if set of images are written successfully to filename.
  */
 static bool write_images(const string & filename,
@@ -177,7 +230,8 @@ static bool write_images(const string & filename,
 									  bool header_only = false,
 									  const Region * region = nullptr,
 									  EMUtil::EMDataType filestoragetype = EMUtil::EM_FLOAT,
-									  bool use_host_endian = true);
+									  bool use_host_endian = true,
+									  int first_index = 0);
 
 friend ostream& operator<<(ostream& out, const EMData& obj);
 
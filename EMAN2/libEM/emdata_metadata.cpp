@@ -1135,8 +1135,9 @@ EMObject EMData::get_attr(const string & key) const
 		return nz;
 	}
 
-	if(attr_dict.has_key(key)) {
-		return attr_dict[key];
+	Dict::const_iterator p = attr_dict.find(key);
+	if(p != attr_dict.end()) {
+		return p->second;
 	}
 	else {
 		throw NotExistingObjectException(key, "The requested key does not exist");
@@ -1234,7 +1235,7 @@ void EMData::set_attr(const string & key, EMObject val)
 		}
 	}
 
-	attr_dict[key] = val;
+	attr_dict[key] = std::move(val);
 }
 
 void EMData::set_attr_python(const string & key, EMObject val)
@@ -1272,7 +1273,7 @@ void EMData::set_attr_python(const string & key, EMObject val)
 		attr_dict[key] = v;
 		delete t; t=0;
 	} else {
-		attr_dict[key] = val;
+		attr_dict[key] = std::move(val);
 	}
 
 }
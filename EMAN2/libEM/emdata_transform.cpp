@@ -115,6 +115,68 @@ EMData *EMData::do_fft() const
 	}
 }
 
+vector<EMData*> EMData::do_fft_batch(const vector<EMData*>& images)
+{
+	ENTERFUNC;
+
+	vector<EMData*> ret;
+	if (images.empty()) return ret;
+
+	const int nxreal = images[0]->get_xsize();
+	const int ny = images[0]->get_ysize();
+	for (size_t i = 0; i < images.size(); i++) {
+		const EMData *img = images[i];
+		if (img->is_complex() || img->get_zsize() != 1 || img->get_xsize() != nxreal || img->get_ysize() != ny) {
+			throw ImageFormatException("do_fft_batch requires real 2D images of identical size");
+		}
+	}
+	ret.reserve(images.size());
+
+#ifdef USE_FFTW3
+	const int offset = 2 - nxreal%2;
+	const int nx2 = nxreal + offset;
+	const size_t rsize = (size_t)nxreal * ny;
+	const size_t csize = (size_t)nx2 * ny;
+
+	// keep each batch to roughly 64 MB of complex output
+	const size_t maxbatch = std::max((size_t)1, ((size_t)1 << 24) / csize);
+	const int nbatch = (int)std::min(images.size(), maxbatch);
+	float *rbuf = EMfft::fftmalloc((int)(rsize * nbatch));
+	float *cbuf = EMfft::fftmalloc((int)(csize * nbatch));
+
+	for (size_t start = 0; start < images.size(); start += nbatch) {
+		const int n = (int)std::min((size_t)nbatch, images.size() - start);
+		for (int i = 0; i < n; i++) {
+			memcpy(rbuf + i * rsize, images[start + i]->get_data(), rsize * sizeof(float));
+		}
+
+		EMfft::real_to_complex_2d_batch(rbuf, cbuf, nxreal, ny, n);
+
+		for (int i = 0; i < n; i++) {
+			EMData* dat = images[start + i]->copy_head();
+			dat->set_size(nx2, ny, 1);
+			memcpy(dat->get_data(), cbuf + i * csize, csize * sizeof(float));
+			dat->set_fftodd(offset == 1);
+			dat->update();
+			dat->set_fftpad(true);
+			dat->set_complex(true);
+			dat->set_attr("is_intensity",false);
+			if(ny==1) dat->set_complex_x(true);
+			dat->set_ri(true);
+			ret.push_back(dat);
+		}
+	}
+
+	EMfft::fftfree(rbuf);
+	EMfft::fftfree(cbuf);
+#else
+	for (size_t i = 0; i < images.size(); i++) ret.push_back(images[i]->do_fft());
+#endif	//USE_FFTW3
+
+	EXITFUNC;
+	return ret;
+}
+
 void EMData::do_fft_inplace()
 {
 	ENTERFUNC;
@@ -45,6 +45,15 @@ public:
  */
 EMData *do_fft() const;
 
+/** Fourier transform a stack of equally sized real 2D images with batched FFTW plans.
+ * Equivalent to calling do_fft() on each image, but the per-image plan lookup is replaced
+ * by one lookup per batch.
+ * @param images the real 2D images, all of the same size
+ * @exception ImageFormatException if any image is complex, 3D or differs in size
+ * @return the FFTs in real/imaginary format, owned by the caller
+ */
+static vector<EMData*> do_fft_batch(const vector<EMData*>& images);
+
 
 #ifdef EMAN2_USING_CUDA
 /** return the fast fourier transform (FFT) image of the current
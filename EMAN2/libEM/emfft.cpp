@@ -30,14 +30,17 @@
  * */
 
 #include <string>
+#include <cstdlib>
 #include <cstring>
 #include <complex>
+#include <thread>
 #include "emfft.h"
 #include "log.h"
 
 #include <iostream>
 using std::cout;
 using std::endl;
+using std::string;
 
 #include "util.h"
 
@@ -72,6 +75,75 @@ MUTEX fft_mutex;
 pthread_mutex_t fft_mutex=PTHREAD_MUTEX_INITIALIZER;
 #endif
 
+#ifdef USE_FFTW3
+namespace {
+	int normalize_fft_threads(int n)
+	{
+		if (n == 0) n = (int)std::thread::hardware_concurrency();
+		return n < 1 ? 1 : n;
+	}
+
+	int fft_threads_from_env()
+	{
+		const char *env = getenv("EMAN2_FFTW_THREADS");
+		return env == NULL ? 1 : normalize_fft_threads(atoi(env));
+	}
+
+	// Threads FFTW may use for large transforms, see EMfft::set_num_threads. Guarded by fft_mutex.
+	int fft_nthreads = fft_threads_from_env();
+	bool fft_threads_initialized = false;
+
+	// Returns the number of threads a transform of n elements should be planned with, and
+	// initializes FFTW threading the first time it is needed. Call with fft_mutex held.
+	int plan_threads(size_t n)
+	{
+#ifdef _WIN32
+		return 1;
+#else
+		if (n < EMFFTW3_THREADS_MIN_SIZE || fft_nthreads == 1) return 1;
+		if (!fft_threads_initialized) {
+			if (!fftwf_init_threads()) {
+				LOGWARN("FFTW thread initialization failed, using 1 thread");
+				fft_nthreads = 1;
+				return 1;
+			}
+			fft_threads_initialized = true;
+		}
+		return fft_nthreads;
+#endif
+	}
+
+	// Sets the thread count for the next plan FFTW creates. Call with fft_mutex held.
+	void set_plan_threads(int nthreads)
+	{
+#ifndef _WIN32
+		if (fft_threads_initialized) fftwf_plan_with_nthreads(nthreads);
+#endif
+	}
+
+	// Real to complex plan for howmany transforms stored back to back. Batched plans are
+	// always out-of-place, with unpadded real images and complex images of n/2+1 columns.
+	fftwf_plan plan_r2c(int rank, const int *n, int howmany, float *r, fftwf_complex *c, unsigned flags)
+	{
+		if (howmany == 1) return fftwf_plan_dft_r2c(rank, n, r, c, flags);
+		int nr = 1;
+		for (int i = 0; i < rank; i++) nr *= n[i];
+		const int nc = nr / n[rank-1] * (n[rank-1]/2+1);
+		return fftwf_plan_many_dft_r2c(rank, n, howmany, r, NULL, 1, nr, c, NULL, 1, nc, flags);
+	}
+
+	// Complex to real counterpart of plan_r2c
+	fftwf_plan plan_c2r(int rank, const int *n, int howmany, fftwf_complex *c, float *r, unsigned flags)
+	{
+		if (howmany == 1) return fftwf_plan_dft_c2r(rank, n, c, r, flags);
+		int nr = 1;
+		for (int i = 0; i < rank; i++) nr *= n[i];
+		const int nc = nr / n[rank-1] * (n[rank-1]/2+1);
+		return fftwf_plan_many_dft_c2r(rank, n, howmany, c, NULL, 1, nc, r, NULL, 1, nr, flags);
+	}
+}
+#endif // USE_FFTW3
+
 #ifdef FFTW_PLAN_CACHING
 // The only thing important about these constants is that they don't equal each other
 // Why isn't this an enum?  --steve
@@ -81,55 +153,67 @@ const int EMfft::EMAN2_COMPLEX_2_COMPLEX = 3;
 
 
 #ifdef USE_FFTW3
+namespace {
+	unsigned rigor_from_string(const string& s)
+	{
+		if (s == "estimate") return FFTW_ESTIMATE;
+		if (s == "measure") return FFTW_MEASURE;
+		if (s == "patient") return FFTW_PATIENT;
+		if (s == "exhaustive") return FFTW_EXHAUSTIVE;
+		throw InvalidValueException(s, "FFTW plan rigor must be estimate, measure, patient or exhaustive");
+	}
+
+	void destroy_cached_plan(fftwf_plan plan)
+	{
+		Util::MUTEX_LOCK(&fft_mutex);
+		fftwf_destroy_plan(plan);
+		Util::MUTEX_UNLOCK(&fft_mutex);
+	}
+}
+
 EMfft::EMfftw3_cache::EMfftw3_cache() :
-		num_plans(0)
+		max_plans(EMFFTW3_CACHE_SIZE), rigor(FFTW_ESTIMATE), wisdom_dirty(false)
 {
-	// NOTE 2018/11/13 Toshio Moriya: 
-	// Modified for Pawel
-	clear_plans();
-	
-	/*
-	for(int i = 0; i < EMFFTW3_CACHE_SIZE; ++i)
-	{
-		rank[i] = 0;
-		plan_dims[i][0] = 0; plan_dims[i][1] = 0; plan_dims[i][2] = 0;
-		r2c[i] = -1;
-		ip[i] = -1;
-		fftwplans[i] = NULL;
+	const char *env = getenv("EMAN2_FFTW_CACHE_SIZE");
+	if (env != NULL) max_plans = (size_t)atol(env);
+
+	env = getenv("EMAN2_FFTW_RIGOR");
+	if (env != NULL) {
+		try {
+			rigor = rigor_from_string(env);
+		}
+		catch (E2Exception &) {
+			LOGWARN("Ignoring unrecognized EMAN2_FFTW_RIGOR '%s'", env);
+		}
+	}
+
+	env = getenv("EMAN2_FFTW_WISDOM");
+	if (env != NULL) {
+		wisdom_file = env;
+		// a missing file is normal on the first run, it will be written at exit
+		fftwf_import_wisdom_from_filename(env);
 	}
-	*/
 }
 
 void EMfft::EMfftw3_cache::debug_plans()
 {
-	for(int i = 0; i < EMFFTW3_CACHE_SIZE; ++i)
+	int i = 0;
+	for (plan_list::const_iterator it = plans.begin(); it != plans.end(); ++it, ++i)
 	{
-		cout << "Plan " << i << " has dims " << plan_dims[i][0] << " " 
-				<< plan_dims[i][1] << " " << 
-				plan_dims[i][2] << ", rank " <<
-				rank[i] << ", rc flag " 
-				<< r2c[i] << ", ip flag " << ip[i] << endl;
+		const PlanKey& k = it->first;
+		cout << "Plan " << i << " has dims " << k.dims[0] << " " 
+				<< k.dims[1] << " " << 
+				k.dims[2] << ", rank " <<
+				k.rank << ", rc flag " 
+				<< k.r2c << ", ip flag " << k.ip << ", batch " << k.howmany << ", flags " << k.flags
+				<< ", threads " << k.nthreads << ", alignment " << k.ralign << " " << k.calign << endl;
 	}
 }
 
 EMfft::EMfftw3_cache::~EMfftw3_cache()
 {
-	// NOTE 2018/11/13 Toshio Moriya: 
-	// Modified for Pawel
+	save_wisdom();
 	destroy_plans();
-	
-	/*
-	for(int i = 0; i < EMFFTW3_CACHE_SIZE; ++i)
-	{
-		if (fftwplans[i] != NULL)
-		{
-			int mrt = Util::MUTEX_LOCK(&fft_mutex);
-			fftwf_destroy_plan(fftwplans[i]);
-			mrt = Util::MUTEX_UNLOCK(&fft_mutex);
-			fftwplans[i] = NULL;
-		}
-	}
-	*/
 }
 
 // NOTE 2018/11/13 Toshio Moriya: 
@@ -140,14 +224,8 @@ void EMfft::EMfftw3_cache::clear_plans()
 	// Debug output to make sure of EMfft::initialize_plan_cache is working
 	//cout << "MRK_DEBUG: EMfft::clear_plans is executed\n";
 	
-	for(int i = 0; i < EMFFTW3_CACHE_SIZE; ++i)
-	{
-		rank[i] = 0;
-		plan_dims[i][0] = 0; plan_dims[i][1] = 0; plan_dims[i][2] = 0;
-		r2c[i] = -1;
-		ip[i] = -1;
-		fftwplans[i] = NULL;
-	}
+	// Plans are reference counted, so forgetting them here destroys any no longer in use
+	destroy_plans();
 }
 
 // NOTE 2018/11/13 Toshio Moriya: 
@@ -158,119 +236,177 @@ void EMfft::EMfftw3_cache::destroy_plans()
 	// Debug output to make sure of EMfft::initialize_plan_cache is working
 	//cout << "MRK_DEBUG: EMfft::EMfftw3_cache destroy_plans is executed\n";
 	
-	for(int i = 0; i < EMFFTW3_CACHE_SIZE; ++i)
-	{
-		if (fftwplans[i] != NULL)
-		{
-			int mrt = Util::MUTEX_LOCK(&fft_mutex);
-			fftwf_destroy_plan(fftwplans[i]);
-			mrt = Util::MUTEX_UNLOCK(&fft_mutex);
-			fftwplans[i] = NULL;
+	plan_list old;
+	Util::MUTEX_LOCK(&fft_mutex);
+	old.swap(plans);
+	index.clear();
+	Util::MUTEX_UNLOCK(&fft_mutex);
+	// old goes out of scope here, the plan deleters take the mutex themselves
+}
+
+void EMfft::EMfftw3_cache::set_rigor(unsigned flags)
+{
+	// get_plan() reads rigor under the same lock
+	Util::MUTEX_LOCK(&fft_mutex);
+	rigor = flags;
+	Util::MUTEX_UNLOCK(&fft_mutex);
+}
+
+void EMfft::EMfftw3_cache::set_max_plans(size_t n)
+{
+	plan_list evicted;
+	Util::MUTEX_LOCK(&fft_mutex);
+	max_plans = n;
+	while (max_plans > 0 && plans.size() > max_plans) {
+		index.erase(plans.back().first);
+		evicted.splice(evicted.end(), plans, --plans.end());
+	}
+	Util::MUTEX_UNLOCK(&fft_mutex);
+}
+
+void EMfft::EMfftw3_cache::save_wisdom()
+{
+	if (wisdom_file.empty()) return;
+
+	Util::MUTEX_LOCK(&fft_mutex);
+	if (wisdom_dirty) {
+		if (!fftwf_export_wisdom_to_filename(wisdom_file.c_str())) {
+			LOGWARN("Cannot write FFTW wisdom to '%s'", wisdom_file.c_str());
 		}
+		wisdom_dirty = false;
 	}
+	Util::MUTEX_UNLOCK(&fft_mutex);
 }
 
-fftwf_plan EMfft::EMfftw3_cache::get_plan(const int rank_in, const int x, const int y, const int z, const int r2c_flag, const int ip_flag, fftwf_complex* complex_data, float* real_data )
+size_t EMfft::EMfftw3_cache::PlanKeyHash::operator()(const PlanKey& k) const
 {
+	size_t h = (size_t)k.rank;
+	const size_t vals[10] = { (size_t)k.dims[0], (size_t)k.dims[1], (size_t)k.dims[2], (size_t)k.r2c,
+		(size_t)k.ip, (size_t)k.howmany, (size_t)k.flags, (size_t)k.nthreads, (size_t)k.ralign, (size_t)k.calign };
+	for (int i = 0; i < 10; i++) h ^= vals[i] + 0x9e3779b9 + (h << 6) + (h >> 2);
+	return h;
+}
+
+fftwf_plan EMfft::EMfftw3_cache::make_plan(const PlanKey& key, fftwf_complex* complex_data, float* real_data)
+{
+	const int x = key.dims[0], y = key.dims[1], z = key.dims[2];
+	const int rank_in = key.rank;
+	const int r2c_flag = key.r2c;
 
-	if ( rank_in > 3 || rank_in < 1 ) throw InvalidValueException(rank_in, "Error, can not get an FFTW plan using rank out of the range [1,3]");
-	if ( r2c_flag != EMAN2_REAL_2_COMPLEX && r2c_flag != EMAN2_COMPLEX_2_REAL && r2c_flag != EMAN2_COMPLEX_2_COMPLEX ) throw InvalidValueException(r2c_flag, "The selected real to complex flag is not supported");
-	
-// 	static int num_added = 0;
-// 	cout << "Was asked for " << rank_in << " " << x << " " << y << " " << z << " " << r2c_flag << endl;
-	
 	int dims[3];
 	dims[0] = z;
 	dims[1] = y;
 	dims[2] = x;
-	
-	int mrt = Util::MUTEX_LOCK(&fft_mutex);
-	
-	// First check to see if we already have the plan
-	int i;
-	for (i=0; i<num_plans; i++) {
-		if (plan_dims[i][0]==x && plan_dims[i][1]==y && plan_dims[i][2]==z && rank[i]==rank_in && r2c[i]==r2c_flag && ip[i]==ip_flag) {
-			mrt = Util::MUTEX_UNLOCK(&fft_mutex);
-			return fftwplans[i];
-		}
-	}
-	
+
 	fftwf_plan plan;
-	// Create the plan
-	if ( y == 1 && z == 1 )
-	{
-		if ( r2c_flag == EMAN2_REAL_2_COMPLEX )
-			plan = fftwf_plan_dft_r2c_1d(x, real_data, complex_data, FFTW_ESTIMATE);
-		else if ( r2c_flag == EMAN2_COMPLEX_2_REAL )
-			plan = fftwf_plan_dft_c2r_1d(x, complex_data, real_data, FFTW_ESTIMATE);
-		else {
-			// This ONLY makes plans for inplace 1D C->C Forward
-			float *tmp=(float *)malloc(sizeof(float)*x*2);
-			memcpy(tmp,complex_data,sizeof(float)*x*2);
-			// technically FFTW_ESTIMATE isn't supposed to mess with the input data, but the manual advises playing it safe
-			plan = fftwf_plan_dft_1d(x,complex_data,complex_data,FFTW_FORWARD,FFTW_ESTIMATE);
-			memcpy(complex_data,tmp,sizeof(float)*x*2);
-			free(tmp);
-		}
-	}
-	else
-	{
+	set_plan_threads(key.nthreads);
+	if (key.flags == FFTW_ESTIMATE) {
+		// FFTW_ESTIMATE plans can be made directly on the caller's arrays
 		if ( r2c_flag == EMAN2_REAL_2_COMPLEX )
-			plan = fftwf_plan_dft_r2c(rank_in, dims + (3 - rank_in), real_data, complex_data, FFTW_ESTIMATE);
+			plan = plan_r2c(rank_in, dims + (3 - rank_in), key.howmany, real_data, complex_data, FFTW_ESTIMATE);
 		else if ( r2c_flag == EMAN2_COMPLEX_2_REAL) 
-			plan = fftwf_plan_dft_c2r(rank_in, dims + (3 - rank_in), complex_data, real_data, FFTW_ESTIMATE);
+			plan = plan_c2r(rank_in, dims + (3 - rank_in), key.howmany, complex_data, real_data, FFTW_ESTIMATE);
 		else {
-			// This ONLY makes plans for inplace 2D/3D C->C Forward
-			float *tmp=(float *)malloc(sizeof(float)*x*2*y*z);
-			memcpy(tmp,complex_data,sizeof(float)*x*2*y*z);
+			// This ONLY makes plans for inplace 1D/2D/3D C->C Forward
+			size_t n = (size_t)x*2*y*z;
+			float *tmp=(float *)malloc(sizeof(float)*n);
+			memcpy(tmp,complex_data,sizeof(float)*n);
 			// technically FFTW_ESTIMATE isn't supposed to mess with the input data, but the manual advises playing it safe
 			plan = fftwf_plan_dft(rank_in, dims + (3 - rank_in), complex_data, complex_data, FFTW_FORWARD, FFTW_ESTIMATE);  // in place!
-			memcpy(complex_data,tmp,sizeof(float)*x*2*y*z);
+			memcpy(complex_data,tmp,sizeof(float)*n);
 			free(tmp);
-
 		}
+	}
+	else {
+		// The other planners overwrite the arrays while timing, so plan on aligned scratch
+		// buffers instead, and let FFTW know if the real arrays will not be aligned like them
+		unsigned flags = key.flags;
+		if (key.ralign != 0 || key.calign != 0) flags |= FFTW_UNALIGNED;
+
+		if ( r2c_flag == EMAN2_COMPLEX_2_COMPLEX ) {
+			fftwf_complex *c = (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex)*(size_t)x*y*z);
+			plan = fftwf_plan_dft(rank_in, dims + (3 - rank_in), c, c, FFTW_FORWARD, flags);
+			fftwf_free(c);
+		}
+		else {
+			size_t nc = (size_t)(x/2+1)*y*z*key.howmany;
+			fftwf_complex *c = (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex)*nc);
+			float *r = key.ip ? (float *)c : (float *)fftwf_malloc(sizeof(float)*(size_t)x*y*z*key.howmany);
+			if ( r2c_flag == EMAN2_REAL_2_COMPLEX )
+				plan = plan_r2c(rank_in, dims + (3 - rank_in), key.howmany, r, c, flags);
+			else
+				plan = plan_c2r(rank_in, dims + (3 - rank_in), key.howmany, c, r, flags);
+			if (!key.ip) fftwf_free(r);
+			fftwf_free(c);
 		}
+		wisdom_dirty = true;
+	}
+	// other planning in this file assumes the single threaded default
+	set_plan_threads(1);
+	return plan;
+}
 
-	if (fftwplans[EMFFTW3_CACHE_SIZE-1] != NULL )
-	{
-		fftwf_destroy_plan(fftwplans[EMFFTW3_CACHE_SIZE-1]);
-		fftwplans[EMFFTW3_CACHE_SIZE-1] = NULL;
+EMfft::EMfftw3_cache::plan_ptr EMfft::EMfftw3_cache::get_plan(const int rank_in, const int x, const int y, const int z, const int r2c_flag, const int ip_flag, fftwf_complex* complex_data, float* real_data, const int howmany )
+{
+
+	if ( rank_in > 3 || rank_in < 1 ) throw InvalidValueException(rank_in, "Error, can not get an FFTW plan using rank out of the range [1,3]");
+	if ( r2c_flag != EMAN2_REAL_2_COMPLEX && r2c_flag != EMAN2_COMPLEX_2_REAL && r2c_flag != EMAN2_COMPLEX_2_COMPLEX ) throw InvalidValueException(r2c_flag, "The selected real to complex flag is not supported");
+	if ( howmany > 1 && (ip_flag || r2c_flag == EMAN2_COMPLEX_2_COMPLEX) ) throw InvalidValueException(howmany, "Batched FFTW plans must be out-of-place real/complex transforms");
+	
+	PlanKey key;
+	key.rank = rank_in;
+	key.dims[0] = x;
+	key.dims[1] = y;
+	key.dims[2] = z;
+	key.r2c = r2c_flag;
+	key.ip = ip_flag;
+	key.howmany = howmany;
+	key.ralign = real_data == NULL ? 0 : fftwf_alignment_of(real_data);
+	key.calign = complex_data == NULL ? 0 : fftwf_alignment_of((float *)complex_data);
+
+	plan_list evicted;
+	Util::MUTEX_LOCK(&fft_mutex);
+	key.flags = rigor;
+	key.nthreads = plan_threads((size_t)x*y*z*howmany);
+	
+	// First check to see if we already have the plan
+	plan_ptr plan;
+	std::unordered_map<PlanKey, plan_list::iterator, PlanKeyHash>::iterator found = index.find(key);
+	if (found != index.end()) {
+		// move to the front of the LRU list
+		plans.splice(plans.begin(), plans, found->second);
+		plan = found->second->second;
 	}
-					
-	int upper_limit = num_plans;
-	if ( upper_limit == EMFFTW3_CACHE_SIZE ) upper_limit -= 1;
-	for (int i=upper_limit-1; i>0; i--)
-	{
-		fftwplans[i]=fftwplans[i-1];
-		rank[i]=rank[i-1];
-		r2c[i]=r2c[i-1];
-		ip[i]=ip[i-1];
-		plan_dims[i][0]=plan_dims[i-1][0];
-		plan_dims[i][1]=plan_dims[i-1][1];
-		plan_dims[i][2]=plan_dims[i-1][2];
+	else {
+		plan = plan_ptr(make_plan(key, complex_data, real_data), destroy_cached_plan);
+		plans.push_front(std::make_pair(key, plan));
+		index[key] = plans.begin();
+
+		while (max_plans > 0 && plans.size() > max_plans) {
+			index.erase(plans.back().first);
+			evicted.splice(evicted.end(), plans, --plans.end());
+		}
+// 		debug_plans();
 	}
-		//dimplan[0]=-1;
-
-	plan_dims[0][0]=x;
-	plan_dims[0][1]=y;
-	plan_dims[0][2]=z;
-	r2c[0]=r2c_flag;
-	ip[0]=ip_flag;
-	fftwplans[0] = plan;
-	rank[0]=rank_in;
-	if (num_plans<EMFFTW3_CACHE_SIZE) num_plans++;
-// 			debug_plans();
-// 			cout << "Created plan 0" << endl;
-// 	++num_added;
-// 	cout << "I have created " << num_added << " plans" << endl;
-	mrt = Util::MUTEX_UNLOCK(&fft_mutex);
-	return fftwplans[0];
+	Util::MUTEX_UNLOCK(&fft_mutex);
+	// evicted plans are destroyed here, outside the lock, unless another thread still holds them
+	return plan;
 
 }
 
 // Static init
 EMfft::EMfftw3_cache EMfft::plan_cache;
 
+void EMfft::set_plan_rigor(const string& rigor)
+{
+	plan_cache.set_rigor(rigor_from_string(rigor));
+}
+
+void EMfft::set_plan_cache_size(size_t n)
+{
+	plan_cache.set_max_plans(n);
+}
+
 #endif // USE_FFTW3
 
 #endif // FFTW_PLAN_CACHING
@@ -304,19 +440,19 @@ int EMfft::real_to_complex_1d(float *real_data, float *complex_data, int n)
 {//cout<<"doing fftw3"<<endl;
 #ifdef FFTW_PLAN_CACHING
 	bool ip = ( complex_data == real_data );
-	fftwf_plan plan = plan_cache.get_plan(1,n,1,1,EMAN2_REAL_2_COMPLEX,ip,(fftwf_complex *) complex_data, real_data);
+	EMfftw3_cache::plan_ptr plan = plan_cache.get_plan(1,n,1,1,EMAN2_REAL_2_COMPLEX,ip,(fftwf_complex *) complex_data, real_data);
 	// According to FFTW3, this is making use of the "guru" interface - this is necessary if plans are to be reused
-	fftwf_execute_dft_r2c(plan, real_data,(fftwf_complex *) complex_data);
+	fftwf_execute_dft_r2c(plan.get(), real_data,(fftwf_complex *) complex_data);
 #else
-	int mrt = Util::MUTEX_LOCK(&fft_mutex);
+	Util::MUTEX_LOCK(&fft_mutex);
 	fftwf_plan plan = fftwf_plan_dft_r2c_1d(n, real_data, (fftwf_complex *) complex_data,
 											FFTW_ESTIMATE);
-	mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+	Util::MUTEX_UNLOCK(&fft_mutex);
 
 	fftwf_execute(plan);
-	mrt = Util::MUTEX_LOCK(&fft_mutex);
+	Util::MUTEX_LOCK(&fft_mutex);
 	fftwf_destroy_plan(plan);
-	mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+	Util::MUTEX_UNLOCK(&fft_mutex);
 #endif // FFTW_PLAN_CACHING
 	return 0;
 };
@@ -325,17 +461,17 @@ int EMfft::complex_to_real_1d(float *complex_data, float *real_data, int n)
 {
 #ifdef FFTW_PLAN_CACHING
 	bool ip = ( complex_data == real_data );
-	fftwf_plan plan = plan_cache.get_plan(1,n,1,1,EMAN2_COMPLEX_2_REAL,ip,(fftwf_complex *) complex_data, real_data);
+	EMfftw3_cache::plan_ptr plan = plan_cache.get_plan(1,n,1,1,EMAN2_COMPLEX_2_REAL,ip,(fftwf_complex *) complex_data, real_data);
 	// According to FFTW3, this is making use of the "guru" interface - this is necessary if plans are to be reused
-	fftwf_execute_dft_c2r(plan, (fftwf_complex *) complex_data, real_data);
+	fftwf_execute_dft_c2r(plan.get(), (fftwf_complex *) complex_data, real_data);
 #else
-	int mrt = Util::MUTEX_LOCK(&fft_mutex);
+	Util::MUTEX_LOCK(&fft_mutex);
 	fftwf_plan plan = fftwf_plan_dft_c2r_1d(n, (fftwf_complex *) complex_data, real_data,FFTW_ESTIMATE);
-	mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+	Util::MUTEX_UNLOCK(&fft_mutex);
 	fftwf_execute(plan);
-	mrt = Util::MUTEX_LOCK(&fft_mutex);
+	Util::MUTEX_LOCK(&fft_mutex);
 	fftwf_destroy_plan(plan);
-	mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+	Util::MUTEX_UNLOCK(&fft_mutex);
 #endif // FFTW_PLAN_CACHING
 	
 	return 0;
@@ -344,8 +480,8 @@ int EMfft::complex_to_real_1d(float *complex_data, float *real_data, int n)
 int EMfft::complex_to_complex_1d_inplace(std::complex<float> *complex_data, int n)
 {
 #ifdef FFTW_PLAN_CACHING
-	fftwf_plan plan = plan_cache.get_plan(1,n/2,1,1,EMAN2_COMPLEX_2_COMPLEX,1,(fftwf_complex *) complex_data,NULL);
-	fftwf_execute_dft(plan, (fftwf_complex *) complex_data,(fftwf_complex *) complex_data);
+	EMfftw3_cache::plan_ptr plan = plan_cache.get_plan(1,n/2,1,1,EMAN2_COMPLEX_2_COMPLEX,1,(fftwf_complex *) complex_data,NULL);
+	fftwf_execute_dft(plan.get(), (fftwf_complex *) complex_data,(fftwf_complex *) complex_data);
 #else
 	printf("ERROR: 1-D in place C2C FFT broken without caching");
 // 	fftwf_plan p;
@@ -369,13 +505,13 @@ int EMfft::complex_to_complex_1d_f(float *complex_data_in, float *complex_data_o
 	fftwf_plan p;
 	fftwf_complex *in=(fftwf_complex *) complex_data_in;
 	fftwf_complex *out=(fftwf_complex *) complex_data_out;
-	int mrt = Util::MUTEX_LOCK(&fft_mutex);
+	Util::MUTEX_LOCK(&fft_mutex);
 	p=fftwf_plan_dft_1d(n/2,in,out, FFTW_FORWARD, FFTW_ESTIMATE);
-	mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+	Util::MUTEX_UNLOCK(&fft_mutex);
 	fftwf_execute(p);
-	mrt = Util::MUTEX_LOCK(&fft_mutex);
+	Util::MUTEX_LOCK(&fft_mutex);
 	fftwf_destroy_plan(p);
-	mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+	Util::MUTEX_UNLOCK(&fft_mutex);
 	return 0;
 }
 
@@ -385,21 +521,21 @@ int EMfft::complex_to_complex_1d_b(float *complex_data_in, float *complex_data_o
 	fftwf_plan p;
 	fftwf_complex *in=(fftwf_complex *) complex_data_in;
 	fftwf_complex *out=(fftwf_complex *) complex_data_out;
-	int mrt = Util::MUTEX_LOCK(&fft_mutex);
+	Util::MUTEX_LOCK(&fft_mutex);
 	p=fftwf_plan_dft_1d(n/2,in,out, FFTW_BACKWARD, FFTW_ESTIMATE);
-	mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+	Util::MUTEX_UNLOCK(&fft_mutex);
 	fftwf_execute(p);
-	mrt = Util::MUTEX_LOCK(&fft_mutex);
+	Util::MUTEX_LOCK(&fft_mutex);
 	fftwf_destroy_plan(p);
-	mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+	Util::MUTEX_UNLOCK(&fft_mutex);
 	return 0;
 }
 
 int EMfft::complex_to_complex_2d_inplace(std::complex<float> *complex_data, int nx,int ny)
 {
 #ifdef FFTW_PLAN_CACHING
-	fftwf_plan plan = plan_cache.get_plan(2,nx/2,ny,1,EMAN2_COMPLEX_2_COMPLEX,1,(fftwf_complex *) complex_data,NULL);
-	fftwf_execute_dft(plan, (fftwf_complex *) complex_data,(fftwf_complex *) complex_data);
+	EMfftw3_cache::plan_ptr plan = plan_cache.get_plan(2,nx/2,ny,1,EMAN2_COMPLEX_2_COMPLEX,1,(fftwf_complex *) complex_data,NULL);
+	fftwf_execute_dft(plan.get(), (fftwf_complex *) complex_data,(fftwf_complex *) complex_data);
 #else
 	printf("ERROR: 2-D in place C2C FFT broken without caching");
 // 	fftwf_plan p;
@@ -435,7 +571,7 @@ int EMfft::complex_to_complex_nd(float *in, float *out, int nx,int ny,int nz)
 		{
 			fftwf_plan p;
 
-			int mrt = Util::MUTEX_LOCK(&fft_mutex);
+			Util::MUTEX_LOCK(&fft_mutex);
 
 			if(out == in) {
 				p=fftwf_plan_dft_3d(nx/2,ny,nz,(fftwf_complex *) in,(fftwf_complex *) out, FFTW_FORWARD, FFTW_ESTIMATE);
@@ -444,13 +580,13 @@ int EMfft::complex_to_complex_nd(float *in, float *out, int nx,int ny,int nz)
 
 				p=fftwf_plan_dft_3d(nx/2,ny,nz,(fftwf_complex *) in,(fftwf_complex *) out, FFTW_FORWARD, FFTW_ESTIMATE);
 			}
-			mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+			Util::MUTEX_UNLOCK(&fft_mutex);
 
 			fftwf_execute(p);
 			
-			mrt = Util::MUTEX_LOCK(&fft_mutex);
+			Util::MUTEX_LOCK(&fft_mutex);
 			fftwf_destroy_plan(p);
-			mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+			Util::MUTEX_UNLOCK(&fft_mutex);
 
 		}
 	}
@@ -477,20 +613,22 @@ int EMfft::real_to_complex_nd(float *real_data, float *complex_data, int nx, int
 		{
 #ifdef FFTW_PLAN_CACHING
 			bool ip = ( complex_data == real_data );
-			fftwf_plan plan = plan_cache.get_plan(rank,nx,ny,nz,EMAN2_REAL_2_COMPLEX,ip,(fftwf_complex *) complex_data, real_data);
+			EMfftw3_cache::plan_ptr plan = plan_cache.get_plan(rank,nx,ny,nz,EMAN2_REAL_2_COMPLEX,ip,(fftwf_complex *) complex_data, real_data);
 			// According to FFTW3, this is making use of the "guru" interface - this is necessary if plans are to be re-used
-			fftwf_execute_dft_r2c(plan, real_data,(fftwf_complex *) complex_data );
+			fftwf_execute_dft_r2c(plan.get(), real_data,(fftwf_complex *) complex_data );
 #else
-			int mrt = Util::MUTEX_LOCK(&fft_mutex);
+			Util::MUTEX_LOCK(&fft_mutex);
+			set_plan_threads(plan_threads((size_t)nx*ny*nz));
 			fftwf_plan plan = fftwf_plan_dft_r2c(rank, dims + (3 - rank), 
 					real_data, (fftwf_complex *) complex_data, FFTW_ESTIMATE);
-			mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+			set_plan_threads(1);
+			Util::MUTEX_UNLOCK(&fft_mutex);
 			
 			fftwf_execute(plan);
 			
-			mrt = Util::MUTEX_LOCK(&fft_mutex);
+			Util::MUTEX_LOCK(&fft_mutex);
 			fftwf_destroy_plan(plan);
-			mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+			Util::MUTEX_UNLOCK(&fft_mutex);
 
 #endif // FFTW_PLAN_CACHING
 		}
@@ -522,20 +660,22 @@ int EMfft::complex_to_real_nd(float *complex_data, float *real_data, int nx, int
 		{
 #ifdef FFTW_PLAN_CACHING
 			bool ip = ( complex_data == real_data );
-			fftwf_plan plan = plan_cache.get_plan(rank,nx,ny,nz,EMAN2_COMPLEX_2_REAL,ip,(fftwf_complex *) complex_data, real_data);
+			EMfftw3_cache::plan_ptr plan = plan_cache.get_plan(rank,nx,ny,nz,EMAN2_COMPLEX_2_REAL,ip,(fftwf_complex *) complex_data, real_data);
 			// According to FFTW3, this is making use of the "guru" interface - this is necessary if plans are to be re-used
-			fftwf_execute_dft_c2r(plan, (fftwf_complex *) complex_data, real_data);
+			fftwf_execute_dft_c2r(plan.get(), (fftwf_complex *) complex_data, real_data);
 #else
-			int mrt = Util::MUTEX_LOCK(&fft_mutex);
+			Util::MUTEX_LOCK(&fft_mutex);
+			set_plan_threads(plan_threads((size_t)nx*ny*nz));
 			fftwf_plan plan = fftwf_plan_dft_c2r(rank, dims + (3 - rank), 
 					(fftwf_complex *) complex_data, real_data, FFTW_ESTIMATE);
-			mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+			set_plan_threads(1);
+			Util::MUTEX_UNLOCK(&fft_mutex);
 
 			fftwf_execute(plan);
 			
-			mrt = Util::MUTEX_LOCK(&fft_mutex);
+			Util::MUTEX_LOCK(&fft_mutex);
 			fftwf_destroy_plan(plan);
-			mrt = Util::MUTEX_UNLOCK(&fft_mutex);
+			Util::MUTEX_UNLOCK(&fft_mutex);
 
 #endif // FFTW_PLAN_CACHING
 			
@@ -552,6 +692,31 @@ int EMfft::complex_to_real_nd(float *complex_data, float *real_data, int nx, int
 }
 
 
+int EMfft::real_to_complex_2d_batch(float *real_data, float *complex_data, int nx, int ny, int n)
+{
+	if (real_data == complex_data) throw InvalidValueException(0, "real_to_complex_2d_batch cannot work in place");
+	if (n < 1) return 0;
+
+#ifdef FFTW_PLAN_CACHING
+	EMfftw3_cache::plan_ptr plan = plan_cache.get_plan(2,nx,ny,1,EMAN2_REAL_2_COMPLEX,0,(fftwf_complex *) complex_data, real_data, n);
+	fftwf_execute_dft_r2c(plan.get(), real_data,(fftwf_complex *) complex_data);
+#else
+	const int dims[2] = { ny, nx };
+	Util::MUTEX_LOCK(&fft_mutex);
+	set_plan_threads(plan_threads((size_t)nx*ny*n));
+	fftwf_plan plan = plan_r2c(2, dims, n, real_data, (fftwf_complex *) complex_data, FFTW_ESTIMATE);
+	set_plan_threads(1);
+	Util::MUTEX_UNLOCK(&fft_mutex);
+
+	fftwf_execute(plan);
+
+	Util::MUTEX_LOCK(&fft_mutex);
+	fftwf_destroy_plan(plan);
+	Util::MUTEX_UNLOCK(&fft_mutex);
+#endif // FFTW_PLAN_CACHING
+	return 0;
+}
+
 // NOTE 2018/11/13 Toshio Moriya: 
 // Added for Pawel so that he re-initialize EMfftw3_cache plan_cache through this function
 // This function is available only when USE_FFTW3 is defined. 
@@ -562,6 +727,37 @@ int EMfft::initialize_plan_cache()
 	return 0;
 }
 
+bool EMfft::import_wisdom(const string& filename)
+{
+	Util::MUTEX_LOCK(&fft_mutex);
+	bool ret = fftwf_import_wisdom_from_filename(filename.c_str()) != 0;
+	Util::MUTEX_UNLOCK(&fft_mutex);
+	return ret;
+}
+
+bool EMfft::export_wisdom(const string& filename)
+{
+	Util::MUTEX_LOCK(&fft_mutex);
+	bool ret = fftwf_export_wisdom_to_filename(filename.c_str()) != 0;
+	Util::MUTEX_UNLOCK(&fft_mutex);
+	return ret;
+}
+
+void EMfft::set_num_threads(int n)
+{
+	Util::MUTEX_LOCK(&fft_mutex);
+	fft_nthreads = normalize_fft_threads(n);
+	Util::MUTEX_UNLOCK(&fft_mutex);
+}
+
+int EMfft::get_num_threads()
+{
+	Util::MUTEX_LOCK(&fft_mutex);
+	int n = fft_nthreads;
+	Util::MUTEX_UNLOCK(&fft_mutex);
+	return n;
+}
+
 #endif	//USE_FFTW3
 
 #ifdef NATIVE_FFT
@@ -36,6 +36,16 @@
 
 #include <fftw3.h>
 #include<complex>
+#include <string>
+
+#ifdef FFTW_PLAN_CACHING
+#include <list>
+#include <memory>
+#include <unordered_map>
+#endif
+
+// Transforms with fewer elements than this are never split across threads
+#define EMFFTW3_THREADS_MIN_SIZE (128*128*128)
  
 namespace EMAN
 {
@@ -55,6 +65,16 @@ namespace EMAN
 		static int complex_to_real_nd(float *complex_data, float *real_data, int nx, int ny,
 									  int nz);
 		static int complex_to_complex_nd(float *complex_data_in, float *complex_data_out, int nx,int ny,int nz);// ming add
+
+		/** Forward FFT of n real 2D images with a single batched FFTW plan. Out-of-place only.
+		 * @param real_data n unpadded nx*ny images stored back to back
+		 * @param complex_data receives n transforms of (nx+2-nx%2)*ny floats, the same layout as do_fft()
+		 * @param nx the x size of each real image
+		 * @param ny the y size of each image
+		 * @param n the number of images
+		 */
+		static int real_to_complex_2d_batch(float *real_data, float *complex_data, int nx, int ny, int n);
+
 		static inline float *fftmalloc(int n) { return (float*)fftw_malloc(n*sizeof(float)); }
 		static inline void fftfree(float *mem) { fftw_free(mem); }
 		
@@ -62,19 +82,64 @@ namespace EMAN
 		// Added for Pawel so that he can access to EMfft::EMfftw3_cache::EMfftw3_cache() through this function
 		// This function is available only when USE_FFTW3 is defined. 
 		static int initialize_plan_cache();
-		
+
+		/** Load FFTW wisdom accumulated by an earlier run, so MEASURE/PATIENT planning for
+		 * known box sizes is nearly free. The file named by the EMAN2_FFTW_WISDOM environment
+		 * variable is imported automatically at startup.
+		 * @param filename the wisdom file written by export_wisdom() or fftwf-wisdom
+		 * @return true if the wisdom was read successfully
+		 */
+		static bool import_wisdom(const std::string& filename);
+
+		/** Write all FFTW wisdom gathered so far to a file. When EMAN2_FFTW_WISDOM is set and
+		 * any plan was created with a rigor above "estimate", this happens automatically at exit.
+		 * @param filename the file to write
+		 * @return true if the wisdom was written successfully
+		 */
+		static bool export_wisdom(const std::string& filename);
+
+		/** Set the number of threads FFTW uses to execute transforms of at least
+		 * EMFFTW3_THREADS_MIN_SIZE elements. Smaller transforms always run on one thread, since
+		 * splitting them costs more than it saves. The initial value is taken from
+		 * EMAN2_FFTW_THREADS, default 1. Ignored on Windows, where fftw3f_threads is not linked.
+		 * @param n the number of threads, 0 to use all hardware threads
+		 */
+		static void set_num_threads(int n);
+
+		/** @return the number of threads FFTW uses for large transforms */
+		static int get_num_threads();
+
+#ifdef FFTW_PLAN_CACHING
+		/** Set the FFTW planning rigor used for plans created from now on. Plans already in the
+		 * cache are kept. The initial value is taken from EMAN2_FFTW_RIGOR, default "estimate".
+		 * @param rigor one of "estimate", "measure", "patient" or "exhaustive"
+		 * @exception InvalidValueException if rigor is not recognized
+		 */
+		static void set_plan_rigor(const std::string& rigor);
+
+		/** Set the maximum number of cached plans. The least recently used plans are destroyed
+		 * when the limit is exceeded. The initial value is taken from EMAN2_FFTW_CACHE_SIZE,
+		 * default EMFFTW3_CACHE_SIZE.
+		 * @param n the maximum number of plans, 0 for no limit
+		 */
+		static void set_plan_cache_size(size_t n);
+#endif
+
 	  private:
 #ifdef FFTW_PLAN_CACHING
-#define EMFFTW3_CACHE_SIZE 32
+#define EMFFTW3_CACHE_SIZE 256
 		static const int EMAN2_REAL_2_COMPLEX;
 		static const int EMAN2_COMPLEX_2_REAL;
 		static const int EMAN2_COMPLEX_2_COMPLEX;		// inplace only
 		/** EMfftw3_cache
-		 * An ecapsulation of FFTW3 plan caching. Keeps an array of plans and records of important details.
+		 * An ecapsulation of FFTW3 plan caching. Plans are kept in a hash map keyed on everything that
+		 * determines their validity (rank, dimensions, direction, in-place flag, thread count and the SIMD
+		 * alignment of the arrays), with least recently used eviction once max_plans is exceeded.
 		 * Main interface is get_plan(...)
 		 * If asked for a plan that is not currently stored this class will create the plan and then return
 		 * it. If asked for a plan that IS stored than the pre-existing plan is returned.
-		 * The number of plans that can be cached is determined by the compile time flag EMFFTW3_CACHE_SIZE.
+		 * Plans are handed out as reference counted pointers, so a plan evicted by one thread remains valid
+		 * for another thread still executing it. All access is serialized on the same mutex as FFTW planning.
 		 * Although FFTW3 documentation states that plan caching is performed internally, tests on Fedora Core
 		 * 6 using rpms indicated that the costs of an associated MD5 algorithm in FFTW3 were prohibitive. 
 		 * Hence this implementation. Using FFTW plan caching usually results in a dramatic performance boost.
@@ -83,6 +148,8 @@ namespace EMAN
 		class EMfftw3_cache
 		{
 		public:
+			typedef std::shared_ptr<fftwf_plan_s> plan_ptr;
+
 			EMfftw3_cache();
 			~EMfftw3_cache();
 
@@ -100,28 +167,63 @@ namespace EMAN
 			 * @param ip_flag the in-place flag, should be either EMAN2_FFTW2_INPLACE or EMAN2_FFTW2_OUT_OF_PLACE
 			 * @param complex_data the complex data, in fftw_complex format
 			 * @param real_data the real_data
+			 * @param howmany the number of transforms stored back to back, batched plans must be out-of-place
 			 * @exception InvalidValueException when the rank is not 1,2 or 3
 			 * @exception InvalidValueException when the r2c_flag is unrecognized
-			 * @return and fftwf_plan corresponding to the input arguments
+			 * @return a reference counted fftwf_plan corresponding to the input arguments, hold it while executing
 			 */
-			fftwf_plan get_plan(const int rank, const int x, const int y, const int z, const int r2c_flag,const int ip_flag, fftwf_complex* complex_data, float* real_data);
+			plan_ptr get_plan(const int rank, const int x, const int y, const int z, const int r2c_flag,const int ip_flag, fftwf_complex* complex_data, float* real_data, const int howmany = 1);
+
+			void set_rigor(unsigned flags);
+			void set_max_plans(size_t n);
+
+			// Writes wisdom to the EMAN2_FFTW_WISDOM file if any new measured plans were made
+			void save_wisdom();
 		private:
+			struct PlanKey
+			{
+				int rank;
+				// Dimensions of the plan (always in 3D, if dimensions are "unused" they are taken to be 1)
+				int dims[3];
+				int r2c;
+				int ip;
+				// number of transforms in a batched plan
+				int howmany;
+				unsigned flags;
+				int nthreads;
+				// fftwf_alignment_of() for the real and complex arrays
+				int ralign, calign;
+
+				bool operator==(const PlanKey& k) const {
+					return rank==k.rank && dims[0]==k.dims[0] && dims[1]==k.dims[1] && dims[2]==k.dims[2] &&
+						r2c==k.r2c && ip==k.ip && howmany==k.howmany && flags==k.flags && nthreads==k.nthreads && ralign==k.ralign && calign==k.calign;
+				}
+			};
+
+			struct PlanKeyHash
+			{
+				size_t operator()(const PlanKey& k) const;
+			};
+
+			typedef std::list<std::pair<PlanKey, plan_ptr> > plan_list;
+
+			// Creates a new plan, must be called with the FFTW mutex held
+			fftwf_plan make_plan(const PlanKey& key, fftwf_complex* complex_data, float* real_data);
+
 			// Prints useful debug information to standard out
 			void debug_plans();
-			
-			// Store the number of plans currently contained in this EMfftw3_cache object
-			int num_plans;
-
-			// Store the rank of the plan
-			int rank[EMFFTW3_CACHE_SIZE];
-			// Store the dimensions of the plan (always in 3D, if dimensions are "unused" they are taken to be 1)
-			int plan_dims[EMFFTW3_CACHE_SIZE][3];
-			// store whether the plan was real to complex or vice versa
-			int r2c[EMFFTW3_CACHE_SIZE];
-			// Store the plans themselves
-			fftwf_plan fftwplans[EMFFTW3_CACHE_SIZE];
-			// Store whether or not the plan was inplace
-			int ip[EMFFTW3_CACHE_SIZE];
+
+			// Plans in most recently used order, and an index into that list
+			plan_list plans;
+			std::unordered_map<PlanKey, plan_list::iterator, PlanKeyHash> index;
+
+			// Maximum number of cached plans, 0 for no limit
+			size_t max_plans;
+			// FFTW planning rigor for new plans (FFTW_ESTIMATE, FFTW_MEASURE, ...)
+			unsigned rigor;
+			// Wisdom file from EMAN2_FFTW_WISDOM, and whether it has anything new to save
+			std::string wisdom_file;
+			bool wisdom_dirty;
 		};
 
 		static EMfftw3_cache plan_cache;
@@ -122,6 +122,7 @@ void EMObject::printInfo() const
 }
 
 EMObject::~EMObject() {
+	release();
 #ifdef MEMDEBUG
 	allemobjlist.erase(this);
 	printf("  -(%6d) %p\n",(int)allemobjlist.size(),this);
@@ -206,7 +207,7 @@ EMObject::EMObject(double dd) :
 }
 
 EMObject::EMObject(const char *s) :
-	str(s), type(STRING)
+	str(new string(s)), type(STRING)
 {
 #ifdef MEMDEBUG
 	allemobjlist.insert(this);
@@ -215,7 +216,7 @@ EMObject::EMObject(const char *s) :
 }
 
 EMObject::EMObject(const string & s) :
-	str(s), type(STRING)
+	str(new string(s)), type(STRING)
 {
 #ifdef MEMDEBUG
 	allemobjlist.insert(this);
@@ -269,7 +270,7 @@ EMObject::EMObject(XYData * xy) :
 }
 
 EMObject::EMObject(Transform* t) :
-	farray(t->get_matrix()), type(TRANSFORM)
+	farray(new vector<float>(t->get_matrix())), type(TRANSFORM)
 {
 #ifdef MEMDEBUG
 	allemobjlist.insert(this);
@@ -278,7 +279,7 @@ EMObject::EMObject(Transform* t) :
 }
 
 EMObject::EMObject(Ctf * ctf) :
-	str(ctf->to_string()), type(CTF)
+	str(new string(ctf->to_string())), type(CTF)
 {
 #ifdef MEMDEBUG
 	allemobjlist.insert(this);
@@ -287,7 +288,7 @@ EMObject::EMObject(Ctf * ctf) :
 }
 
 EMObject::EMObject(const vector< int >& v ) :
-	iarray(v), type(INTARRAY)
+	iarray(new vector<int>(v)), type(INTARRAY)
 {
 #ifdef MEMDEBUG
 	allemobjlist.insert(this);
@@ -296,7 +297,7 @@ EMObject::EMObject(const vector< int >& v ) :
 }
 
 EMObject::EMObject(const vector < float >&v) :
-	farray(v), type(FLOATARRAY)
+	farray(new vector<float>(v)), type(FLOATARRAY)
 {
 #ifdef MEMDEBUG
 	allemobjlist.insert(this);
@@ -305,7 +306,7 @@ EMObject::EMObject(const vector < float >&v) :
 }
 
 EMObject::EMObject(const vector <string>& sarray) :
-	strarray(sarray), type(STRINGARRAY)
+	strarray(new vector<string>(sarray)), type(STRINGARRAY)
 {
 #ifdef MEMDEBUG
 	allemobjlist.insert(this);
@@ -314,7 +315,7 @@ EMObject::EMObject(const vector <string>& sarray) :
 }
 
 EMObject::EMObject(const vector <Transform>& tarray) :
-	transformarray(tarray), type(TRANSFORMARRAY)
+	transformarray(new vector<Transform>(tarray)), type(TRANSFORMARRAY)
 {
 #ifdef MEMDEBUG
 	allemobjlist.insert(this);
@@ -448,7 +449,7 @@ EMObject::operator float () const
 		return (float) d;
 	}
 	else if (type == STRING) {
-		return (float)atof(str.c_str());
+		return (float)atof(str->c_str());
 	}
 	else {
 		if (type != UNKNOWN) {
@@ -568,7 +569,7 @@ EMObject::operator const char * () const
 
 		return "";
 	}
-	return str.c_str();
+	return str->c_str();
 }
 
 EMObject::operator EMData * () const
@@ -604,7 +605,7 @@ EMObject::operator Transform* () const
 		}
 	}
 	Transform * transform = new Transform();
-	transform->set_matrix(farray);
+	transform->set_matrix(type == TRANSFORM ? *farray : vector<float>());
 	return transform;
 }
 
@@ -617,13 +618,14 @@ EMObject::operator Ctf* () const
 		}
 	}*/
 	Ctf * ctf = 0;
-	if(str[0] == 'O') {
+	if (type != STRING && type != CTF) return ctf;
+	if((*str)[0] == 'O') {
 		ctf = new EMAN1Ctf();
-		ctf->from_string(str);
+		ctf->from_string(*str);
 	}
-	else if(str[0] == 'E') {
+	else if((*str)[0] == 'E') {
 		ctf = new EMAN2Ctf();
-		ctf->from_string(str);
+		ctf->from_string(*str);
 	}
 	return ctf;
 }
@@ -637,7 +639,7 @@ EMObject::operator vector<int>() const
 		}
 		return vector<int>();
     }
-    return iarray;
+    return *iarray;
 }
 
 EMObject::operator vector < float > () const
@@ -649,7 +651,7 @@ EMObject::operator vector < float > () const
 		}
 		return vector < float >();
 	}
-	return farray;
+	return *farray;
 }
 
 EMObject::operator vector<string> () const
@@ -661,7 +663,7 @@ EMObject::operator vector<string> () const
 		}
 		return vector<string>();
 	}
-	return strarray;
+	return *strarray;
 }
 
 EMObject::operator vector<Transform> () const
@@ -673,7 +675,7 @@ EMObject::operator vector<Transform> () const
 		}
 		return vector<Transform>();
 	}
-	return transformarray;
+	return *transformarray;
 }
 
 bool EMObject::is_null() const
@@ -689,7 +691,7 @@ string EMObject::to_str() const
 string EMObject::to_str(ObjectType argtype) const
 {
 	if (argtype == STRING) {
-		return str;
+		return (type == STRING || type == CTF) ? *str : string();
 	}
 	else {
 		char tmp_str[32];
@@ -795,7 +797,7 @@ bool EMAN::operator==(const EMObject &e1, const EMObject & e2)
 	break;
 	case EMObject::CTF:
 	case  EMObject::STRING:
-		return (e1.str == e2.str);
+		return (*e1.str == *e2.str);
 	break;
 	case  EMObject::FLOAT_POINTER:
 		return (e1.fp == e2.fp);
@@ -814,9 +816,9 @@ bool EMAN::operator==(const EMObject &e1, const EMObject & e2)
 	break;
 	case  EMObject::TRANSFORM:
 	case  EMObject::FLOATARRAY:
-		if (e1.farray.size() == e2.farray.size()) {
-			for (size_t i = 0; i < e1.farray.size(); i++) {
-				if (e1.farray[i] != e2.farray[i]) {
+		if (e1.farray->size() == e2.farray->size()) {
+			for (size_t i = 0; i < e1.farray->size(); i++) {
+				if ((*e1.farray)[i] != (*e2.farray)[i]) {
 					return false;
 				}
 			}
@@ -827,9 +829,9 @@ bool EMAN::operator==(const EMObject &e1, const EMObject & e2)
 		}
 	break;
 	case  EMObject::INTARRAY:
-		if (e1.iarray.size() == e2.iarray.size()) {
-			for (size_t i = 0; i < e1.iarray.size(); i++) {
-				if (e1.iarray[i] != e2.iarray[i]) {
+		if (e1.iarray->size() == e2.iarray->size()) {
+			for (size_t i = 0; i < e1.iarray->size(); i++) {
+				if ((*e1.iarray)[i] != (*e2.iarray)[i]) {
 					return false;
 				}
 			}
@@ -837,9 +839,9 @@ bool EMAN::operator==(const EMObject &e1, const EMObject & e2)
 		}
 	break;
 	case  EMObject::STRINGARRAY:
-		if (e1.strarray.size() == e2.strarray.size()) {
-			for (size_t i = 0; i < e1.strarray.size(); i++) {
-				if (e1.strarray[i] != e2.strarray[i]) {
+		if (e1.strarray->size() == e2.strarray->size()) {
+			for (size_t i = 0; i < e1.strarray->size(); i++) {
+				if ((*e1.strarray)[i] != (*e2.strarray)[i]) {
 					return false;
 				}
 			}
@@ -850,9 +852,9 @@ bool EMAN::operator==(const EMObject &e1, const EMObject & e2)
 		}
 	break;
 	case EMObject::TRANSFORMARRAY:
-		if (e1.transformarray.size() == e2.transformarray.size()) {
-			for (size_t i = 0; i < e1.transformarray.size(); i++) {
-				if (e1.transformarray[i] != e2.transformarray[i]) {
+		if (e1.transformarray->size() == e2.transformarray->size()) {
+			for (size_t i = 0; i < e1.transformarray->size(); i++) {
+				if ((*e1.transformarray)[i] != (*e2.transformarray)[i]) {
 					return false;
 				}
 			}
@@ -876,10 +878,21 @@ bool EMAN::operator!=(const EMObject &e1, const EMObject & e2)
 }
 
 // Copy constructor
-EMObject::EMObject(const EMObject& that)
+EMObject::EMObject(const EMObject& that) :
+	type(UNKNOWN)
 {
-	// init isn't necessary because that must have already called it!
-	*this = that;
+	copy_from(that);
+#ifdef MEMDEBUG
+	allemobjlist.insert(this);
+	printf("  +(%6d) %p\n",(int)allemobjlist.size(),this);
+#endif
+}
+
+EMObject::EMObject(EMObject&& that) noexcept :
+	d(that.d), type(that.type)
+{
+	// d is the widest member of the union, so this copies any of them
+	that.type = UNKNOWN;
 #ifdef MEMDEBUG
 	allemobjlist.insert(this);
 	printf("  +(%6d) %p\n",(int)allemobjlist.size(),this);
@@ -892,95 +905,129 @@ EMObject::EMObject(const EMObject& that)
 // the concept of an EMObject, which is always of a single type.
 EMObject& EMObject::operator=( const EMObject& that )
 {
+	if ( this != &that )
+	{
+		EMObject tmp(that);
+		*this = std::move(tmp);
+	}
+
+	return *this;
+}
 
-// This test breaks assignment when either the current or assigned values are (float)nan
-// it's also somewhat inherently stupid, since testing for equivalence may cost as much
-// as assignment.
-//	if ( *this != that )
+EMObject& EMObject::operator=( EMObject&& that ) noexcept
+{
+	if ( this != &that )
 	{
-		// First store the type of the input, At first I forgot to do this and it was a very
-		// difficult bug to track down
+		release();
+		d = that.d;
 		type = that.type;
+		that.type = UNKNOWN;
+	}
 
-// 		if ( type != this_type ) throw
+	return *this;
+}
 
+void EMObject::release()
+{
+	switch (type)
+	{
+	case CTF:
+	case STRING:
+		delete str;
+	break;
+	case TRANSFORM:
+	case FLOATARRAY:
+		delete farray;
+	break;
+	case INTARRAY:
+		delete iarray;
+	break;
+	case STRINGARRAY:
+		delete strarray;
+	break;
+	case TRANSFORMARRAY:
+		delete transformarray;
+	break;
+	default:
+	break;
+	}
+	type = UNKNOWN;
+}
 
-		switch (type)
-		{
-		case BOOL:
-			b = that.b;
-		break;
-		case SHORT:
-			si = that.si;
-		break;
-		case INT:
-			n = that.n;
-		break;
-		case UNSIGNEDINT:
-			ui = that.ui;
-		break;
-		case FLOAT:
-			f = that.f;
-		break;
-		case DOUBLE:
-			d = that.d;
-		break;
-		case CTF:
-		case STRING:
-			str = that.str;
-		break;
-		case FLOAT_POINTER:
-			// Warning - Pointer address copy.
-			fp = that.fp;
-		break;
-		case INT_POINTER:
+// Expects this to hold no owned storage. Only the member matching the type is copied,
+// heap types are deep copied, pointer types copy the address only.
+void EMObject::copy_from(const EMObject& that)
+{
+	switch (that.type)
+	{
+	case BOOL:
+		b = that.b;
+	break;
+	case SHORT:
+		si = that.si;
+	break;
+	case INT:
+		n = that.n;
+	break;
+	case UNSIGNEDINT:
+		ui = that.ui;
+	break;
+	case FLOAT:
+		f = that.f;
+	break;
+	case DOUBLE:
+		d = that.d;
+	break;
+	case CTF:
+	case STRING:
+		str = new string(*that.str);
+	break;
+	case FLOAT_POINTER:
 		// Warning - Pointer address copy.
-			ip = that.ip;
-		break;
-		case VOID_POINTER:
-			// Warning - Pointer address copy.
-			vp = that.vp;
-		break;
-		case EMDATA:
-			// Warning - Pointer address copy.
-			emdata = that.emdata;
-		break;
-		case XYDATA:
-			// Warning - Pointer address copy.
-			xydata = that.xydata;
-		break;
-		case TRANSFORM:
-		case FLOATARRAY:
-			farray = that.farray;
-		break;
-		case INTARRAY:
-			iarray = that.iarray;
-		break;
-		case STRINGARRAY:
-			strarray = that.strarray;
-		break;
-		case TRANSFORMARRAY:
-			transformarray = that.transformarray;
-		break;
-		case UNKNOWN:
-			// This is possible, nothing should happen
-			// The EMObject's default constructor has been called and
-			// as yet has no type - doing nothing is exactly as the
-			// the assignment operator should work.
-		break;
-		default:
-			LOGERR("No such EMObject defined");
-			throw NotExistingObjectException("EMObject", "unknown type");
-		break;
-		}
+		fp = that.fp;
+	break;
+	case INT_POINTER:
+	// Warning - Pointer address copy.
+		ip = that.ip;
+	break;
+	case VOID_POINTER:
+		// Warning - Pointer address copy.
+		vp = that.vp;
+	break;
+	case EMDATA:
+		// Warning - Pointer address copy.
+		emdata = that.emdata;
+	break;
+	case XYDATA:
+		// Warning - Pointer address copy.
+		xydata = that.xydata;
+	break;
+	case TRANSFORM:
+	case FLOATARRAY:
+		farray = new vector<float>(*that.farray);
+	break;
+	case INTARRAY:
+		iarray = new vector<int>(*that.iarray);
+	break;
+	case STRINGARRAY:
+		strarray = new vector<string>(*that.strarray);
+	break;
+	case TRANSFORMARRAY:
+		transformarray = new vector<Transform>(*that.transformarray);
+	break;
+	case UNKNOWN:
+		// This is possible, nothing should happen
+		// The EMObject's default constructor has been called and
+		// as yet has no type - doing nothing is exactly as the
+		// the assignment operator should work.
+	break;
+	default:
+		LOGERR("No such EMObject defined");
+		throw NotExistingObjectException("EMObject", "unknown type");
+	break;
 	}
-//	else
-//	{
-//		cerr << "Warning - attempt to assign EMObject onto itself. No action taken" << endl;
-//		cerr << "My type is " << get_object_type_name(type) << endl;
-//	}
-
-	return *this;
+	// set last, so a failed allocation leaves this UNKNOWN
+	type = that.type;
 }
 
 //-------------------------------TypeDict--------------------------------------------
@@ -1005,10 +1052,8 @@ Dict& Dict::operator=(const Dict& that)
 {
 	if ( this != &that )
 	{
-		dict.clear();
-		copy(that.begin(), that.end(), inserter(dict, dict.begin()));
-		// or use this
-		// dict.insert( that.begin(), that.end());
+		// map assignment reuses the existing nodes where it can
+		dict = that.dict;
 	}
 	else
 	{
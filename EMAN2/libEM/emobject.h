@@ -115,6 +115,11 @@ namespace EMAN
      *  EMObjects may store pointers but they currently do not assume ownership - that
      *  is, the memory associated with a pointer is never freed by an EMObject.
      *
+     *  Scalars and pointers are stored inline. Strings, arrays and transforms are kept
+     *  in a single heap block owned by the EMObject, so an EMObject is only as large as
+     *  a pointer plus its type tag. This matters for image headers, which hold many
+     *  small values per image.
+     *
      * This type of class design is sometimes referred to as the Variant pattern.
      *
      * See the testing code in rt/emdata/test_emobject.cpp for prewritten testing code
@@ -176,12 +181,21 @@ namespace EMAN
 		 */
 		EMObject(const EMObject& that);
 
+		/** Move constructor.
+		 * takes over the heap storage of 'that', which is left UNKNOWN
+		 */
+		EMObject(EMObject&& that) noexcept;
+
 		/** Assigment operator
 		 * copies pointer locations (emdata, xydata, transform) - does not take ownership
 		 * deep copies all non pointer objects
 		 */
 		EMObject& operator=(const EMObject& that);
 
+		/** Move assignment operator
+		 */
+		EMObject& operator=(EMObject&& that) noexcept;
+
 		/** Desctructor
 		 * Does not free pointers.
 		 */
@@ -268,15 +282,24 @@ namespace EMAN
 			void * vp;
 			EMData *emdata;
 			XYData *xydata;
+			// owned storage, see copy_from() and release()
+			string *str;					// STRING, CTF
+			vector <int> *iarray;			// INTARRAY
+			vector <float> *farray;			// FLOATARRAY, TRANSFORM (3x4 matrix)
+			vector <string> *strarray;		// STRINGARRAY
+			vector <Transform> *transformarray;	// TRANSFORMARRAY
 		};
 
-		string str;
-		vector <int> iarray;
-		vector <float> farray;
-		vector <string> strarray;
-		vector <Transform> transformarray;
 		ObjectType type;
 
+		/** Frees the owned storage, if any, and leaves the object UNKNOWN
+		 */
+		void release();
+
+		/** Sets this object to a deep copy of 'that', which must not be this
+		 */
+		void copy_from(const EMObject& that);
+
 		/** A debug function that prints as much information as possibe to cout
 		 */
 		void printInfo() const;
@@ -465,11 +488,24 @@ namespace EMAN
 		 */
 		Dict( const Dict& that);
 
+		/** Move constructor
+		 * Takes over the elements of that, leaving it empty
+		 */
+		Dict( Dict&& that) noexcept : dict(std::move(that.dict)) {}
+
 		/** Assignment operator
 		 * Copies all elements in dict
 		 */
 		Dict& operator=(const Dict& that);
 
+		/** Move assignment operator
+		 */
+		Dict& operator=(Dict&& that) noexcept
+		{
+			dict.swap(that.dict);
+			return *this;
+		}
+
 		/**	Get a vector containing all of the (string) keys in this dictionary.
 		 */
 		vector<string> keys()const
@@ -526,8 +562,9 @@ namespace EMAN
 		 */
 		EMObject get(const string & key) const
 		{
-			if( has_key(key) ) {
-				return dict[key];
+			auto p = dict.find(key);
+			if( p != dict.end() ) {
+				return p->second;
 			}
 			else {
 				LOGERR("No such key exist in this Dict");
@@ -568,10 +605,11 @@ namespace EMAN
 		template <typename type>
 		type set_default(const string & key, type val)
 		{
-			if (!has_key(key)) {
-				dict[key] = val;
+			auto p = dict.lower_bound(key);
+			if (p == dict.end() || p->first != key) {
+				p = dict.emplace_hint(p, key, EMObject(val));
 			}
-			return dict[key];
+			return p->second;
 		}
 
 		Dict copy_exclude_keys(const vector<string>& excluded_keys) const
@@ -721,10 +721,8 @@ void EMUtil::close_imageio(const string & filename, const ImageIO * io)
 {
     //printf("EMUtil::close_imageio\n");
     #ifdef IMAGEIO_CACHE
-    if (GlobalCache::instance()->contains(filename)) {
-        GlobalCache::instance()->close_imageio(filename);
-    } else {
-        delete io;
+    if (!GlobalCache::instance()->close_imageio(filename, io)) {
+        delete io;		// opened outside the cache
     }
     #else
     delete io;
@@ -1688,6 +1686,34 @@ vector<EMObject> EMUtil::get_all_attributes(const string & file_name, const stri
 	return v;
 }
 
+vector<EMObject> EMUtil::read_header_column(const string & filename, const string & key,
+											  vector<int> indices)
+{
+	ENTERFUNC;
+
+	int total_img = get_image_count(filename);
+
+	if (indices.empty()) {
+		indices.resize(total_img);
+		for (int i = 0; i < total_img; i++) indices[i] = i;
+	}
+	else {
+		for (size_t i = 0; i < indices.size(); i++)
+			if (indices[i] < 0 || indices[i] >= total_img)
+				throw OutofRangeException(0, total_img, indices[i], "image index");
+	}
+
+	ImageIOHandle imageio(filename, ImageIO::READ_ONLY);
+
+	if (!imageio)
+		throw ImageFormatException("cannot create an image io");
+
+	vector<EMObject> v = imageio->read_header_column(key, indices);
+
+	EXITFUNC;
+	return v;
+}
+
 void EMUtil::getRenderLimits(const Dict & dict, float & rendermin, float & rendermax, int & renderbits)
 {
 	// This routine used to have some complicated logic for specifying the limits in various ways
@@ -1842,6 +1868,16 @@ EMObject EMUtil::read_hdf_attribute(const string & filename, const string & key,
 	HdfIO2* imageio = new HdfIO2(filename, ImageIO::READ_ONLY);
 	imageio->init();
 
+	// packed stacks keep per-image metadata in shared datasets rather than groups
+	if (imageio->is_packed()) {
+		Dict dict;
+		imageio->read_header(dict, image_index);
+		delete imageio;
+
+		if (!dict.has_key(key)) return EMObject();
+		return dict[key];
+	}
+
 	// Each image is in a group for later expansion. Open the group
 	hid_t file = imageio->get_fileid();
 
@@ -1877,6 +1913,16 @@ int EMUtil::write_hdf_attribute(const string & filename, const string & key, EMO
 	HdfIO2* imageio = new HdfIO2(filename, ImageIO::WRITE_ONLY);
 	imageio->init();
 
+	if (imageio->is_packed()) {
+		Dict dict;
+		imageio->read_header(dict, image_index);
+		dict[key] = value;
+		int ret = imageio->write_header(dict, image_index);
+		delete imageio;
+
+		return ret;
+	}
+
 	// Each image is in a group for later expansion. Open the group
 
 	hid_t file = imageio->get_fileid();
@@ -1911,6 +1957,20 @@ int EMUtil::delete_hdf_attribute(const string & filename, const string & key, in
 	HdfIO2* imageio = new HdfIO2(filename, ImageIO::READ_WRITE);
 	imageio->init();
 
+	if (imageio->is_packed()) {
+		Dict dict;
+		imageio->read_header(dict, image_index);
+		if (!dict.has_key(key)) {
+			delete imageio;
+			return -1;
+		}
+		dict.erase(key);
+		int ret = imageio->write_header(dict, image_index);
+		delete imageio;
+
+		return ret;
+	}
+
 	// Each image is in a group for later expansion. Open the group
 
 	hid_t file = imageio->get_fileid();
@@ -299,6 +299,17 @@ namespace EMAN
 		 * @exception InvalidCallException when call this function for a non-stack image */
 		static vector<EMObject> get_all_attributes(const string & file_name, const string & attr_name);
 
+		/** Read one header attribute from many images in a file without
+		 * building a header dictionary for each image.
+		 *
+		 * @param filename the image file name
+		 * @param key The header attribute name.
+		 * @param indices The images to read. Empty means all images in the file.
+		 * @return one value per image; images without the attribute give an empty EMObject
+		 * @exception OutofRangeException when an index is outside the file */
+		static vector<EMObject> read_header_column(const string & filename, const string & key,
+												   vector<int> indices = vector<int>());
+
 		/** Get the min and max pixel value accepted for image nomalization
 		 * from image attribute dictionary, or return zeroes if not present
 		 *
@@ -413,6 +424,29 @@ namespace EMAN
 
 	};
 
+	/** ImageIOHandle holds one reference to an ImageIO from EMUtil::get_imageio()
+	 * and returns it through EMUtil::close_imageio() when it goes out of scope, so
+	 * cached handles are released even when reading throws.
+	 */
+	class ImageIOHandle
+	{
+	  public:
+		ImageIOHandle(const string & fname, int rw_mode, EMUtil::ImageType image_type = EMUtil::IMAGE_UNKNOWN)
+			: filename(fname), io(EMUtil::get_imageio(fname, rw_mode, image_type)) {}
+		~ImageIOHandle() { if (io) EMUtil::close_imageio(filename, io); }
+
+		ImageIO *get() const { return io; }
+		ImageIO *operator->() const { return io; }
+		operator bool() const { return io != 0; }
+
+	  private:
+		ImageIOHandle(const ImageIOHandle &);
+		ImageIOHandle & operator=(const ImageIOHandle &);
+
+		string filename;
+		ImageIO *io;
+	};
+
 	struct ImageScore {
 		int index;
 		float score;
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2000-2006 Baylor College of Medicine
+ * 
+ * This software is issued under a joint BSD/GNU license. You may use the
+ * source code in this file under either license. However, note that the
+ * complete EMAN2 and SPARX software packages have some GPL dependencies,
+ * so you are responsible for compliance with the licenses of these packages
+ * if you opt to use BSD licensing. The warranty disclaimer below holds
+ * in either instance.
+ * 
+ * This complete copyright notice must be included in any revised version of the
+ * source code. Additional authorship citations may be added, but existing
+ * author citations must be preserved.
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ * 
+ * */
+ 
+
+#include "imagestream.h"
+#include "emdata.h"
+#include "emutil.h"
+#include "io/imageio.h"
+#include "exception.h"
+
+using namespace EMAN;
+
+ImageStackReader::ImageStackReader(const string & fname, const vector<int> & img_indices,
+								   int nahead, bool hdr_only)
+	: filename(fname), indices(img_indices), readahead(0), header_only(hdr_only),
+	  position(0), finished(false), stop(false)
+{
+	ENTERFUNC;
+
+	if (nahead < 1)
+		throw InvalidValueException(nahead, "readahead must be >= 1");
+	readahead = (size_t)nahead;
+
+	int total_img = EMUtil::get_image_count(filename);
+	for (size_t i = 0; i < indices.size(); i++)
+		if (indices[i] < 0 || indices[i] >= total_img)
+			throw OutofRangeException(0, total_img, indices[i], "image index");
+
+	if (indices.empty()) {
+		indices.resize(total_img);
+		for (int i = 0; i < total_img; i++) indices[i] = i;
+	}
+
+	worker = std::thread(&ImageStackReader::run, this);
+
+	EXITFUNC;
+}
+
+ImageStackReader::~ImageStackReader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	cond.notify_all();
+	if (worker.joinable()) worker.join();
+
+	for (size_t i = 0; i < ready.size(); i++)
+		if (ready[i].img) delete ready[i].img;
+	for (size_t i = 0; i < pool.size(); i++)
+		EMUtil::em_free(pool[i]);
+}
+
+void ImageStackReader::run()
+{
+	ImageIO *imageio = 0;
+	try {
+		imageio = EMUtil::get_imageio(filename, ImageIO::READ_ONLY);
+		if (!imageio)
+			throw ImageFormatException("cannot create an image io");
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lock(mutex);
+		Slot s = { 0, std::current_exception() };
+		ready.push_back(s);
+		finished = true;
+		cond.notify_all();
+		return;
+	}
+
+	for (size_t i = 0; i < indices.size(); i++) {
+		float *buf = 0;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cond.wait(lock, [this] { return stop || ready.size() < readahead; });
+			if (stop) break;
+			if (!header_only && !pool.empty()) {
+				buf = pool.back();
+				pool.pop_back();
+			}
+		}
+
+		// a recycled buffer is handed to the image with a nonzero size, so
+		// set_size() reallocs it in place rather than allocating and zeroing
+		Slot s = { new EMData(), std::exception_ptr() };
+		if (buf) s.img->set_data(buf, 1, 1, 1);
+		try {
+			s.img->_read_image(imageio, indices[i], header_only);
+		}
+		catch (...) {
+			delete s.img;
+			s.img = 0;
+			s.err = std::current_exception();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			ready.push_back(s);
+		}
+		cond.notify_all();
+		if (s.err) break;
+	}
+
+	EMUtil::close_imageio(filename, imageio);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	finished = true;
+	cond.notify_all();
+}
+
+EMData *ImageStackReader::next()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	cond.wait(lock, [this] { return finished || !ready.empty(); });
+	if (ready.empty()) return 0;
+
+	Slot s = ready.front();
+	ready.pop_front();
+	lock.unlock();
+	cond.notify_all();
+
+	if (s.err) std::rethrow_exception(s.err);
+	position++;
+	return s.img;
+}
+
+void ImageStackReader::recycle(EMData * img)
+{
+	if (!img) return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!header_only && pool.size() <= readahead) {
+			float *buf = img->get_data();
+			if (buf) {
+				img->set_data(0);
+				pool.push_back(buf);
+			}
+		}
+	}
+	delete img;
+}
+
+ImageStackWriter::ImageStackWriter(const string & fname, int first, int queue,
+								   EMUtil::EMDataType storage, EMUtil::ImageType type)
+	: filename(fname), first_index(first), queue_size(0), filestoragetype(storage),
+	  imgtype(type), count(0), closing(false), finished(false)
+{
+	ENTERFUNC;
+
+	if (queue < 1)
+		throw InvalidValueException(queue, "queue must be >= 1");
+	queue_size = (size_t)queue;
+
+	if (imgtype == EMUtil::IMAGE_UNKNOWN) {
+		string::size_type pos = filename.rfind('.');
+		if (pos != string::npos)
+			imgtype = EMUtil::get_image_ext_type(filename.substr(pos+1));
+	}
+
+	worker = std::thread(&ImageStackWriter::run, this);
+
+	EXITFUNC;
+}
+
+ImageStackWriter::~ImageStackWriter()
+{
+	try {
+		close();
+	}
+	catch (...) {
+	}
+}
+
+void ImageStackWriter::run()
+{
+	ImageIO *imageio = 0;
+	try {
+		ImageIO::IOMode rwmode = (first_index == 0 ? ImageIO::WRITE_ONLY : ImageIO::READ_WRITE);
+		imageio = EMUtil::get_imageio(filename, rwmode, imgtype);
+		if (!imageio)
+			throw ImageFormatException("cannot create an image io");
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lock(mutex);
+		err = std::current_exception();
+		finished = true;
+		cond.notify_all();
+		return;
+	}
+
+	int index = first_index;
+	std::deque<EMData *> batch;
+	std::exception_ptr failed;
+	while (!failed) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cond.wait(lock, [this] { return closing || !pending.empty(); });
+			if (pending.empty()) break;		// closing, and everything is written
+			batch.swap(pending);
+		}
+		cond.notify_all();		// room in the queue again
+
+		try {
+			for (size_t i = 0; i < batch.size(); i++) {
+				batch[i]->_write_image(imageio, index, imgtype, false, 0, filestoragetype, true, false);
+				if (index >= 0) index++;
+			}
+		}
+		catch (...) {
+			failed = std::current_exception();
+		}
+
+		for (size_t i = 0; i < batch.size(); i++)
+			delete batch[i];
+		batch.clear();
+	}
+
+	if (!failed && imgtype != EMUtil::IMAGE_PNG)
+		imageio->flush();
+	EMUtil::close_imageio(filename, imageio);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	err = failed;
+	finished = true;
+	cond.notify_all();
+}
+
+void ImageStackWriter::write(const EMData & img)
+{
+	EMData *copy = new EMData(img);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	cond.wait(lock, [this] { return finished || closing || pending.size() < queue_size; });
+	if (err || closing || finished) {
+		delete copy;
+		if (err) std::rethrow_exception(err);
+		throw ImageWriteException(filename, "write() after the stack writer was closed");
+	}
+
+	pending.push_back(copy);
+	count++;
+	lock.unlock();
+	cond.notify_all();
+}
+
+void ImageStackWriter::close()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closing = true;
+	}
+	cond.notify_all();
+	if (worker.joinable()) worker.join();
+
+	std::exception_ptr e;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (size_t i = 0; i < pending.size(); i++)
+			delete pending[i];
+		pending.clear();
+		e = err;
+		err = std::exception_ptr();
+	}
+	if (e) std::rethrow_exception(e);
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2000-2006 Baylor College of Medicine
+ * 
+ * This software is issued under a joint BSD/GNU license. You may use the
+ * source code in this file under either license. However, note that the
+ * complete EMAN2 and SPARX software packages have some GPL dependencies,
+ * so you are responsible for compliance with the licenses of these packages
+ * if you opt to use BSD licensing. The warranty disclaimer below holds
+ * in either instance.
+ * 
+ * This complete copyright notice must be included in any revised version of the
+ * source code. Additional authorship citations may be added, but existing
+ * author citations must be preserved.
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ * 
+ * */
+ 
+
+#ifndef eman__imagestream_h__
+#define eman__imagestream_h__ 1
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include "emutil.h"
+
+using std::string;
+using std::vector;
+
+namespace EMAN
+{
+	class EMData;
+
+	/** ImageStackReader streams the images of a stack file (HDF, MRCS, LST, ...)
+	 * through a background I/O thread. The thread reads up to 'readahead' images
+	 * ahead of the consumer, so disk access, byte swapping and conversion of
+	 * int16/uint8/bit-reduced data to float (done by each ImageIO's read_data)
+	 * overlap with whatever the caller does with the previous image.
+	 *
+	 * Images returned by next() belong to the caller. Passing them back through
+	 * recycle() when finished lets the reader reuse their pixel buffers for
+	 * subsequent reads instead of allocating (and page-faulting) a fresh one
+	 * for every particle.
+	 *
+	 * While a reader is active, the same file should not be read or written by
+	 * other threads; with IMAGEIO_CACHE the ImageIO object may be shared. HDF5
+	 * files additionally require a thread-safe HDF5 library if other HDF5 files
+	 * are accessed concurrently.
+	 *
+	 * Typical use:
+	 * @code
+	 * ImageStackReader rdr("particles.hdf");
+	 * while (EMData *img = rdr.next()) {
+	 *     ...
+	 *     rdr.recycle(img);
+	 * }
+	 * @endcode
+	 */
+	class ImageStackReader
+	{
+	  public:
+		/** @param filename Stack to read.
+		 * @param img_indices Images to read, in order. Empty means every image in the file.
+		 * @param readahead Maximum number of decoded images held ahead of the consumer.
+		 * @param header_only Read headers only.
+		 * @exception OutofRangeException if an index is outside the file.
+		 */
+		ImageStackReader(const string & filename, const vector<int> & img_indices = vector<int>(),
+						 int readahead = 16, bool header_only = false);
+		~ImageStackReader();
+
+		/** Return the next image in the sequence, waiting for the I/O thread
+		 * if necessary. The caller owns the returned image.
+		 * @return The next image, or 0 once the sequence is exhausted.
+		 * @exception Any exception raised while reading the image.
+		 */
+		EMData *next();
+
+		/** Hand an image obtained from next() (or any other image of the same
+		 * size) back to the reader. The image is deleted and its pixel buffer
+		 * kept for reuse by later reads.
+		 */
+		void recycle(EMData * img);
+
+		/** @return The number of images in the sequence. */
+		int get_count() const { return (int)indices.size(); }
+
+		/** @return The number of images already returned by next(). */
+		int get_position() const { return position; }
+
+	  private:
+		ImageStackReader(const ImageStackReader &);
+		ImageStackReader & operator=(const ImageStackReader &);
+
+		void run();
+
+		struct Slot {
+			EMData *img;
+			std::exception_ptr err;
+		};
+
+		string filename;
+		vector<int> indices;
+		size_t readahead;
+		bool header_only;
+		int position;
+
+		std::deque<Slot> ready;
+		vector<float *> pool;
+		bool finished;
+		bool stop;
+		std::mutex mutex;
+		std::condition_variable cond;
+		std::thread worker;
+	};
+
+	/** ImageStackWriter writes a stack file from a background I/O thread
+	 * (write-behind). write() queues a copy of the image and returns at once
+	 * unless 'queue' images are already waiting. The thread takes everything
+	 * queued at each wake-up and writes it through one ImageIO that stays open
+	 * for the life of the writer, so a long run of appends becomes sequential
+	 * writes with the file flushed once, at close(), instead of an open,
+	 * header update and flush per image as with EMData::write_image().
+	 *
+	 * An error in the I/O thread stops the writing; it is rethrown by the next
+	 * write() or by close(). The file should not be accessed by anything else
+	 * until close() returns.
+	 *
+	 * Typical use:
+	 * @code
+	 * ImageStackWriter wtr("aligned.hdf");
+	 * for (...) {
+	 *     ...
+	 *     wtr.write(*img);
+	 * }
+	 * wtr.close();
+	 * @endcode
+	 */
+	class ImageStackWriter
+	{
+	  public:
+		/** @param filename Stack to write.
+		 * @param first_index File index of the first image written; later images
+		 *     follow it. -1 appends each image to the end of the file.
+		 * @param queue Maximum number of images waiting to be written.
+		 * @param filestoragetype The image data type used in the file.
+		 * @param imgtype File format. By default it comes from the extension.
+		 * @exception InvalidValueException if queue < 1.
+		 */
+		ImageStackWriter(const string & filename, int first_index = -1, int queue = 64,
+						 EMUtil::EMDataType filestoragetype = EMUtil::EM_FLOAT,
+						 EMUtil::ImageType imgtype = EMUtil::IMAGE_UNKNOWN);
+
+		/** Calls close(), discarding any error. */
+		~ImageStackWriter();
+
+		/** Queue a copy of img to be written after the images already queued.
+		 * @exception ImageWriteException if the writer is closed.
+		 * @exception Any exception raised while writing an earlier image.
+		 */
+		void write(const EMData & img);
+
+		/** Write everything still queued, flush and close the file. Further
+		 * calls do nothing.
+		 * @exception Any exception raised while writing.
+		 */
+		void close();
+
+		/** @return The number of images passed to write(). */
+		int get_count() const { return count; }
+
+	  private:
+		ImageStackWriter(const ImageStackWriter &);
+		ImageStackWriter & operator=(const ImageStackWriter &);
+
+		void run();
+
+		string filename;
+		int first_index;
+		size_t queue_size;
+		EMUtil::EMDataType filestoragetype;
+		EMUtil::ImageType imgtype;
+		int count;
+
+		std::deque<EMData *> pending;
+		std::exception_ptr err;
+		bool closing;
+		bool finished;
+		std::mutex mutex;
+		std::condition_variable cond;
+		std::thread worker;
+	};
+}
+
+#endif	//eman__imagestream_h__
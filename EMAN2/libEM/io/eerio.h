@@ -186,6 +186,16 @@ namespace EMAN
 		int get_nimg();
 		bool is_single_image_format() const override;
 
+		/** Sum the electron counts of a group of consecutive frames.
+		 *
+		 * @param rdata Output image, num_pix x num_pix of the decoder.
+		 * @param first The first frame of the group.
+		 * @param count The number of frames to sum.
+		 * @param nthreads Frames decoded at once, 0 to use all cores.
+		 * @return 0 if OK.
+		 */
+		int read_frames(float *rdata, int first, int count, int nthreads = 0);
+
 
 		DEFINE_IMAGEIO_FUNC;
 
@@ -34,6 +34,7 @@
 // #define DEBUGHDF	1
 
 #include "hdfio2.h"
+#include "headerjson.h"
 #include "geometry.h"
 #include "ctf.h"
 #include "emassert.h"
@@ -42,6 +43,10 @@
 
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
 #include <inttypes.h>
 
 #ifndef WIN32
@@ -54,9 +59,115 @@ using namespace EMAN;
 
 static const int ATTR_NAME_LEN = 128;
 
+// Columnar header values in the packed stack layout. Values of any other type
+// (or CTFs with background/SNR curves) go to the JSON header instead.
+struct PackedColumn {
+	const char *key;
+	EMObject::ObjectType type;
+	int width;
+};
+
+static const PackedColumn packed_columns[] = {
+	{ "xform.projection", EMObject::TRANSFORM, 12 },
+	{ "xform.align2d",    EMObject::TRANSFORM, 12 },
+	{ "xform.align3d",    EMObject::TRANSFORM, 12 },
+	{ "ctf",              EMObject::CTF,        9 },
+	{ "class_id",         EMObject::INT,        1 },
+	{ "score",            EMObject::FLOAT,      1 }
+};
+
+static const int NUM_PACKED_COLUMNS = sizeof(packed_columns) / sizeof(PackedColumn);
+static const int PACKED_INT_UNSET = INT_MIN;
+
+// Converts one row of a float packed column back to a header value
+static EMObject packed_value(const PackedColumn & pc, const float *v)
+{
+	if (pc.type == EMObject::TRANSFORM) {
+		Transform t(vector<float>(v, v + 12));
+		return EMObject(&t);
+	}
+	else if (pc.type == EMObject::CTF) {
+		EMAN2Ctf ctf;
+		ctf.defocus = v[0];
+		ctf.dfdiff = v[1];
+		ctf.dfang = v[2];
+		ctf.bfactor = v[3];
+		ctf.ampcont = v[4];
+		ctf.voltage = v[5];
+		ctf.cs = v[6];
+		ctf.apix = v[7];
+		ctf.dsbg = v[8];
+		return EMObject(&ctf);
+	}
+
+	return EMObject(v[0]);
+}
+
+// Reads or writes rows [first, first+count) of a dataset whose first dimension is the image number
+static herr_t h5_rows_io(hid_t ds, hid_t memtype, hsize_t first, hsize_t count, void *buf, bool write)
+{
+	hid_t filespace = H5Dget_space(ds);
+	int rank = H5Sget_simple_extent_ndims(filespace);
+	hsize_t dims[3], offset[3] = { first, 0, 0 };
+
+	H5Sget_simple_extent_dims(filespace, dims, NULL);
+	dims[0] = count;
+	H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset, NULL, dims, NULL);
+	hid_t memspace = H5Screate_simple(rank, dims, NULL);
+
+	herr_t err;
+	if (write) err = H5Dwrite(ds, memtype, memspace, filespace, H5P_DEFAULT, buf);
+	else       err = H5Dread(ds, memtype, memspace, filespace, H5P_DEFAULT, buf);
+
+	H5Sclose(memspace);
+	H5Sclose(filespace);
+	return err;
+}
+
+static hid_t h5_vlen_string()
+{
+	hid_t type = H5Tcopy(H5T_C_S1);
+	H5Tset_size(type, H5T_VARIABLE);
+	return type;
+}
+
+// Creates a dataset with an unlimited first (image) dimension
+static hid_t h5_create_rows(hid_t file, const char *path, hid_t type, int rank, const hsize_t *dims,
+							hsize_t chunkrows, const void *fill)
+{
+	hsize_t maxdims[3] = { H5S_UNLIMITED, rank > 1 ? dims[1] : 0, rank > 2 ? dims[2] : 0 };
+	hsize_t chunk[3] = { chunkrows, maxdims[1], maxdims[2] };
+
+	hid_t spc = H5Screate_simple(rank, dims, maxdims);
+	hid_t plist = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_chunk(plist, rank, chunk);
+	if (fill) H5Pset_fill_value(plist, type, fill);
+
+	hid_t ds = H5Dcreate(file, path, type, spc, plist);
+
+	H5Pclose(plist);
+	H5Sclose(spc);
+	return ds;
+}
+
+static void h5_extend_rows(hid_t ds, hsize_t n)
+{
+	hid_t spc = H5Dget_space(ds);
+	hsize_t dims[3];
+
+	H5Sget_simple_extent_dims(spc, dims, NULL);
+	H5Sclose(spc);
+
+	if (dims[0] < n) {
+		dims[0] = n;
+		H5Dset_extent(ds, dims);
+	}
+}
+
 HdfIO2::HdfIO2(const string & fname, IOMode rw)
 :	ImageIO(fname, rw), nx(1), ny(1), nz(1), is_exist(false),
-	file(-1), group(-1)
+	file(-1), group(-1), chunk_mode("brick"), chunk_edge(64), compress_shuffle(true),
+	rd_ds(-1), rd_index(-1), packed(false), pk_stack(-1), pk_header(-1)
 {
 	H5dont_atexit();
 	accprop=H5Pcreate(H5P_FILE_ACCESS);
@@ -81,8 +192,14 @@ HdfIO2::HdfIO2(const string & fname, IOMode rw)
 
 HdfIO2::~HdfIO2()
 {
+	close_image_dataset();
 	H5Sclose(simple_space);
 	H5Pclose(accprop);
+	if (pk_stack >= 0) H5Dclose(pk_stack);
+	if (pk_header >= 0) H5Dclose(pk_header);
+	for (map<string, hid_t>::iterator it = pk_columns.begin(); it != pk_columns.end(); ++it) {
+		H5Dclose(it->second);
+	}
    if (group >= 0) {
       H5Gclose(group);
    }
@@ -485,7 +602,10 @@ void HdfIO2::init()
 			hid_t attr=H5Aopen_by_idx(group,".",H5_INDEX_CRT_ORDER,H5_ITER_NATIVE,i,H5P_DEFAULT,H5P_DEFAULT);
 			H5Aget_name(attr,127,name);
 
-			if (strcmp(name,"imageid_max")!=0) {
+			if (strcmp(name,"packed_layout")==0) {
+				packed = (int)read_attr(attr) != 0;
+			}
+			else if (strcmp(name,"imageid_max")!=0) {
 				EMObject val=read_attr(attr);
 				meta_attr_dict["Group."+string(name)]=val;
 			}
@@ -493,6 +613,8 @@ void HdfIO2::init()
 			H5Aclose(attr);
 		}
 
+		if (packed) open_packed();
+
 	}
 	initialized = true;
 	EXITFUNC;
@@ -608,18 +730,25 @@ int HdfIO2::read_header(Dict & dict, int image_index, const Region * area, bool)
 
 	// Each image is in a group for later expansion. Open the group
 	char ipath[50];
-	sprintf(ipath,"/MDF/images/%d", image_index);
-	hid_t igrp=H5Gopen(file, ipath);
+	hid_t igrp=-1;
 
-	if (igrp<0) {
-		char msg[40];
-		sprintf(msg,"Image %d does not exist",image_index); // yes, sprintf(), terrible I know
-		throw ImageReadException(filename,msg);
+	if (packed) {
+		read_packed_header(dict, image_index);
 	}
-	
-	hsize_t n=0;
-	if (H5Aiterate2(igrp,H5_INDEX_NAME, H5_ITER_NATIVE, &n, &h5_iter_attr_read, &dict)) {
-		printf("Error on HDF5 iter attr\n");
+	else {
+		sprintf(ipath,"/MDF/images/%d", image_index);
+		igrp=H5Gopen(file, ipath);
+
+		if (igrp<0) {
+			char msg[40];
+			sprintf(msg,"Image %d does not exist",image_index); // yes, sprintf(), terrible I know
+			throw ImageReadException(filename,msg);
+		}
+
+		hsize_t n=0;
+		if (H5Aiterate2(igrp,H5_INDEX_NAME, H5_ITER_NATIVE, &n, &h5_iter_attr_read, &dict)) {
+			printf("Error on HDF5 iter attr\n");
+		}
 	}
 
 	// if apix is unset, see if we can find it elsewhere
@@ -669,6 +798,11 @@ int HdfIO2::read_header(Dict & dict, int image_index, const Region * area, bool)
 		}
 	}
 
+	if (packed) {	// size and data type came from the stack dataset
+		EXITFUNC;
+		return 0;
+	}
+
 	H5Gclose(igrp);
 
 	//Get the data type from data set, HDF5 file header attribute 'datatype' may be wrong
@@ -714,28 +848,28 @@ int HdfIO2::read_header(Dict & dict, int image_index, const Region * area, bool)
 		H5Sclose(spc);
 	}
 
-	// FIXME - This isn't valid any more, since we support signed and unsigned, and have compression
+	dict["datatype"] = dataset_datatype(dt);
+
+	H5Tclose(dt);
+	H5Dclose(ds);
+
+	EXITFUNC;
+	return 0;
+}
 
+// FIXME - This isn't valid any more, since we support signed and unsigned, and have compression
+int HdfIO2::dataset_datatype(hid_t dt)
+{
 	switch(H5Tget_size(dt)) {
 	case 4:
-		dict["datatype"] = (int)EMUtil::EM_FLOAT;
-		break;
+		return (int)EMUtil::EM_FLOAT;
 	case 2:
-		dict["datatype"] = (int)EMUtil::EM_USHORT;
-		break;
+		return (int)EMUtil::EM_USHORT;
 	case 1:
-		dict["datatype"] = (int)EMUtil::EM_UCHAR;
-		break;
+		return (int)EMUtil::EM_UCHAR;
 	default:
 		throw ImageReadException(filename, "EMAN does not support this data type.");
 	}
-
-
-	H5Tclose(dt);
-	H5Dclose(ds);
-
-	EXITFUNC;
-	return 0;
 }
 
 // This erases any existing attributes from the image group
@@ -749,6 +883,10 @@ int HdfIO2::erase_header(int image_index)
 
 	init();
 
+	if (packed) return 0;	// write_packed_header() rewrites the whole row
+
+	close_image_dataset();
+
 #ifdef DEBUGHDF
 	printf("HDF: erase_head %d\n",image_index);
 #endif
@@ -778,6 +916,8 @@ int HdfIO2::read_data_8bit(unsigned char *data, int image_index, const Region *a
 	printf("HDF: read_data_8bit %d\n",image_index);
 #endif
 
+	if (packed) throw ImageReadException(filename, "8 bit reading not supported for packed HDF stacks");
+
 	char ipath[50];
 	sprintf(ipath,"/MDF/images/%d/image",image_index);
 	hid_t ds = H5Dopen(file,ipath);
@@ -1022,9 +1162,10 @@ int HdfIO2::read_data(float *data, int image_index, const Region *area, bool)
 	printf("HDF: read_data %d\n",image_index);
 #endif
 
+	if (packed) return read_packed_data(data, image_index, area);
+
 	char ipath[50];
-	sprintf(ipath,"/MDF/images/%d/image",image_index);
-	hid_t ds = H5Dopen(file,ipath);
+	hid_t ds = open_image_dataset(image_index);
 
 	if (ds < 0) throw ImageReadException(filename,"Image does not exist");
 
@@ -1230,7 +1371,6 @@ int HdfIO2::read_data(float *data, int image_index, const Region *area, bool)
 
 	H5Tclose(dt);
 	H5Sclose(spc);
-	H5Dclose(ds);
 	// Rescale data on read if bit reduction took place
 	sprintf(ipath,"/MDF/images/%d",image_index);
 	hid_t igrp=H5Gopen(file,ipath);
@@ -1273,11 +1413,28 @@ int HdfIO2::write_header(const Dict & dict, int image_index, const Region* area,
 	ENTERFUNC;
 
 	init();
+	close_image_dataset();
 
 	nx = (int)dict["nx"];
 	ny = (int)dict["ny"];
 	nz = (int)dict["nz"];
 
+	chunk_mode = dict.has_key("hdf_chunk") ? (string)dict["hdf_chunk"] : string("brick");
+	chunk_edge = dict.has_key("hdf_chunk_size") ? (int)dict["hdf_chunk_size"] : 64;
+	compress_shuffle = dict.has_key("render_compress_shuffle") ? (int)dict["render_compress_shuffle"] != 0 : true;
+	if (chunk_mode != "brick" && chunk_mode != "slice") {
+		throw ImageWriteException(filename, "hdf_chunk must be 'brick' or 'slice'");
+	}
+	if (chunk_edge < 1) throw ImageWriteException(filename, "hdf_chunk_size must be positive");
+
+	// the first image written to a new file may select the packed stack layout
+	if (!packed && dict.has_key("hdf_packed") && (int)dict["hdf_packed"] && get_nimg() == 0) {
+		write_attr(group, "packed_layout", EMObject(1));
+		packed = true;
+	}
+
+	if (packed) return write_packed_header(dict, image_index, area);
+
 	if (image_index<0) {
 		image_index = get_nimg();
 	}
@@ -1367,6 +1524,92 @@ int HdfIO2::write_header(const Dict & dict, int image_index, const Region* area,
 	return 0;
 }
 
+// Chunk shape for a compressed image of eltsize byte values, slowest axis first. Returns the rank.
+int HdfIO2::chunk_dims(hsize_t *cdims, size_t eltsize) const
+{
+	const hsize_t target = (1 << 20) / eltsize;		// ~1 MB of stored values per chunk
+
+	if (nz == 1 && ny == 1) {
+		cdims[0] = std::min(nx, target);
+		return 1;
+	}
+
+	if (nz == 1) {
+		cdims[0] = std::min(ny, std::max((hsize_t)1, target / nx));	// bands of whole rows
+		cdims[1] = nx;
+		return 2;
+	}
+
+	if (chunk_mode == "slice") {
+		cdims[0] = 1;
+		cdims[1] = ny;
+		cdims[2] = nx;
+	}
+	else {
+		hsize_t edge = chunk_edge;
+		cdims[0] = std::min(nz, edge);
+		cdims[1] = std::min(ny, edge);
+		cdims[2] = std::min(nx, edge);
+	}
+	return 3;
+}
+
+// Opens /MDF/images/N/image, or returns the already open dataset. Chunked datasets get a cache
+// big enough for one layer of chunks across X and Y (4 MB - 256 MB), so reading a volume slice
+// by slice, or box by box, decompresses each chunk once rather than once per read.
+hid_t HdfIO2::open_image_dataset(int image_index)
+{
+	if (rd_ds >= 0 && rd_index == image_index) return rd_ds;
+	close_image_dataset();
+
+	char ipath[50];
+	sprintf(ipath,"/MDF/images/%d/image",image_index);
+	hid_t ds = H5Dopen(file,ipath);
+	if (ds < 0) return ds;
+
+	hid_t cpl = H5Dget_create_plist(ds);
+	if (H5Pget_layout(cpl) == H5D_CHUNKED) {
+		hsize_t cdims[3] = { 1, 1, 1 };
+		hsize_t dims[3] = { 1, 1, 1 };
+		int crank = H5Pget_chunk(cpl, 3, cdims);
+
+		hid_t spc = H5Dget_space(ds);
+		H5Sget_simple_extent_dims(spc, dims, NULL);
+		H5Sclose(spc);
+
+		hid_t dt = H5Dget_type(ds);
+		size_t chunkbytes = H5Tget_size(dt);
+		H5Tclose(dt);
+
+		size_t nchunks = 1;
+		for (int i = 0; i < crank; i++) chunkbytes *= cdims[i];
+		for (int i = (crank > 2 ? 1 : 0); i < crank; i++) nchunks *= (dims[i] + cdims[i] - 1) / cdims[i];
+
+		const size_t minbytes = (size_t)4 << 20, maxbytes = (size_t)256 << 20;
+		size_t nbytes = std::max(minbytes, std::min(maxbytes, chunkbytes * nchunks));
+
+		if (nbytes > minbytes) {
+			H5Dclose(ds);
+			hid_t dapl = H5Pcreate(H5P_DATASET_ACCESS);
+			H5Pset_chunk_cache(dapl, 12421, nbytes, 0.75);
+			ds = H5Dopen2(file, ipath, dapl);
+			H5Pclose(dapl);
+		}
+	}
+	H5Pclose(cpl);
+
+	rd_ds = ds;
+	rd_index = image_index;
+	return ds;
+}
+
+void HdfIO2::close_image_dataset()
+{
+	if (rd_ds >= 0) H5Dclose(rd_ds);
+	rd_ds = -1;
+	rd_index = -1;
+}
+
 hid_t HdfIO2::em_to_hdf(EMUtil::EMDataType dt) {
 	switch(dt) {
 		case EMUtil::EM_FLOAT:
@@ -1414,6 +1657,10 @@ int HdfIO2::write_data(float *data, int image_index, const Region* area,
 		H5Aclose(attr);
 	}
 
+	if (packed) return write_packed_data(data, image_index, area);
+
+	close_image_dataset();
+
 	char ipath[50];
 	hid_t spc;	//dataspace
 	hid_t ds;	//dataset
@@ -1472,19 +1719,14 @@ int HdfIO2::write_data(float *data, int image_index, const Region* area,
 	if (ds < 0) {	//new dataset
 		hid_t plist = H5Pcreate(H5P_DATASET_CREATE);	// we could just use H5P_DEFAULT for non-compressed
 		if (dt==EMUtil::EM_COMPRESSED) {
-			if (nz==1) {
-				//hsize_t cdims[2] = { ny>256?256:ny, nx>256?256:nx};		// whole image for 2-D
-				//hsize_t cdims[2] = { ny>512?int(2+ny/(ny/512+1)):ny, int(2+nx>512?(nx/512+1)):nx};		// whole image for 2-D < 512
-				hsize_t cdims[2] = { 8, nx};		// match nx, 8 for ny is just to make the chunk a bit larger
-				H5Pset_chunk(plist,2,cdims);	// uses only the first 2 elements
-			}
-			else {
-				//hsize_t cdims[3] = { 1, ny>256?256:ny, nx>256?256:nx};		// slice-wise reading common in 3D so 2-D chunks
-				//hsize_t cdims[3] = { 1, ny>512?int(2+ny/(ny/512+1)):ny, int(2+nx>512?(nx/512+1)):nx};		// whole image for 2-D < 512
-				hsize_t cdims[3] = { 1, 8, nx};		// nx so that axis is matched, 8 arbitrary to make block size a bit larger
-				H5Pset_chunk(plist,3,cdims);
-			}
-			H5Pset_deflate(plist, renderlevel);		// zlib level default is 1
+			size_t eltsize = H5Tget_size(hdt);
+			hsize_t cdims[3];
+			int crank = chunk_dims(cdims, eltsize);
+			H5Pset_chunk(plist, crank, cdims);
+
+			// shuffling the bytes of 16/32 bit values groups the slowly varying high bytes, which deflate compresses far better
+			if (compress_shuffle && eltsize > 1) H5Pset_shuffle(plist);
+			if (renderlevel > 0) H5Pset_deflate(plist, renderlevel);		// zlib level default is 1
 		}
 
 		ds=H5Dcreate(file,ipath, hdt, spc, plist );
@@ -1613,6 +1855,427 @@ int HdfIO2::write_data(float *data, int image_index, const Region* area,
 	return 0;
 }
 
+// Opens the datasets of an existing packed stack
+void HdfIO2::open_packed()
+{
+	pk_stack = H5Dopen(file, "/MDF/images/stack");
+	pk_header = H5Dopen(file, "/MDF/images/header");
+
+	for (int i = 0; i < NUM_PACKED_COLUMNS; i++) {
+		string path = string("/MDF/images/columns/") + packed_columns[i].key;
+		hid_t ds = H5Dopen(file, path.c_str());
+		if (ds >= 0) pk_columns[packed_columns[i].key] = ds;
+	}
+}
+
+// Creates the pixel and header datasets of a packed stack for nx*ny images
+void HdfIO2::create_packed()
+{
+	if (nz != 1) throw ImageWriteException(filename, "packed HDF stacks hold 2-D images only");
+
+	hsize_t dims[3] = { 0, ny, nx };
+	pk_stack = h5_create_rows(file, "/MDF/images/stack", H5T_NATIVE_FLOAT, 3, dims, 1, NULL);
+
+	hid_t strtype = h5_vlen_string();
+	pk_header = h5_create_rows(file, "/MDF/images/header", strtype, 1, dims, 1024, NULL);
+	H5Tclose(strtype);
+
+	hid_t cgrp = H5Gcreate(file, "/MDF/images/columns", 64);
+	if (pk_stack < 0 || pk_header < 0 || cgrp < 0) {
+		throw ImageWriteException(filename, "Unable to create packed HDF5 stack");
+	}
+	H5Gclose(cgrp);
+}
+
+// Returns the dataset for packed_columns[col], creating it (filled with the unset
+// marker for the images already in the file) if necessary
+hid_t HdfIO2::packed_column(int col)
+{
+	const PackedColumn & pc = packed_columns[col];
+	map<string, hid_t>::iterator it = pk_columns.find(pc.key);
+	if (it != pk_columns.end()) return it->second;
+
+	hid_t spc = H5Dget_space(pk_stack);
+	hsize_t dims[3];
+	H5Sget_simple_extent_dims(spc, dims, NULL);
+	H5Sclose(spc);
+
+	dims[1] = pc.width;
+	string path = string("/MDF/images/columns/") + pc.key;
+	float nanfill = std::numeric_limits<float>::quiet_NaN();
+	hid_t ds;
+	if (pc.type == EMObject::INT) {
+		ds = h5_create_rows(file, path.c_str(), H5T_NATIVE_INT, 1, dims, 1024, &PACKED_INT_UNSET);
+	}
+	else {
+		ds = h5_create_rows(file, path.c_str(), H5T_NATIVE_FLOAT, pc.width > 1 ? 2 : 1, dims, 1024, &nanfill);
+	}
+	if (ds < 0) throw ImageWriteException(filename, "Unable to create packed HDF5 column " + path);
+
+	pk_columns[pc.key] = ds;
+	return ds;
+}
+
+void HdfIO2::read_packed_header(Dict & dict, int image_index)
+{
+	if (image_index < 0 || image_index >= get_nimg() || pk_stack < 0) {
+		char msg[40];
+		sprintf(msg,"Image %d does not exist",image_index);
+		throw ImageReadException(filename,msg);
+	}
+
+	// everything that didn't fit a column
+	hid_t strtype = h5_vlen_string();
+	char *json = 0;
+	h5_rows_io(pk_header, strtype, image_index, 1, &json, false);
+	try {
+		json_decode_header(json, dict);
+	}
+	catch (E2Exception &) {
+		printf("HDF: Error decoding header of image %d\n", image_index);
+	}
+	if (json) {
+		hsize_t one = 1;
+		hid_t spc = H5Screate_simple(1, &one, NULL);
+		H5Dvlen_reclaim(strtype, spc, H5P_DEFAULT, &json);
+		H5Sclose(spc);
+	}
+	H5Tclose(strtype);
+
+	for (int i = 0; i < NUM_PACKED_COLUMNS; i++) {
+		const PackedColumn & pc = packed_columns[i];
+		map<string, hid_t>::iterator it = pk_columns.find(pc.key);
+		if (it == pk_columns.end()) continue;
+
+		if (pc.type == EMObject::INT) {
+			int v;
+			h5_rows_io(it->second, H5T_NATIVE_INT, image_index, 1, &v, false);
+			if (v != PACKED_INT_UNSET) dict[pc.key] = v;
+			continue;
+		}
+
+		float v[12];
+		h5_rows_io(it->second, H5T_NATIVE_FLOAT, image_index, 1, v, false);
+		if (!std::isnan(v[0])) dict[pc.key] = packed_value(pc, v);
+	}
+
+	hid_t spc = H5Dget_space(pk_stack);
+	hsize_t dims[3];
+	H5Sget_simple_extent_dims(spc, dims, NULL);
+	H5Sclose(spc);
+
+	dict["nx"] = (int)dims[2];
+	dict["ny"] = (int)dims[1];
+	dict["nz"] = 1;
+	dict["datatype"] = (int)EMUtil::EM_FLOAT;
+}
+
+int HdfIO2::write_packed_header(const Dict & dict, int image_index, const Region * area)
+{
+	if (area) throw ImageWriteException(filename, "Region writing is not supported for packed HDF stacks");
+
+	if (pk_stack < 0) {
+		create_packed();
+	}
+	else {
+		hid_t spc = H5Dget_space(pk_stack);
+		hsize_t dims[3];
+		H5Sget_simple_extent_dims(spc, dims, NULL);
+		H5Sclose(spc);
+
+		if (nz != 1 || ny != dims[1] || nx != dims[2]) {
+			throw ImageWriteException(filename, "All images in a packed HDF stack must be 2-D and the same size");
+		}
+	}
+
+	int nimg = get_nimg();
+	if (image_index < 0) image_index = nimg;
+	if (image_index >= nimg) {
+		h5_extend_rows(pk_stack, image_index + 1);
+		h5_extend_rows(pk_header, image_index + 1);
+		for (map<string, hid_t>::iterator it = pk_columns.begin(); it != pk_columns.end(); ++it) {
+			h5_extend_rows(it->second, image_index + 1);
+		}
+		write_attr(group, "imageid_max", EMObject(image_index));
+	}
+
+	Dict rest = dict;
+	const char *skip[] = { "nx", "ny", "nz", "datatype", "hdf_packed",
+		"stored_rendermin", "stored_rendermax", "stored_renderbits",
+		"render_min", "render_max", "render_bits" };
+	for (size_t i = 0; i < sizeof(skip) / sizeof(skip[0]); i++) rest.erase(skip[i]);
+
+	for (int i = 0; i < NUM_PACKED_COLUMNS; i++) {
+		const PackedColumn & pc = packed_columns[i];
+		float v[12];
+		int iv = PACKED_INT_UNSET;
+		v[0] = std::numeric_limits<float>::quiet_NaN();
+
+		if (rest.has_key(pc.key)) {
+			EMObject obj = rest[pc.key];
+			bool stored = false;
+
+			if (pc.type == EMObject::TRANSFORM && obj.get_type() == EMObject::TRANSFORM) {
+				Transform *t = obj;
+				for (int r = 0, k = 0; r < 3; r++) {
+					for (int c = 0; c < 4; c++, k++) v[k] = t->at(r,c);
+				}
+				delete t;
+				stored = true;
+			}
+			else if (pc.type == EMObject::CTF && obj.get_type() == EMObject::CTF) {
+				Ctf *c = obj;
+				EMAN2Ctf *ctf = dynamic_cast<EMAN2Ctf *>(c);
+				if (ctf && ctf->background.empty() && ctf->snr.empty()) {
+					float cv[9] = { ctf->defocus, ctf->dfdiff, ctf->dfang, ctf->bfactor, ctf->ampcont,
+									ctf->voltage, ctf->cs, ctf->apix, ctf->dsbg };
+					memcpy(v, cv, sizeof(cv));
+					stored = true;
+				}
+				delete c;
+			}
+			else if (pc.type == EMObject::INT && obj.get_type() == EMObject::INT && (int)obj != PACKED_INT_UNSET) {
+				iv = obj;
+				stored = true;
+			}
+			else if (pc.type == EMObject::FLOAT && obj.get_type() == EMObject::FLOAT && !std::isnan((float)obj)) {
+				v[0] = obj;
+				stored = true;
+			}
+
+			if (stored) {
+				rest.erase(pc.key);
+			}
+		}
+
+		// an unset column only needs writing if it exists, to clear an overwritten image
+		bool unset = (pc.type == EMObject::INT ? iv == PACKED_INT_UNSET : std::isnan(v[0]));
+		if (unset && pk_columns.find(pc.key) == pk_columns.end()) continue;
+
+		hid_t ds = packed_column(i);
+		if (pc.type == EMObject::INT) h5_rows_io(ds, H5T_NATIVE_INT, image_index, 1, &iv, true);
+		else {
+			for (int k = 1; k < pc.width; k++) if (unset) v[k] = v[0];
+			h5_rows_io(ds, H5T_NATIVE_FLOAT, image_index, 1, v, true);
+		}
+	}
+
+	string json = json_encode_header(rest);
+	const char *s = json.c_str();
+	hid_t strtype = h5_vlen_string();
+	h5_rows_io(pk_header, strtype, image_index, 1, &s, true);
+	H5Tclose(strtype);
+
+	return 0;
+}
+
+int HdfIO2::read_packed_data(float *data, int image_index, const Region * area)
+{
+	if (image_index < 0 || image_index >= get_nimg() || pk_stack < 0) {
+		throw ImageReadException(filename,"Image does not exist");
+	}
+
+	if (!area) {
+		if (h5_rows_io(pk_stack, H5T_NATIVE_FLOAT, image_index, 1, data, false) < 0) {
+			throw ImageReadException(filename,"packed HDF5 read failed");
+		}
+		return 0;
+	}
+
+	// Regions are cut from the whole image, anything outside the image is zero
+	hid_t spc = H5Dget_space(pk_stack);
+	hsize_t dims[3];
+	H5Sget_simple_extent_dims(spc, dims, NULL);
+	H5Sclose(spc);
+
+	int pnx = (int)dims[2], pny = (int)dims[1];
+	vector<float> img((size_t)pnx * pny);
+	if (h5_rows_io(pk_stack, H5T_NATIVE_FLOAT, image_index, 1, img.data(), false) < 0) {
+		throw ImageReadException(filename,"packed HDF5 read failed");
+	}
+
+	int x0 = (int)area->x_origin(), y0 = (int)area->y_origin(), z0 = (int)area->z_origin();
+	int w = (int)area->get_width(), h = (int)area->get_height();
+	int d = area->get_ndim() > 2 ? (int)area->get_depth() : 1;
+	if (w < 1) w = 1;
+	if (h < 1) h = 1;
+	if (d < 1) d = 1;
+
+	for (int k = 0; k < d; k++) {
+		for (int j = 0; j < h; j++) {
+			float *row = data + ((size_t)k * h + j) * w;
+			int y = y0 + j;
+			for (int i = 0; i < w; i++) {
+				int x = x0 + i;
+				row[i] = (z0 + k == 0 && x >= 0 && x < pnx && y >= 0 && y < pny) ? img[(size_t)y * pnx + x] : 0.0f;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int HdfIO2::write_packed_data(float *data, int image_index, const Region * area)
+{
+	if (area) throw ImageWriteException(filename, "Region writing is not supported for packed HDF stacks");
+	if (!data) return 0;
+
+	if (pk_stack < 0 || image_index >= get_nimg()) {
+		throw ImageWriteException(filename, "Please write header before write data");
+	}
+
+	if (h5_rows_io(pk_stack, H5T_NATIVE_FLOAT, image_index, 1, data, true) < 0) {
+		throw ImageWriteException(filename, "packed HDF5 write failed");
+	}
+	return 0;
+}
+
+int HdfIO2::read_data_range(float *data, int image_index, int count)
+{
+	init();
+	if (!packed || pk_stack < 0) return 1;
+
+	if (image_index < 0 || count < 1 || image_index + count > get_nimg()) {
+		throw OutofRangeException(0, get_nimg() - 1, image_index + count - 1, "image index");
+	}
+
+	if (h5_rows_io(pk_stack, H5T_NATIVE_FLOAT, image_index, count, data, false) < 0) {
+		throw ImageReadException(filename,"packed HDF5 read failed");
+	}
+	return 0;
+}
+
+// Keys read_header may derive from other attributes when they are not stored directly
+static bool derived_header_key(const string & key)
+{
+	const char *derived[] = { "nx", "ny", "nz", "apix_x", "apix_y", "apix_z",
+		"tilt_angle", "tilt_dose_begin" };
+	for (size_t i = 0; i < sizeof(derived) / sizeof(derived[0]); i++) {
+		if (key == derived[i]) return true;
+	}
+	return false;
+}
+
+vector<EMObject> HdfIO2::read_header_column(const string & key, const vector<int> & indices)
+{
+	ENTERFUNC;
+	init();
+
+	if (packed) return read_packed_column(key, indices);
+
+	vector<EMObject> v(indices.size());
+	string ekey = "EMAN." + key;
+	bool meta = meta_attr_dict.has_key(key);
+	char ipath[50];
+
+	for (size_t i = 0; i < indices.size(); i++) {
+		sprintf(ipath,"/MDF/images/%d", indices[i]);
+		hid_t igrp = H5Gopen(file, ipath);
+		if (igrp < 0) {
+			char msg[40];
+			sprintf(msg,"Image %d does not exist",indices[i]);
+			throw ImageReadException(filename,msg);
+		}
+
+		// read_header takes the data type from the image dataset, not the attribute
+		if (key == "datatype") {
+			hid_t ds = H5Dopen(igrp, "image");
+			if (ds < 0) {
+				H5Gclose(igrp);
+				throw ImageReadException(filename, "Image does not exist");
+			}
+			hid_t dt = H5Dget_type(ds);
+			v[i] = dataset_datatype(dt);
+			H5Tclose(dt);
+			H5Dclose(ds);
+			H5Gclose(igrp);
+			continue;
+		}
+
+		const char *aname = 0;
+		if (H5Aexists(igrp, ekey.c_str()) > 0) aname = ekey.c_str();
+		else if (H5Aexists(igrp, key.c_str()) > 0) aname = key.c_str();
+
+		if (aname) {
+			hid_t attr = H5Aopen_name(igrp, aname);
+			v[i] = read_attr(attr);
+			H5Aclose(attr);
+		}
+		else if (meta) {
+			v[i] = meta_attr_dict[key];
+		}
+		H5Gclose(igrp);
+
+		if (!aname && derived_header_key(key)) {
+			Dict dict;
+			read_header(dict, indices[i]);
+			if (dict.has_key(key)) v[i] = dict[key];
+		}
+	}
+
+	EXITFUNC;
+	return v;
+}
+
+// Column keys come from one read of the rows spanning the requested images;
+// anything else (or a row left unset because the value went to the JSON header)
+// is taken from the full header of that image
+vector<EMObject> HdfIO2::read_packed_column(const string & key, const vector<int> & indices)
+{
+	vector<EMObject> v(indices.size());
+	vector<bool> done(indices.size(), false);
+	int nimg = get_nimg();
+
+	int col = -1;
+	for (int i = 0; i < NUM_PACKED_COLUMNS; i++) {
+		if (key == packed_columns[i].key) col = i;
+	}
+
+	map<string, hid_t>::iterator it = (col >= 0 ? pk_columns.find(key) : pk_columns.end());
+	if (it != pk_columns.end() && !indices.empty()) {
+		const PackedColumn & pc = packed_columns[col];
+		int lo = *std::min_element(indices.begin(), indices.end());
+		int hi = *std::max_element(indices.begin(), indices.end());
+		if (lo < 0 || hi >= nimg) {
+			throw OutofRangeException(0, nimg - 1, lo < 0 ? lo : hi, "image index");
+		}
+
+		size_t span = (size_t)(hi - lo + 1);
+		if (pc.type == EMObject::INT) {
+			vector<int> rows(span);
+			h5_rows_io(it->second, H5T_NATIVE_INT, lo, (int)span, rows.data(), false);
+			for (size_t i = 0; i < indices.size(); i++) {
+				int r = rows[indices[i] - lo];
+				if (r != PACKED_INT_UNSET) {
+					v[i] = r;
+					done[i] = true;
+				}
+			}
+		}
+		else {
+			vector<float> rows(span * pc.width);
+			h5_rows_io(it->second, H5T_NATIVE_FLOAT, lo, (int)span, rows.data(), false);
+			for (size_t i = 0; i < indices.size(); i++) {
+				const float *r = &rows[(size_t)(indices[i] - lo) * pc.width];
+				if (!std::isnan(r[0])) {
+					v[i] = packed_value(pc, r);
+					done[i] = true;
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < indices.size(); i++) {
+		if (done[i]) continue;
+
+		Dict dict;
+		read_header(dict, indices[i]);
+		if (dict.has_key(key)) v[i] = dict[key];
+	}
+
+	return v;
+}
+
 int HdfIO2::get_nimg()
 {
 	init();
@@ -57,6 +57,29 @@ namespace EMAN
 	 * HdfIO. This is a revised HDF5 format file.
 	 *
 	 * A HDF5 file may contains multiple 2D or 3D images.
+	 *
+	 * By default each image is its own group, /MDF/images/N, holding the
+	 * pixel dataset and one attribute per header value. A stack of
+	 * same-size 2D images may instead use the packed layout, selected by
+	 * setting the header value "hdf_packed" to 1 on the first image
+	 * written to a new file. All pixels then live in a single chunked 3D
+	 * dataset (/MDF/images/stack), the common per-particle values
+	 * (xform.projection, xform.align2d, xform.align3d, ctf, class_id,
+	 * score) in columnar datasets under /MDF/images/columns, and any
+	 * other header values in a per-image JSON string (/MDF/images/header).
+	 * Reading image N then costs a few hyperslab reads instead of a group
+	 * open and an attribute scan, and consecutive images can be read with
+	 * one hyperslab read (read_data_range).
+	 *
+	 * Compressed images (EM_COMPRESSED) are stored in chunks. 2D images
+	 * use bands of whole rows of about 1 MB. 3D volumes use cubic bricks
+	 * by default (header value "hdf_chunk"="brick", edge "hdf_chunk_size",
+	 * default 64), so extracting a small subvolume only decompresses the
+	 * bricks it overlaps, or whole XY slices ("hdf_chunk"="slice") for
+	 * volumes read one slice at a time. 16 and 32 bit data passes through
+	 * the HDF5 byte-shuffle filter before deflate unless
+	 * "render_compress_shuffle" is 0, and "render_compress_level"=0 skips
+	 * deflate altogether, leaving only the bit reduction and shuffle.
 	 * 
 	 * Attribute name must be within 128 charaters, including string terminator '\0'. 
 	 * 
@@ -116,6 +139,19 @@ namespace EMAN
 		 * For single attribute read/write*/
 		hid_t get_fileid() const {return file;}
 
+		/* Return true if the file uses the packed stack layout */
+		bool is_packed() { init(); return packed; }
+
+		/* Read the pixels of 'count' consecutive images in a packed stack
+		 * with a single hyperslab read.
+		 *
+		 * @return 0 on success, 1 if the file is not a packed stack */
+		int read_data_range(float *data, int image_index, int count);
+
+		/* Read one header key for many images, opening only the attribute
+		 * (or packed column) that holds it */
+		vector<EMObject> read_header_column(const string & key, const vector<int> & indices);
+
 	  private:
 		template<EMUtil::EMDataType I>
 		auto write_compressed(float *data, size_t size, hid_t ds, hid_t memoryspace, hid_t filespace);
@@ -144,6 +180,35 @@ namespace EMAN
 		
 		Dict meta_attr_dict;	//this is used for the meta attributes stored in /MDF/images
 
+		/* chunking of compressed images, see the class description */
+		string chunk_mode;
+		int chunk_edge;
+		bool compress_shuffle;
+		int chunk_dims(hsize_t *cdims, size_t eltsize) const;
+
+		/* The image dataset last read is kept open, so consecutive region
+		 * reads (e.g. boxes from a tomogram) reuse its decompressed chunks */
+		hid_t rd_ds;
+		int rd_index;
+		hid_t open_image_dataset(int image_index);
+		void close_image_dataset();
+
+		/* packed stack layout, see the class description */
+		bool packed;
+		hid_t pk_stack;		// (n, ny, nx) pixel dataset
+		hid_t pk_header;	// (n) JSON strings for the remaining header values
+		map<string, hid_t> pk_columns;	// columnar header datasets, by header key
+
+		void open_packed();
+		void create_packed();
+		hid_t packed_column(int col);
+		void read_packed_header(Dict & dict, int image_index);
+		vector<EMObject> read_packed_column(const string & key, const vector<int> & indices);
+		int dataset_datatype(hid_t dt);
+		int write_packed_header(const Dict & dict, int image_index, const Region * area);
+		int read_packed_data(float *data, int image_index, const Region * area);
+		int write_packed_data(float *data, int image_index, const Region * area);
+
 		/* Erases any existing attributes from the image group
 		 * prior to writing a new header. For a new image there
 		 * won't be any, so this should be harmless. 
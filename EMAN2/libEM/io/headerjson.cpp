@@ -0,0 +1,388 @@
+/*
+ * Author: Steven Ludtke, 04/10/2003 (sludtke@bcm.edu)
+ * Copyright (c) 2000-2006 Baylor College of Medicine
+ * 
+ * This software is issued under a joint BSD/GNU license. You may use the
+ * source code in this file under either license. However, note that the
+ * complete EMAN2 and SPARX software packages have some GPL dependencies,
+ * so you are responsible for compliance with the licenses of these packages
+ * if you opt to use BSD licensing. The warranty disclaimer below holds
+ * in either instance.
+ * 
+ * This complete copyright notice must be included in any revised version of the
+ * source code. Additional authorship citations may be added, but existing
+ * author citations must be preserved.
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ * 
+ * */
+
+#include "headerjson.h"
+#include "transform.h"
+#include "exception.h"
+#include "log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <climits>
+
+using namespace EMAN;
+
+static void json_put_string(string & out, const string & s)
+{
+	out += '"';
+	for (size_t i = 0; i < s.size(); i++) {
+		unsigned char c = s[i];
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += c;
+		}
+		else if (c == '\n') out += "\\n";
+		else if (c == '\t') out += "\\t";
+		else if (c < 0x20) {
+			char buf[8];
+			sprintf(buf, "\\u%04x", c);
+			out += buf;
+		}
+		else out += c;
+	}
+	out += '"';
+}
+
+static void json_put_real(string & out, double v, int digits)
+{
+	if (std::isnan(v)) { out += "NaN"; return; }
+	if (std::isinf(v)) { out += (v < 0 ? "-Infinity" : "Infinity"); return; }
+
+	char buf[32];
+	sprintf(buf, "%.*g", digits, v);
+	out += buf;
+	if (!strpbrk(buf, ".eE")) out += ".0";	// keep reals distinct from ints
+}
+
+static void json_put_transform(string & out, const Transform * t)
+{
+	out += "{\"__class__\":\"Transform\",\"matrix\":[";
+	for (int r = 0; r < 3; r++) {
+		for (int c = 0; c < 4; c++) {
+			if (r || c) out += ',';
+			json_put_real(out, t->at(r,c), 9);
+		}
+	}
+	out += "]}";
+}
+
+static bool json_put_value(string & out, const EMObject & obj)
+{
+	char buf[32];
+
+	switch (obj.get_type()) {
+	case EMObject::BOOL:
+		out += ((bool)obj ? "true" : "false");
+		break;
+	case EMObject::SHORT:
+	case EMObject::INT:
+		sprintf(buf, "%d", (int)obj);
+		out += buf;
+		break;
+	case EMObject::UNSIGNEDINT:
+		sprintf(buf, "%u", (unsigned int)obj);
+		out += buf;
+		break;
+	case EMObject::FLOAT:
+		json_put_real(out, (float)obj, 9);
+		break;
+	case EMObject::DOUBLE:
+		json_put_real(out, (double)obj, 17);
+		break;
+	case EMObject::STRING:
+	case EMObject::CTF:
+		json_put_string(out, (const char *)obj);
+		break;
+	case EMObject::FLOATARRAY: {
+		vector<float> v = obj;
+		out += '[';
+		for (size_t i = 0; i < v.size(); i++) {
+			if (i) out += ',';
+			json_put_real(out, v[i], 9);
+		}
+		out += ']';
+		break;
+	}
+	case EMObject::INTARRAY: {
+		vector<int> v = obj;
+		out += '[';
+		for (size_t i = 0; i < v.size(); i++) {
+			sprintf(buf, i ? ",%d" : "%d", v[i]);
+			out += buf;
+		}
+		out += ']';
+		break;
+	}
+	case EMObject::STRINGARRAY: {
+		vector<string> v = obj;
+		out += '[';
+		for (size_t i = 0; i < v.size(); i++) {
+			if (i) out += ',';
+			json_put_string(out, v[i]);
+		}
+		out += ']';
+		break;
+	}
+	case EMObject::TRANSFORM: {
+		Transform *t = obj;
+		json_put_transform(out, t);
+		delete t;
+		break;
+	}
+	case EMObject::TRANSFORMARRAY: {
+		vector<Transform> v = obj;
+		out += '[';
+		for (size_t i = 0; i < v.size(); i++) {
+			if (i) out += ',';
+			json_put_transform(out, &v[i]);
+		}
+		out += ']';
+		break;
+	}
+	default:
+		return false;
+	}
+	return true;
+}
+
+string EMAN::json_encode_header(const Dict & dict)
+{
+	if (dict.size() == 0) return string();
+
+	string out("{");
+	vector<string> keys = dict.keys();
+	for (size_t i = 0; i < keys.size(); i++) {
+		string val;
+		if (!json_put_value(val, dict[keys[i]])) {
+			LOGERR("Unhandled header value '%s'", keys[i].c_str());
+			continue;
+		}
+		if (out.size() > 1) out += ',';
+		json_put_string(out, keys[i]);
+		out += ':';
+		out += val;
+	}
+	out += '}';
+	return out;
+}
+
+static void json_skip_ws(const char *& p)
+{
+	while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+}
+
+static string json_get_string(const char *& p)
+{
+	string s;
+	if (*p != '"') throw ImageReadException("", "bad JSON header: string expected");
+	for (p++; *p && *p != '"'; p++) {
+		if (*p != '\\') {
+			s += *p;
+			continue;
+		}
+		p++;
+		switch (*p) {
+		case 'n': s += '\n'; break;
+		case 't': s += '\t'; break;
+		case 'r': s += '\r'; break;
+		case 'b': s += '\b'; break;
+		case 'f': s += '\f'; break;
+		case 'u': {
+			unsigned int c = 0;
+			if (sscanf(p+1, "%4x", &c) != 1) throw ImageReadException("", "bad JSON header: \\u escape");
+			p += 4;
+			if (c < 0x80) s += (char)c;
+			else if (c < 0x800) {
+				s += (char)(0xc0 | (c >> 6));
+				s += (char)(0x80 | (c & 0x3f));
+			}
+			else {
+				s += (char)(0xe0 | (c >> 12));
+				s += (char)(0x80 | ((c >> 6) & 0x3f));
+				s += (char)(0x80 | (c & 0x3f));
+			}
+			break;
+		}
+		case 0: throw ImageReadException("", "bad JSON header: unterminated string");
+		default: s += *p;
+		}
+	}
+	if (*p != '"') throw ImageReadException("", "bad JSON header: unterminated string");
+	p++;
+	return s;
+}
+
+// Integers come back as INT. Reals with more than the 9 significant digits
+// written for a float come back as DOUBLE, the rest as FLOAT.
+static EMObject json_get_number(const char *& p)
+{
+	if (strncmp(p, "NaN", 3) == 0) { p += 3; return EMObject(std::numeric_limits<float>::quiet_NaN()); }
+	if (strncmp(p, "Infinity", 8) == 0) { p += 8; return EMObject(std::numeric_limits<float>::infinity()); }
+	if (strncmp(p, "-Infinity", 9) == 0) { p += 9; return EMObject(-std::numeric_limits<float>::infinity()); }
+
+	const char *start = p;
+	bool real = false;
+	int digits = 0;
+	bool mantissa = true;
+	for (; *p && strchr("+-0123456789.eE", *p); p++) {
+		if (*p == '.' || *p == 'e' || *p == 'E') real = true;
+		if (*p == 'e' || *p == 'E') mantissa = false;
+		if (mantissa && isdigit(*p) && (digits || *p != '0')) digits++;
+	}
+	if (p == start) throw ImageReadException("", "bad JSON header: value expected");
+
+	string tok(start, p - start);
+	if (!real) {
+		long long v = strtoll(tok.c_str(), NULL, 10);
+		if (v >= INT_MIN && v <= INT_MAX) return EMObject((int)v);
+		return EMObject((double)v);
+	}
+
+	double v = strtod(tok.c_str(), NULL);
+	if (digits > 9) return EMObject(v);
+	return EMObject((float)v);
+}
+
+static EMObject json_get_value(const char *& p);
+
+static EMObject json_get_object(const char *& p)
+{
+	Dict d;
+	p++;
+	json_skip_ws(p);
+	while (*p && *p != '}') {
+		string key = json_get_string(p);
+		json_skip_ws(p);
+		if (*p != ':') throw ImageReadException("", "bad JSON header: ':' expected");
+		p++;
+		json_skip_ws(p);
+		d[key] = json_get_value(p);
+		json_skip_ws(p);
+		if (*p == ',') {
+			p++;
+			json_skip_ws(p);
+		}
+	}
+	if (*p != '}') throw ImageReadException("", "bad JSON header: unterminated object");
+	p++;
+
+	if (d.has_key("__class__") && string((const char *)d["__class__"]) == "Transform" && d.has_key("matrix")) {
+		vector<float> m;
+		if (d["matrix"].get_type() == EMObject::INTARRAY) {
+			vector<int> mi = d["matrix"];
+			m.assign(mi.begin(), mi.end());
+		}
+		else m = (vector<float>)d["matrix"];
+		Transform t(m);
+		return EMObject(&t);
+	}
+	return EMObject();	// other objects are not header values
+}
+
+static EMObject json_get_array(const char *& p)
+{
+	vector<EMObject> items;
+	p++;
+	json_skip_ws(p);
+	while (*p && *p != ']') {
+		items.push_back(json_get_value(p));
+		json_skip_ws(p);
+		if (*p == ',') {
+			p++;
+			json_skip_ws(p);
+		}
+	}
+	if (*p != ']') throw ImageReadException("", "bad JSON header: unterminated array");
+	p++;
+
+	bool ints = true, reals = true, strings = true, xforms = true;
+	for (size_t i = 0; i < items.size(); i++) {
+		EMObject::ObjectType t = items[i].get_type();
+		ints = ints && t == EMObject::INT;
+		reals = reals && (t == EMObject::INT || t == EMObject::FLOAT || t == EMObject::DOUBLE);
+		strings = strings && t == EMObject::STRING;
+		xforms = xforms && t == EMObject::TRANSFORM;
+	}
+
+	if (items.empty() || (reals && !ints)) {
+		vector<float> v(items.size());
+		for (size_t i = 0; i < items.size(); i++) v[i] = (float)items[i];
+		return EMObject(v);
+	}
+	if (ints) {
+		vector<int> v(items.size());
+		for (size_t i = 0; i < items.size(); i++) v[i] = (int)items[i];
+		return EMObject(v);
+	}
+	if (strings) {
+		vector<string> v(items.size());
+		for (size_t i = 0; i < items.size(); i++) v[i] = (const char *)items[i];
+		return EMObject(v);
+	}
+	if (xforms) {
+		vector<Transform> v;
+		for (size_t i = 0; i < items.size(); i++) {
+			Transform *t = items[i];
+			v.push_back(*t);
+			delete t;
+		}
+		return EMObject(v);
+	}
+	throw ImageReadException("", "bad JSON header: mixed array");
+}
+
+static EMObject json_get_value(const char *& p)
+{
+	json_skip_ws(p);
+	if (*p == '{') return json_get_object(p);
+	if (*p == '[') return json_get_array(p);
+	if (*p == '"') return EMObject(json_get_string(p));
+	if (strncmp(p, "true", 4) == 0) { p += 4; return EMObject(true); }
+	if (strncmp(p, "false", 5) == 0) { p += 5; return EMObject(false); }
+	if (strncmp(p, "null", 4) == 0) { p += 4; return EMObject(); }
+	return json_get_number(p);
+}
+
+void EMAN::json_decode_header(const char *s, Dict & dict)
+{
+	if (!s || !*s) return;
+
+	const char *p = s;
+	json_skip_ws(p);
+	if (*p != '{') throw ImageReadException("", "bad JSON header: object expected");
+	p++;
+	json_skip_ws(p);
+	while (*p && *p != '}') {
+		string key = json_get_string(p);
+		json_skip_ws(p);
+		if (*p != ':') throw ImageReadException("", "bad JSON header: ':' expected");
+		p++;
+		EMObject val = json_get_value(p);
+		if (val.get_type() != EMObject::UNKNOWN) dict[key] = val;
+		json_skip_ws(p);
+		if (*p == ',') {
+			p++;
+			json_skip_ws(p);
+		}
+	}
+}
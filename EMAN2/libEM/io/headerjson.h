@@ -0,0 +1,56 @@
+/*
+ * Author: Steven Ludtke, 04/10/2003 (sludtke@bcm.edu)
+ * Copyright (c) 2000-2006 Baylor College of Medicine
+ * 
+ * This software is issued under a joint BSD/GNU license. You may use the
+ * source code in this file under either license. However, note that the
+ * complete EMAN2 and SPARX software packages have some GPL dependencies,
+ * so you are responsible for compliance with the licenses of these packages
+ * if you opt to use BSD licensing. The warranty disclaimer below holds
+ * in either instance.
+ * 
+ * This complete copyright notice must be included in any revised version of the
+ * source code. Additional authorship citations may be added, but existing
+ * author citations must be preserved.
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ * 
+ * */
+
+#ifndef eman__headerjson_h__
+#define eman__headerjson_h__ 1
+
+#include "emobject.h"
+
+namespace EMAN
+{
+	/* A small JSON encoder/decoder for image header values, used for the
+	 * header values that don't have a column in the packed HDF layout and
+	 * for the per-line overrides in LST/LSX files. It handles the same value
+	 * types as the HDF attributes, plus string arrays. Transforms are written
+	 * as {"__class__":"Transform","matrix":[...]}, as EMAN2jsondb does.
+	 */
+
+	/** @return dict as one JSON object, or "" for an empty dict. Values
+	 * of other types are logged and skipped. */
+	string json_encode_header(const Dict & dict);
+
+	/** Add the members of the JSON object s to dict. Members whose value
+	 * isn't a header type (null, other classes) are skipped.
+	 * @exception ImageReadException if s is not valid JSON. */
+	void json_decode_header(const char *s, Dict & dict);
+}
+
+#endif	//eman__headerjson_h__
@@ -31,6 +31,14 @@
 
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "imageio.h"
 #include "geometry.h"
@@ -43,6 +51,27 @@ ImageIO::ImageIO(const string & fname, IOMode rw)
 
 ImageIO::~ImageIO()
 {
+#ifndef _WIN32
+	if (mapped) {
+		munmap((void *) mapped, mapped_size);
+		mapped = 0;
+	}
+#endif
+}
+
+vector<EMObject> ImageIO::read_header_column(const string & key, const vector<int> & indices)
+{
+	vector<EMObject> v(indices.size());
+
+	for (size_t i = 0; i < indices.size(); i++) {
+		Dict dict;
+		if (read_header(dict, indices[i])) {
+			throw ImageReadException(filename, "imageio read header failed");
+		}
+		if (dict.has_key(key)) v[i] = dict[key];
+	}
+
+	return v;
 }
 
 int ImageIO::read_ctf(Ctf &, int)
@@ -172,6 +201,37 @@ FILE *ImageIO::sfopen(const string & filename, IOMode mode,
 	return f;
 }
 
+const char *ImageIO::map_file(const string & fname)
+{
+	if (map_tried) {
+		return mapped;
+	}
+	map_tried = true;
+
+	const char *env = getenv("EMAN2_MMAP");
+	if (rw_mode != READ_ONLY || (env && atoi(env) == 0)) {
+		return 0;
+	}
+
+#ifndef _WIN32
+	int fd = open(fname.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return 0;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		void *p = mmap(0, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (p != MAP_FAILED) {
+			mapped = (const char *) p;
+			mapped_size = (size_t) st.st_size;
+		}
+	}
+	close(fd);
+#endif
+
+	return mapped;
+}
 
 int ImageIO::get_nimg()
 {
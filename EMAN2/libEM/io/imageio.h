@@ -35,6 +35,9 @@
 #include "byteorder.h"
 #include "emutil.h"
 
+#include <cstring>
+#include <type_traits>
+
 using std::vector;
 using std::string;
 
@@ -146,6 +149,17 @@ namespace EMAN
 		virtual int read_header(Dict & dict, int image_index = 0,
 								const Region * area = 0, bool is_3d = false) = 0;
 
+		/** Read a single header field from a set of images.
+		 * The default implementation reads each header in full. Formats
+		 * which can look up one key directly should override it.
+		 *
+		 * @param key The header key to read.
+		 * @param indices The indices of the images to read.
+		 * @return One value per index. Images without the key give an
+		 *   empty EMObject.
+		 */
+		virtual vector<EMObject> read_header_column(const string & key, const vector<int> & indices);
+
 		/** Write a header to an image.
 		 *
 		 * @param dict A keyed-dictionary storing the header information.
@@ -349,10 +363,59 @@ namespace EMAN
 		FILE *sfopen(const string & filename, IOMode mode,
 					 bool * is_new = 0, bool overwrite = false);
 
+		/** Map a data file read-only into memory, so whole images can be
+		 * read straight from the page cache without a seek/fread per image.
+		 * The first call decides; later calls return the same mapping.
+		 * Only files opened READ_ONLY are mapped, and setting EMAN2_MMAP=0
+		 * in the environment disables mapping.
+		 *
+		 * @param fname The file to map. Formats with a separate data file
+		 * (IMAGIC) pass its name; others use 'filename'.
+		 * @return The start of the mapping, or 0 if the file is not mapped.
+		 */
+		const char *map_file(const string & fname);
+
+		/** Convert 'n' values of type T stored at 'offset' in the mapping made
+		 * by map_file() to host-endian floats.
+		 *
+		 * @param data The output array, with room for 'n' floats.
+		 * @param offset Byte offset of the first value in the file.
+		 * @param n Number of values.
+		 * @return false if nothing is mapped or the range is past the end of
+		 * the mapping, in which case the caller should fall back to stdio.
+		 */
+		template < class T > bool read_mapped(float *data, size_t offset, size_t n)
+		{
+			if (!mapped || offset > mapped_size || n > (mapped_size - offset) / sizeof(T)) {
+				return false;
+			}
+
+			const char *src = mapped + offset;
+			if (std::is_same < T, float >::value) {
+				memcpy(data, src, n * sizeof(float));
+				become_host_endian(data, n);
+			}
+			else {
+				bool swap = (sizeof(T) > 1 && is_image_big_endian() != ByteOrder::is_host_big_endian());
+				T v;
+				for (size_t i = 0; i < n; i++) {
+					memcpy(&v, src + i * sizeof(T), sizeof(T));
+					if (swap) ByteOrder::swap_bytes(&v);
+					data[i] = static_cast < float >(v);
+				}
+			}
+			return true;
+		}
+
 		string filename;
 		IOMode rw_mode;
 		FILE *file = nullptr;
 		bool initialized = false;
+
+	private:
+		const char *mapped = nullptr;
+		size_t mapped_size = 0;
+		bool map_tried = false;
 	};
 
 	/** DEFINE_IMAGEIO_FUNC declares the functions that needs to
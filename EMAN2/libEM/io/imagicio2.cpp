@@ -708,6 +708,24 @@ int ImagicIO2::read_data(float* data, int image_index, EMAN::Region const* area,
 
 	check_region(area, FloatSize(nx, ny, nz), is_new_hed, false);
 
+	// whole float images of a read-only file are copied straight from the
+	// mapping, storing rows bottom-up as process_region_io does with need_flip
+	if (!area && datatype == IMAGIC_FLOAT && map_file(img_filename)) {
+		size_t offset = img_size*image_index*sizeof(float);
+		bool from_map = true;
+
+		for (size_t r = 0; from_map && r < (size_t)ny*nz; r++) {
+			size_t k = r / ny, j = r % ny;
+			from_map = read_mapped < float >(data + (k*ny + (ny-1-j))*nx,
+											 offset + r*nx*sizeof(float), nx);
+		}
+
+		if (from_map) {
+			EXITFUNC;
+			return 0;
+		}
+	}
+
 	portable_fseek(img_file, img_size*image_index*sizeof(float), SEEK_SET);
 
 	short *sdata = (short *) data;
@@ -41,7 +41,9 @@
 
 #include <cstdio>
 #include <cstring>
+#include <map>
 #include "lstfastio.h"
+#include "portable_fileio.h"
 #include "util.h"
 
 
@@ -56,8 +58,6 @@ LstFastIO::LstFastIO(const string & fname, IOMode rw)
 	nimg = 0;
 	imageio = 0;
 	ref_filename = "";
-	last_lst_index = -1;
-	last_ref_index = -1;
 }
 
 LstFastIO::~LstFastIO()
@@ -67,10 +67,7 @@ LstFastIO::~LstFastIO()
 		file = 0;
 	}
 	ref_filename = "";
-	if(imageio) {
-		delete imageio;
-		imageio = 0;
-	}
+	imageio = 0;
 }
 
 void LstFastIO::init()
@@ -137,39 +134,25 @@ bool LstFastIO::is_valid(const void *first_block)
 
 int LstFastIO::calc_ref_image_index(int image_index)
 {
-	if (image_index == last_lst_index) {
-		return last_ref_index;
+	string line(line_length, '\0');
+	portable_fseek(file, head_length + (off_t)line_length * image_index, SEEK_SET);
+	size_t n = fread(&line[0], 1, line_length, file);
+	if (n == 0) {
+		throw ImageReadException(filename, "image index beyond the end of the file");
 	}
-	else {
-		vector<char> buf(line_length+1);
-
-		fseek(file,head_length+line_length*image_index,SEEK_SET);
-		if (!fgets(buf.data(), line_length, file)) {
-			LOGERR("reach EOF in file '%s' before reading %dth image",
-				   filename.c_str(), image_index);
-			return 1;
-		}
-
-		int ref_image_index = 0;
-		char ref_image_path[MAXPATHLEN];
-		vector<char> unused(line_length);
-		sscanf(buf.data(), " %d %s %[ .,0-9-]", &ref_image_index, ref_image_path, unused.data());
-		string newrefname = string(ref_image_path);
-		if (newrefname.compare(ref_filename)==0) {	// use the existing imageio when possible, TODO: cache a few?
-			if (imageio==0) throw FileAccessException(ref_filename);
-		} else {
-			ref_filename = newrefname;
-			if (!Util::is_file_exist(ref_filename)) throw FileAccessException(ref_filename);
-			if (imageio!=0) delete imageio;
-			imageio = EMUtil::get_imageio(ref_filename, rw_mode);
-		}
-		last_ref_index = ref_image_index;
+	line.resize(n);
+	size_t nl = line.find('\n');
+	if (nl != string::npos) line.resize(nl);
+
+	int ref_image_index;
+	size_t extra, extra_len;
+	if (!LstIndex::parse_line(line, ref_image_index, ref_filename, extra, extra_len)) {
+		throw ImageReadException(filename, "line does not reference an image");
 	}
-//	printf("%d\t%d\t%s\n",image_index,last_ref_index,ref_filename.c_str());
-
-	last_lst_index = image_index;
+	overrides = line.substr(extra, extra_len);
+	imageio = refs.get(ref_filename, rw_mode);
 
-	return last_ref_index;
+	return ref_image_index;
 }
 
 
@@ -181,10 +164,50 @@ int LstFastIO::read_header(Dict & dict, int image_index, const Region * area, bo
 	int err = imageio->read_header(dict, ref_image_index, area, is_3d);
 	dict.put("data_source",ref_filename);
 	dict.put("data_n",ref_image_index);
+	if (!overrides.empty()) LstIndex::decode_overrides(filename, image_index, overrides, dict);
 	EXITFUNC;
 	return err;
 }
 
+vector<EMObject> LstFastIO::read_header_column(const string & key, const vector<int> & indices)
+{
+	ENTERFUNC;
+	vector<EMObject> v(indices.size());
+	vector<int> refn(indices.size());
+
+	// group the lines by referenced file so each file is asked only once;
+	// lines overriding the key answer it themselves
+	map<string, vector<size_t> > byfile;
+	for (size_t i = 0; i < indices.size(); i++) {
+		check_read_access(indices[i]);
+		refn[i] = calc_ref_image_index(indices[i]);
+		if (!overrides.empty()) {
+			Dict over;
+			LstIndex::decode_overrides(filename, indices[i], overrides, over);
+			if (over.has_key(key)) {
+				v[i] = over[key];
+				continue;
+			}
+		}
+		if (key == "data_source") v[i] = ref_filename;
+		else if (key == "data_n") v[i] = refn[i];
+		else byfile[ref_filename].push_back(i);
+	}
+
+	for (map<string, vector<size_t> >::iterator it = byfile.begin(); it != byfile.end(); ++it) {
+		const vector<size_t> & pos = it->second;
+		vector<int> ri(pos.size());
+		for (size_t j = 0; j < pos.size(); j++) ri[j] = refn[pos[j]];
+
+		vector<EMObject> rv = refs.get(it->first, rw_mode)->read_header_column(key, ri);
+
+		for (size_t j = 0; j < pos.size(); j++) v[pos[j]] = rv[j];
+	}
+
+	EXITFUNC;
+	return v;
+}
+
 int LstFastIO::write_header(const Dict &, int, const Region* , EMUtil::EMDataType, bool)
 {
 	ENTERFUNC;
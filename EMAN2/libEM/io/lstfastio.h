@@ -33,6 +33,7 @@
 #define eman__lstiofast_h__ 1
 
 #include "imageio.h"
+#include "lstindex.h"
 
 namespace EMAN
 {
@@ -65,18 +66,23 @@ namespace EMAN
 			return false;
 		}
 		int get_nimg();
+
+		/* Looks the key up in the referenced files, one call per file */
+		vector<EMObject> read_header_column(const string & key, const vector<int> & indices);
 	  private:
 		bool is_big_endian;
 		int nimg;
 		unsigned int line_length;
 		unsigned int head_length;
 
-		ImageIO *imageio;
+		ImageIO *imageio;		// owned by refs
 		string ref_filename;
+		string overrides;		// JSON text at the end of the last line read
 
-		int last_lst_index;
-		int last_ref_index;
+		LstRefFiles refs;
 
+		/* lines are found at head_length + line_length * image_index, so each
+		 * call reads just that line */
 		int calc_ref_image_index(int image_index);
 		static const char *MAGIC;
 	};
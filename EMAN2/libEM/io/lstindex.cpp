@@ -0,0 +1,350 @@
+/*
+ * Author: Steven Ludtke, 04/10/2003 (sludtke@bcm.edu)
+ * Copyright (c) 2000-2006 Baylor College of Medicine
+ * 
+ * This software is issued under a joint BSD/GNU license. You may use the
+ * source code in this file under either license. However, note that the
+ * complete EMAN2 and SPARX software packages have some GPL dependencies,
+ * so you are responsible for compliance with the licenses of these packages
+ * if you opt to use BSD licensing. The warranty disclaimer below holds
+ * in either instance.
+ * 
+ * This complete copyright notice must be included in any revised version of the
+ * source code. Additional authorship citations may be added, but existing
+ * author citations must be preserved.
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ * 
+ * */
+
+#include <sys/stat.h>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <map>
+#ifndef WIN32
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+#include "lstindex.h"
+#include "headerjson.h"
+#include "imageio.h"
+#include "emutil.h"
+#include "util.h"
+#include "portable_fileio.h"
+
+using namespace EMAN;
+
+static const char SIDECAR_MAGIC[8] = { 'E', 'M', 'L', 'S', 'T', 'I', 'X', '2' };
+static const uint32_t SIDECAR_ORDER = 0x01020304;	// sidecars are host byte order
+static const size_t STAMP_BLOCK = 4096;
+
+// FNV-1a, continuing from h
+static uint64_t fnv1a(const char *s, size_t n, uint64_t h)
+{
+	for (size_t i = 0; i < n; i++) {
+		h ^= (unsigned char)s[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+// size, modification time (ns where available) and a hash of the first and
+// last STAMP_BLOCK bytes of fname, so a line rewritten in place at the start
+// or end of the file is caught even where the mtime is too coarse to change
+static bool file_stamp(const string & fname, LstIndex::Stamp & stamp)
+{
+	struct stat st;
+	if (stat(fname.c_str(), &st) != 0) return false;
+
+	stamp.size = (int64_t)st.st_size;
+#if defined(__APPLE__)
+	stamp.mtime = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#elif defined(WIN32)
+	stamp.mtime = (int64_t)st.st_mtime * 1000000000;
+#else
+	stamp.mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+
+	FILE *in = fopen(fname.c_str(), "rb");
+	if (!in) return false;
+
+	char buf[STAMP_BLOCK];
+	size_t n = fread(buf, 1, STAMP_BLOCK, in);
+	uint64_t h = fnv1a(buf, n, 14695981039346656037ULL);
+	if (stamp.size > (int64_t)STAMP_BLOCK) {
+		portable_fseek(in, stamp.size - (int64_t)STAMP_BLOCK, SEEK_SET);
+		n = fread(buf, 1, STAMP_BLOCK, in);
+		h = fnv1a(buf, n, h);
+	}
+	fclose(in);
+
+	stamp.hash = h;
+	return true;
+}
+
+// a sidecar is only left next to a LST file we could modify ourselves, in a
+// directory we can write
+static bool sidecar_allowed(const string & fname)
+{
+#ifndef WIN32
+	string dir = ".";
+	size_t slash = fname.rfind('/');
+	if (slash == 0) dir = "/";
+	else if (slash != string::npos) dir = fname.substr(0, slash);
+
+	return access(fname.c_str(), W_OK) == 0 && access(dir.c_str(), W_OK) == 0;
+#else
+	return false;
+#endif
+}
+
+LstIndex::LstIndex(const string & fname)
+	: filename(fname)
+{
+	Stamp stamp;
+	if (!file_stamp(filename, stamp)) throw FileAccessException(filename);
+
+	if (load(stamp)) return;
+
+	scan();
+	if (size_t(entries.size()) >= size_t(SIDECAR_MIN) && sidecar_allowed(filename)) {
+		save(stamp);
+	}
+}
+
+bool LstIndex::parse_line(const string & line, int & ref_n, string & path, size_t & extra, size_t & extra_len)
+{
+	const char *s = line.c_str();
+	char *end;
+	long refn = strtol(s, &end, 10);
+
+	// "n<tab>path<tab>{json}" as written by LSXFile and EMData::write_lst, or
+	// the older whitespace separated "n path comment"
+	const char *p = end;
+	bool tabbed = (*p == '\t');
+	while (*p == ' ' || *p == '\t') p++;
+	const char *q = p;
+	if (tabbed) while (*q && *q != '\t') q++;
+	else while (*q && !isspace((unsigned char)*q)) q++;
+	const char *pe = q;
+	while (pe > p && (pe[-1] == ' ' || pe[-1] == '\r')) pe--;
+
+	if (end == s || pe == p) return false;
+
+	ref_n = (int)refn;
+	path.assign(p, pe);
+	extra = extra_len = 0;
+
+	while (*q == ' ' || *q == '\t') q++;
+	if (*q == '{') {
+		const char *qe = s + line.size();
+		while (qe > q && isspace((unsigned char)qe[-1])) qe--;
+		extra = q - s;
+		extra_len = qe - q;
+	}
+	return true;
+}
+
+void LstIndex::decode_overrides(const string & fname, int i, const string & text, Dict & dict)
+{
+	try {
+		json_decode_header(text.c_str(), dict);
+	}
+	catch (E2Exception &) {
+		LOGERR("%s line %d: ignoring overrides that are not valid JSON", fname.c_str(), i);
+	}
+}
+
+void LstIndex::scan()
+{
+	FILE *in = fopen(filename.c_str(), "rb");
+	if (!in) throw FileAccessException(filename);
+
+	std::map<string, int32_t> ids;
+	vector<char> buf(1 << 20);
+	string line, path;
+	int64_t pos = 0, start = 0;
+	bool eof = false;
+
+	while (!eof) {
+		size_t n = fread(buf.data(), 1, buf.size(), in);
+		eof = (n == 0);
+
+		// one pass per line; the last one of a block continues into the next
+		size_t i = 0;
+		while (i < n || (eof && !line.empty())) {
+			const char *nl = (i < n ? (const char *)memchr(buf.data() + i, '\n', n - i) : 0);
+			if (!nl && !eof) {
+				line.append(buf.data() + i, n - i);
+				break;
+			}
+			size_t len = (nl ? nl - (buf.data() + i) : n - i);
+			line.append(buf.data() + i, len);
+			i += len + (nl ? 1 : 0);
+
+			if (line.empty() || line[0] != '#') {
+				Entry e = { start, -1, 0, 0, 0 };
+				int refn;
+				size_t extra, extra_len;
+				if (parse_line(line, refn, path, extra, extra_len)) {
+					std::map<string, int32_t>::iterator it = ids.find(path);
+					if (it == ids.end()) {
+						it = ids.insert(std::make_pair(path, (int32_t)paths.size())).first;
+						paths.push_back(path);
+					}
+					e.file = it->second;
+					e.ref_n = (int32_t)refn;
+					e.extra = (int32_t)extra;
+					e.extra_len = (int32_t)extra_len;
+				}
+				entries.push_back(e);
+			}
+
+			line.clear();
+			start = pos + i;
+		}
+		pos += n;
+	}
+	fclose(in);
+}
+
+bool LstIndex::load(const Stamp & stamp)
+{
+	FILE *in = fopen((filename + ".idx").c_str(), "rb");
+	if (!in) return false;
+
+	char magic[8];
+	uint32_t order = 0;
+	Stamp istamp;
+	int32_t nent = -1, npath = -1;
+
+	bool ok = fread(magic, sizeof(magic), 1, in) == 1 && memcmp(magic, SIDECAR_MAGIC, sizeof(magic)) == 0
+		&& fread(&order, sizeof(order), 1, in) == 1 && order == SIDECAR_ORDER
+		&& fread(&istamp, sizeof(istamp), 1, in) == 1 && istamp.size == stamp.size
+		&& istamp.mtime == stamp.mtime && istamp.hash == stamp.hash
+		&& fread(&nent, sizeof(nent), 1, in) == 1 && nent >= 0
+		&& fread(&npath, sizeof(npath), 1, in) == 1 && npath >= 0;
+
+	for (int32_t i = 0; ok && i < npath; i++) {
+		uint32_t len = 0;
+		ok = fread(&len, sizeof(len), 1, in) == 1 && len < (1u << 16);
+		if (ok) {
+			string path(len, '\0');
+			ok = (len == 0 || fread(&path[0], 1, len, in) == len);
+			paths.push_back(path);
+		}
+	}
+
+	if (ok) {
+		entries.resize(nent);
+		ok = (nent == 0 || fread(entries.data(), sizeof(Entry), nent, in) == (size_t)nent);
+	}
+	for (size_t i = 0; ok && i < entries.size(); i++) {
+		ok = entries[i].file >= -1 && entries[i].file < npath;
+	}
+	fclose(in);
+
+	if (!ok) {
+		entries.clear();
+		paths.clear();
+	}
+	return ok;
+}
+
+// written under a temporary name and renamed, so readers never see a partial sidecar
+void LstIndex::save(const Stamp & stamp) const
+{
+	string sidecar = filename + ".idx";
+	char suffix[32];
+	sprintf(suffix, ".%d.tmp", (int)getpid());
+	string tmp = sidecar + suffix;
+
+	FILE *out = fopen(tmp.c_str(), "wb");
+	if (!out) return;
+
+	int32_t nent = (int32_t)entries.size(), npath = (int32_t)paths.size();
+	bool ok = fwrite(SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC), 1, out) == 1
+		&& fwrite(&SIDECAR_ORDER, sizeof(SIDECAR_ORDER), 1, out) == 1
+		&& fwrite(&stamp, sizeof(stamp), 1, out) == 1
+		&& fwrite(&nent, sizeof(nent), 1, out) == 1
+		&& fwrite(&npath, sizeof(npath), 1, out) == 1;
+
+	for (size_t i = 0; ok && i < paths.size(); i++) {
+		uint32_t len = (uint32_t)paths[i].size();
+		ok = fwrite(&len, sizeof(len), 1, out) == 1 && (len == 0 || fwrite(paths[i].data(), 1, len, out) == len);
+	}
+	ok = ok && (nent == 0 || fwrite(entries.data(), sizeof(Entry), nent, out) == (size_t)nent);
+	ok = (fclose(out) == 0) && ok;
+
+	if (!ok || rename(tmp.c_str(), sidecar.c_str()) != 0) remove(tmp.c_str());
+}
+
+void LstIndex::read_overrides(FILE * file, int i, Dict & dict) const
+{
+	const Entry & e = entries[i];
+	if (e.extra_len <= 0) return;
+
+	string text(e.extra_len, '\0');
+	if (portable_fseek(file, e.offset + e.extra, SEEK_SET) != 0
+		|| fread(&text[0], 1, e.extra_len, file) != (size_t)e.extra_len) {
+		throw ImageReadException(filename, "cannot read the line overrides");
+	}
+
+	decode_overrides(filename, i, text, dict);
+}
+
+LstRefFiles::LstRefFiles(size_t cap)
+	: capacity(cap < 1 ? 1 : cap)
+{
+}
+
+LstRefFiles::~LstRefFiles()
+{
+	clear();
+}
+
+ImageIO *LstRefFiles::get(const string & path, int rw_mode)
+{
+	for (std::list<OpenFile>::iterator it = files.begin(); it != files.end(); ++it) {
+		if (it->path == path) {
+			if (it != files.begin()) files.splice(files.begin(), files, it);
+			return it->io;
+		}
+	}
+
+	if (!Util::is_file_exist(path)) throw FileAccessException(path);
+	ImageIO *io = EMUtil::get_imageio(path, rw_mode);
+	if (!io) throw ImageFormatException("cannot create an image io for " + path);
+
+	OpenFile f = { path, io };
+	files.push_front(f);
+	if (files.size() > capacity) {
+		EMUtil::close_imageio(files.back().path, files.back().io);
+		files.pop_back();
+	}
+	return io;
+}
+
+void LstRefFiles::clear()
+{
+	for (std::list<OpenFile>::iterator it = files.begin(); it != files.end(); ++it) {
+		EMUtil::close_imageio(it->path, it->io);
+	}
+	files.clear();
+}
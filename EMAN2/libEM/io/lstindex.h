@@ -0,0 +1,143 @@
+/*
+ * Author: Steven Ludtke, 04/10/2003 (sludtke@bcm.edu)
+ * Copyright (c) 2000-2006 Baylor College of Medicine
+ * 
+ * This software is issued under a joint BSD/GNU license. You may use the
+ * source code in this file under either license. However, note that the
+ * complete EMAN2 and SPARX software packages have some GPL dependencies,
+ * so you are responsible for compliance with the licenses of these packages
+ * if you opt to use BSD licensing. The warranty disclaimer below holds
+ * in either instance.
+ * 
+ * This complete copyright notice must be included in any revised version of the
+ * source code. Additional authorship citations may be added, but existing
+ * author citations must be preserved.
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ * 
+ * */
+
+#ifndef eman__lstindex_h__
+#define eman__lstindex_h__ 1
+
+#include <cstdio>
+#include <list>
+#include <inttypes.h>
+#include "emobject.h"
+
+namespace EMAN
+{
+	class ImageIO;
+
+	/** LstIndex is the random-access index of a LST file, whose lines vary in
+	 * length. (LSX lines have a fixed length, so LstFastIO finds them without
+	 * an index.) Every line that references an image (any line not starting
+	 * with '#') is recorded with its byte offset in the file, the id of the
+	 * referenced file in a table of paths, the image number in that file, and
+	 * the position of the JSON override text at the end of the line, if there
+	 * is one.
+	 *
+	 * The index is built by one pass over the file and, for files of at least
+	 * SIDECAR_MIN lines, saved next to it as "<file>.idx". Later opens load
+	 * the sidecar instead of parsing the text, as long as the size,
+	 * modification time and a hash of the first and last block of the file
+	 * recorded in it still match. The sidecar is only written if we could
+	 * modify the LST file and its directory ourselves, so read-only datasets
+	 * are never touched; it is silently skipped if the write fails.
+	 */
+	class LstIndex
+	{
+	  public:
+		struct Entry {
+			int64_t offset;		// of the line in the LST file
+			int32_t file;		// into the path table, -1 if the line is not a reference
+			int32_t ref_n;		// image number in the referenced file
+			int32_t extra;		// offset of the override text in the line
+			int32_t extra_len;	// 0 if the line has no overrides
+		};
+
+		/** What a sidecar records about the file it indexes. */
+		struct Stamp {
+			int64_t size;
+			int64_t mtime;
+			uint64_t hash;
+		};
+
+		static const int SIDECAR_MIN = 1000;
+
+		explicit LstIndex(const string & filename);
+
+		int size() const { return (int)entries.size(); }
+		const Entry & entry(int i) const { return entries[i]; }
+		const string & path(int file) const { return paths[file]; }
+
+		/** Add the overrides of line i to dict. The text is read through
+		 * 'file', an open handle on the LST file itself. Overrides that can't
+		 * be decoded are logged and ignored. */
+		void read_overrides(FILE * file, int i, Dict & dict) const;
+
+		/** Split a line into the image number, the referenced path and the
+		 * position of the override text, if any (extra_len is 0 if not).
+		 * @return false if the line does not reference an image. */
+		static bool parse_line(const string & line, int & ref_n, string & path,
+							   size_t & extra, size_t & extra_len);
+
+		/** Add the JSON override text of line i of fname to dict, logging and
+		 * ignoring text that can't be decoded. */
+		static void decode_overrides(const string & fname, int i, const string & text, Dict & dict);
+
+	  private:
+		string filename;
+		vector<Entry> entries;
+		vector<string> paths;
+
+		void scan();
+		bool load(const Stamp & stamp);
+		void save(const Stamp & stamp) const;
+	};
+
+	/** LstRefFiles keeps the files referenced by a LST/LSX file open, up to
+	 * 'capacity' of them, closing the least recently used one when another is
+	 * needed. Entries interleaved across a few source stacks then read without
+	 * reopening a file for every change of source.
+	 */
+	class LstRefFiles
+	{
+	  public:
+		explicit LstRefFiles(size_t capacity = 8);
+		~LstRefFiles();
+
+		/** @return The open ImageIO for path, opening it if needed. It stays
+		 * owned by this object.
+		 * @exception FileAccessException if path does not exist. */
+		ImageIO *get(const string & path, int rw_mode);
+
+		/** Close every file. */
+		void clear();
+
+	  private:
+		LstRefFiles(const LstRefFiles &);
+		LstRefFiles & operator=(const LstRefFiles &);
+
+		struct OpenFile {
+			string path;
+			ImageIO *io;
+		};
+		std::list<OpenFile> files;	// most recently used first
+		size_t capacity;
+	};
+}
+
+#endif	//eman__lstindex_h__
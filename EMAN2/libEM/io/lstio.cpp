@@ -41,6 +41,7 @@
 
 #include <cstdio>
 #include <cstring>
+#include <map>
 #include "lstio.h"
 #include "util.h"
 
@@ -56,8 +57,7 @@ LstIO::LstIO(const string & fname, IOMode rw)
 	nimg = 0;
 	imageio = 0;
 	ref_filename = "";
-	last_lst_index = -1;
-	last_ref_index = -1;
+	index = 0;
 }
 
 LstIO::~LstIO()
@@ -67,10 +67,9 @@ LstIO::~LstIO()
 		file = 0;
 	}
 	ref_filename = "";
-	if(imageio) {
-		delete imageio;
-		imageio = 0;
-	}
+	imageio = 0;
+	delete index;
+	index = 0;
 }
 
 void LstIO::init()
@@ -97,11 +96,7 @@ void LstIO::init()
 			throw ImageReadException(filename, "invalid LST file");
 		}
 
-		for (nimg = 0; fgets(buf, MAXPATHLEN, file) != 0; nimg++) {
-			if (buf[0] == '#') {
-				nimg--;
-			}
-		}
+		nimg = get_index().size();
 		rewind(file);
 	}
 	EXITFUNC;
@@ -123,77 +118,26 @@ bool LstIO::is_valid(const void *first_block)
 	return result;
 }
 
+const LstIndex & LstIO::get_index()
+{
+	if (!index) index = new LstIndex(filename);
+	return *index;
+}
+
 int LstIO::calc_ref_image_index(int image_index)
 {
-	if (image_index == last_lst_index) {
-		return last_ref_index;
+	const LstIndex & idx = get_index();
+	if (image_index >= idx.size()) {
+		throw ImageReadException(filename, "image index beyond the end of the file");
 	}
-	else {
-		char buf[MAXPATHLEN];
-		int step = image_index - last_lst_index;
 
-		if (step < 0) {
-			rewind(file);
-			step = image_index + 1;
-		}
-
-		for (int i = 0; i < step; i++) {
-			if (!fgets(buf, MAXPATHLEN, file)) {
-				LOGERR("reach EOF in file '%s' before reading %dth image",
-					   filename.c_str(), image_index);
-				return 1;
-			}
-			if (buf[0] == '#') {
-				i--;
-			}
-		}
-		int ref_image_index = 0;
-		char ref_image_path[MAXPATHLEN];
-		char unused[256];
-		sscanf(buf, " %d %s %[ .,0-9-]", &ref_image_index, ref_image_path, unused);
-
-		char fullpath[MAXPATHLEN];
+	const LstIndex::Entry & e = idx.entry(image_index);
+	if (e.file < 0) throw ImageReadException(filename, "line does not reference an image");
 
-		char sep = '/';
-#ifdef WIN32
-		sep = '\\';
-#endif
-// 		if (ref_image_path[0] == sep) {
-			strcpy(fullpath, ref_image_path);
-// 		}
-// 		else {
-// 			if (strrchr(filename.c_str(), sep)) {
-// 				strcpy(fullpath, filename.c_str());
-// 			}
-// 			else {
-// #ifndef WIN32
-// 				getcwd(fullpath, MAXPATHLEN);
-// #else
-// 				//GetCurrentDirectory(MAXPATHLEN, fullpath);
-// #endif
-// 			}
-// 
-// 			char *p_basename = strrchr(fullpath, sep);
-// 			if (p_basename) {
-// 				//p_basename++;
-// 				//*p_basename = '\0';
-// 				char ssep[2];
-// 				ssep[0] = sep;
-// 				ssep[1] = '\0';
-// 				strcat(fullpath, ssep);
-// 				strcat(fullpath, ref_image_path);
-// 			}
-// 		}
-
-		ref_filename = string(fullpath);
-		imageio = EMUtil::get_imageio(ref_filename, rw_mode);
-
-		last_ref_index = ref_image_index;
-	}
+	ref_filename = idx.path(e.file);
+	imageio = refs.get(ref_filename, rw_mode);
 
-	last_lst_index = image_index;
-
-	return last_ref_index;
+	return e.ref_n;
 }
 
 
@@ -205,10 +149,50 @@ int LstIO::read_header(Dict & dict, int image_index, const Region * area, bool i
 	int ref_image_index = calc_ref_image_index(image_index);
 	int err = imageio->read_header(dict, ref_image_index, area, is_3d);
 	dict["source_path"] = ref_filename;
+	index->read_overrides(file, image_index, dict);
 	EXITFUNC;
 	return err;
 }
 
+vector<EMObject> LstIO::read_header_column(const string & key, const vector<int> & indices)
+{
+	ENTERFUNC;
+	init();
+	vector<EMObject> v(indices.size());
+	vector<int> refn(indices.size());
+
+	// group the lines by referenced file so each file is asked only once;
+	// lines overriding the key answer it themselves
+	map<string, vector<size_t> > byfile;
+	for (size_t i = 0; i < indices.size(); i++) {
+		check_read_access(indices[i]);
+		refn[i] = calc_ref_image_index(indices[i]);
+		if (get_index().entry(indices[i]).extra_len > 0) {
+			Dict over;
+			index->read_overrides(file, indices[i], over);
+			if (over.has_key(key)) {
+				v[i] = over[key];
+				continue;
+			}
+		}
+		if (key == "source_path") v[i] = ref_filename;
+		else byfile[ref_filename].push_back(i);
+	}
+
+	for (map<string, vector<size_t> >::iterator it = byfile.begin(); it != byfile.end(); ++it) {
+		const vector<size_t> & pos = it->second;
+		vector<int> ri(pos.size());
+		for (size_t j = 0; j < pos.size(); j++) ri[j] = refn[pos[j]];
+
+		vector<EMObject> rv = refs.get(it->first, rw_mode)->read_header_column(key, ri);
+
+		for (size_t j = 0; j < pos.size(); j++) v[pos[j]] = rv[j];
+	}
+
+	EXITFUNC;
+	return v;
+}
+
 int LstIO::write_header(const Dict &, int, const Region* , EMUtil::EMDataType, bool)
 {
 	ENTERFUNC;
@@ -232,6 +216,9 @@ int LstIO::write_data(float *data, int, const Region* , EMUtil::EMDataType, bool
 {
 	ENTERFUNC;
 	fprintf(file, "%s\n", (char*)data);
+
+	delete index;		// rebuilt from the file on the next read
+	index = 0;
 	EXITFUNC;
 	return 0;
 }
@@ -33,6 +33,7 @@
 #define eman__lstio_h__ 1
 
 #include "imageio.h"
+#include "lstindex.h"
 
 namespace EMAN
 {
@@ -56,16 +57,20 @@ namespace EMAN
 			return false;
 		}
 		int get_nimg();
+
+		/* Looks the key up in the referenced files, one call per file */
+		vector<EMObject> read_header_column(const string & key, const vector<int> & indices);
 	  private:
 		bool is_big_endian;
 		int nimg;
 
-		ImageIO *imageio;
+		ImageIO *imageio;		// owned by refs
 		string ref_filename;
 
-		int last_lst_index;
-		int last_ref_index;
+		LstIndex *index;		// built on first use
+		LstRefFiles refs;
 
+		const LstIndex & get_index();
 		int calc_ref_image_index(int image_index);
 		static const char *MAGIC;
 	};
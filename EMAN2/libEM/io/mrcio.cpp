@@ -50,7 +50,7 @@ MrcIO::MrcIO(const string & fname, IOMode rw)
 :	ImageIO(fname, rw), mode_size(0),
 		isFEI(false), is_ri(0), is_new_file(false),
 		is_transpose(false), is_stack(false), stack_size(1),
-		is_8_bit_packed(false), use_given_dimensions(true)
+		is_8_bit_packed(false), use_given_dimensions(true), header_dirty(false)
 {
 	memset(&mrch, 0, sizeof(MrcHeader));
 	is_big_endian = ByteOrder::is_host_big_endian();
@@ -59,6 +59,12 @@ MrcIO::MrcIO(const string & fname, IOMode rw)
 MrcIO::~MrcIO()
 {
 	if (file) {
+		try {
+			write_main_header();
+		}
+		catch (...) {
+			LOGERR("MRC header of %s was not written", filename.c_str());
+		}
 		fclose(file);
 		file = NULL;
 	}
@@ -741,8 +747,6 @@ int MrcIO::write_header(const Dict & dict, int image_index, const Region* area,
 		if (is_big_endian != ByteOrder::is_host_big_endian()) {
 			opposite_endian = true;
 		}
-
-		portable_fseek(file, 0, SEEK_SET);
 	}
 	else {
 		mrch.alpha = mrch.beta = mrch.gamma = 90.0f;
@@ -905,15 +909,13 @@ int MrcIO::write_header(const Dict & dict, int image_index, const Region* area,
 	strncpy(mrch.map, "MAP ", 4);
 	mrch.machinestamp = generate_machine_stamp();
 
-	MrcHeader mrch2 = mrch;
+	out_header = mrch;
 
 	if (opposite_endian || !use_host_endian) {
-		swap_header(mrch2);
+		swap_header(out_header);
 	}
 
-	if (fwrite(&mrch2, sizeof(MrcHeader), 1, file) != 1) {
-		throw ImageWriteException(filename, "MRC header");
-	}
+	header_dirty = true;
 
 	mode_size = get_mode_size(mrch.mode);
 	is_new_file = false;
@@ -967,8 +969,47 @@ int MrcIO::read_data(float *rdata, int image_index, const Region * area, bool)
 
 	size_t size = 0;
 	int xlen = 0, ylen = 0, zlen = 0;
+	bool from_map = false;
+
+	if (! area  &&  map_file(filename)) {
+		// whole image of a read-only file, converted straight from the mapping
+		int fnx = isFEI ? feimrch.nx : mrch.nx;
+		int fny = isFEI ? feimrch.ny : mrch.ny;
+		int fnz = isFEI ? feimrch.nz : mrch.nz;
+		size_t offset = sizeof(MrcHeader) + (isFEI ? feimrch.next : mrch.nsymbt);
+
+		xlen = fnx;
+		ylen = fny;
+		zlen = fnz;
+		size = (size_t)xlen * ylen * zlen;
+		offset += (fnz > 1 ? 0 : image_index) * size * mode_size;
+
+		switch (mrch.mode) {
+		case MRC_UCHAR:
+			from_map = read_mapped < unsigned char >(rdata, offset, size);
+			break;
+		case MRC_CHAR:
+			from_map = read_mapped < signed char >(rdata, offset, size);
+			break;
+		case MRC_SHORT:
+			from_map = read_mapped < short >(rdata, offset, size);
+			break;
+		case MRC_USHORT:
+			from_map = read_mapped < unsigned short >(rdata, offset, size);
+			break;
+		case MRC_FLOAT:
+		case MRC_FLOAT_COMPLEX:
+			from_map = read_mapped < float >(rdata, offset, size);
+			break;
+		default:
+			break;
+		}
+	}
 
-	if (isFEI) {	// FEI extended MRC
+	if (from_map) {
+		// already host-endian float
+	}
+	else if (isFEI) {	// FEI extended MRC
 		check_region(area, FloatSize(feimrch.nx, feimrch.ny, feimrch.nz), is_new_file, false);
 		portable_fseek(file, sizeof(MrcHeader)+feimrch.next, SEEK_SET);
 
@@ -1004,7 +1045,10 @@ int MrcIO::read_data(float *rdata, int image_index, const Region * area, bool)
 		size = (size_t)xlen * ylen * zlen;
 	}
 
-	if (mrch.mode != MRC_UCHAR  &&  mrch.mode != MRC_CHAR  &&
+	if (from_map) {
+		// already host-endian float
+	}
+	else if (mrch.mode != MRC_UCHAR  &&  mrch.mode != MRC_CHAR  &&
 	    mrch.mode != MRC_UHEX) {
 
 		if (mode_size == sizeof(short)) {
@@ -1015,7 +1059,10 @@ int MrcIO::read_data(float *rdata, int image_index, const Region * area, bool)
 		}
 	}
 
-	if (mrch.mode == MRC_UHEX) {
+	if (from_map) {
+		// already converted
+	}
+	else if (mrch.mode == MRC_UHEX) {
 		size_t num_pairs = size / 2;
 		size_t num_pts   = num_pairs * 2;
 
@@ -1261,14 +1308,33 @@ void MrcIO::write_ctf(const Ctf & ctf, int)
 		throw ImageWriteException(filename, "write CTF info to header failed");
 	}
 
+	if (header_dirty) {
+		memcpy(out_header.labels[0], mrch.labels[0], MRC_LABEL_SIZE);
+	}
+
 	EXITFUNC;
 }
 
 void MrcIO::flush()
 {
+	write_main_header();
 	fflush(file);
 }
 
+void MrcIO::write_main_header()
+{
+	if (! header_dirty) {
+		return;
+	}
+
+	header_dirty = false;
+	portable_fseek(file, 0, SEEK_SET);
+
+	if (fwrite(&out_header, sizeof(MrcHeader), 1, file) != 1) {
+		throw ImageWriteException(filename, "MRC header");
+	}
+}
+
 int MrcIO::get_mode_size(int mm)
 {
 	MrcIO::MrcMode m = static_cast < MrcMode > (mm);
@@ -1414,6 +1480,31 @@ void MrcIO::swap_header(MrcHeader& mrch)
 	ByteOrder::swap_bytes((int *) &mrch.machinestamp, NUM_4BYTES_AFTER_MAP);
 }
 
+vector<EMObject> MrcIO::read_header_column(const string & key, const vector<int> & indices)
+{
+	ENTERFUNC;
+	init();
+
+	if (isFEI) return ImageIO::read_header_column(key, indices);
+
+	for (size_t i = 0; i < indices.size(); i++) {
+		if (indices[i] < 0 || indices[i] >= stack_size) {
+			throw OutofRangeException(0, stack_size - 1, indices[i], "image index");
+		}
+	}
+
+	Dict dict;
+	if (read_mrc_header(dict, 0)) {
+		throw ImageReadException(filename, "imageio read header failed");
+	}
+
+	EMObject value;
+	if (dict.has_key(key)) value = dict[key];
+
+	EXITFUNC;
+	return vector<EMObject>(indices.size(), value);
+}
+
 int MrcIO::get_nimg()
 {
 	init();
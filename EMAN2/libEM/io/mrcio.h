@@ -60,6 +60,10 @@ namespace EMAN
 
 		int get_nimg();
 
+		/* Every image in an MRC stack shares the main header, so it is
+		 * read once; FEI extended headers go through read_header per image */
+		vector<EMObject> read_header_column(const string & key, const vector<int> & indices);
+
 	private:
 		enum MrcMode {
 			MRC_UCHAR = 0,
@@ -284,6 +288,14 @@ namespace EMAN
 		bool is_big_endian;
 		bool is_new_file;
 		bool is_transpose;
+
+		/* the main header from the last write_header. It is written out by
+		 * flush(), so a stack written one image at a time updates it once. */
+		MrcHeader out_header;
+		bool header_dirty;
+
+		/** write out_header to the start of the file if it changed. */
+		void write_main_header();
 		
 		/** generate the machine stamp used in MRC image format. */
 		static int generate_machine_stamp();
@@ -552,15 +552,20 @@ int SpiderIO::read_data(float *data, int image_index, const Region * area, bool)
 	size_t size = static_cast < size_t > (first_h->nsam * first_h->nrow * first_h->nslice);
 	size_t single_image_size = static_cast < size_t > (first_h->headlen + size * sizeof(float));
 	off_t offset = overall_headlen + single_image_size * image_index;
-	portable_fseek(file, offset, SEEK_SET);
 
-	portable_fseek(file, (int) first_h->headlen, SEEK_CUR);
+	// whole images of a read-only file are copied straight from the mapping
+	bool from_map = (!area && map_file(filename) &&
+					 read_mapped < float >(data, offset + (size_t) first_h->headlen, size));
 
-#if 1
-	EMUtil::process_region_io(data, file, READ_ONLY, 0, sizeof(float),
-							  (int) first_h->nsam, (int) first_h->nrow,
-							  (int) first_h->nslice, area);
-#endif
+	if (!from_map) {
+		portable_fseek(file, offset, SEEK_SET);
+
+		portable_fseek(file, (int) first_h->headlen, SEEK_CUR);
+
+		EMUtil::process_region_io(data, file, READ_ONLY, 0, sizeof(float),
+								  (int) first_h->nsam, (int) first_h->nrow,
+								  (int) first_h->nslice, area);
+	}
 #if 0
 	unsigned int nz = static_cast < unsigned int >(first_h->nslice);
 	int sec_size = static_cast < int >(first_h->nsam * first_h->nrow * sizeof(float));
@@ -576,7 +581,9 @@ int SpiderIO::read_data(float *data, int image_index, const Region * area, bool)
 							(int) first_h->nslice, &zlen);
 
 	int data_size = xlen * ylen * zlen;
-	become_host_endian(data, data_size);
+	if (!from_map) {
+		become_host_endian(data, data_size);
+	}
 	EXITFUNC;
 	return 0;
 }
@@ -46,6 +46,23 @@ namespace {
 	const int RED = PCT(30);		/* 30% */
 	const int GREEN = PCT(59);		/* 59% */
 	const int BLUE = PCT(11);		/* 11% */
+
+	/* Converts rows [y_start, y_end) of a decoded strip, columns [x0, x0 + xlen), to float */
+	template<class T>
+	void strip_rows_to_float(const unsigned char *cdata, int nx, int y_start, int y_end,
+							 int x0, int xlen, bool negate, float *& out)
+	{
+		const T *src = reinterpret_cast<const T *>(cdata);
+		for (int l = y_start; l < y_end; l++) {
+			const T *row = src + (size_t)l * nx + x0;
+			if (negate) {
+				for (int j = 0; j < xlen; j++) *out++ = -(float)row[j];
+			}
+			else {
+				for (int j = 0; j < xlen; j++) *out++ = (float)row[j];
+			}
+		}
+	}
 }
 
 TiffIO::TiffIO(const string & fname, IOMode rw)
@@ -165,6 +182,18 @@ int TiffIO::get_nimg()
 	return nimg;
 }
 
+// TIFFSetDirectory() walks the directory chain from the first frame, so reading
+// a movie frame by frame steps to the next directory instead
+void TiffIO::set_directory(int image_index)
+{
+	int cur = (int)TIFFCurrentDirectory(tiff_file);
+
+	if (cur == image_index) return;
+	if (cur + 1 == image_index && TIFFReadDirectory(tiff_file)) return;
+
+	TIFFSetDirectory(tiff_file, image_index);
+}
+
 int TiffIO::read_header(Dict & dict, int image_index, const Region * area, bool)
 {
 	ENTERFUNC;
@@ -175,7 +204,7 @@ int TiffIO::read_header(Dict & dict, int image_index, const Region * area, bool)
 		image_index = 0;
 	}
 
-	TIFFSetDirectory(tiff_file, image_index);
+	set_directory(image_index);
 
 	int nx = 0;
 	int ny = 0;
@@ -238,7 +267,7 @@ int TiffIO::read_data(float *rdata, int image_index, const Region * area, bool)
 
 	check_read_access(image_index, rdata);
 
-	TIFFSetDirectory(tiff_file, image_index);
+	set_directory(image_index);
 
 	int nx = 0;
 	int ny = 0;
@@ -331,10 +360,11 @@ int TiffIO::read_data(float *rdata, int image_index, const Region * area, bool)
 				return -1;
 			}
 
-			int k = 0;
+			float *out = rdata;
 			int num_read = 0;
 			int mode_size = bitspersample / CHAR_BIT;
 			int total_rows = 0;
+			bool negate = (photometric == PHOTOMETRIC_MINISWHITE);
 
 			for (uint32 i = 0; i < num_strips; i++) {
 				if ((num_read = TIFFReadEncodedStrip(tiff_file, i, cdata, strip_size)) == -1) {
@@ -362,25 +392,14 @@ int TiffIO::read_data(float *rdata, int image_index, const Region * area, bool)
 					}
 				}
 
-				for (int l = y_start; l < y_end; l++) {
-					for (int j = x0; j < x0 + xlen; j++) {
-						if (bitspersample == CHAR_BIT) {
-							photometric == PHOTOMETRIC_MINISWHITE ?
-								rdata[k] = -(float) ((unsigned char*)cdata)[l * nx + j] :
-								rdata[k] = (float) ((unsigned char*)cdata)[l * nx + j];
-						}
-						else if (bitspersample == sizeof(unsigned short) * CHAR_BIT) {
-							photometric == PHOTOMETRIC_MINISWHITE ?
-								rdata[k] = -(float)((unsigned short*)cdata)[l * nx + j] :
-								rdata[k] = (float)((unsigned short*)cdata)[l * nx + j];
-						}
-						else if (bitspersample == sizeof(float) * CHAR_BIT) {
-							photometric == PHOTOMETRIC_MINISWHITE ?
-								rdata[k] = -((float*)cdata)[l * nx + j] :
-								rdata[k] = ((float*)cdata)[l * nx + j];
-						}
-						k++;
-					}
+				if (bitspersample == CHAR_BIT) {
+					strip_rows_to_float<unsigned char>(cdata, nx, y_start, y_end, x0, xlen, negate, out);
+				}
+				else if (bitspersample == sizeof(unsigned short) * CHAR_BIT) {
+					strip_rows_to_float<unsigned short>(cdata, nx, y_start, y_end, x0, xlen, negate, out);
+				}
+				else if (bitspersample == sizeof(float) * CHAR_BIT) {
+					strip_rows_to_float<float>(cdata, nx, y_start, y_end, x0, xlen, negate, out);
 				}
 			}
 
@@ -60,6 +60,8 @@ namespace EMAN
 		int write_compressed(float *data);
 
 	  private:
+		void set_directory(int image_index);
+
 		enum
 		{
 			TIFF_LITTLE_ENDIAN = 0x49,
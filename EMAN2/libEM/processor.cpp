@@ -52,6 +52,8 @@
 #include <algorithm>
 #include <gsl/gsl_fit.h>
 #include <ctime>
+#include <memory>
+#include <thread>
 
 #ifdef __APPLE__
 	typedef unsigned int uint;
@@ -1804,8 +1806,7 @@ EMData* ApplySymProcessor::process(const EMData * const image)
 		return ret;
 	}
 
-	Symmetry3D* sym = Factory<Symmetry3D>::get((string)params.set_default("sym","c1"));
-	vector<Transform> transforms = sym->get_syms();
+	const vector<Transform>& transforms = Symmetry3D::get_symmetry_ops((string)params.set_default("sym","c1")).syms;
 
 	for(vector<Transform>::const_iterator trans_it = transforms.begin(); trans_it != transforms.end(); trans_it++) {
 		Transform t = *trans_it;
@@ -7678,8 +7679,9 @@ EMData *FSCFourierProcessor::process(EMData const *image)
 	}
 	fclose(out);
 
-	EMData *fft=image->do_fft();
+	EMData *fft=image->is_complex()?image->copy():image->do_fft();
 	fft->apply_radial_func(0,sscale*0.5/(float)image->get_ysize(),wienerary);
+	if (image->is_complex()) return fft;
 
 	EMData *ret=fft->do_ift();
 	delete fft;
@@ -8075,7 +8077,7 @@ void SymSearchProcessor::process_inplace(EMData * image)
 	vector< vector< Transform > > transforms(sym_num);
 	vector< float* > symvals(sym_num);
 	for (int i =0; i < sym_num; i++) {
-		vector<Transform> sym_transform =  Symmetry3D::get_symmetries(sym_list[i]);
+		const vector<Transform>& sym_transform =  Symmetry3D::get_symmetry_ops(sym_list[i]).syms;
 		transforms[i] = sym_transform;
 		symvals[i] = new float[sym_transform.size()]; // new float(nsym);
 	}
@@ -10756,62 +10758,526 @@ int EMAN::multi_processors(EMData * image, vector < string > processornames)
 	return 0;
 }
 
-float* TransformProcessor::transform(const EMData* const image, const Transform& t) const {
+ProcessorChain::~ProcessorChain()
+{
+	for (size_t i = 0; i < procs.size(); i++) delete procs[i];
+}
 
-	ENTERFUNC;
+void ProcessorChain::add(const string & name, const Dict & new_params)
+{
+	Processor *p = Factory < Processor >::get(name, new_params);
+	if (!p) throw NotExistingObjectException(name, "The named processor does not exist");
 
-	Transform inv = t.inverse();
-	int nx = image->get_xsize();
-	int ny = image->get_ysize();
-	int nz = image->get_zsize();
-	int nxy = nx*ny;
-	int N	= ny;
+	procs.push_back(p);
+	params.push_back(new_params);
+}
 
-	int zerocorners = params.set_default("zerocorners",0);
+bool ProcessorChain::in_fourier(size_t i) const
+{
+	Processor *p = procs[i];
 
+	// leaves the transform in amplitude/phase form
+	if (dynamic_cast<LowpassRandomPhaseProcessor *>(p)) return false;
+	// a transform can't be padded
+	if (dynamic_cast<NewFourierProcessor *>(p)) return !params[i].has_key("dopad") || (int)params[i].get("dopad") == 0;
 
-	const float * const src_data = image->get_const_data();
-	float *des_data = (float *) EMUtil::em_calloc(sizeof(float)*nx,ny*nz);
+	return dynamic_cast<FourierProcessor *>(p) || dynamic_cast<FourierAnlProcessor *>(p) ||
+		dynamic_cast<CTFCorrProcessor *>(p) || dynamic_cast<FSCFourierProcessor *>(p);
+}
 
-	if ((nz == 1)&&(image -> is_real()))  {
-		Vec2f offset(nx/2,ny/2);
-		for (int j = 0; j < ny; j++) {
+void ProcessorChain::reset_params(size_t i, const EMData * image)
+{
+	// preprocess() stores derived cutoffs in params, so each image starts over from the
+	// parameters given to add(). A cutoff in pixels is resolved against the real space nx
+	// here, as the transform the processor sees is nx+2 wide.
+	Dict p = params[i];
+	if (p.has_key("cutoff_pixels") && !p.has_key("sigma") && !p.has_key("cutoff_abs") && !p.has_key("cutoff_freq")) {
+		p["cutoff_abs"] = (float)p["cutoff_pixels"] / image->get_xsize();
+		p.erase("cutoff_pixels");
+	}
+	procs[i]->set_params(p);
+}
+
+void ProcessorChain::process_inplace(EMData * image)
+{
+	if (!image) {
+		LOGWARN("NULL Image");
+		return;
+	}
+
+	size_t i = 0;
+	while (i < procs.size()) {
+		size_t end = i;
+		if (!image->is_complex()) {
+			if (dynamic_cast<NormalizeProcessor *>(procs[end]) && end + 1 < procs.size() && in_fourier(end + 1)) end++;
+			while (end < procs.size() && in_fourier(end)) end++;
+		}
+
+		if (end - i > 1) {
+			process_fourier_run(image, i, end);
+			i = end;
+		}
+		else {
+			procs[i]->set_params(params[i]);
+			procs[i]->process_inplace(image);
+			i++;
+		}
+	}
+}
+
+EMData *ProcessorChain::process(const EMData * image)
+{
+	EMData *result = image->copy();
+	process_inplace(result);
+	return result;
+}
+
+void ProcessorChain::process_fourier_run(EMData * image, size_t begin, size_t end)
+{
+	const size_t n = (size_t)image->get_xsize() * image->get_ysize() * image->get_zsize();
+	float mean = 0, scale = 1;
+
+	NormalizeProcessor *norm = dynamic_cast<NormalizeProcessor *>(procs[begin]);
+	if (norm) {
+		norm->set_params(params[begin]);
+		float sigma = norm->calc_sigma(image);
+		if (sigma == 0 || !Util::goodf(&sigma)) {
+			LOGWARN("cannot do normalization on image with sigma = 0");
+		}
+		else {
+			mean = norm->calc_mean(image);
+			scale = 1.0f / sigma;
+		}
+		begin++;
+	}
+
+	std::unique_ptr<EMData> fft(image->do_fft());
+	if (fft->has_attr("filter_curve")) fft->del_attr("filter_curve");
+
+	// (x - mean) / sigma only changes the origin term and scales the whole transform
+	fft->get_data()[0] -= mean * n;
+	fft->update();
+
+	const int array_size = FFTRADIALOVERSAMPLE * image->get_ysize();
+	const float step = 0.5f / array_size;
+	vector < float > table;		// product of the pending FourierProcessor tables
+
+	for (size_t i = begin; i <= end; i++) {
+		FourierProcessor *fp = i < end ? dynamic_cast<FourierProcessor *>(procs[i]) : 0;
+		if (fp) {
+			reset_params(i, image);
+			fp->preprocess(image);
+			vector < float > yarray(array_size);
+			fp->create_radial_func(yarray);
+			if (params[i].has_key("return_radial") && (bool)params[i]["return_radial"]) image->set_attr("filter_curve", yarray);
+
+			if (table.empty()) table = yarray;
+			else for (int k = 0; k < array_size; k++) table[k] *= yarray[k];
+			continue;
+		}
+
+		// apply what has been gathered before handing the transform to anything else
+		if (!table.empty()) {
+			for (int k = 0; k < array_size; k++) table[k] *= scale;
+			fft->apply_radial_func(0, step, table);
+			table.clear();
+		}
+		else if (scale != 1.0f) {
+			fft->mult(scale);
+		}
+		scale = 1.0f;
+
+		if (i < end) {
+			reset_params(i, image);
+			procs[i]->process_inplace(fft.get());
+		}
+	}
+
+	if (fft->has_attr("filter_curve")) image->set_attr("filter_curve", fft->get_attr("filter_curve"));
+
+	std::unique_ptr<EMData> ift(fft->do_ift());
+	memcpy(image->get_data(), ift->get_data(), n * sizeof(float));
+	image->update();
+}
+
+namespace {
+	/** Separable interpolation kernels for TransformProcessor. weights() gives the weights of
+	 * the TAPS samples floor(x) - TAPS/2 + 1 ... floor(x) + TAPS/2 for t = x - floor(x), and
+	 * edge() maps a tap index outside 0 ... n-1 back into the image.
+	 *
+	 * Cubic B-spline, applied to coefficients from bspline_prefilter() it interpolates. Taps
+	 * past the edge are mirrored, the same extension the prefilter assumes */
+	struct BSplineKernel
+	{
+		static const int TAPS = 4;
+		static inline int edge(int i, int n)
+		{
+			if (i >= 0 && i < n) return i;
+			if (n == 1) return 0;
+			const int p = 2 * n - 2;
+			i = abs(i) % p;
+			return i < n ? i : p - i;
+		}
+		static inline void weights(float t, float *w)
+		{
+			float s = 1.0f - t;
+			float t2 = t * t;
+			float t3 = t2 * t;
+			w[0] = s * s * s / 6.0f;
+			w[1] = (3.0f * t3 - 6.0f * t2 + 4.0f) / 6.0f;
+			w[2] = (-3.0f * t3 + 3.0f * t2 + 3.0f * t + 1.0f) / 6.0f;
+			w[3] = t3 / 6.0f;
+		}
+	};
+
+	/** Lanczos (a=3) windowed sinc, normalized to unit sum. The kernel is tabulated, as
+	 * evaluating it directly costs a dozen sin() per tap. Taps past the edge repeat the
+	 * edge voxel. */
+	struct SincKernel
+	{
+		static const int TAPS = 6;
+		static const int RES = 1024;	// table entries per pixel
+		static inline int edge(int i, int n) { return std::min(std::max(i, 0), n - 1); }
+
+		static const vector<float> & table()
+		{
+			static const vector<float> tab = [] {
+				vector<float> t(TAPS * RES + 2, 0.0f);
+				for (int i = 0; i <= TAPS * RES; i++) {
+					double d = M_PI * ((double)i / RES - TAPS / 2);
+					t[i] = (i == TAPS * RES / 2) ? 1.0f : (float)(3.0 * sin(d) * sin(d / 3.0) / (d * d));
+				}
+				return t;
+			}();
+			return tab;
+		}
+
+		static inline void weights(float t, float *w)
+		{
+			const float *tab = &table()[0];
+			float sum = 0.0f;
+			for (int k = 0; k < TAPS; k++) {
+				float p = (t - (k - 2) + TAPS / 2) * RES;
+				int i = (int)p;
+				float f = p - i;
+				w[k] = tab[i] + f * (tab[i + 1] - tab[i]);
+				sum += w[k];
+			}
+			for (int k = 0; k < TAPS; k++) w[k] /= sum;
+		}
+	};
+
+	/** Turns the n samples c[0], c[stride], ... into cubic B-spline coefficients, with
+	 * the recursive filter of Unser et al. and mirror boundaries (c[-k] = c[k],
+	 * c[n-1+k] = c[n-1-k]) */
+	void bspline_prefilter_line(float *c, int n, size_t stride)
+	{
+		if (n < 2) return;
+
+		const double z = sqrt(3.0) - 2.0;
+		const double lambda = (1.0 - z) * (1.0 - 1.0 / z);
+		const int horizon = 30;	// z^30 < 1e-17
+
+		double sum;
+		if (n > horizon) {
+			double zk = z;
+			sum = c[0];
+			for (int k = 1; k < horizon; k++) {
+				sum += zk * c[k * stride];
+				zk *= z;
+			}
+		}
+		else {
+			// short lines sum the mirrored extension exactly
+			const double zn = pow(z, n - 1);
+			const double z2n = zn * zn / z;
+			double zk = z, zr = z2n;
+			sum = c[0] + zn * c[(n - 1) * stride];
+			for (int k = 1; k < n - 1; k++) {
+				sum += (zk + zr) * c[k * stride];
+				zk *= z;
+				zr /= z;
+			}
+			sum /= 1.0 - zn * zn;
+		}
+		sum *= lambda;
+
+		double prev = sum;
+		c[0] = (float)sum;
+		for (int k = 1; k < n; k++) {
+			prev = c[k * stride] * lambda + z * prev;
+			c[k * stride] = (float)prev;
+		}
+
+		prev = (z / (z * z - 1.0)) * (c[(n - 1) * stride] + z * c[(n - 2) * stride]);
+		c[(n - 1) * stride] = (float)prev;
+		for (int k = n - 2; k >= 0; k--) {
+			prev = z * (prev - c[k * stride]);
+			c[k * stride] = (float)prev;
+		}
+	}
+
+	void bspline_prefilter(float *data, int nx, int ny, int nz)
+	{
+		const size_t nxy = (size_t)nx * ny;
+		for (int k = 0; k < nz; k++) {
+			for (int j = 0; j < ny; j++) bspline_prefilter_line(data + k * nxy + (size_t)j * nx, nx, 1);
+			for (int i = 0; i < nx; i++) bspline_prefilter_line(data + k * nxy + i, ny, nx);
+		}
+		for (size_t i = 0; i < nxy; i++) bspline_prefilter_line(data + i, nz, nxy);
+	}
+
+	/** Resamples output rows [r0, r1), row r being line r % ny of slice r / ny. Output voxel
+	 * (i,j,k) takes the source value at m (i-nx/2, j-ny/2, k-nz/2) + (nx/2, ny/2, nz/2), m a row
+	 * major 3x4 matrix; along a row that position only advances by the first column of m.
+	 * Positions outside the source give 0 and taps past the edge go through K::edge(). */
+	template<class K, bool THREED>
+	void resample_rows(const float *src, float *des, int nx, int ny, int nz, const float *m,
+					   size_t r0, size_t r1)
+	{
+		const int T = K::TAPS;
+		const size_t nxy = (size_t)nx * ny;
+		vector<float> xs(nx), ys(nx), zs(nx);
+		float wx[T], wy[T], wz[T];
+		int ox[T];
+		size_t oy[T], oz[T];
+
+		for (size_t r = r0; r < r1; r++) {
+			const int j = (int)(r % ny);
+			const int k = (int)(r / ny);
+			const float cx = (float)(-nx / 2), cy = (float)(j - ny / 2), cz = (float)(k - nz / 2);
+			float *out = des + r * nx;
+
+			const float bx = m[0] * cx + m[1] * cy + m[2] * cz + m[3] + nx / 2;
+			const float by = m[4] * cx + m[5] * cy + m[6] * cz + m[7] + ny / 2;
+			const float bz = m[8] * cx + m[9] * cy + m[10] * cz + m[11] + nz / 2;
 			for (int i = 0; i < nx; i++) {
-				Vec2f coord(i-nx/2,j-ny/2);
-				Vec2f soln = inv*coord;
-				soln += offset;
+				xs[i] = bx + i * m[0];
+				ys[i] = by + i * m[4];
+			}
+			if (THREED) {
+				for (int i = 0; i < nx; i++) zs[i] = bz + i * m[8];
+			}
 
-				float x2 = soln[0];
-				float y2 = soln[1];
+			for (int i = 0; i < nx; i++) {
+				const float x = xs[i], y = ys[i], z = THREED ? zs[i] : 0.0f;
+				if (x < 0 || y < 0 || x >= nx || y >= ny || (THREED && (z < 0 || z >= nz))) {
+					out[i] = 0;
+					continue;
+				}
 
-				if (x2 < 0 || x2 >= nx || y2 < 0 || y2 >= ny ) {
-					des_data[i + j * nx] = 0; // It may be tempting to set this value to the
-					// mean but in fact this is not a good thing to do. Talk to S.Ludtke about it.
+				const int ix = (int)x, iy = (int)y, iz = (int)z;
+				K::weights(x - ix, wx);
+				K::weights(y - iy, wy);
+				for (int a = 0; a < T; a++) {
+					ox[a] = K::edge(ix + a - T / 2 + 1, nx);
+					oy[a] = (size_t)K::edge(iy + a - T / 2 + 1, ny) * nx;
 				}
-				else {
-					int ii = Util::fast_floor(x2);
-					int jj = Util::fast_floor(y2);
-					int k0 = ii + jj * nx;
-					int k1 = k0 + 1;
-					int k2 = k0 + nx;
-					int k3 = k0 + nx + 1;
-
-					if (ii == nx - 1) {
-						k1--;
-						k3--;
+
+				float sum = 0;
+				if (THREED) {
+					K::weights(z - iz, wz);
+					for (int a = 0; a < T; a++) oz[a] = (size_t)K::edge(iz + a - T / 2 + 1, nz) * nxy;
+					for (int c = 0; c < T; c++) {
+						float sy = 0;
+						for (int b = 0; b < T; b++) {
+							const float *row = src + oz[c] + oy[b];
+							float sx = 0;
+							for (int a = 0; a < T; a++) sx += wx[a] * row[ox[a]];
+							sy += wy[b] * sx;
+						}
+						sum += wz[c] * sy;
 					}
-					if (jj == ny - 1) {
-						k2 -= nx;
-						k3 -= nx;
+				}
+				else {
+					for (int b = 0; b < T; b++) {
+						const float *row = src + oy[b];
+						float sx = 0;
+						for (int a = 0; a < T; a++) sx += wx[a] * row[ox[a]];
+						sum += wy[b] * sx;
 					}
+				}
+				out[i] = sum;
+			}
+		}
+	}
 
-					float t = x2 - ii;
-					float u = y2 - jj;
+	/** resample_rows() for (bi/tri)linear interpolation, spelled out as it is the default */
+	template<bool THREED>
+	void linear_rows(const float *src, float *des, int nx, int ny, int nz, const float *m,
+					 size_t r0, size_t r1)
+	{
+		const size_t nxy = (size_t)nx * ny;
+		vector<float> xs(nx), ys(nx), zs(nx);
+
+		for (size_t r = r0; r < r1; r++) {
+			const int j = (int)(r % ny);
+			const int k = (int)(r / ny);
+			const float cx = (float)(-nx / 2), cy = (float)(j - ny / 2), cz = (float)(k - nz / 2);
+			float *out = des + r * nx;
+
+			const float bx = m[0] * cx + m[1] * cy + m[2] * cz + m[3] + nx / 2;
+			const float by = m[4] * cx + m[5] * cy + m[6] * cz + m[7] + ny / 2;
+			const float bz = m[8] * cx + m[9] * cy + m[10] * cz + m[11] + nz / 2;
+			for (int i = 0; i < nx; i++) {
+				xs[i] = bx + i * m[0];
+				ys[i] = by + i * m[4];
+			}
+			if (THREED) {
+				for (int i = 0; i < nx; i++) zs[i] = bz + i * m[8];
+			}
 
-					des_data[i + j * nx] = Util::bilinear_interpolate(src_data[k0],src_data[k1], src_data[k2], src_data[k3],t,u);
+			for (int i = 0; i < nx; i++) {
+				const float x = xs[i], y = ys[i], z = THREED ? zs[i] : 0.0f;
+				if (x < 0 || y < 0 || x >= nx || y >= ny || (THREED && (z < 0 || z >= nz))) {
+					out[i] = 0;
+					continue;
 				}
+
+				const int ix = (int)x, iy = (int)y;
+				const float tx = x - ix, ty = y - iy;
+				const size_t dx = ix < nx - 1 ? 1 : 0;
+				const size_t dy = iy < ny - 1 ? nx : 0;
+				const float *p = src + (size_t)iy * nx + ix;
+
+				if (THREED) {
+					const int iz = (int)z;
+					const float tz = z - iz;
+					const size_t dz = iz < nz - 1 ? nxy : 0;
+					p += iz * nxy;
+					const float a = p[0] + tx * (p[dx] - p[0]);
+					const float b = p[dy] + tx * (p[dy + dx] - p[dy]);
+					const float c = p[dz] + tx * (p[dz + dx] - p[dz]);
+					const float d = p[dz + dy] + tx * (p[dz + dy + dx] - p[dz + dy]);
+					const float e = a + ty * (b - a);
+					out[i] = e + tz * (c + ty * (d - c) - e);
+				}
+				else {
+					const float a = p[0] + tx * (p[dx] - p[0]);
+					const float b = p[dy] + tx * (p[dy + dx] - p[dy]);
+					out[i] = a + ty * (b - a);
+				}
+			}
+		}
+	}
+
+	/** resample_rows() for a matrix of 0, +-1 and integer shifts (integer translations,
+	 * multiples of 90 degrees, mirrors), which only moves voxels */
+	void permute_rows(const float *src, float *des, int nx, int ny, int nz, const int *m,
+					  size_t r0, size_t r1)
+	{
+		const size_t nxy = (size_t)nx * ny;
+
+		for (size_t r = r0; r < r1; r++) {
+			const int j = (int)(r % ny);
+			const int k = (int)(r / ny);
+			float *out = des + r * nx;
+
+			const int bx = m[0] * (-nx / 2) + m[1] * (j - ny / 2) + m[2] * (k - nz / 2) + m[3] + nx / 2;
+			const int by = m[4] * (-nx / 2) + m[5] * (j - ny / 2) + m[6] * (k - nz / 2) + m[7] + ny / 2;
+			const int bz = m[8] * (-nx / 2) + m[9] * (j - ny / 2) + m[10] * (k - nz / 2) + m[11] + nz / 2;
+
+			// a shifted row is a block copy
+			if (m[0] == 1 && m[4] == 0 && m[8] == 0) {
+				std::fill(out, out + nx, 0.0f);
+				if (by < 0 || by >= ny || bz < 0 || bz >= nz) continue;
+				const int i0 = std::max(0, -bx);
+				const int i1 = std::min(nx, nx - bx);
+				if (i0 < i1) std::copy(src + bz * nxy + (size_t)by * nx + bx + i0, src + bz * nxy + (size_t)by * nx + bx + i1, out + i0);
+				continue;
+			}
+
+			for (int i = 0; i < nx; i++) {
+				const int x = bx + i * m[0], y = by + i * m[4], z = bz + i * m[8];
+				out[i] = (x < 0 || y < 0 || z < 0 || x >= nx || y >= ny || z >= nz) ? 0.0f : src[z * nxy + (size_t)y * nx + x];
+			}
+		}
+	}
+
+	/** Real space transform of src into des by TransformProcessor, m being the inverse
+	 * transform, rows split between nthreads threads (0: by image size) */
+	void transform_real(const float *src, float *des, int nx, int ny, int nz, const Transform & inv,
+						const string & interp, int nthreads)
+	{
+		float m[12];
+		for (int r = 0; r < 3; r++) {
+			for (int c = 0; c < 4; c++) m[r * 4 + c] = inv.at(r, c);
+		}
+		// a 2D transform ignores z
+		if (nz == 1) {
+			m[2] = m[6] = 0;
+			for (int c = 8; c < 12; c++) m[c] = 0;
+		}
+
+		// a voxel moves by up to n/2 times the matrix error, keep that under 0.005 voxel
+		const float tol = 0.01f / std::max(nx, std::max(ny, nz));
+		bool integral = true;
+		int mi[12];
+		for (int c = 0; c < 12; c++) {
+			mi[c] = (int)Util::round(m[c]);
+			if (fabs(m[c] - mi[c]) >= tol || ((c & 3) != 3 && abs(mi[c]) > 1)) integral = false;
+		}
+
+		vector<float> coef;
+		if (!integral && interp == "bspline") {
+			coef.assign(src, src + (size_t)nx * ny * nz);
+			bspline_prefilter(&coef[0], nx, ny, nz);
+			src = &coef[0];
+		}
+
+		const size_t nrows = (size_t)ny * nz;
+		auto rows = [&](size_t r0, size_t r1) {
+			if (integral) permute_rows(src, des, nx, ny, nz, mi, r0, r1);
+			else if (interp == "bspline") {
+				if (nz > 1) resample_rows<BSplineKernel, true>(src, des, nx, ny, nz, m, r0, r1);
+				else resample_rows<BSplineKernel, false>(src, des, nx, ny, nz, m, r0, r1);
+			}
+			else if (interp == "sinc") {
+				if (nz > 1) resample_rows<SincKernel, true>(src, des, nx, ny, nz, m, r0, r1);
+				else resample_rows<SincKernel, false>(src, des, nx, ny, nz, m, r0, r1);
 			}
+			else {
+				if (nz > 1) linear_rows<true>(src, des, nx, ny, nz, m, r0, r1);
+				else linear_rows<false>(src, des, nx, ny, nz, m, r0, r1);
+			}
+		};
+
+		// threads only pay off for volumes; particles are usually processed in parallel already
+		if (nthreads <= 0) nthreads = (nrows * nx >= ((size_t)1 << 20)) ? (int)std::thread::hardware_concurrency() : 1;
+		if ((size_t)nthreads > nrows) nthreads = (int)nrows;
+		if (nthreads <= 1) {
+			rows(0, nrows);
+			return;
 		}
+
+		vector<std::thread> threads;
+		for (int t = 1; t < nthreads; t++) threads.push_back(std::thread(rows, nrows * t / nthreads, nrows * (t + 1) / nthreads));
+		rows(0, nrows / nthreads);
+		for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+	}
+}
+
+float* TransformProcessor::transform(const EMData* const image, const Transform& t) const {
+
+	ENTERFUNC;
+
+	Transform inv = t.inverse();
+	int nx = image->get_xsize();
+	int ny = image->get_ysize();
+	int nz = image->get_zsize();
+	int N	= ny;
+
+	int zerocorners = params.set_default("zerocorners",0);
+
+
+	const float * const src_data = image->get_const_data();
+	float *des_data = (float *) EMUtil::em_calloc(sizeof(float)*nx,ny*nz);
+
+	if (image->is_real()) {
+		string interp = (string)params.set_default("interp", "linear");
+		if (interp != "linear" && interp != "bspline" && interp != "sinc")
+			throw InvalidParameterException("interp must be linear, bspline or sinc");
+		transform_real(src_data, des_data, nx, ny, nz, inv, interp, params.set_default("nthreads", 0));
 	}
 	if ((nz == 1)&&(image -> is_complex())&&(nx%2==0)&&((2*(nx-ny)-3)*(2*(nx-ny)-3)==1)&&(zerocorners==0) )	 {
 	  //printf("Hello 2-d complex  TransformProcessor \n");
@@ -11611,71 +12077,6 @@ float* TransformProcessor::transform(const EMData* const image, const Transform&
 				  des_data[IndexOut+1] = tempIb;
 		}}}	 // end z, y, x loops through new coordinates
 	}	//	end	 rotations in Fourier Space	 3D
-	if ((nz > 1)&&(image -> is_real())) {
-		size_t l=0, ii, k0, k1, k2, k3, k4, k5, k6, k7;
-		Vec3f offset(nx/2,ny/2,nz/2);
-		float x2, y2, z2, tuvx, tuvy, tuvz;
-		int ix, iy, iz;
-		for (int k = 0; k < nz; ++k) {
-			for (int j = 0; j < ny; ++j) {
-				for (int i = 0; i < nx; ++i,++l) {
-					Vec3f coord(i-nx/2,j-ny/2,k-nz/2);
-					Vec3f soln = inv*coord;
-					soln += offset;
-
-					x2 = soln[0];
-					y2 = soln[1];
-					z2 = soln[2];
-
-					if (x2 < 0 || y2 < 0 || z2 < 0 || x2 >= nx	|| y2 >= ny	 || z2>= nz ) {
-						des_data[l] = 0;
-					}
-					else {
-						ix = Util::fast_floor(x2);
-						iy = Util::fast_floor(y2);
-						iz = Util::fast_floor(z2);
-						tuvx = x2-ix;
-						tuvy = y2-iy;
-						tuvz = z2-iz;
-						ii = ix + iy * nx + iz * nxy;
-
-						k0 = ii;
-						k1 = k0 + 1;
-						k2 = k0 + nx;
-						k3 = k0 + nx+1;
-						k4 = k0 + nxy;
-						k5 = k1 + nxy;
-						k6 = k2 + nxy;
-						k7 = k3 + nxy;
-
-						if (ix == nx - 1) {
-							k1--;
-							k3--;
-							k5--;
-							k7--;
-						}
-						if (iy == ny - 1) {
-							k2 -= nx;
-							k3 -= nx;
-							k6 -= nx;
-							k7 -= nx;
-						}
-						if (iz == nz - 1) {
-							k4 -= nxy;
-							k5 -= nxy;
-							k6 -= nxy;
-							k7 -= nxy;
-						}
-
-						des_data[l] = Util::trilinear_interpolate(src_data[k0],
-								src_data[k1], src_data[k2], src_data[k3], src_data[k4],
-								src_data[k5], src_data[k6], src_data[k7], tuvx, tuvy, tuvz);
-					}
-				}
-			}
-		}
-	}
-
 	EXITFUNC;
 	return des_data;
 }
@@ -331,6 +331,8 @@ The basic design of EMAN Processors: <br>\
 	 */
 	class FourierProcessor:public Processor
 	{
+		friend class ProcessorChain;
+
 	  public:
 		void process_inplace(EMData * image);
 
@@ -2859,6 +2861,8 @@ The data itself will remain stored in single precision floating point format, so
 				d.put("ty", EMObject::FLOAT, "y translation" );
 				d.put("tz", EMObject::FLOAT, "y translation" );
 				d.put("zerocorners",EMObject::INT,"If set, corners (anything beyond radius/2-1) may be zeroed out in real or Fourier space. This will produce a considerable speedup in Fourier rotations. ");
+				d.put("interp",EMObject::STRING,"Real space interpolation: linear (default), bspline (cubic B-spline) or sinc (Lanczos windowed, 6 taps). Transforms that only move whole pixels (integer shifts, multiples of 90 degrees, mirrors) are copied exactly.");
+				d.put("nthreads",EMObject::INT,"Threads for real space transforms, default 0 uses all cores for images of 1M voxels or more and 1 thread otherwise");
 				return d;
 			}
 
@@ -5826,6 +5830,8 @@ width is also anisotropic and relative to the radii, with 1 being equal to the r
 	 */
 	class NormalizeProcessor:public Processor
 	{
+		friend class ProcessorChain;
+
 	  public:
 		void process_inplace(EMData * image);
 
@@ -10041,6 +10047,53 @@ symmetric phase flipping can optionally be performed.";
 #endif
 
 
+	/** Applies a list of processors in order, with the same result as calling
+	 * process_inplace() with each of them, but with one FFT round trip for every
+	 * run of consecutive Fourier space filters (FourierProcessor's,
+	 * FourierAnlProcessor's, the sparx filter.* processors, filter.ctfcorr.simple
+	 * and filter.wiener.byfsc). The radial tables of adjacent FourierProcessor's
+	 * are multiplied together and applied in one pass, and a normalize.* step
+	 * directly before a run is folded into the transform. Real space steps such as
+	 * mask.soft run in place between the runs.
+	 *
+	 * The processors are created once and reused, so a chain is meant to be set up
+	 * once and applied to every particle.
+	 */
+	class ProcessorChain
+	{
+	  public:
+		ProcessorChain() {}
+		~ProcessorChain();
+
+		/** Appends a processor to the chain.
+		 * @param name The processor name, as for EMData::process_inplace().
+		 * @param params The processor parameters.
+		 * @exception NotExistingObjectException
+		 */
+		void add(const string & name, const Dict & params = Dict());
+
+		void process_inplace(EMData * image);
+
+		/** @return a processed copy of image, which the caller owns */
+		EMData *process(const EMData * image);
+
+		int size() const
+		{
+			return (int)procs.size();
+		}
+
+	  private:
+		ProcessorChain(const ProcessorChain &);
+		ProcessorChain & operator=(const ProcessorChain &);
+
+		bool in_fourier(size_t i) const;
+		void reset_params(size_t i, const EMData * image);
+		void process_fourier_run(EMData * image, size_t begin, size_t end);
+
+		vector < Processor * > procs;
+		vector < Dict > params;
+	};
+
 	int multi_processors(EMData * image, vector < string > processornames);
 	void dump_processors();
 	map<string, vector<string> > dump_processors_list();
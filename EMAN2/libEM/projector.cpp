@@ -34,6 +34,9 @@
 #include "interp.h"
 #include "emutil.h"
 #include "plugins/projector_template.h"
+#include <atomic>
+#include <exception>
+#include <thread>
 
 #ifdef WIN32
 	#define M_PI 3.14159265358979323846f
@@ -66,18 +69,62 @@ template <> Factory < Projector >::Factory()
 //	force_add<XYZProjector>();
 }
 
+EMData *Projector::prepare_volume(const EMData * image) const
+{
+	return image->copy();
+}
+
+EMData *Projector::project_prepared(const EMData * prepared, const Transform & t3d) const
+{
+	Dict p = params;
+	p["transform"] = (Transform *) &t3d;
+	Projector *proj = Factory < Projector >::get(get_name(), p);
+	EMData *vol = prepared->copy();
+	EMData *ret = 0;
+	try {
+		ret = proj->project3d(vol);
+	}
+	catch (...) {
+		delete vol;
+		delete proj;
+		throw;
+	}
+	delete vol;
+	delete proj;
+	return ret;
+}
+
 EMData *GaussFFTProjector::project3d(EMData * image) const
 {
 	Transform* t3d = params["transform"];
 	if ( t3d == NULL ) throw NullPointerException("The transform object (required for projection), was not specified");
+
+	EMData *f = prepare_volume(image);
+	EMData *ret = 0;
+	if (f) {
+		ret = project_prepared(f, *t3d);
+		delete f;
+	}
+
+	if(t3d) {delete t3d; t3d=0;}
+
+	return ret;
+}
+
+EMData *GaussFFTProjector::prepare_volume(const EMData * image) const
+{
 	if ( image->get_ndim() != 3 ) throw ImageDimensionException("Error, the projection volume must be 3D");
 
-	EMData *f = image;
+	EMData *f = 0;
 	if (!image->is_complex()) {
-		image->process_inplace("xform.phaseorigin.tocorner");
-		f = image->do_fft();
+		EMData *tmp = image->copy();
+		tmp->process_inplace("xform.phaseorigin.tocorner");
+		f = tmp->do_fft();
+		delete tmp;
 		f->process_inplace("xform.fourierorigin.tocenter");
-		image->process_inplace("xform.phaseorigin.tocenter");
+	}
+	else {
+		f = image->copy();
 	}
 
 	int f_nx = f->get_xsize();
@@ -86,10 +133,24 @@ EMData *GaussFFTProjector::project3d(EMData * image) const
 
 	if (!f->is_complex() || f_nz != f_ny || f_nx != f_ny + 2) {
 		LOGERR("Cannot project this image");
+		delete f;
 		return 0;
 	}
 
 	f->ap2ri();
+	// modes 3-7 interpolate from a lazily built support table and mode 5 from a lazily
+	// built global kernel table; build both here so project_prepared() only reads them
+	int mode = params["mode"];
+	if (mode >= 3) f->setup4slice();
+	if (mode == 5) Interp::get_gimx();
+	return f;
+}
+
+EMData *GaussFFTProjector::project_prepared(const EMData * f, const Transform & t3d) const
+{
+	int f_nx = f->get_xsize();
+	int f_ny = f->get_ysize();
+	int f_nz = f->get_zsize();
 
 	EMData *tmp = new EMData();
 	tmp->set_size(f_nx, f_ny, 1);
@@ -98,11 +159,13 @@ EMData *GaussFFTProjector::project3d(EMData * image) const
 
 	float *data = tmp->get_data();
 
-	Transform r = t3d->get_rotation_transform();
+	Transform r = t3d.get_rotation_transform();
 	r.invert();
-	float scale = t3d->get_scale();
+	float scale = t3d.get_scale();
 
 	int mode = params["mode"];
+	// built by prepare_volume(), setup4slice(false) only returns it
+	const float *supp = (mode >= 3 ? const_cast<EMData *>(f)->setup4slice(false) : 0);
 	float gauss_width = 1;
 // 	if ( mode == 0 ) mode = 2;
 	if (mode == 2 ) {
@@ -155,7 +218,7 @@ EMData *GaussFFTProjector::project3d(EMData * image) const
 					continue;
 				}
 
-				if (interp_ft_3d(mode, f, xx, yy, zz, data + ii, gauss_width)) {
+				if (interp_ft_3d(mode, f, supp, xx, yy, zz, data + ii, gauss_width)) {
 					data[ii + 1] *= cc;
 				} else {
 					data[ii] = 0;
@@ -173,7 +236,7 @@ EMData *GaussFFTProjector::project3d(EMData * image) const
 	if (returnfft==1){
 		//apperently there is something wrong with translating images in fourier space...
 // 		printf("return fft!\n");
-		Vec3f trans=t3d->get_trans();
+		Vec3f trans=t3d.get_trans();
 		ret=tmp->copy();
 		ret->process_inplace("xform.fourierorigin.tocorner");
 		ret->process_inplace("xform", Dict("tx", (float)trans[0], "ty", (float)trans[1]));
@@ -187,9 +250,9 @@ EMData *GaussFFTProjector::project3d(EMData * image) const
 		ret = tmp->do_ift();
 		ret->process_inplace("xform.phaseorigin.tocenter");
 
-		ret->translate(t3d->get_trans());
+		ret->translate(t3d.get_trans());
 
-		if (t3d->get_mirror() ) ret->process_inplace("xform.flip",Dict("axis","x"));
+		if (t3d.get_mirror() ) ret->process_inplace("xform.flip",Dict("axis","x"));
 
 		Dict filter_d;
 		filter_d["gauss_width"] = gauss_width;
@@ -203,20 +266,19 @@ EMData *GaussFFTProjector::project3d(EMData * image) const
 		tmp = 0;
 	}
 
-	ret->set_attr("xform.projection",t3d);
+	Transform xf(t3d);
+	ret->set_attr("xform.projection",&xf);
 	ret->update();
 
-	if(t3d) {delete t3d; t3d=0;}
-
 	return ret;
 }
 
 
 
-bool GaussFFTProjector::interp_ft_3d(int mode, EMData * image, float x, float y,
+bool GaussFFTProjector::interp_ft_3d(int mode, const EMData * image, const float *supp, float x, float y,
 									 float z, float *data, float gw) const
 {
-	float *rdata = image->get_data();
+	const float *rdata = image->get_const_data();
 	int nx = image->get_xsize();
 	int ny = image->get_ysize();
 	int nz = image->get_zsize();
@@ -298,8 +360,6 @@ bool GaussFFTProjector::interp_ft_3d(int mode, EMData * image, float x, float y,
 		int y0 = (int) floor(y + .5);
 		int z0 = (int) floor(z + .5);
 
-		float *supp = image->setup4slice();
-
 		if (x0 < nx - 4 && y0 <= ny - 3 && z0 <= nz - 3 && y0 >= 2 && z0 >= 2) {
 			float n = 0;
 
@@ -348,8 +408,6 @@ bool GaussFFTProjector::interp_ft_3d(int mode, EMData * image, float x, float y,
 		int y0 = (int) floor(y);
 		int z0 = (int) floor(z);
 
-		float *supp = image->setup4slice();
-
 		if (x0 < nx - 4 && y0 <= ny - 3 && z0 <= nz - 3 && y0 >= 2 && z0 >= 2) {
 			float n = 0;
 
@@ -397,7 +455,6 @@ bool GaussFFTProjector::interp_ft_3d(int mode, EMData * image, float x, float y,
 		int y0 = (int) floor(y + .5);
 		int z0 = (int) floor(z + .5);
 
-		float *supp = image->setup4slice();
 		float *gimx = Interp::get_gimx();
 
 		if (x0 < nx - 4 && y0 <= ny - 3 && z0 <= nz - 3 && y0 >= 2 && z0 >= 2) {
@@ -455,8 +512,6 @@ bool GaussFFTProjector::interp_ft_3d(int mode, EMData * image, float x, float y,
 		int y0 = (int) floor(y + .5);
 		int z0 = (int) floor(z + .5);
 
-		float *supp = image->setup4slice();
-
 		if (x0 < nx - 4 && y0 <= ny - 3 && z0 <= nz - 3 && y0 >= 2 && z0 >= 2) {
 			float n = 0;
 
@@ -507,8 +562,6 @@ bool GaussFFTProjector::interp_ft_3d(int mode, EMData * image, float x, float y,
 		int y0 = (int) floor(y + .5);
 		int z0 = (int) floor(z + .5);
 
-		float *supp = image->setup4slice();
-
 		if (x0 < nx - 4 && y0 <= ny - 3 && z0 <= nz - 3 && y0 >= 2 && z0 >= 2) {
 			float n = 0;
 			if (x0 < 4) {
@@ -797,89 +850,7 @@ EMData *StandardProjector::project3d(EMData * image) const
 			return e;
 		}
 #endif
-		int nx = image->get_xsize();
-		int ny = image->get_ysize();
-		int nz = image->get_zsize();
-
-// 		Transform3D r(Transform3D::EMAN, az, alt, phi);
-		Transform r = t3d->inverse(); // The inverse is taken here because we are rotating the coordinate system, not the image
-		int xy = nx * ny;
-
-		EMData *proj = new EMData();
-		proj->set_size(nx, ny, 1);
-
-		Vec3i offset(nx/2,ny/2,nz/2);
-
-		float *sdata = image->get_data();
-		float *ddata = proj->get_data();
-		for (int k = -nz / 2; k < nz - nz / 2; k++) {
-			int l = 0;
-			for (int j = -ny / 2; j < ny - ny / 2; j++) {
-				ddata[l]=0;
-				for (int i = -nx / 2; i < nx - nx / 2; i++,l++) {
-
-					Vec3f coord(i,j,k);
-					Vec3f soln = r*coord;
-					soln += offset;
-
-					/**A "fix" for the segmentation fault when calling initmodel.py with
-					 * standard projector. We'll look into this and make a real fix.
-					 * -- Grant Tang*/
-//					printf(" ");
-
-					float x2 = soln[0];
-					float y2 = soln[1];
-					float z2 = soln[2];
-
-					float x = (float)Util::fast_floor(x2);
-					float y = (float)Util::fast_floor(y2);
-					float z = (float)Util::fast_floor(z2);
-
-					float t = x2 - x;
-					float u = y2 - y;
-					float v = z2 - z;
-
-					size_t ii = (size_t) ((size_t)x + (size_t)y * nx + (size_t)z * xy);
-// 
-					if (x2 < 0 || y2 < 0 || z2 < 0 ) continue;
-					if 	(x2 > (nx-1) || y2  > (ny-1) || z2 > (nz-1) ) continue;
-
-					if (x2 < (nx - 1) && y2 < (ny - 1) && z2 < (nz - 1)) {
-						ddata[l] +=
-								Util::trilinear_interpolate(sdata[ii], sdata[ii + 1], sdata[ii + nx],
-								sdata[ii + nx + 1], sdata[ii + xy],	sdata[ii + xy + 1], sdata[ii + xy + nx],
-								sdata[ii + xy + nx + 1], t, u, v);
-					}
-					else if ( x2 == (nx - 1) && y2 == (ny - 1) && z2 == (nz - 1) ) {
-						ddata[l] += sdata[ii];
-					}
-					else if ( x2 == (nx - 1) && y2 == (ny - 1) ) {
-						ddata[l] +=	Util::linear_interpolate(sdata[ii], sdata[ii + xy],v);
-					}
-					else if ( x2 == (nx - 1) && z2 == (nz - 1) ) {
-						ddata[l] += Util::linear_interpolate(sdata[ii], sdata[ii + nx],u);
-					}
-					else if ( y2 == (ny - 1) && z2 == (nz - 1) ) {
-						ddata[l] += Util::linear_interpolate(sdata[ii], sdata[ii + 1],t);
-					}
-					else if ( x2 == (nx - 1) ) {
-						ddata[l] += Util::bilinear_interpolate(sdata[ii], sdata[ii + nx], sdata[ii + xy], sdata[ii + xy + nx],u,v);
-					}
-					else if ( y2 == (ny - 1) ) {
-						ddata[l] += Util::bilinear_interpolate(sdata[ii], sdata[ii + 1], sdata[ii + xy], sdata[ii + xy + 1],t,v);
-					}
-					else if ( z2 == (nz - 1) ) {
-						ddata[l] += Util::bilinear_interpolate(sdata[ii], sdata[ii + 1], sdata[ii + nx], sdata[ii + nx + 1],t,u);
-					}
-				}
-			}
-		}
-		proj->update();
-		proj->set_attr("xform.projection",t3d);
-		proj->set_attr("apix_x",(float)image->get_attr("apix_x"));
-		proj->set_attr("apix_y",(float)image->get_attr("apix_y"));
-		proj->set_attr("apix_z",(float)image->get_attr("apix_z"));
-		
+		EMData *proj = project_prepared(image, *t3d);
 		if(t3d) {delete t3d; t3d=0;}
 		return proj;
 	}
@@ -941,6 +912,98 @@ EMData *StandardProjector::project3d(EMData * image) const
 	else throw ImageDimensionException("Standard projection works only for 2D and 3D images");
 }
 
+EMData *StandardProjector::project_prepared(const EMData * image, const Transform & t3d) const
+{
+	if ( image->get_ndim() != 3 ) throw ImageDimensionException("Error, the projection volume must be 3D");
+
+	int nx = image->get_xsize();
+	int ny = image->get_ysize();
+	int nz = image->get_zsize();
+
+// 		Transform3D r(Transform3D::EMAN, az, alt, phi);
+	Transform r = t3d.inverse(); // The inverse is taken here because we are rotating the coordinate system, not the image
+	int xy = nx * ny;
+
+	EMData *proj = new EMData();
+	proj->set_size(nx, ny, 1);
+
+	Vec3i offset(nx/2,ny/2,nz/2);
+
+	const float *sdata = image->get_const_data();
+	float *ddata = proj->get_data();
+	for (int k = -nz / 2; k < nz - nz / 2; k++) {
+		int l = 0;
+		for (int j = -ny / 2; j < ny - ny / 2; j++) {
+			ddata[l]=0;
+			for (int i = -nx / 2; i < nx - nx / 2; i++,l++) {
+
+				Vec3f coord(i,j,k);
+				Vec3f soln = r*coord;
+				soln += offset;
+
+				/**A "fix" for the segmentation fault when calling initmodel.py with
+				 * standard projector. We'll look into this and make a real fix.
+				 * -- Grant Tang*/
+//					printf(" ");
+
+				float x2 = soln[0];
+				float y2 = soln[1];
+				float z2 = soln[2];
+
+				float x = (float)Util::fast_floor(x2);
+				float y = (float)Util::fast_floor(y2);
+				float z = (float)Util::fast_floor(z2);
+
+				float t = x2 - x;
+				float u = y2 - y;
+				float v = z2 - z;
+
+				size_t ii = (size_t) ((size_t)x + (size_t)y * nx + (size_t)z * xy);
+// 
+				if (x2 < 0 || y2 < 0 || z2 < 0 ) continue;
+				if 	(x2 > (nx-1) || y2  > (ny-1) || z2 > (nz-1) ) continue;
+
+				if (x2 < (nx - 1) && y2 < (ny - 1) && z2 < (nz - 1)) {
+					ddata[l] +=
+							Util::trilinear_interpolate(sdata[ii], sdata[ii + 1], sdata[ii + nx],
+							sdata[ii + nx + 1], sdata[ii + xy],	sdata[ii + xy + 1], sdata[ii + xy + nx],
+							sdata[ii + xy + nx + 1], t, u, v);
+				}
+				else if ( x2 == (nx - 1) && y2 == (ny - 1) && z2 == (nz - 1) ) {
+					ddata[l] += sdata[ii];
+				}
+				else if ( x2 == (nx - 1) && y2 == (ny - 1) ) {
+					ddata[l] +=	Util::linear_interpolate(sdata[ii], sdata[ii + xy],v);
+				}
+				else if ( x2 == (nx - 1) && z2 == (nz - 1) ) {
+					ddata[l] += Util::linear_interpolate(sdata[ii], sdata[ii + nx],u);
+				}
+				else if ( y2 == (ny - 1) && z2 == (nz - 1) ) {
+					ddata[l] += Util::linear_interpolate(sdata[ii], sdata[ii + 1],t);
+				}
+				else if ( x2 == (nx - 1) ) {
+					ddata[l] += Util::bilinear_interpolate(sdata[ii], sdata[ii + nx], sdata[ii + xy], sdata[ii + xy + nx],u,v);
+				}
+				else if ( y2 == (ny - 1) ) {
+					ddata[l] += Util::bilinear_interpolate(sdata[ii], sdata[ii + 1], sdata[ii + xy], sdata[ii + xy + 1],t,v);
+				}
+				else if ( z2 == (nz - 1) ) {
+					ddata[l] += Util::bilinear_interpolate(sdata[ii], sdata[ii + 1], sdata[ii + nx], sdata[ii + nx + 1],t,u);
+				}
+			}
+		}
+	}
+	proj->update();
+	Transform xf(t3d);
+	proj->set_attr("xform.projection",&xf);
+	proj->set_attr("apix_x",(float)image->get_attr("apix_x"));
+	proj->set_attr("apix_y",(float)image->get_attr("apix_y"));
+	proj->set_attr("apix_z",(float)image->get_attr("apix_z"));
+	
+
+	return proj;
+}
+
 EMData *MaxValProjector::project3d(EMData * image) const
 {
 	Transform* t3d = params["transform"];
@@ -1192,39 +1255,9 @@ EMData *FourierGriddingProjector::project3d(EMData * image) const
 	if (!image) {
 		return 0;
 	}
-	if (3 != image->get_ndim())
-		throw ImageDimensionException(
-									  "FourierGriddingProjector needs a 3-D volume");
-	if (image->is_complex())
-		throw ImageFormatException(
-								   "FourierGriddingProjector requires a real volume");
-	const int npad = params.has_key("npad") ? int(params["npad"]) : 2;
 	const int nx = image->get_xsize();
 	const int ny = image->get_ysize();
-	const int nz = image->get_zsize();
-	if (nx != ny || nx != nz)
-		throw ImageDimensionException(
-									  "FourierGriddingProjector requires nx==ny==nz");
-	const int m = Util::get_min(nx,ny,nz);
-	const int n = m*npad;
-
-	int K = params["kb_K"];
-	if ( K == 0 ) K = 6;
-	float alpha = params["kb_alpha"];
-	if ( alpha == 0 ) alpha = 1.25;
-	Util::KaiserBessel kb(alpha, K, (float)(m/2), K/(2.0f*n), n);
-
-	// divide out gridding weights
-	EMData* tmpImage = image->copy();
-	tmpImage->divkbsinh(kb);
-	// pad and center volume, then FFT and multiply by (-1)**(i+j+k)
-	//EMData* imgft = tmpImage->pad_fft(npad);
-	//imgft->center_padded();
-	EMData* imgft = tmpImage->norm_pad(false, npad);
-	imgft->do_fft_inplace();
-	imgft->center_origin_fft();
-	imgft->fft_shuffle();
-	delete tmpImage;
+	EMData* imgft = prepare_volume(image);
 
 	// Do we have a list of angles?
 	int nangles = 0;
@@ -1239,7 +1272,10 @@ EMData *FourierGriddingProjector::project3d(EMData * image) const
 		// but the framework of the Transform3D allows for a generic implementation
 		// as specified here.
 		Transform* t3d = params["transform"];
-		if ( t3d == NULL ) throw NullPointerException("The transform object (required for projection), was not specified");
+		if ( t3d == NULL ) {
+			delete imgft;
+			throw NullPointerException("The transform object (required for projection), was not specified");
+		}
 		Dict p = t3d->get_rotation("spider");
 
 		string angletype = "SPIDER";
@@ -1264,12 +1300,7 @@ EMData *FourierGriddingProjector::project3d(EMData * image) const
 		int indx = 3*ia;
 		Dict d("type","spider","phi",anglelist[indx],"theta",anglelist[indx+1],"psi",anglelist[indx+2]);
 		Transform tf(d);
-		EMData* proj = imgft->extract_plane(tf, kb);
-		if (proj->is_shuffled()) proj->fft_shuffle();
-		proj->center_origin_fft();
-		proj->do_ift_inplace();
-		EMData* winproj = proj->window_center(m);
-		delete proj;
+		EMData* winproj = project_prepared(imgft, tf);
 		for (int iy=0; iy < ny; iy++)
 			for (int ix=0; ix < nx; ix++)
 				(*ret)(ix,iy,ia) = (*winproj)(ix,iy);
@@ -1286,6 +1317,70 @@ EMData *FourierGriddingProjector::project3d(EMData * image) const
 	return ret;
 }
 
+EMData *FourierGriddingProjector::prepare_volume(const EMData * image) const
+{
+	if (3 != image->get_ndim())
+		throw ImageDimensionException(
+									  "FourierGriddingProjector needs a 3-D volume");
+	if (image->is_complex())
+		throw ImageFormatException(
+								   "FourierGriddingProjector requires a real volume");
+	const int npad = params.has_key("npad") ? int(params["npad"]) : 2;
+	const int nx = image->get_xsize();
+	const int ny = image->get_ysize();
+	const int nz = image->get_zsize();
+	if (nx != ny || nx != nz)
+		throw ImageDimensionException(
+									  "FourierGriddingProjector requires nx==ny==nz");
+	const int m = Util::get_min(nx,ny,nz);
+	const int n = m*npad;
+
+	int K = params["kb_K"];
+	if ( K == 0 ) K = 6;
+	float alpha = params["kb_alpha"];
+	if ( alpha == 0 ) alpha = 1.25;
+	Util::KaiserBessel kb(alpha, K, (float)(m/2), K/(2.0f*n), n);
+
+	// divide out gridding weights
+	EMData* tmpImage = image->copy();
+	tmpImage->divkbsinh(kb);
+	// pad and center volume, then FFT and multiply by (-1)**(i+j+k)
+	//EMData* imgft = tmpImage->pad_fft(npad);
+	//imgft->center_padded();
+	EMData* imgft = tmpImage->norm_pad(false, npad);
+	imgft->do_fft_inplace();
+	imgft->center_origin_fft();
+	imgft->fft_shuffle();
+	delete tmpImage;
+	return imgft;
+}
+
+EMData *FourierGriddingProjector::project_prepared(const EMData * prepared, const Transform & t3d) const
+{
+	const int npad = params.has_key("npad") ? int(params["npad"]) : 2;
+	const int n = prepared->get_ysize();
+	const int m = n/npad;
+
+	int K = params["kb_K"];
+	if ( K == 0 ) K = 6;
+	float alpha = params["kb_alpha"];
+	if ( alpha == 0 ) alpha = 1.25;
+	Util::KaiserBessel kb(alpha, K, (float)(m/2), K/(2.0f*n), n);
+
+	// extract_plane() only reads the volume, so threads may share it
+	EMData* proj = prepared->extract_plane(t3d, kb);
+	if (proj->is_shuffled()) proj->fft_shuffle();
+	proj->center_origin_fft();
+	proj->do_ift_inplace();
+	EMData* winproj = proj->window_center(m);
+	delete proj;
+
+	Transform xf(t3d);
+	winproj->set_attr("xform.projection",&xf);
+	winproj->update();
+	return winproj;
+}
+
 // BEGIN Chao projectors and backprojector addition (04/25/06)
 int ChaoProjector::getnnz(Vec3i volsize, int ri, Vec3i origin, int *nrays, int *nnz) const
 /*
@@ -2150,6 +2245,71 @@ EMData *FourierGriddingProjector::backproject3d(EMData * ) const
 
 // End Chao's projector addition 4/25/06
 
+ProjectionSession::ProjectionSession(const string & projector_name, const Dict & params, const EMData * volume)
+	: projector(0), prepared(0)
+{
+	if (!volume) throw NullPointerException("ProjectionSession requires a volume");
+
+	projector = Factory < Projector >::get(projector_name, params);
+	try {
+		prepared = projector->prepare_volume(volume);
+	}
+	catch (...) {
+		delete projector;
+		throw;
+	}
+	if (!prepared) {
+		delete projector;
+		throw ImageFormatException("projector '" + projector_name + "' cannot project this volume");
+	}
+}
+
+ProjectionSession::~ProjectionSession()
+{
+	delete prepared;
+	delete projector;
+}
+
+EMData *ProjectionSession::project(const Transform & t3d) const
+{
+	return projector->project_prepared(prepared, t3d);
+}
+
+vector<std::shared_ptr<EMData>> ProjectionSession::project(const vector<Transform> & xforms, int nthreads) const
+{
+	const int n = (int)xforms.size();
+	vector<std::shared_ptr<EMData>> ret(n);
+	if (n == 0) return ret;
+
+	if (nthreads <= 0) nthreads = std::max(1, (int)std::thread::hardware_concurrency());
+	nthreads = std::min(nthreads, n);
+
+	// workers pull the next orientation off a shared counter; the calling thread is worker 0
+	std::atomic<int> next(0);
+	vector<std::exception_ptr> errs(nthreads);
+	auto worker = [&](int t) {
+		try {
+			for (int i = next++; i < n; i = next++) {
+				ret[i] = std::shared_ptr<EMData>(projector->project_prepared(prepared, xforms[i]));
+			}
+		}
+		catch (...) {
+			errs[t] = std::current_exception();
+			next = n;
+		}
+	};
+
+	vector<std::thread> threads;
+	for (int t = 1; t < nthreads; t++) threads.push_back(std::thread(worker, t));
+	worker(0);
+	for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+	for (int t = 0; t < nthreads; t++) {
+		if (errs[t]) std::rethrow_exception(errs[t]);
+	}
+	return ret;
+}
+
 void EMAN::dump_projectors()
 {
 	dump_factory < Projector > ();
@@ -33,6 +33,7 @@
 #define eman__projector_h__ 1
 
 #include "transform.h"
+#include <memory>
 
 using std::string;
 
@@ -91,6 +92,23 @@ namespace EMAN
                  */
 		virtual EMData *backproject3d(EMData * image) const = 0;
 
+		/** Do the per-volume work of project3d (padding, gridding
+		 * correction, FFT, ...) once, so the result can be passed to
+		 * project_prepared() for any number of orientations. The
+		 * input volume is not modified.
+		 * @return A new image owned by the caller, or 0 on failure.
+		 */
+		virtual EMData *prepare_volume(const EMData * image) const;
+
+		/** Project a volume returned by prepare_volume() along a
+		 * single orientation. Projectors which override this must
+		 * not modify 'prepared', so several threads may project
+		 * from the same prepared volume at once. The default
+		 * runs project3d() on a private copy of 'prepared'.
+		 * @return A 2D image from the projection.
+		 */
+		virtual EMData *project_prepared(const EMData * prepared, const Transform & t3d) const;
+
 		/** Get the projector's name. Each projector is indentified by
 		 * unique name.
 		 * @return The projector's name.
@@ -154,6 +172,8 @@ namespace EMAN
                 // no implementation yet
 		EMData *backproject3d(EMData * image) const;
 
+		EMData *prepare_volume(const EMData * image) const;
+		EMData *project_prepared(const EMData * prepared, const Transform & t3d) const;
 
 		void set_params(const Dict & new_params)
 		{
@@ -191,7 +211,8 @@ namespace EMAN
 
 	  private:
 		float alt, az, phi;
-		bool interp_ft_3d(int mode, EMData * image, float x, float y,
+		/** supp is the table from image->setup4slice(), required for modes 3-7 */
+		bool interp_ft_3d(int mode, const EMData * image, const float *supp, float x, float y,
 						  float z, float *data, float gauss_width) const;
 	};
 
@@ -207,6 +228,8 @@ namespace EMAN
                 // no implementation yet
 		EMData * backproject3d(EMData * image) const;
 
+		EMData * prepare_volume(const EMData * image) const;
+		EMData * project_prepared(const EMData * prepared, const Transform & t3d) const;
 
 		string get_name() const
 		{
@@ -348,6 +371,8 @@ namespace EMAN
                 // no implementation yet
 		EMData * backproject3d(EMData * image) const;
 
+		EMData * project_prepared(const EMData * prepared, const Transform & t3d) const;
+
 		string get_name() const
 		{
 			return NAME;
@@ -419,6 +444,41 @@ namespace EMAN
         	void setdm(vector<float> anglelist, string const angletype, float *dm) const;
 	};
 
+	/** ProjectionSession prepares a volume once for a given projector
+	 * and then generates projections of it for many orientations,
+	 * optionally on several threads. The volume passed to the
+	 * constructor is copied and never modified.
+	 *
+	 @code
+	 *    ProjectionSession session("fourier", Dict(), volume);
+	 *    vector<std::shared_ptr<EMData>> projs = session.project(xforms);
+	 @endcode
+	 */
+	class ProjectionSession
+	{
+	  public:
+		ProjectionSession(const string & projector_name, const Dict & params, const EMData * volume);
+		~ProjectionSession();
+
+		/** Project the prepared volume along one orientation.
+		 * @return A new 2D image owned by the caller.
+		 */
+		EMData *project(const Transform & t3d) const;
+
+		/** Project the prepared volume along each orientation in
+		 * 'xforms'. The results are in the same order as 'xforms'.
+		 * @param nthreads Number of threads, 0 for one per core.
+		 */
+		vector<std::shared_ptr<EMData>> project(const vector<Transform> & xforms, int nthreads = 0) const;
+
+	  private:
+		ProjectionSession(const ProjectionSession &);
+		ProjectionSession & operator=(const ProjectionSession &);
+
+		Projector *projector;
+		EMData *prepared;
+	};
+
 	template <> Factory < Projector >::Factory();
 
 	void dump_projectors();
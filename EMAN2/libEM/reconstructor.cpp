@@ -37,6 +37,7 @@
 #include <cstring>
 #include <fstream>
 #include <iomanip>
+#include <thread>
 
 #include <gsl/gsl_statistics_double.h>
 #include <gsl/gsl_fit.h>
@@ -530,7 +531,7 @@ int FourierIterReconstructor::insert_slice(const EMData* const slice, const Tran
 
 //	if (slice->get_attr_default("reconstruct_preproc",(int) 0)) throw ImageDimensionException("ERROR: FourierIterReconstructor requires preprocess_slice() to be called in advance");
 
-	vector<Transform> syms = Symmetry3D::get_symmetries((string)params["sym"]);
+	const vector<Transform>& syms = Symmetry3D::get_symmetry_ops((string)params["sym"]).syms;
 
 	float inx=(float)(slice->get_xsize());		// x/y dimensions of the input image
 	float iny=(float)(slice->get_ysize());
@@ -688,10 +689,12 @@ void FourierReconstructor::load_default_settings()
 	inserter=0;
 	image=0;
 	tmp_data=0;
+	acc_dirty=false;
 }
 
 void FourierReconstructor::free_memory()
 {
+	free_accum_volumes();
 	if (image) { delete image; image=0; }
 	if (tmp_data) { delete tmp_data; tmp_data=0; }
 	if ( inserter != 0 )
@@ -701,6 +704,75 @@ void FourierReconstructor::free_memory()
 	}
 }
 
+void FourierReconstructor::alloc_accum_volumes(int naccum)
+{
+	while ((int)acc_images.size()<naccum-1) {
+		EMData *im = new EMData();
+		im->set_size(subnx, subny, subnz);
+		im->set_complex(true);
+		im->set_fftodd(image->is_fftodd());
+		im->set_ri(true);
+		im->to_zero();
+
+		// the inserter picks up the subvolume geometry from the data header
+		if (image->has_attr("subvolume_x0")) {
+			im->set_attr("subvolume_x0",subx0);
+			im->set_attr("subvolume_y0",suby0);
+			im->set_attr("subvolume_z0",subz0);
+			im->set_attr("subvolume_full_nx",nx);
+			im->set_attr("subvolume_full_ny",ny);
+			im->set_attr("subvolume_full_nz",nz);
+		}
+
+		EMData *norm = new EMData();
+		norm->set_size(subnx/2, subny, subnz);
+		norm->to_zero();
+
+		Dict parms;
+		parms["data"] = im;
+		parms["norm"] = norm->get_data();
+		FourierPixelInserter3D *ins = Factory<FourierPixelInserter3D>::get((string)params["mode"], parms);
+		ins->init();
+
+		acc_images.push_back(im);
+		acc_norms.push_back(norm);
+		acc_inserters.push_back(ins);
+	}
+}
+
+void FourierReconstructor::merge_accum_volumes()
+{
+	if (!acc_dirty) return;
+
+	// fixed summation order, independent of the number of threads used for insertion
+	size_t n=(size_t)subnx*subny*subnz;
+	size_t nn=(size_t)(subnx/2)*subny*subnz;
+	float *rdata=image->get_data();
+	float *ndata=tmp_data->get_data();
+	for (size_t v=0; v<acc_images.size(); v++) {
+		float *ad=acc_images[v]->get_data();
+		float *an=acc_norms[v]->get_data();
+		for (size_t i=0; i<n; i++) rdata[i]+=ad[i];
+		for (size_t i=0; i<nn; i++) ndata[i]+=an[i];
+		acc_images[v]->to_zero();
+		acc_norms[v]->to_zero();
+	}
+	image->update();
+	tmp_data->update();
+	acc_dirty=false;
+}
+
+void FourierReconstructor::free_accum_volumes()
+{
+	for (size_t v=0; v<acc_inserters.size(); v++) delete acc_inserters[v];
+	for (size_t v=0; v<acc_images.size(); v++) delete acc_images[v];
+	for (size_t v=0; v<acc_norms.size(); v++) delete acc_norms[v];
+	acc_inserters.clear();
+	acc_images.clear();
+	acc_norms.clear();
+	acc_dirty=false;
+}
+
 #include <sstream>
 
 void FourierReconstructor::load_inserter()
@@ -725,6 +797,9 @@ void FourierReconstructor::load_inserter()
 
 	inserter = Factory<FourierPixelInserter3D>::get((string)params["mode"], parms);
 	inserter->init();
+
+	// accumulation volumes are tied to the old image size and mode
+	free_accum_volumes();
 }
 
 void FourierReconstructor::setup()
@@ -1016,7 +1091,12 @@ void FourierReconstructor::clear()
 
 	if(zeroimage) image->to_zero();
 	if(zerotmpimg) tmp_data->to_zero();
-	
+
+	for (size_t v=0; v<acc_images.size(); v++) {
+		acc_images[v]->to_zero();
+		acc_norms[v]->to_zero();
+	}
+	acc_dirty=false;
 }
 
 EMData* FourierReconstructor::preprocess_slice( const EMData* const slice,  const Transform& t )
@@ -1079,6 +1159,8 @@ int FourierReconstructor::insert_slice(const EMData* const input_slice, const Tr
 
 	bool usessnr=params.set_default("usessnr",false);
 	bool corners=params.set_default("corners",false);
+	int nthreads=params.has_key("threads")?(int)params["threads"]:1;
+	int naccum=params.has_key("accumvols")?(int)params["accumvols"]:1;
 	float weight=oweight;
 	if (usessnr) {
 		if (input_slice->has_attr("class_ssnr")) weight=-1.0;	// negative weight is a flag for using SSNR
@@ -1109,7 +1191,11 @@ Transform * rotation;
 	//slice->copy_to_cuda();
 //	EMData *s2=slice->do_ift();
 //	s2->write_image("is.hdf",-1);
-	do_insert_slice_work(slice, *rotation, weight, corners);
+#ifdef EMAN2_USING_CUDA
+	if (EMData::usecuda == 1) naccum=1;
+#endif
+	if (naccum>1) do_insert_slice_work_threaded(slice, *rotation, weight, corners, nthreads, naccum);
+	else do_insert_slice_work(slice, *rotation, weight, corners);
 	
 	delete rotation; rotation=0;
 	delete slice;
@@ -1131,7 +1217,7 @@ void FourierReconstructor::do_insert_slice_work(const EMData* const input_slice,
 // 	if (input_slice->is_fftodd()) x_in -= 1;
 // 	else x_in -= 2;
 
-	vector<Transform> syms = Symmetry3D::get_symmetries((string)params["sym"]);
+	const vector<Transform>& syms = Symmetry3D::get_symmetry_ops((string)params["sym"]).syms;
 
 	float inx=(float)(input_slice->get_xsize());		// x/y dimensions of the input image
 	float iny=(float)(input_slice->get_ysize());
@@ -1155,58 +1241,88 @@ void FourierReconstructor::do_insert_slice_work(const EMData* const input_slice,
 		return;
 	}
 #endif
-	vector<float> ssnr;
-	float sscale = 1.0f;
-	if (weight<0) {
-		ssnr=input_slice->get_attr("class_ssnr");
-		sscale=2.0*(ssnr.size()-1)/iny;
-	}
-	
-	float rweight=weight;
+	vector<float> radweight = slice_radial_weights(input_slice, weight, corners);
+	int ymin=-(int)iny/2;
+	int ymax=((int)iny+1)/2;
 	for ( vector<Transform>::const_iterator it = syms.begin(); it != syms.end(); ++it ) {
 		Transform t3d = arg*(*it);
-		for (int y = -iny/2; y < iny/2; y++) {
-			for (int x = 0; x < inx/2; x++) {
+		inserter->insert_slice_rows(input_slice, t3d, ymin, ymax, radweight);
+	}
+}
 
-				float rx = (float) x/(inx-2.0f);	// coords relative to Nyquist=.5
-				float ry = (float) y/iny;
-				if (corners) {
-					if (weight<0) {
-						int r=Util::hypot_fast_int(x,y);
-						rweight=Util::get_max(0.0f,ssnr[int(r*sscale)]);
-					}
-				}
-				else {
-					int r=Util::hypot_fast_int(x,y);
-					if (r>iny/2 && abs(inx-iny)<3) continue;	// no filling in Fourier corners...
+void FourierReconstructor::do_insert_slice_work_threaded(const EMData* const input_slice, const Transform & arg,const float weight,const bool corners, int nthreads, int naccum)
+{
+	const vector<Transform>& syms = Symmetry3D::get_symmetry_ops((string)params["sym"]).syms;
 
-					if (weight<0) rweight=Util::get_max(0.0f,ssnr[int(r*sscale)]);
-				}
-//				printf("%d\t%f\n",int(r*sscale),rweight);
+	float inx=(float)(input_slice->get_xsize());		// x/y dimensions of the input image
+	float iny=(float)(input_slice->get_ysize());
 
-				Vec3f coord(rx,ry,0);
-				coord = coord*t3d; // transpose multiplication
-				float xx = coord[0]; // transformed coordinates in terms of Nyquist
-				float yy = coord[1];
-				float zz = coord[2];
+	if (abs(inx-iny)>2 && weight<0) printf("WARNING: Fourier Reconstruction failure. SSNR flag set with asymmetric dimensions on input image\n");
 
-				// Map back to real pixel coordinates in output volume
-				xx=xx*(nx-2);
-				yy=yy*ny;
-				zz=zz*nz;
-				
-// 				if (x==10 && y==0) printf("10,0 -> %1.2f,%1.2f,%1.2f\t(%5.2f %5.2f %5.2f   %5.2f %5.2f %5.2f   %5.2f %5.2f %5.2f) %1.0f %d\n",
-// 					xx,yy,zz,t3d.at(0,0),t3d.at(0,1),t3d.at(0,2),t3d.at(1,0),t3d.at(1,1),t3d.at(1,2),t3d.at(2,0),t3d.at(2,1),t3d.at(2,2),inx,nx);
-// 				if (x==0 && y==10 FourierReconstructor:) printf("0,10 -> %1.2f,%1.2f,%1.2f\t(%5.2f %5.2f %5.2f   %5.2f %5.2f %5.2f   %5.2f %5.2f %5.2f)\n",
-// 					xx,yy,zz,t3d.at(0,0),t3d.at(0,1),t3d.at(0,2),t3d.at(1,0),t3d.at(1,1),t3d.at(1,2),t3d.at(2,0),t3d.at(2,1),t3d.at(2,2));
-
-				//printf("%3.1f %3.1f %3.1f\t %1.4f %1.4f\t%1.4f\n",xx,yy,zz,input_slice->get_complex_at(x,y).real(),input_slice->get_complex_at(x,y).imag(),weight);
-//				if (floor(xx)==45 && floor(yy)==45 &&floor(zz)==0) printf("%d. 45 45 0\t %d %d\t %1.4f %1.4f\t%1.4f\n",(int)input_slice->get_attr("n"),x,y,input_slice->get_complex_at(x,y).real(),input_slice->get_complex_at(x,y).imag(),weight);
-//				if (floor(xx)==21 && floor(yy)==21 &&floor(zz)==0) printf("%d. 21 21 0\t %d %d\t %1.4f %1.4f\t%1.4f\n",(int)input_slice->get_attr("n"),x,y,input_slice->get_complex_at(x,y).real(),input_slice->get_complex_at(x,y).imag(),weight);
-				inserter->insert_pixel(xx,yy,zz,input_slice->get_complex_at(x,y),rweight);
+	vector<float> radweight = slice_radial_weights(input_slice, weight, corners);
+
+	alloc_accum_volumes(naccum);
+	if (nthreads<1) nthreads=1;
+	if (nthreads>naccum) nthreads=naccum;
+
+	// Util::hypot_fast_int and Util::fast_exp fill their lookup tables on first use, which isn't threadsafe,
+	// so make sure they are complete before any threads start
+	Util::hypot_fast_int((int)inx/2,(int)iny/2);
+	Util::fast_exp(-1.0f);
+
+	vector<Transform> t3ds;
+	for ( vector<Transform>::const_iterator it = syms.begin(); it != syms.end(); ++it ) t3ds.push_back(arg*(*it));
+
+	int ymin=-(int)iny/2;
+	int nrows=((int)iny+1)/2-ymin;
+	size_t nwork=t3ds.size()*(size_t)nrows;
+
+	// Work item k is (operator k/nrows, row k%nrows), in the same order as the serial loop. Volume v gets a
+	// contiguous block of k, so the summation order in each volume is fixed no matter which thread runs it
+	auto worker = [&](int thr) {
+		for (int v=thr; v<naccum; v+=nthreads) {
+			FourierPixelInserter3D *ins = v==0?inserter:acc_inserters[v-1];
+			size_t k0=nwork*v/naccum;
+			size_t k1=nwork*(v+1)/naccum;
+			while (k0<k1) {
+				size_t op=k0/nrows;
+				size_t kend=std::min(k1,(op+1)*nrows);
+				ins->insert_slice_rows(input_slice, t3ds[op], ymin+(int)(k0%nrows), ymin+(int)((kend-1)%nrows)+1, radweight);
+				k0=kend;
 			}
 		}
+	};
+
+	vector<std::thread> threads;
+	for (int thr=1; thr<nthreads; thr++) threads.push_back(std::thread(worker,thr));
+	worker(0);
+	for (size_t i=0; i<threads.size(); i++) threads[i].join();
+
+	acc_dirty=true;
+}
+
+vector<float> FourierReconstructor::slice_radial_weights(const EMData* const input_slice, const float weight, const bool corners)
+{
+	float inx=(float)(input_slice->get_xsize());
+	float iny=(float)(input_slice->get_ysize());
+
+	vector<float> ssnr;
+	float sscale = 1.0f;
+	if (weight<0) {
+		ssnr=input_slice->get_attr("class_ssnr");
+		sscale=2.0*(ssnr.size()-1)/iny;
 	}
+
+	// without corners, square images are only filled out to Nyquist
+	int nr;
+	if (!corners && abs(inx-iny)<3) nr=(int)iny/2+1;
+	else nr=Util::hypot_fast_int(((int)inx+1)/2-1,(int)iny/2)+1;		// largest x is the last one below inx/2
+
+	vector<float> radweight(nr,weight);
+	if (weight<0) {
+		for (int r=0; r<nr; r++) radweight[r]=Util::get_max(0.0f,ssnr[int(r*sscale)]);
+	}
+	return radweight;
 }
 
 int FourierReconstructor::determine_slice_agreement(EMData*  input_slice, const Transform & arg, const float weight,bool sub)
@@ -1220,6 +1336,9 @@ int FourierReconstructor::determine_slice_agreement(EMData*  input_slice, const
 	}
 #endif
 
+	// anything inserted by the threaded path must be visible to the comparison (and subtraction) below
+	merge_accum_volumes();
+
 	Transform * rotation;
 	rotation = new Transform(arg); // assignment operator
 
@@ -1262,7 +1381,7 @@ void FourierReconstructor::do_compare_slice_work(EMData* input_slice, const Tran
 	float dt[3];	// This stores the complex and weight from the volume
 	float dt2[2];	// This stores the local image complex
 	float *dat = input_slice->get_data();
-	vector<Transform> syms = Symmetry3D::get_symmetries((string)params["sym"]);
+	const vector<Transform>& syms = Symmetry3D::get_symmetry_ops((string)params["sym"]).syms;
 
 	float inx=(float)(input_slice->get_xsize());		// x/y dimensions of the input image
 	float iny=(float)(input_slice->get_ysize());
@@ -1384,6 +1503,8 @@ EMData* FourierReconstructor::projection(const Transform &euler, int ret_fourier
 	
 	if (subx0!=0 || suby0!=0 || subz0!=0 || subnx!=nx || subny!=ny ||subnz!=nz) 
 		throw ImageDimensionException("ERROR: Reconstructor->projection() does not work with subvolumes");
+
+	merge_accum_volumes();
 	
 	EMData *ret = new EMData(nx,ny,1);
 	ret->set_complex(1);
@@ -1560,6 +1681,9 @@ EMData *FourierReconstructor::finish(bool doift)
 		tmp_data->copy_from_device();
 	}
 #endif
+
+	merge_accum_volumes();
+	free_accum_volumes();
 	
 	bool sqrtnorm=params.set_default("sqrtnorm",false);
 	normalize_threed(sqrtnorm);
@@ -1679,7 +1803,7 @@ int WienerFourierReconstructor::insert_slice(const EMData* const input_slice, co
 void WienerFourierReconstructor::do_insert_slice_work(const EMData* const input_slice, const Transform & arg,const float inweight)
 {
 
-	vector<Transform> syms = Symmetry3D::get_symmetries((string)params["sym"]);
+	const vector<Transform>& syms = Symmetry3D::get_symmetry_ops((string)params["sym"]).syms;
 
 	float inx=(float)(input_slice->get_xsize());		// x/y dimensions of the input image
 	float iny=(float)(input_slice->get_ysize());
@@ -1781,7 +1905,7 @@ void WienerFourierReconstructor::do_compare_slice_work(EMData* input_slice, cons
 	float dt[3];	// This stores the complex and weight from the volume
 	float dt2[2];	// This stores the local image complex
 	float *dat = input_slice->get_data();
-	vector<Transform> syms = Symmetry3D::get_symmetries((string)params["sym"]);
+	const vector<Transform>& syms = Symmetry3D::get_symmetry_ops((string)params["sym"]).syms;
 
 	float inx=(float)(input_slice->get_xsize());		// x/y dimensions of the input image
 	float iny=(float)(input_slice->get_ysize());
@@ -2199,7 +2323,7 @@ int BaldwinWoolfordReconstructor::insert_slice(const EMData* const input_slice,
 	int tny = tmp_data->get_ysize();
 	int tnz = tmp_data->get_zsize();
 
-	vector<Transform> syms = Symmetry3D::get_symmetries((string)params["sym"]);
+	const vector<Transform>& syms = Symmetry3D::get_symmetry_ops((string)params["sym"]).syms;
 // 	float weight = params.set_default("weight",1.0f);
 
 	rotation->set_scale(1.0); rotation->set_mirror(false); rotation->set_trans(0,0,0);
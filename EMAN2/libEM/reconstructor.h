@@ -511,6 +511,8 @@ namespace EMAN
 			d.put("quiet", EMObject::BOOL, "Optional. If false, print verbose information.");
 			d.put("subvolume",EMObject::INTARRAY, "Optional. (xorigin,yorigin,zorigin,xsize,ysize,zsize) all in Fourier pixels. Useful for parallelism.");
 			d.put("savenorm",EMObject::STRING, "Debug. Will cause the normalization volume to be written directly to the specified file when finish() is called.");
+			d.put("threads",EMObject::INT, "Optional. Number of threads used to insert each slice. Limited to accumvols, so it has no effect unless accumvols>1. Default 1.");
+			d.put("accumvols",EMObject::INT, "Optional. Number of private accumulation volumes (memory ~1.5x the padded volume each), summed in a fixed order by finish(). Results are bit-identical for any number of threads with the same accumvols. Default 1.");
 			
 			d.put("normout",EMObject::EMDATA, "Will write the normalization volume to the given EMData object file when finish() is called.");
 			return d;
@@ -539,6 +541,34 @@ namespace EMAN
 		 */
 		virtual void do_insert_slice_work(const EMData* const input_slice, const Transform & euler,const float weight, const bool corners=false);
 
+		/** Threaded version of do_insert_slice_work. The (symmetry operator, slice row) pairs are split into accumvols
+		 * contiguous blocks in serial order, each inserted into its own accumulation volume, and threads take whole
+		 * volumes. Since the split does not depend on the number of threads, neither does the result.
+		 * @param input_slice the slice to insert into the 3D volume
+		 * @param euler a transform storing the slice euler angle
+		 * @param weight weighting factor for this slice (usually number of particles in a class-average)
+		 * @param nthreads number of threads to use
+		 * @param naccum number of accumulation volumes
+		 */
+		void do_insert_slice_work_threaded(const EMData* const input_slice, const Transform & euler,const float weight, const bool corners, int nthreads, int naccum);
+
+		/** Computes the insertion weight for each integer radius of a preprocessed slice, for FourierPixelInserter3D::insert_slice_rows.
+		 * Negative weight uses the class_ssnr header value, and radii which aren't inserted are left off the end.
+		 */
+		vector<float> slice_radial_weights(const EMData* const input_slice, const float weight, const bool corners);
+
+		/** Makes sure naccum-1 additional accumulation volumes (and their inserters) exist. Volume 0 is image/tmp_data itself.
+		 */
+		void alloc_accum_volumes(int naccum);
+
+		/** Adds the accumulation volumes into image/tmp_data, in order, and zeroes them. Must be called before anything reads image.
+		 */
+		void merge_accum_volumes();
+
+		/** Frees the accumulation volumes and their inserters
+		 */
+		void free_accum_volumes();
+
 		/** A function to perform the nuts and bolts of comparing an image slice
 		 * @param input_slice the slice to insert into the 3D volume
 		 * @param euler a transform storing the slice euler angle
@@ -554,6 +584,15 @@ namespace EMAN
 		/// A pixel inserter pointer which inserts pixels into the 3D volume using one of a variety of insertion methods
 		FourierPixelInserter3D* inserter;
 
+		/// Extra accumulation volumes for threaded insertion (accumulation volume 0 is image itself)
+		vector<EMData*> acc_images;
+		/// Normalization volumes matching acc_images
+		vector<EMData*> acc_norms;
+		/// Inserters writing into acc_images/acc_norms
+		vector<FourierPixelInserter3D*> acc_inserters;
+		/// Set when the accumulation volumes hold data not yet merged into image
+		bool acc_dirty;
+
 	  private:
 		 /** Disallow copy construction
   		 */
@@ -110,6 +110,72 @@ void FourierPixelInserter3D::init()
 	}
 }
 
+void FourierPixelInserter3D::insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight)
+{
+	for (int i=0; i<n; i++) insert_pixel(xx[i],yy[i],zz[i],dt[i],weight[i]);
+}
+
+// Used by the modes to implement insert_pixels(). The qualified call is not virtual, so the
+// compiler can inline the mode's insert_pixel into the loop
+template<class T>
+static inline void insert_pixels_direct(T* ins, const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight)
+{
+	for (int i=0; i<n; i++) ins->T::insert_pixel(xx[i],yy[i],zz[i],dt[i],weight[i]);
+}
+
+void FourierPixelInserter3D::insert_slice_rows(const EMData* const slice, const Transform& t3d, const int ymin, const int ymax, const vector<float>& radweight)
+{
+	int inx=slice->get_xsize();
+	int iny=slice->get_ysize();
+	int nxh=(inx+1)/2;					// number of x values with x<inx/2.0
+	int nr=(int)radweight.size();
+	const float *sdata=slice->get_const_data();
+
+	// slice coordinates are relative to Nyquist=.5, and are mapped back to pixels in the full volume
+	float vnx=(float)((subx0<0?nx:fullnx)-2);
+	float vny=(float)(subx0<0?ny:fullny);
+	float vnz=(float)(subx0<0?nz:fullnz);
+	float rnx=inx-2.0f;
+
+	float m00=t3d.at(0,0),m01=t3d.at(0,1),m02=t3d.at(0,2);
+	float m10=t3d.at(1,0),m11=t3d.at(1,1),m12=t3d.at(1,2);
+
+	vector<float> xx(nxh),yy(nxh),zz(nxh),w(nxh);
+	vector<std::complex<float> > dt(nxh);
+
+	for (int y=ymin; y<ymax; y++) {
+		float ry=(float)y/iny;
+		float bx=ry*m10;
+		float by=ry*m11;
+		float bz=ry*m12;
+
+		// transpose multiplication of (rx,ry,0) for the whole row, written so it vectorizes
+		for (int x=0; x<nxh; x++) {
+			float rx=(float)x/rnx;
+			xx[x]=(rx*m00+bx)*vnx;
+			yy[x]=(rx*m01+by)*vny;
+			zz[x]=(rx*m02+bz)*vnz;
+		}
+
+		// compact the pixels we actually insert, with their values and weights
+		const float *row=sdata+(size_t)(y>=0?y:iny+y)*inx;
+		int n=0;
+		for (int x=0; x<nxh; x++) {
+			int r=Util::hypot_fast_int(x,y);
+			if (r>=nr) continue;
+			xx[n]=xx[x];
+			yy[n]=yy[x];
+			zz[n]=zz[x];
+			w[n]=radweight[r];
+			if (x==0 || x>=inx/2) dt[n]=slice->get_complex_at(x,y);
+			else dt[n]=std::complex<float>(row[x*2],row[x*2+1]);
+			n++;
+		}
+
+		insert_pixels(n,&xx[0],&yy[0],&zz[0],&dt[0],&w[0]);
+	}
+}
+
 bool FourierInserter3DMode1::insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt, const float& weight)
 {
 	int x0 = (int) floor(xx + 0.5f);
@@ -125,6 +191,11 @@ bool FourierInserter3DMode1::insert_pixel(const float& xx, const float& yy, cons
 	return true;
 }
 
+void FourierInserter3DMode1::insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight)
+{
+	insert_pixels_direct(this,n,xx,yy,zz,dt,weight);
+}
+
 bool FourierInserter3DMode2::insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt,const float& weight)
 {
 	int x0 = (int) floor(xx);
@@ -188,6 +259,11 @@ bool FourierInserter3DMode2::insert_pixel(const float& xx, const float& yy, cons
 	}
 }
 
+void FourierInserter3DMode2::insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight)
+{
+	insert_pixels_direct(this,n,xx,yy,zz,dt,weight);
+}
+
 bool FourierInserter3DMode2l::insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt,const float& weight)
 {
 	int x0 = (int) floor(xx);
@@ -261,6 +337,11 @@ bool FourierInserter3DMode2l::insert_pixel(const float& xx, const float& yy, con
 	}
 }
 
+void FourierInserter3DMode2l::insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight)
+{
+	insert_pixels_direct(this,n,xx,yy,zz,dt,weight);
+}
+
 
 bool FourierInserter3DMode3::insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt,const float& weight)
 {
@@ -311,6 +392,11 @@ bool FourierInserter3DMode3::insert_pixel(const float& xx, const float& yy, cons
 	return false;
 }
 
+void FourierInserter3DMode3::insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight)
+{
+	insert_pixels_direct(this,n,xx,yy,zz,dt,weight);
+}
+
 
 bool FourierInserter3DMode5::insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt,const float& weight)
 {
@@ -378,6 +464,11 @@ bool FourierInserter3DMode5::insert_pixel(const float& xx, const float& yy, cons
 	return false;
 }
 
+void FourierInserter3DMode5::insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight)
+{
+	insert_pixels_direct(this,n,xx,yy,zz,dt,weight);
+}
+
 
 bool FourierInserter3DMode6::insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt,const float& weight)
 {
@@ -451,6 +542,11 @@ bool FourierInserter3DMode6::insert_pixel(const float& xx, const float& yy, cons
 	return false;
 }
 
+void FourierInserter3DMode6::insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight)
+{
+	insert_pixels_direct(this,n,xx,yy,zz,dt,weight);
+}
+
 // Kernel determined by examples/kernel_opt
 const float FourierInserter3DMode7::kernel[9][9][9] = {
 0.3293228,0.2999721,0.2230405,0.1263839,0.0412195,-0.0116440,-0.0287601,-0.0214417,0.0000000,
@@ -578,6 +674,11 @@ bool FourierInserter3DMode7::insert_pixel(const float& xx, const float& yy, cons
 	return false;
 }
 
+void FourierInserter3DMode7::insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight)
+{
+	insert_pixels_direct(this,n,xx,yy,zz,dt,weight);
+}
+
 
 void FourierInserter3DMode8::init()
 {
@@ -756,6 +857,11 @@ bool FourierInserter3DMode9::insert_pixel(const float& xx, const float& yy, cons
 	return false;
 }
 
+void FourierInserter3DMode9::insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight)
+{
+	insert_pixels_direct(this,n,xx,yy,zz,dt,weight);
+}
+
 // imprecise KBD kernel/window
 bool FourierInserter3DMode10::insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt,const float& weight)
 {
@@ -814,6 +920,11 @@ bool FourierInserter3DMode10::insert_pixel(const float& xx, const float& yy, con
 	return false;
 }
 
+void FourierInserter3DMode10::insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight)
+{
+	insert_pixels_direct(this,n,xx,yy,zz,dt,weight);
+}
+
 const float FourierInserter3DMode11::kernel[12][12][12] = {
 0.3756136,0.3403310,0.2474435,0.1296879,0.0245121,-0.0418448,-0.0631182,-0.0511850,-0.0262455,-0.0054893,0.0036277,0.0000000,
 0.3403310,0.3082430,0.2237843,0.1167696,0.0212886,-0.0388006,-0.0578490,-0.0467286,-0.0238678,-0.0049178,0.0033657,0.0000000,
@@ -1002,3 +1113,8 @@ bool FourierInserter3DMode11::insert_pixel(const float& xx, const float& yy, con
 	printf("region writing not supported in mode \n");
 	return false;
 }
+
+void FourierInserter3DMode11::insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight)
+{
+	insert_pixels_direct(this,n,xx,yy,zz,dt,weight);
+}
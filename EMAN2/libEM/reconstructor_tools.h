@@ -124,6 +124,24 @@ namespace EMAN
 		 */
 		virtual bool insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt, const float& weight=1.0) = 0;
 
+		/** Insert n complex pixels. Equivalent to calling insert_pixel() on each, but most modes override
+		 * this with a loop which calls their own insert_pixel() directly, avoiding a virtual call per pixel.
+		 * @param n the number of pixels
+		 * @param xx,yy,zz the n floating point coordinates
+		 * @param dt the n complex pixel values
+		 * @param weight the n weights
+		 */
+		virtual void insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight);
+
+		/** Insert rows ymin<=y<ymax of a preprocessed 2D slice (complex, phase origin at the corner) into the volume.
+		 * The coordinate transform is done a row at a time, then the row is passed to insert_pixels().
+		 * @param slice the preprocessed slice
+		 * @param t3d the orientation of the slice, used as a transpose multiplication as in FourierReconstructor
+		 * @param ymin,ymax the range of (signed) Fourier rows to insert
+		 * @param radweight the weight for each integer radius (Util::hypot_fast_int). Pixels at larger radii are skipped.
+		 */
+		void insert_slice_rows(const EMData* const slice, const Transform& t3d, const int ymin, const int ymax, const vector<float>& radweight);
+
 
 		virtual void init();
 
@@ -163,6 +181,7 @@ namespace EMAN
 			virtual ~FourierInserter3DMode1() {}
 
 			virtual bool insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt, const float& weight=1.0);
+			virtual void insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight);
 
 			static FourierPixelInserter3D *NEW()
 			{
@@ -197,6 +216,7 @@ namespace EMAN
 			virtual ~FourierInserter3DMode2() {}
 
 			virtual bool insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt, const float& weight=1.0);
+			virtual void insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight);
 
 			static FourierPixelInserter3D *NEW()
 			{
@@ -230,6 +250,7 @@ namespace EMAN
 			virtual ~FourierInserter3DMode2l() {}
 
 			virtual bool insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt, const float& weight=1.0);
+			virtual void insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight);
 
 			static FourierPixelInserter3D *NEW()
 			{
@@ -264,6 +285,7 @@ namespace EMAN
 			virtual ~FourierInserter3DMode3() {}
 
 			virtual bool insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt, const float& weight=1.0);
+			virtual void insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight);
 
 			static FourierPixelInserter3D *NEW()
 			{
@@ -310,6 +332,7 @@ namespace EMAN
 			}
 
 			virtual bool insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt, const float& weight=1.0);
+			virtual void insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight);
 
 			static FourierPixelInserter3D *NEW()
 			{
@@ -346,6 +369,7 @@ namespace EMAN
 			virtual ~FourierInserter3DMode6() {}
 
 			virtual bool insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt, const float& weight=1.0);
+			virtual void insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight);
 
 			static FourierPixelInserter3D *NEW()
 			{
@@ -383,6 +407,7 @@ namespace EMAN
 			virtual ~FourierInserter3DMode7() {}
 
 			virtual bool insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt, const float& weight=1.0);
+			virtual void insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight);
 
 			static FourierPixelInserter3D *NEW()
 			{
@@ -465,6 +490,7 @@ namespace EMAN
 			virtual ~FourierInserter3DMode9() {}
 
 			virtual bool insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt, const float& weight=1.0);
+			virtual void insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight);
 
 			static FourierPixelInserter3D *NEW()
 			{
@@ -499,6 +525,7 @@ namespace EMAN
 			virtual ~FourierInserter3DMode10() {}
 
 			virtual bool insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt, const float& weight=1.0);
+			virtual void insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight);
 
 			static FourierPixelInserter3D *NEW()
 			{
@@ -539,6 +566,7 @@ namespace EMAN
 			virtual ~FourierInserter3DMode11() {}
 
 			virtual bool insert_pixel(const float& xx, const float& yy, const float& zz, const std::complex<float> dt, const float& weight=1.0);
+			virtual void insert_pixels(const int n, const float* xx, const float* yy, const float* zz, const std::complex<float>* dt, const float* weight);
 
 			static FourierPixelInserter3D *NEW()
 			{
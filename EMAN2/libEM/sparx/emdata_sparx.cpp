@@ -5285,7 +5285,7 @@ Dict EMData::masked_stats(const EMData* mask) {
 }
 */
 
-EMData* EMData::extract_plane(const Transform& tf, Util::KaiserBessel& kb) {
+EMData* EMData::extract_plane(const Transform& tf, Util::KaiserBessel& kb) const {
 	if (!is_complex())
 		throw ImageFormatException("extractplane requires a complex image");
 	if (nx%2 != 0)
@@ -5301,11 +5301,16 @@ EMData* EMData::extract_plane(const Transform& tf, Util::KaiserBessel& kb) {
 	res->set_fftodd(false);
 	res->set_fftpad(true);
 	res->set_ri(true);
-	// Array offsets: (0..nhalf,-nhalf..nhalf-1,-nhalf..nhalf-1)
+	// Volume indices: (0..nhalf,-nhalf..nhalf-1,-nhalf..nhalf-1). The offsets are applied
+	// here rather than through set_array_offsets(), so the volume is only read and
+	// several threads may extract planes from it at once
 	int n = nxreal;
 	int nhalf = n/2;
-	vector<int> saved_offsets = get_array_offsets();
-	set_array_offsets(0,-nhalf,-nhalf);
+	const std::complex<float>* vol = reinterpret_cast<const std::complex<float>*>(get_const_data());
+	const size_t cnx = nx/2;
+	auto volc = [&](int ix, int iy, int iz) {
+		return vol[ix + ((size_t)(iy + nhalf) + (size_t)(iz + nhalf)*ny)*cnx];
+	};
 	res->set_array_offsets(0,-nhalf,0);
 	// set up some temporary weighting arrays
 	int kbsize =  kb.get_window_size();
@@ -5408,7 +5413,7 @@ EMData* EMData::extract_plane(const Transform& tf, Util::KaiserBessel& kb) {
 							for (int lx=lnbx; lx<=lnex; lx++) {
 								int ixp = ixn + lx;
 								float wg = wx[lx]*ty;
-								btq += cmplx(ixp,iyp,izp)*wg;
+								btq += volc(ixp,iyp,izp)*wg;
 								wsum += wg;
 							}
 						}
@@ -5462,8 +5467,8 @@ EMData* EMData::extract_plane(const Transform& tf, Util::KaiserBessel& kb) {
 								}
 								if (iyt == nhalf) iyt = -nhalf;
 								if (izt == nhalf) izt = -nhalf;
-								if (mirror)   btq += conj(cmplx(ixt,iyt,izt))*wg;
-								else          btq += cmplx(ixt,iyt,izt)*wg;
+								if (mirror)   btq += conj(volc(ixt,iyt,izt))*wg;
+								else          btq += volc(ixt,iyt,izt)*wg;
 								wsum += wg;
 							}
 						}
@@ -5478,7 +5483,6 @@ EMData* EMData::extract_plane(const Transform& tf, Util::KaiserBessel& kb) {
 		for (int jx = 0; jx <= nhalf; jx++)
 			res->cmplx(jx,jy) *= count/wsum;
 	delete[] wx0; delete[] wy0; delete[] wz0;
-	set_array_offsets(saved_offsets);
 	res->set_array_offsets(0,0,0);
 	res->set_shuffled(true);
 	return res;
@@ -622,7 +622,7 @@ std::complex<float> extractpoint(float xin, float yin, Util::KaiserBessel& kb);
  *       J. Opt. Soc. Am. A _21_, 499-509 (2004)
  *
  */
-EMData* extract_plane(const Transform& tf, Util::KaiserBessel& kb);
+EMData* extract_plane(const Transform& tf, Util::KaiserBessel& kb) const;
 EMData* extract_plane_rect(const Transform& tf, Util::KaiserBessel& kbx, Util::KaiserBessel& kby, Util::KaiserBessel& kbz);
 EMData* extract_plane_rect_fast(const Transform& tf, Util::KaiserBessel& kbx, Util::KaiserBessel& kby, Util::KaiserBessel& kbz);
 
@@ -34,6 +34,7 @@
 #include "vec3.h"
 #include "exception.h"
 #include "util.h"
+#include <mutex>
 
 using namespace EMAN;
 
@@ -494,9 +495,10 @@ vector<Transform> EmanOrientationGenerator::gen_orientations(const Symmetry3D* c
 	if (breaksym) {
 		// no iterators here since we are making the list longer as we go
 		int nwithsym=ret.size();	// transforms in one asym unit
-		int nsym=sym->get_nsym();	// number of asymmetric units to generate
+		const vector<Transform>& syms=sym->get_sym_ops().syms;
+		int nsym=syms.size();		// number of asymmetric units to generate
 		for (int j=1; j<nsym; j++) {
-			Transform t=sym->get_sym(j);
+			const Transform& t=syms[j];
 			for (int i=0; i<nwithsym; i++) {
 				ret.push_back(ret[i]*t);		// add the symmetry modified transform to the end of the vector
 			}
@@ -1031,6 +1033,7 @@ void Symmetry3D::cache_au_planes() const {
 		}
 
 
+		const vector<Transform>& syms = get_sym_ops().syms;
 		int k = 0;
 		for(int i = 0; i < get_nsym(); ++i) {
 
@@ -1042,7 +1045,7 @@ void Symmetry3D::cache_au_planes() const {
 					for (vector<Vec3f>::iterator iit = points.begin(); iit != points.end(); ++iit ) {
 						// Rotate the points in the triangle so that the triangle occupies the
 						// space of the current asymmetric unit
-						*iit = (*iit)*get_sym(i);
+						*iit = (*iit)*syms[i];
 					}
 				}
 
@@ -1187,13 +1190,14 @@ vector<Transform> Symmetry3D::get_touching_au_transforms(bool inc_mirror) const
 		}
 	}
 
+	const vector<Transform>& syms = get_sym_ops().syms;
 	typedef vector<Vec3f>::const_iterator const_point_it;
 	for(const_point_it point = points.begin(); point != points.end(); ++point ) {
 
 		for(int i = 1; i < get_nsym(); ++i) {
 
 			if ( find(hit_cache.begin(),hit_cache.end(),i) != hit_cache.end() ) continue;
-			Transform t = get_sym(i);
+			const Transform& t = syms[i];
 			Vec3f result = (*point)*t;
 
 			if (is_platonic_sym()) {
@@ -1223,26 +1227,63 @@ vector<Transform> Symmetry3D::get_touching_au_transforms(bool inc_mirror) const
 
 vector<Transform> Symmetry3D::get_syms() const
 {
-
-	vector<Transform> ret;
-// 	if (t.is_identity()) {
-		for(int i = 0; i < get_nsym(); ++i ) {
-			ret.push_back(get_sym(i));
-		}
-// 	} else {
-// 		for(int i = 0; i < get_nsym(); ++i ) {
-// 			ret.push_back(get_sym(i)*t);
-// 		}
-// 	}
-	return ret;
+	return get_sym_ops().syms;
 }
 
 vector<Transform> Symmetry3D::get_symmetries(const string& symmetry)
 {
+	return get_symmetry_ops(symmetry).syms;
+}
+
+// The operator cache. symops_cache is keyed by the symmetry name plus all of its parameters, so it is
+// shared by every way of writing the same symmetry. symops_names maps the strings passed to
+// get_symmetry_ops() onto those entries, so a repeated lookup doesn't need to construct a Symmetry3D
+static std::mutex symops_mutex;
+static map<string, Symmetry3D::SymOps*> symops_cache;
+static map<string, Symmetry3D::SymOps*> symops_names;
+
+static string symops_key(const Symmetry3D* sym)
+{
+	string key=sym->get_name();
+	Dict p=sym->get_params();
+	for (Dict::const_iterator it=p.begin(); it!=p.end(); ++it) key+=","+it->first+"="+it->second.to_str();
+	return key;
+}
+
+// must be called with symops_mutex held
+static Symmetry3D::SymOps* symops_get(const Symmetry3D* sym)
+{
+	string key=symops_key(sym);
+	map<string, Symmetry3D::SymOps*>::iterator it=symops_cache.find(key);
+	if (it!=symops_cache.end()) return it->second;
+
+	Symmetry3D::SymOps* ops=new Symmetry3D::SymOps;
+	int nsym=sym->get_nsym();
+	for (int i=0; i<nsym; i++) ops->syms.push_back(sym->get_sym(i));
+
+	// generating the operators may fill in default parameters, so file it under both keys
+	symops_cache[key]=ops;
+	symops_cache[symops_key(sym)]=ops;
+	return ops;
+}
+
+const Symmetry3D::SymOps& Symmetry3D::get_sym_ops() const
+{
+	std::lock_guard<std::mutex> lock(symops_mutex);
+	return *symops_get(this);
+}
+
+const Symmetry3D::SymOps& Symmetry3D::get_symmetry_ops(const string& symmetry)
+{
+	std::lock_guard<std::mutex> lock(symops_mutex);
+	map<string, SymOps*>::iterator it=symops_names.find(symmetry);
+	if (it!=symops_names.end()) return *it->second;
+
 	Symmetry3D* sym = Factory<Symmetry3D>::get(Util::str_to_lower(symmetry));
-	vector<Transform> ret = sym->get_syms();
+	SymOps* ops=symops_get(sym);
 	delete sym;
-	return ret;
+	symops_names[symmetry]=ops;
+	return *ops;
 }
 
 // C Symmetry stuff
@@ -56,6 +56,14 @@ namespace EMAN {
 	class Symmetry3D : public FactoryBase
 	{
 	public:
+		/** The full set of operators of one symmetry, as returned by get_symmetry_ops() and get_sym_ops()
+		 */
+		struct SymOps
+		{
+			/// the symmetry operators, in get_sym() order
+			vector<Transform> syms;
+		};
+
 		typedef vector<vector<Vec3f> >::const_iterator cit;
 		typedef vector<vector<Vec3f> >::iterator ncit;
 		Symmetry3D();
@@ -201,6 +209,19 @@ namespace EMAN {
 
 		virtual vector<Transform> get_syms() const;
 		static vector<Transform> get_symmetries(const string& symmetry);
+
+		/** Get the operators of this symmetry from the process-wide cache (see get_symmetry_ops)
+		 * @return the operators, valid for the life of the process
+		 */
+		const SymOps& get_sym_ops() const;
+
+		/** Process-wide, threadsafe cache of symmetry operators. The first request for a symmetry generates its
+		 * operators, later requests from any thread return the same object without touching the Factory.
+		 * Differently written strings for the same symmetry (eg "C4" and "c4") share one entry. Entries are never freed.
+		 * @param symmetry a symmetry name as accepted by Factory<Symmetry3D>::get, eg "c4", "d7", "icos", "h3:1:27.5:4.7"
+		 * @return the operators, valid for the life of the process
+		 */
+		static const SymOps& get_symmetry_ops(const string& symmetry);
 	protected:
 		/// The asymmetric unit planes are cached to provide a great speed up
 		/// the point_in_which_asym_unit function, which is called by reduce and by in_which_asym_unit
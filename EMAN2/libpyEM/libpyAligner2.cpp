@@ -309,6 +309,13 @@ struct EMAN_EMAN1Ctf_Wrapper: EMAN::EMAN1Ctf
     PyObject* py_self;
 };
 
+void EMAN_EMAN2Ctf_compute_2d_complex_multi(EMAN::EMAN2Ctf& ctf, const std::vector<EMAN::EMData*>& images, const std::vector<int>& types)
+{
+    std::vector<EMAN::Ctf::CtfType> t(types.size());
+    for (size_t i = 0; i < types.size(); i++) t[i] = (EMAN::Ctf::CtfType)types[i];
+    ctf.compute_2d_complex_multi(images, t);
+}
+
 struct EMAN_EMAN2Ctf_Wrapper: EMAN::EMAN2Ctf
 {
     EMAN_EMAN2Ctf_Wrapper(PyObject* py_self_, const EMAN::EMAN2Ctf& p0):
@@ -466,6 +473,8 @@ BOOST_PYTHON_MODULE(libpyAligner2)
         .def("align", pure_virtual((EMAN::EMData* (EMAN::Aligner::*)(EMAN::EMData*, EMAN::EMData*) const)&EMAN::Aligner::align), return_value_policy< manage_new_object >())
         .def("align", pure_virtual((EMAN::EMData* (EMAN::Aligner::*)(EMAN::EMData*, EMAN::EMData*, const std::string&, const EMAN::Dict&) const)&EMAN::Aligner::align), return_value_policy< manage_new_object >())
 		.def("xform_align_nbest", &EMAN::Aligner::xform_align_nbest)
+		.def("xform_align_nbest_batch", &EMAN::Aligner::xform_align_nbest_batch)
+		.def("align_batch", &EMAN::Aligner::align_batch)
         .def("get_name", pure_virtual(&EMAN::Aligner::get_name))
         .def("get_desc", pure_virtual(&EMAN::Aligner::get_desc))
         .def("get_params", &EMAN::Aligner::get_params, &EMAN_Aligner_Wrapper::default_get_params)
@@ -610,6 +619,7 @@ BOOST_PYTHON_MODULE(libpyAligner2)
         .def("compute_2d_real", (void (EMAN_EMAN2Ctf_Wrapper::*)(EMAN::EMData*, EMAN::Ctf::CtfType))&EMAN_EMAN2Ctf_Wrapper::default_compute_2d_real_2)
         .def("compute_2d_complex", (void (EMAN::EMAN2Ctf::*)(EMAN::EMData*, EMAN::Ctf::CtfType, EMAN::XYData*) )&EMAN::EMAN2Ctf::compute_2d_complex, (void (EMAN_EMAN2Ctf_Wrapper::*)(EMAN::EMData*, EMAN::Ctf::CtfType, EMAN::XYData*))&EMAN_EMAN2Ctf_Wrapper::default_compute_2d_complex_3)
         .def("compute_2d_complex", (void (EMAN_EMAN2Ctf_Wrapper::*)(EMAN::EMData*, EMAN::Ctf::CtfType))&EMAN_EMAN2Ctf_Wrapper::default_compute_2d_complex_2)
+        .def("compute_2d_complex_multi", &EMAN_EMAN2Ctf_compute_2d_complex_multi, args("images", "types"), "Computes types[i] into the complex image images[i] for all i in a single pass.")
         .def("from_string", (int (EMAN::EMAN2Ctf::*)(const std::string&) )&EMAN::EMAN2Ctf::from_string, (int (EMAN_EMAN2Ctf_Wrapper::*)(const std::string&))&EMAN_EMAN2Ctf_Wrapper::default_from_string)
         .def("to_string", (std::string (EMAN::EMAN2Ctf::*)() const)&EMAN::EMAN2Ctf::to_string, (std::string (EMAN_EMAN2Ctf_Wrapper::*)() const)&EMAN_EMAN2Ctf_Wrapper::default_to_string)
         .def("from_dict", (void (EMAN::EMAN2Ctf::*)(const EMAN::Dict&) )&EMAN::EMAN2Ctf::from_dict, (void (EMAN_EMAN2Ctf_Wrapper::*)(const EMAN::Dict&))&EMAN_EMAN2Ctf_Wrapper::default_from_dict)
@@ -39,6 +39,7 @@
 #include <emdata_pickle.h>
 #include <emdata_wrapitems.h>
 #include <emfft.h>
+#include <imagestream.h>
 #include <processor.h>
 #include <transform.h>
 #include <xydata.h>/** return the FFT amplitude which is greater than thres %
@@ -55,7 +56,7 @@ using namespace boost::python;
 namespace  {
 //BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(EMAN_EMData_read_image_overloads_1_6, read_image, 1, 6)
 
-BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(EMAN_EMData_read_binedimage_overloads_1_5, read_binedimage, 1, 5)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(EMAN_EMData_read_binedimage_overloads_1_7, read_binedimage, 1, 7)
 
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(EMAN_EMData_write_image_overloads_1_7, write_image, 1, 7)
 
@@ -65,7 +66,7 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(EMAN_EMData_write_lst_overloads_1_4, writ
 
 //BOOST_PYTHON_FUNCTION_OVERLOADS(EMAN_EMData_read_images_overloads_1_4, EMAN::EMData::read_images, 1, 4)
 
-BOOST_PYTHON_FUNCTION_OVERLOADS(EMAN_EMData_write_images_overloads_2_7, EMAN::EMData::write_images, 2, 7)
+BOOST_PYTHON_FUNCTION_OVERLOADS(EMAN_EMData_write_images_overloads_2_8, EMAN::EMData::write_images, 2, 8)
 
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(EMAN_EMData_set_size_overloads_1_4, EMAN::EMData::set_size, 1, 4)
 
@@ -263,6 +264,69 @@ void EMData_read_image_wrapper6(EMData &ths, const string & filename, int img_in
 	ths.read_image(filename,img_index,header_only,region,is_3d,imgtype);
 }
 
+void EMData_read_frame_sum_wrapper3(EMData &ths, const string & filename, int first, int count)
+{
+	GILRelease rel;
+
+	ths.read_frame_sum(filename,first,count);
+}
+
+void EMData_read_frame_sum_wrapper4(EMData &ths, const string & filename, int first, int count, int nthreads)
+{
+	GILRelease rel;
+
+	ths.read_frame_sum(filename,first,count,nthreads);
+}
+
+void EMData_read_frame_sum_wrapper5(EMData &ths, const string & filename, int first, int count, int nthreads, EMUtil::ImageType imgtype)
+{
+	GILRelease rel;
+
+	ths.read_frame_sum(filename,first,count,nthreads,imgtype);
+}
+
+void EMData_read_frame_sum_wrapper6(EMData &ths, const string & filename, int first, int count, int nthreads, EMUtil::ImageType imgtype, const EMData *gain)
+{
+	GILRelease rel;
+
+	ths.read_frame_sum(filename,first,count,nthreads,imgtype,gain);
+}
+
+static vector<std::shared_ptr<EMData>> EMData_read_frame_sums_wrapper3(const string & filename, int first, int count)
+{
+	GILRelease rel;
+
+	return EMData::read_frame_sums(filename,first,count);
+}
+
+static vector<std::shared_ptr<EMData>> EMData_read_frame_sums_wrapper4(const string & filename, int first, int count, int group)
+{
+	GILRelease rel;
+
+	return EMData::read_frame_sums(filename,first,count,group);
+}
+
+static vector<std::shared_ptr<EMData>> EMData_read_frame_sums_wrapper5(const string & filename, int first, int count, int group, int nthreads)
+{
+	GILRelease rel;
+
+	return EMData::read_frame_sums(filename,first,count,group,nthreads);
+}
+
+static vector<std::shared_ptr<EMData>> EMData_read_frame_sums_wrapper6(const string & filename, int first, int count, int group, int nthreads, EMUtil::ImageType imgtype)
+{
+	GILRelease rel;
+
+	return EMData::read_frame_sums(filename,first,count,group,nthreads,imgtype);
+}
+
+static vector<std::shared_ptr<EMData>> EMData_read_frame_sums_wrapper7(const string & filename, int first, int count, int group, int nthreads, EMUtil::ImageType imgtype, const EMData *gain)
+{
+	GILRelease rel;
+
+	return EMData::read_frame_sums(filename,first,count,group,nthreads,imgtype,gain);
+}
+
 static vector<std::shared_ptr<EMData>> EMData_read_images_wrapper1(const string &filename)
 {
 	GILRelease rel;
@@ -291,6 +355,27 @@ static vector<std::shared_ptr<EMData>> EMData_read_images_wrapper4(const string
 	return EMData::read_images(filename,img_indices,imgtype,header_only);
 }
 
+static EMData *ImageStackReader_next_wrapper(ImageStackReader &ths)
+{
+	GILRelease rel;
+
+	return ths.next();
+}
+
+static void ImageStackWriter_write_wrapper(ImageStackWriter &ths, const EMData &img)
+{
+	GILRelease rel;
+
+	ths.write(img);
+}
+
+static void ImageStackWriter_close_wrapper(ImageStackWriter &ths)
+{
+	GILRelease rel;
+
+	ths.close();
+}
+
 EMData *EMData_get_clip_1(EMData &ths, Region rgn) {
 	GILRelease rel;
 	
@@ -309,6 +394,18 @@ EMData *EMData_do_fft_wrapper(EMData &ths) {
 	return ths.do_fft();
 }
 
+vector<std::shared_ptr<EMData>> EMData_do_fft_batch_wrapper(const vector<EMData*>& images) {
+	vector<EMData*> ffts;
+	{
+		GILRelease rel;
+		ffts = EMData::do_fft_batch(images);
+	}
+
+	vector<std::shared_ptr<EMData>> ret;
+	for (size_t i = 0; i < ffts.size(); i++) ret.push_back(std::shared_ptr<EMData>(ffts[i]));
+	return ret;
+}
+
 void EMData_add_wrapper(EMData &ths, EMData &to) {
 	GILRelease rel;
 	
@@ -625,7 +722,16 @@ BOOST_PYTHON_MODULE(libpyEMData2)
 	.def("read_image", &EMData_read_image_wrapper4,args("filename", "img_index", "header_only", "region"), "read an image file and stores its information to this EMData object.\n\nIf a region is given, then only read a\nregion of the image file. The region will be this\nEMData object. The given region must be inside the given\nimage file. Otherwise, an error will be created.\n\nfilename The image file name.\nimg_index The nth image you want to read.\nheader_only To read only the header or both header and data.\nregion To read only a region of the image.\nis_3d  Whether to treat the image as a single 3D or a set of 2Ds. This is a hint for certain image formats which has no difference between 3D image and set of 2Ds.\nexception ImageFormatException\nexception ImageReadException")
 	.def("read_image", &EMData_read_image_wrapper5,args("filename", "img_index", "header_only", "region", "is_3d"), "read an image file and stores its information to this EMData object.\n\nIf a region is given, then only read a\nregion of the image file. The region will be this\nEMData object. The given region must be inside the given\nimage file. Otherwise, an error will be created.\n\nfilename The image file name.\nimg_index The nth image you want to read.\nheader_only To read only the header or both header and data.\nregion To read only a region of the image.\nis_3d  Whether to treat the image as a single 3D or a set of 2Ds. This is a hint for certain image formats which has no difference between 3D image and set of 2Ds.\nexception ImageFormatException\nexception ImageReadException")
 	.def("read_image", &EMData_read_image_wrapper6,args("filename", "img_index", "header_only", "region", "is_3d", "imgtype"), "read an image file and stores its information to this EMData object.\n\nIf a region is given, then only read a\nregion of the image file. The region will be this\nEMData object. The given region must be inside the given\nimage file. Otherwise, an error will be created.\n\nfilename The image file name.\nimg_index The nth image you want to read.\nheader_only To read only the header or both header and data.\nregion To read only a region of the image.\nis_3d  Whether to treat the image as a single 3D or a set of 2Ds. This is a hint for certain image formats which has no difference between 3D image and set of 2Ds.\nexception ImageFormatException\nexception ImageReadException")
-	.def("read_binedimage", &EMAN::EMData::read_binedimage, EMAN_EMData_read_binedimage_overloads_1_5(args("filename", "img_index", "binfactor", "fast", "is_3d"), "read an image file and stores its information to this EMData object.\nfilename The image file name.\nimg_index The nth image you want to read.\nbinfactor The amount by which to bin by. Must be an integer\nfast bin very binfactor xy slice otherwise meanshrink z slice\nis_3d  Whether to treat the image as a single 3D or a set of 2Ds. This is a hint for certain image formats which has no difference between 3D image and set of 2Ds.\nexception ImageFormatException\nexception ImageReadException"))
+	.def("read_frame_sum", &EMData_read_frame_sum_wrapper3,args("filename", "first", "count"), "read the sum of a group of consecutive frames of a movie, e.g. to group EER frames into dose fractions. EER frames are decoded straight into the sum on several threads; other formats are read on several threads, each through its own file handle (HDF is read on one).\n\nfilename The image file name.\nfirst The first frame to include.\ncount The number of frames to sum.\nnthreads Threads used to read the frames, 0 for all cores.\nimgtype Read as this image type, e.g. IMAGE_EER2X for an 8k grid.\ngain If given, the sum is multiplied by this gain reference, which may be zero at defective pixels.\nexception ImageFormatException\nexception ImageReadException\nexception ImageDimensionException\nexception OutofRangeException")
+	.def("read_frame_sum", &EMData_read_frame_sum_wrapper4,args("filename", "first", "count", "nthreads"), "read the sum of a group of consecutive frames of a movie, e.g. to group EER frames into dose fractions. EER frames are decoded straight into the sum on several threads; other formats are read on several threads, each through its own file handle (HDF is read on one).\n\nfilename The image file name.\nfirst The first frame to include.\ncount The number of frames to sum.\nnthreads Threads used to read the frames, 0 for all cores.\nimgtype Read as this image type, e.g. IMAGE_EER2X for an 8k grid.\ngain If given, the sum is multiplied by this gain reference, which may be zero at defective pixels.\nexception ImageFormatException\nexception ImageReadException\nexception ImageDimensionException\nexception OutofRangeException")
+	.def("read_frame_sum", &EMData_read_frame_sum_wrapper5,args("filename", "first", "count", "nthreads", "imgtype"), "read the sum of a group of consecutive frames of a movie, e.g. to group EER frames into dose fractions. EER frames are decoded straight into the sum on several threads; other formats are read on several threads, each through its own file handle (HDF is read on one).\n\nfilename The image file name.\nfirst The first frame to include.\ncount The number of frames to sum.\nnthreads Threads used to read the frames, 0 for all cores.\nimgtype Read as this image type, e.g. IMAGE_EER2X for an 8k grid.\ngain If given, the sum is multiplied by this gain reference, which may be zero at defective pixels.\nexception ImageFormatException\nexception ImageReadException\nexception ImageDimensionException\nexception OutofRangeException")
+	.def("read_frame_sum", &EMData_read_frame_sum_wrapper6,args("filename", "first", "count", "nthreads", "imgtype", "gain"), "read the sum of a group of consecutive frames of a movie, e.g. to group EER frames into dose fractions. EER frames are decoded straight into the sum on several threads; other formats are read on several threads, each through its own file handle (HDF is read on one).\n\nfilename The image file name.\nfirst The first frame to include.\ncount The number of frames to sum.\nnthreads Threads used to read the frames, 0 for all cores.\nimgtype Read as this image type, e.g. IMAGE_EER2X for an 8k grid.\ngain If given, the sum is multiplied by this gain reference, which may be zero at defective pixels.\nexception ImageFormatException\nexception ImageReadException\nexception ImageDimensionException\nexception OutofRangeException")
+	.def("read_frame_sums", &EMData_read_frame_sums_wrapper3,args("filename", "first", "count"), "read a frame range of a movie as sums of consecutive groups of frames in one pass, e.g. all the dose fractions of a movie. The frames are read as by read_frame_sum(). With group = 1 this reads the frames themselves.\n\nfilename The image file name.\nfirst The first frame to include.\ncount The number of frames to include.\ngroup Frames per sum; the last sum may have fewer.\nnthreads Threads used to read the frames, 0 for all cores.\nimgtype Read as this image type, e.g. IMAGE_EER2X for an 8k grid.\ngain If given, every sum is multiplied by this gain reference.\nreturn ceil(count / group) images, each with the header of its first frame.")
+	.def("read_frame_sums", &EMData_read_frame_sums_wrapper4,args("filename", "first", "count", "group"), "read a frame range of a movie as sums of consecutive groups of frames in one pass, e.g. all the dose fractions of a movie. The frames are read as by read_frame_sum(). With group = 1 this reads the frames themselves.\n\nfilename The image file name.\nfirst The first frame to include.\ncount The number of frames to include.\ngroup Frames per sum; the last sum may have fewer.\nnthreads Threads used to read the frames, 0 for all cores.\nimgtype Read as this image type, e.g. IMAGE_EER2X for an 8k grid.\ngain If given, every sum is multiplied by this gain reference.\nreturn ceil(count / group) images, each with the header of its first frame.")
+	.def("read_frame_sums", &EMData_read_frame_sums_wrapper5,args("filename", "first", "count", "group", "nthreads"), "read a frame range of a movie as sums of consecutive groups of frames in one pass, e.g. all the dose fractions of a movie. The frames are read as by read_frame_sum(). With group = 1 this reads the frames themselves.\n\nfilename The image file name.\nfirst The first frame to include.\ncount The number of frames to include.\ngroup Frames per sum; the last sum may have fewer.\nnthreads Threads used to read the frames, 0 for all cores.\nimgtype Read as this image type, e.g. IMAGE_EER2X for an 8k grid.\ngain If given, every sum is multiplied by this gain reference.\nreturn ceil(count / group) images, each with the header of its first frame.")
+	.def("read_frame_sums", &EMData_read_frame_sums_wrapper6,args("filename", "first", "count", "group", "nthreads", "imgtype"), "read a frame range of a movie as sums of consecutive groups of frames in one pass, e.g. all the dose fractions of a movie. The frames are read as by read_frame_sum(). With group = 1 this reads the frames themselves.\n\nfilename The image file name.\nfirst The first frame to include.\ncount The number of frames to include.\ngroup Frames per sum; the last sum may have fewer.\nnthreads Threads used to read the frames, 0 for all cores.\nimgtype Read as this image type, e.g. IMAGE_EER2X for an 8k grid.\ngain If given, every sum is multiplied by this gain reference.\nreturn ceil(count / group) images, each with the header of its first frame.")
+	.def("read_frame_sums", &EMData_read_frame_sums_wrapper7,args("filename", "first", "count", "group", "nthreads", "imgtype", "gain"), "read a frame range of a movie as sums of consecutive groups of frames in one pass, e.g. all the dose fractions of a movie. The frames are read as by read_frame_sum(). With group = 1 this reads the frames themselves.\n\nfilename The image file name.\nfirst The first frame to include.\ncount The number of frames to include.\ngroup Frames per sum; the last sum may have fewer.\nnthreads Threads used to read the frames, 0 for all cores.\nimgtype Read as this image type, e.g. IMAGE_EER2X for an 8k grid.\ngain If given, every sum is multiplied by this gain reference.\nreturn ceil(count / group) images, each with the header of its first frame.")
+	.def("read_binedimage", &EMAN::EMData::read_binedimage, EMAN_EMData_read_binedimage_overloads_1_7(args("filename", "img_index", "binfactor", "fast", "is_3d", "fourier", "nthreads"), "read an image file and stores its information to this EMData object.\nfilename The image file name.\nimg_index The nth image you want to read.\nbinfactor The amount by which to bin by. Must be an integer\nfast bin very binfactor xy slice otherwise meanshrink z slice\nis_3d  Whether to treat the image as a single 3D or a set of 2Ds. This is a hint for certain image formats which has no difference between 3D image and set of 2Ds.\nfourier Bin each slice in XY by Fourier cropping rather than by averaging\nnthreads Threads used to reduce each slab, 0 for all cores\nexception ImageFormatException\nexception ImageReadException"))
 	.def("write_image", &EMAN::EMData::write_image, EMAN_EMData_write_image_overloads_1_7(args("filename", "img_index", "imgtype", "header_only", "region", "filestoragetype", "use_host_endian"), "write the header and data out to an image.\n\nIf the img_index = -1, append the image to the given image file.\n\nIf the given image file already exists, this image\nformat only stores 1 image, and no region is given, then\ntruncate the image file  to  zero length before writing\ndata out. For header writing only, no truncation happens.\n\nIf a region is given, then write a region only.\n\nfilename - The image file name.\nimg_index - The nth image to write as.\nimgtype - Write to the given image format type. if not specified, use the 'filename' extension to decide.\nheader_only - To write only the header or both header and data.\nregion - Define the region to write to.\nfilestoragetype - The image data type used in the output file.\nuse_host_endian - To write in the host computer byte order.\n\nexception - ImageFormatException\nexception ImageWriteException"))
 	.def("append_image", &EMAN::EMData::append_image, EMAN_EMData_append_image_overloads_1_3(args("filename", "imgtype", "header_only"), "append to an image file; If the file doesn't exist, create one.\nfilename - The image file name.\nimgtype - Write to the given image format type. if not specified, use the 'filename' extension to decide.\nheader_only - To write only the header or both header and data."))
 	.def("write_lst", &EMAN::EMData::write_lst, EMAN_EMData_write_lst_overloads_1_4(args("filename", "reffile", "refn", "comment"), "Append data to a LST image file.\nfilename - The LST image file name.\nreffile - Reference file name.\nrefn The reference file number.\ncomment - The comment to the added reference file."))
@@ -633,7 +739,7 @@ BOOST_PYTHON_MODULE(libpyEMData2)
 	.def("read_images", &EMData_read_images_wrapper2,args("filename", "img_indices"),"Read a set of images from file specified by 'filename'.\nWhich images are read is set by 'img_indices'.\nfilename The image file name.\nimg_indices Which images are read. If it is empty, all images are read. If it is not empty, only those in this array are read.\nheader_only If true, only read image header. If false, read both data and header.\nreturn The set of images read from filename.")
 	.def("read_images", &EMData_read_images_wrapper3,args("filename", "img_indices", "imgtype"),"Read a set of images from file specified by 'filename'.\nWhich images are read is set by 'img_indices'.\nfilename The image file name.\nimg_indices Which images are read. If it is empty, all images are read. If it is not empty, only those in this array are read.\nheader_only If true, only read image header. If false, read both data and header.\nreturn The set of images read from filename.")
 	.def("read_images", &EMData_read_images_wrapper4,args("filename", "img_indices", "imgtype", "header_only"),"Read a set of images from file specified by 'filename'.\nWhich images are read is set by 'img_indices'.\nfilename The image file name.\nimg_indices Which images are read. If it is empty, all images are read. If it is not empty, only those in this array are read.\nheader_only If true, only read image header. If false, read both data and header.\nreturn The set of images read from filename.")
-	.def("write_images", &EMAN::EMData::write_images, EMAN_EMData_write_images_overloads_2_7(args("filename", "imgs", "imgtype", "header_only", "region", "filestoragetype", "use_host_endian"),"Write a set of images to file specified by 'filename'.\nWhich images are written is set by 'imgs'.\nfilename The image file name.\\n\\nIf a region is given, then write a region only.\\n\\nfilename - The image file name.\\nimgs - Images to write.\\nimgtype - Write to the given image format type. if not specified, use the 'filename' extension to decide.\\nheader_only - To write only the header or both header and data.\\nregion - Define the region to write to.\\nfilestoragetype - The image data type used in the output file.\\nuse_host_endian - To write in the host computer byte order.\\n\\nreturn True if images written successfully to filename."))
+	.def("write_images", &EMAN::EMData::write_images, EMAN_EMData_write_images_overloads_2_8(args("filename", "imgs", "imgtype", "header_only", "region", "filestoragetype", "use_host_endian", "first_index"),"Write a set of images to file specified by 'filename'.\nWhich images are written is set by 'imgs'.\nfilename The image file name.\\n\\nIf a region is given, then write a region only.\\n\\nfilename - The image file name.\\nimgs - Images to write.\\nimgtype - Write to the given image format type. if not specified, use the 'filename' extension to decide.\\nheader_only - To write only the header or both header and data.\\nregion - Define the region to write to.\\nfilestoragetype - The image data type used in the output file.\\nuse_host_endian - To write in the host computer byte order.\\nfirst_index - File index of the first image, -1 to append. Default 0.\\n\\nreturn True if images written successfully to filename."))
 	.def("get_fft_amplitude", &EMAN::EMData::get_fft_amplitude, return_value_policy< manage_new_object >(), "return the amplitudes of the FFT including the left half\n \nreturn The current FFT image's amplitude image.\nexception - ImageFormatException If the image is not a complex image.")
 	.def("get_fft_amplitude2D", &EMAN::EMData::get_fft_amplitude2D, return_value_policy< manage_new_object >(), "return the amplitudes of the 2D FFT including the left half, PRB\n \nreturn The current FFT image's amplitude image.\nexception - ImageFormatException If the image is not a complex image.")
 	.def("get_fft_phase", &EMAN::EMData::get_fft_phase, return_value_policy< manage_new_object >(), "return the phases of the FFT including the left half\n \nreturn The current FFT image's phase image.\nexception - ImageFormatException If the image is not a complex image.")
@@ -738,6 +844,8 @@ BOOST_PYTHON_MODULE(libpyEMData2)
 //	.def("project", (EMAN::EMData* (EMAN::EMData::*)(const std::string&, const EMAN::Transform&) )&EMAN::EMData::project, args("projector_name", "t3d"), "Calculate the projection of this image and return the result.\n \nprojector_name - Projection algorithm name.\nt3d - Transform object used to do projection.\n \nreturn The result image.\nexception - NotExistingObjectError If the projection algorithm doesn't exist.", return_value_policy< manage_new_object >() )
 	.def("backproject", &EMAN::EMData::backproject, EMAN_EMData_backproject_overloads_1_2(args("peojector_name", "params"), "Calculate the backprojection of this image (stack) and return the result.\n \nprojector_name - Projection algorithm name. Only \"pawel\" and \"chao\" have been implemented now.\nparams - Projection Algorithm parameters, default to Null.\n \nreturn The result image.\nexception - NotExistingObjectError If the projection algorithm doesn't exist.")[ return_value_policy< manage_new_object >() ])
 	.def("do_fft", &EMData_do_fft_wrapper, return_value_policy< manage_new_object >(), "return the fast fourier transform (FFT) image of the current\nimage. the current image is not changed. The result is in\nreal/imaginary format.\n \nreturn The FFT of the current image in real/imaginary format.")
+	.def("do_fft_batch", &EMData_do_fft_batch_wrapper, args("images"), "Fourier transform a list of equally sized real 2D images using batched FFTW plans.\nEquivalent to calling do_fft() on each image.\n \nimages - the real 2D images\n \nreturn a list of FFTs in real/imaginary format.")
+	.staticmethod("do_fft_batch")
 	.def("do_fft_inplace", &EMAN::EMData::do_fft_inplace, return_value_policy< reference_existing_object >(), "Do FFT inplace. And return the FFT image.\n \nreturn The FFT of the current image in real/imaginary format.")
 	.def("do_ift", &EMAN::EMData::do_ift, return_value_policy< manage_new_object >(), "return the inverse fourier transform (IFT) image of the current\nimage. the current image may be changed if it is in amplitude/phase\nformat as opposed to real/imaginary format - if this change is\nperformed it is not undone.\n \nreturn The current image's inverse fourier transform image.\nexception - ImageFormatException If the image is not a complex image.")
 	.def("do_ift_inplace", &EMAN::EMData::do_ift_inplace, return_value_policy< reference_existing_object >(), "Do IFT inplace. And return the IFT image.\n \nreturn The IFT image.")
@@ -977,6 +1085,7 @@ BOOST_PYTHON_MODULE(libpyEMData2)
 	.def("__getitem__", &emdata_getitem)
 	.def("__setitem__", &emdata_setitem)
 	.staticmethod("read_images")
+	.staticmethod("read_frame_sums")
 	.staticmethod("write_images")
 	.def("__add__", (EMAN::EMData* (*)(const EMAN::EMData&, const EMAN::EMData&) )&EMAN::operator+, return_value_policy< manage_new_object >() )
 	.def("__sub__", (EMAN::EMData* (*)(const EMAN::EMData&, const EMAN::EMData&) )&EMAN::operator-, return_value_policy< manage_new_object >() )
@@ -1011,4 +1120,22 @@ BOOST_PYTHON_MODULE(libpyEMData2)
 
 	delete EMAN_EMData_scope;
 
+	class_< EMAN::ImageStackReader, boost::noncopyable >("ImageStackReader",
+			"Streams the images of a stack file through a background I/O thread,\n"
+			"reading up to 'readahead' images ahead of the caller.",
+			init< const std::string&, boost::python::optional< const std::vector<int>&, int, bool > >(args("filename", "img_indices", "readahead", "header_only"), "filename - the stack to read\nimg_indices - images to read, in order. Empty means all images.\nreadahead - maximum number of images read ahead of the caller (default 16)\nheader_only - read headers only"))
+	.def("next", &ImageStackReader_next_wrapper, return_value_policy< manage_new_object >(), "Return the next image in the sequence, or None at the end.")
+	.def("get_count", &EMAN::ImageStackReader::get_count, "Return the number of images in the sequence.")
+	.def("get_position", &EMAN::ImageStackReader::get_position, "Return the number of images already returned by next().")
+	;
+
+	class_< EMAN::ImageStackWriter, boost::noncopyable >("ImageStackWriter",
+			"Writes a stack file from a background I/O thread. write() queues a copy of\n"
+			"the image; the file stays open and is flushed once, by close().",
+			init< const std::string&, boost::python::optional< int, int, EMAN::EMUtil::EMDataType, EMAN::EMUtil::ImageType > >(args("filename", "first_index", "queue", "filestoragetype", "imgtype"), "filename - the stack to write\nfirst_index - file index of the first image, -1 (default) appends\nqueue - maximum number of images waiting to be written (default 64)\nfilestoragetype - data type in the file (default EM_FLOAT)\nimgtype - file format, by default from the extension"))
+	.def("write", &ImageStackWriter_write_wrapper, args("img"), "Queue a copy of img to be written. Raises any error from writing earlier images.")
+	.def("close", &ImageStackWriter_close_wrapper, "Write what is still queued, flush and close the file. Raises any error from writing.")
+	.def("get_count", &EMAN::ImageStackWriter::get_count, "Return the number of images passed to write().")
+	;
+
 }
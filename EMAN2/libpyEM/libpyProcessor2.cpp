@@ -106,6 +106,8 @@ struct EMAN_Processor_Wrapper: EMAN::Processor
 };
 
 
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(EMAN_ProcessorChain_add_overloads_1_2, add, 1, 2)
+
 }// namespace
 
 
@@ -161,6 +163,12 @@ BOOST_PYTHON_MODULE(libpyProcessor2)
     def("dump_processors", &EMAN::dump_processors);
     def("dump_processors_list", &EMAN::dump_processors_list);
     def("multi_processors", &EMAN::multi_processors);
+    class_< EMAN::ProcessorChain, boost::noncopyable >("ProcessorChain", "Applies a list of processors in order, with one FFT round trip for every run of consecutive Fourier space filters.", init<  >())
+        .def("add", &EMAN::ProcessorChain::add, EMAN_ProcessorChain_add_overloads_1_2(args("name", "params"), "Appends a processor to the chain."))
+        .def("process_inplace", &EMAN::ProcessorChain::process_inplace, args("image"))
+        .def("process", &EMAN::ProcessorChain::process, args("image"), return_value_policy< manage_new_object >())
+        .def("size", &EMAN::ProcessorChain::size)
+    ;
     def("group_processors", &EMAN::group_processors);
     class_< EMAN::Factory<EMAN::Processor>, boost::noncopyable >("Processors", no_init)
         .def("get", (EMAN::Processor* (*)(const std::basic_string<char,std::char_traits<char>,std::allocator<char> >&))&EMAN::Factory<EMAN::Processor>::get, return_value_policy< manage_new_object >())
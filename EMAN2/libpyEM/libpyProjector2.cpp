@@ -85,6 +85,34 @@ struct EMAN_Projector_Wrapper: EMAN::Projector
     PyObject* py_self;
 };
 
+// Instantiating this class in the function gives us GIL release
+class GILRelease
+{
+public:
+    inline GILRelease() { m_thread_state = PyEval_SaveThread(); }
+    inline ~GILRelease() { PyEval_RestoreThread(m_thread_state); m_thread_state = NULL; }
+private:
+    PyThreadState * m_thread_state;
+};
+
+EMAN::EMData* EMAN_ProjectionSession_project1(const EMAN::ProjectionSession& s, const EMAN::Transform& t3d)
+{
+    GILRelease rel;
+    return s.project(t3d);
+}
+
+std::vector<std::shared_ptr<EMAN::EMData> > EMAN_ProjectionSession_project_list1(const EMAN::ProjectionSession& s, const std::vector<EMAN::Transform>& xforms)
+{
+    GILRelease rel;
+    return s.project(xforms);
+}
+
+std::vector<std::shared_ptr<EMAN::EMData> > EMAN_ProjectionSession_project_list2(const EMAN::ProjectionSession& s, const std::vector<EMAN::Transform>& xforms, int nthreads)
+{
+    GILRelease rel;
+    return s.project(xforms, nthreads);
+}
+
 
 }// namespace
 
@@ -112,5 +140,14 @@ BOOST_PYTHON_MODULE(libpyProjector2)
         .staticmethod("get")
     ;
 
+    class_< EMAN::ProjectionSession, boost::noncopyable >("ProjectionSession",
+        "Prepares a volume once for the named projector and projects it along\n"
+        "many orientations. project([xforms], nthreads=0) runs on several threads.",
+        init< const std::string&, const EMAN::Dict&, const EMAN::EMData* >())
+        .def("project", &EMAN_ProjectionSession_project1, return_value_policy< manage_new_object >())
+        .def("project", &EMAN_ProjectionSession_project_list1)
+        .def("project", &EMAN_ProjectionSession_project_list2)
+    ;
+
 }
 
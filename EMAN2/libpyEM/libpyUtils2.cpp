@@ -46,6 +46,7 @@
 #include "ctf.h"
 #include "geometry.h"
 #include "portable_fileio.h"
+#include "emfft.h"
 
 // Using =======================================================================
 using namespace boost::python;
@@ -238,6 +239,8 @@ struct EMAN_Util_FakeKaiserBessel_Wrapper: EMAN::Util::FakeKaiserBessel
 
 BOOST_PYTHON_FUNCTION_OVERLOADS(EMAN_EMUtil_get_imageio_overloads_2_3, EMAN::EMUtil::get_imageio, 2, 3)
 
+BOOST_PYTHON_FUNCTION_OVERLOADS(EMAN_EMUtil_read_header_column_overloads_2_3, EMAN::EMUtil::read_header_column, 2, 3)
+
 #ifdef USE_HDF5
 BOOST_PYTHON_FUNCTION_OVERLOADS(EMAN_EMUtil_read_hdf_attribute_2_3, EMAN::EMUtil::read_hdf_attribute, 2, 3)
 
@@ -1204,6 +1207,7 @@ hyb -- y- mesh spacing above f0\nhya -- y- mesh spacing below f0\n \nInterpolant
         .def("jump_lines", &EMAN::EMUtil::jump_lines, args("file", "nlines"), "")
         .def("get_euler_names", &EMAN::EMUtil::get_euler_names, args("euler_type"), "")
         .def("get_all_attributes", &EMAN::EMUtil::get_all_attributes, args("file_name", "attr_name"), "Get an attribute from a stack of image, returned as a vector\n \nfile_name - the image file name\nattr_name - The header attribute name.\n \nreturn the vector of attribute value\n \nexception - NotExistingObjectException when access an non-existing attribute\nexception - InvalidCallException when call this function for a non-stack image")
+		.def("read_header_column", &EMAN::EMUtil::read_header_column, EMAN_EMUtil_read_header_column_overloads_2_3(args("filename", "key", "indices"), "Read one header attribute from many images in a file without building a header dictionary for each image.\n \nfilename - the image file name\nkey - The header attribute name.\nindices - The images to read, default=all images in the file\n \nreturn a list with one value per image, None where the attribute is missing"))
 		.def("cuda_available", &EMAN::EMUtil::cuda_available)
 #ifdef USE_HDF5
 		.def("read_hdf_attribute", &EMAN::EMUtil::read_hdf_attribute, EMAN_EMUtil_read_hdf_attribute_2_3(args("filename", "key", "image_index"), "Retrive a single attribute value from a HDF5 image file.\n \nfilename - HDF5 image's file name\nkey - the attribute's key name\nimage_index - the image index, default=0\n \nreturn the attribute value for the given key"))
@@ -1216,6 +1220,7 @@ hyb -- y- mesh spacing above f0\nhya -- y- mesh spacing below f0\n \nInterpolant
         .staticmethod("get_datatype_string")
         .staticmethod("dump_dict")
         .staticmethod("get_all_attributes")
+        .staticmethod("read_header_column")
         .staticmethod("get_imageio")
         .staticmethod("get_image_count")
         .staticmethod("get_imagetype_name")
@@ -1285,6 +1290,25 @@ hyb -- y- mesh spacing above f0\nhya -- y- mesh spacing below f0\n \nInterpolant
 
     delete EMAN_EMUtil_scope;
 
+#ifdef USE_FFTW3
+    class_< EMAN::EMfft, boost::noncopyable >("EMfft", "Process-wide settings for the FFTW Fourier transforms.", no_init)
+        .def("set_num_threads", &EMAN::EMfft::set_num_threads, args("n"), "Set the number of threads FFTW uses for large transforms (0 for all hardware threads). Defaults to EMAN2_FFTW_THREADS or 1.")
+        .staticmethod("set_num_threads")
+        .def("get_num_threads", &EMAN::EMfft::get_num_threads, "Get the number of threads FFTW uses for large transforms.")
+        .staticmethod("get_num_threads")
+        .def("import_wisdom", &EMAN::EMfft::import_wisdom, args("filename"), "Load FFTW wisdom from a file.\n \nreturn True on success.")
+        .staticmethod("import_wisdom")
+        .def("export_wisdom", &EMAN::EMfft::export_wisdom, args("filename"), "Write the current FFTW wisdom to a file.\n \nreturn True on success.")
+        .staticmethod("export_wisdom")
+#ifdef FFTW_PLAN_CACHING
+        .def("set_plan_rigor", &EMAN::EMfft::set_plan_rigor, args("rigor"), "Set the FFTW planning rigor for new plans: estimate, measure, patient or exhaustive.")
+        .staticmethod("set_plan_rigor")
+        .def("set_plan_cache_size", &EMAN::EMfft::set_plan_cache_size, args("n"), "Set the maximum number of cached FFTW plans, 0 for no limit.")
+        .staticmethod("set_plan_cache_size")
+#endif
+    ;
+#endif	//USE_FFTW3
+
     class_< EMAN::ImageSort >("ImageSort", init< const EMAN::ImageSort& >())
         .def(init< int >())
         .def("sort", &EMAN::ImageSort::sort)
@@ -383,6 +383,70 @@ class TestAligner(unittest.TestCase):
 		e.align('rtf_exhaustive', e2)
 		#self.run_rtf_aligner_test("rtf_exhaustive")
 		
+	def test_RT3DTreeAligner_threads(self):
+		"""test RT3DTreeAligner threads ....................."""
+		e = EMData()
+		e.set_size(48,48,48)
+		e.process_inplace('testimage.noise.uniform.rand')
+		
+		e2 = e.process('xform', {'transform':Transform({'type':'eman', 'az':30, 'alt':20, 'phi':10, 'tx':2})})
+		
+		# the search is merged in a fixed order, so the thread count must not change the answer
+		res = []
+		for threads in (1, 3):
+			a = e2.xform_align_nbest('rotate_translate_3d_tree', e, {'sym':'d2', 'threads':threads}, 2)
+			res.append([(d['score'], d['xform.align3d'].get_params('eman')) for d in a])
+		self.assertEqual(res[0], res[1])
+		
+	def test_RT3DTreeAligner_batch(self):
+		"""test RT3DTreeAligner xform_align_nbest_batch ......"""
+		e = EMData()
+		e.set_size(48,48,48)
+		e.process_inplace('testimage.noise.uniform.rand')
+		
+		ptcls = [e.process('xform', {'transform':Transform({'type':'eman', 'az':az, 'alt':20, 'phi':10, 'tx':2})}) for az in (30, 70)]
+		
+		# reusing the rotated reference between particles must not change the answers
+		for name in ('rotate_translate_3d_tree', 'rotate_translate_3d_local_tree'):
+			a = Aligners.get(name, {'sym':'d2'})
+			batch = a.xform_align_nbest_batch(ptcls, e, 2, '', {})
+			self.assertEqual(len(batch), len(ptcls))
+			for p, b in zip(ptcls, batch):
+				single = p.xform_align_nbest(name, e, {'sym':'d2'}, 2)
+				self.assertEqual([(d['score'], d['xform.align3d'].get_params('eman')) for d in single],
+					[(d['score'], d['xform.align3d'].get_params('eman')) for d in b])
+		
+	def test_align_batch(self):
+		"""test Aligner align_batch .........................."""
+		ptcls = []
+		for i in range(3):
+			e = EMData()
+			e.set_size(64,64,1)
+			e.process_inplace('testimage.noise.uniform.rand')
+			ptcls.append(e)
+		refs = [ptcls[0].process('xform', {'transform':Transform({'type':'2d', 'alpha':a, 'tx':3})}) for a in (20, 130)]
+		
+		# the score of a single alignment, as the batch computes it
+		def single_score(name, p, r, ali):
+			if name == 'rotate_translate_tree':
+				return p.xform_align_nbest(name, r, {}, 2, 'ccc', {})[0]['score']
+			if ali['xform.align2d'].get_mirror():
+				# compared to the flipped reference before the result is flipped back
+				return ali.process('xform.flip', {'axis':'x'}).cmp('ccc', r.process('xform.flip', {'axis':'x'}), {})
+			return ali.cmp('ccc', r, {})
+
+		# preparing the references once and spreading the particles over threads must not change the answers
+		for name in ('rotate_translate', 'rotate_translate_flip', 'rotate_translate_tree'):
+			a = Aligners.get(name, {'threads':2})
+			batch = a.align_batch(ptcls, refs, 'ccc', {})
+			self.assertEqual(len(batch), len(ptcls))
+			for p, row in zip(ptcls, batch):
+				self.assertEqual(len(row), len(refs))
+				for r, d in zip(refs, row):
+					ali = p.align(name, r, {}, 'ccc', {})
+					self.assertEqual(d['xform.align2d'].get_params('2d'), ali['xform.align2d'].get_params('2d'))
+					self.assertAlmostEqual(d['score'], single_score(name, p, r, ali), 5)
+		
 	def test_RefineAligner(self):
 		"""test RefineAligner ..............................."""
 		e = EMData()
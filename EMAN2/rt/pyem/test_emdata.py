@@ -718,6 +718,31 @@ class TestEMData(unittest.TestCase):
             except RuntimeError as runtime_err:
                 self.assertEqual(exception_type(runtime_err), "ImageFormatException")
     
+    def test_do_fft_batch(self):
+        """test do_fft_batch() function ......................"""
+        for nx in (32, 31):
+            imgs = []
+            for i in range(5):
+                e = EMData()
+                e.set_size(nx,24,1)
+                e.process_inplace("testimage.noise.uniform.rand")
+                imgs.append(e)
+            
+            ffts = EMData.do_fft_batch(imgs)
+            self.assertEqual(len(ffts), len(imgs))
+            for e, f in zip(imgs, ffts):
+                f2 = e.do_fft()
+                self.assertEqual(f.get_xsize(), f2.get_xsize())
+                self.assertEqual(f.is_fftodd(), f2.is_fftodd())
+                for x, y in zip(f.numpy().flatten(), f2.numpy().flatten()):
+                    self.assertAlmostEqual(x, y, 3)
+        
+        if(IS_TEST_EXCEPTION):
+            #all images must have the same size
+            e = EMData()
+            e.set_size(16,16,1)
+            self.assertRaises( RuntimeError, EMData.do_fft_batch, imgs + [e])
+    
     #for native FFT, this test will fail because the sign of the imaginary part
     def test_do_fft_complex_value(self):
         """test the complex image values after FFT .........."""
@@ -2313,6 +2338,26 @@ class TestEMData(unittest.TestCase):
         testlib.check_emdata(proj, sys.argv[0])
         testlib.safe_unlink(infile)
 
+    def test_projection_session(self):
+        """test ProjectionSession batch projection .........."""
+        n = 24
+        volume = test_image_3d(1, (n, n, n))
+        before = volume.copy()
+        xforms = [Transform({"type":"eman", "az":10.0*i, "alt":7.0*i, "phi":3.0*i}) for i in range(5)]
+        # gauss_fft modes 3 and up share the support table built when the volume is prepared, mode 5 also a kernel table
+        for name, opts in (("standard", {}), ("fourier_gridding", {}), ("gauss_fft", {"mode":2}), ("gauss_fft", {"mode":3}),
+                           ("gauss_fft", {"mode":5}), ("gauss_fft", {"mode":7})):
+            session = ProjectionSession(name, opts, volume)
+            projs = session.project(xforms, 3)
+            self.assertEqual(len(projs), len(xforms))
+            for t, p in zip(xforms, projs):
+                opts["transform"] = t
+                ref = volume.project(name, opts)
+                self.assertEqual(p.get_xsize(), ref.get_xsize())
+                self.assertAlmostEqual(p.cmp("sqeuclidean", ref), 0.0, places=4)
+            self.assertEqual(session.project(xforms[2]).get_ysize(), n)
+        self.assertEqual(volume.cmp("sqeuclidean", before), 0.0)
+
     def test_calc_highest_locations(self):
         """test calculation of highest location ............."""
         infile = "test_calc_highest_locations.mrc"
@@ -3130,6 +3175,102 @@ class TestEMData(unittest.TestCase):
         im = EMData.read_images(file1)
         
         testlib.safe_unlink(file1)
+
+    def test_ImageStackReader(self):
+        """test ImageStackReader ............................"""
+        file1 = 'stackreader_' + str(os.getpid()) + '.hdf'
+        imgs = []
+        for i in range(5):
+            e = EMData()
+            e.set_size(32,32,1)
+            e.process_inplace('testimage.noise.uniform.rand')
+            e.write_image(file1, i)
+            imgs.append(e)
+
+        # the file must not be read elsewhere while the reader is active, so compare with the written images
+        rdr = ImageStackReader(file1, [], 2)
+        self.assertEqual(rdr.get_count(), 5)
+        for i in range(5):
+            img = rdr.next()
+            self.assertTrue(img.equal(imgs[i]))
+            self.assertEqual(img["source_n"], i)
+        self.assertEqual(rdr.next(), None)
+        self.assertEqual(rdr.get_position(), 5)
+
+        rdr = ImageStackReader(file1, [3, 1])
+        for i in (3, 1):
+            img = rdr.next()
+            self.assertEqual(img["source_n"], i)
+            self.assertTrue(img.equal(imgs[i]))
+        self.assertEqual(rdr.next(), None)
+
+        self.assertRaises(RuntimeError, ImageStackReader, file1, [7])
+
+        testlib.safe_unlink(file1)
+
+    def test_ImageStackWriter(self):
+        """test ImageStackWriter and write_images ..........."""
+        file1 = 'stackwriter_' + str(os.getpid()) + '.hdf'
+        file2 = 'stackwriter_' + str(os.getpid()) + '.mrcs'
+        imgs = []
+        for i in range(9):
+            e = EMData()
+            e.set_size(32,32,1)
+            e.process_inplace('testimage.noise.uniform.rand')
+            imgs.append(e)
+
+        for f in (file1, file2):
+            wtr = ImageStackWriter(f, -1, 2)
+            for e in imgs[:4]:
+                wtr.write(e)
+            wtr.close()
+            self.assertEqual(wtr.get_count(), 4)
+            self.assertRaises(RuntimeError, wtr.write, imgs[0])
+
+            EMData.write_images(f, imgs[4:6], EMUtil.ImageType.IMAGE_UNKNOWN, False, None, EMUtil.EMDataType.EM_FLOAT, True, -1)
+            self.assertEqual(EMUtil.get_image_count(f), 6)
+            for i in range(6):
+                self.assertTrue(EMData(f, i).equal(imgs[i]))
+
+            # overwrite images in the middle of the existing stack
+            EMData.write_images(f, imgs[6:8], EMUtil.ImageType.IMAGE_UNKNOWN, False, None, EMUtil.EMDataType.EM_FLOAT, True, 2)
+            wtr = ImageStackWriter(f, 1, 2)
+            wtr.write(imgs[8])
+            wtr.close()
+            expect = [imgs[0], imgs[8], imgs[6], imgs[7], imgs[4], imgs[5]]
+            self.assertEqual(EMUtil.get_image_count(f), 6)
+            for i in range(6):
+                self.assertTrue(EMData(f, i).equal(expect[i]))
+            testlib.safe_unlink(f)
+
+    def test_read_binedimage(self):
+        """test read_binedimage() function .................."""
+        file1 = 'test_read_binedimage_' + str(os.getpid()) + '.mrc'
+        e = EMData()
+        e.set_size(32,24,16)
+        e.process_inplace('testimage.noise.uniform.rand')
+        e.write_image(file1)
+
+        b = EMData()
+        b.read_binedimage(file1, 0, 4)
+        self.assertEqual((b.get_xsize(), b.get_ysize(), b.get_zsize()), (8, 6, 4))
+        shrunk = e.process('math.meanshrink', {'n':4})
+        self.assertAlmostEqual(b.cmp('sqeuclidean', shrunk), 0.0, 5)
+
+        # Fourier binning, sampling every other slice (fast) or averaging slice pairs, against FourTruncate of each slice
+        for fast in (True, False):
+            f = EMData()
+            f.read_binedimage(file1, 0, 2, fast, False, True, 2)
+            self.assertEqual((f.get_xsize(), f.get_ysize(), f.get_zsize()), (16, 12, 8))
+            for z in range(8):
+                ref = e.get_clip(Region(0, 0, 2*z, 32, 24, 1)).FourTruncate(16, 12, 1, True, False)
+                if not fast:
+                    ref.add(e.get_clip(Region(0, 0, 2*z+1, 32, 24, 1)).FourTruncate(16, 12, 1, True, False))
+                    ref.mult(0.5)
+                got = f.get_clip(Region(0, 0, z, 16, 12, 1))
+                self.assertAlmostEqual(got.cmp('sqeuclidean', ref), 0.0, 5)
+
+        testlib.safe_unlink(file1)
         
         #no such function in EMAN2 any more 
     def no_test_rot_trans2D(self):
@@ -3486,6 +3627,44 @@ class TestEMData(unittest.TestCase):
         self.assertEqual(q.to_dict(), q2.to_dict())
         if platform.system() != "Windows":
             testlib.safe_unlink('mydb2')
+
+    def test_eman2ctf_compute_2d_complex_multi(self):
+        """test EMAN2Ctf.compute_2d_complex_multi ..........."""
+        ctf = EMAN2Ctf()
+        ctf.from_dict({"defocus":1.5, "dfdiff":0.2, "dfang":30.0, "bfactor":50.0, "ampcont":10.0,
+                       "voltage":300.0, "cs":2.7, "apix":1.5, "dsbg":1.0/(1.5*64)})
+        ctf.snr = [1.0/(i+1) for i in range(64)]
+        ctf.background = [1.0+i*0.01 for i in range(64)]
+        types = [Ctf.CtfType.CTF_AMP, Ctf.CtfType.CTF_SNR, Ctf.CtfType.CTF_TOTAL, Ctf.CtfType.CTF_SIGN]
+        for size in (64, 65):
+            fft = test_image(0, (size, size)).do_fft()
+            multi = [fft.copy() for t in types]
+            ctf.compute_2d_complex_multi(multi, types)
+            for t, m in zip(types, multi):
+                single = fft.copy()
+                ctf.compute_2d_complex(single, t)
+                self.assertAlmostEqual(m.cmp("sqeuclidean", single), 0.0, places=6)
+
+            # CTF_AMP against a direct per pixel evaluation of cos(gamma - acac) * envelope
+            amp = multi[0]
+            ds = 1.0 / (1.5 * size)
+            lam = 12.2639 / math.sqrt(300.0 * 1000.0 + 0.97845 * 300.0 * 300.0)
+            g1 = math.pi / 2.0 * 2.7 * 1.0e7 * lam**3
+            g2 = math.pi * lam * 10000.0
+            acac = math.pi / 2.0 - ctf.get_phase()
+            nx = amp.get_xsize()
+            for y in range(-(size//2), size//2):
+                y2 = (y + size) % size
+                for x in range(nx//2):
+                    s = math.hypot(x, y) * ds
+                    df = 1.5 + 0.2 / 2.0 * math.cos(2.0 * math.atan2(y, x) - 2.0 * math.pi / 180.0 * 30.0)
+                    gam = -g1 * s**4 + g2 * df * s * s
+                    v = math.cos(gam - acac) * math.exp(-(50.0 / 4.0 * s * s))
+                    self.assertAlmostEqual(amp.get_value_at(2*x, y2), v, places=3)
+                    self.assertEqual(amp.get_value_at(2*x+1, y2), 0)
+            # the row an odd size leaves out keeps the to_one() initialisation
+            if size % 2 == 1:
+                self.assertEqual(amp.get_value_at(0, size//2), 1.0)
         
     def test_transform_pickling(self):
         """test Transform pickle as attribute ..............."""
@@ -42,6 +42,9 @@ import platform
 from optparse import OptionParser
 from EMAN2 import remove_file
 from testlib import exception_type
+import numpy
+import random
+import struct
 
 IS_TEST_EXCEPTION = False
 
@@ -231,7 +234,163 @@ class TestTIFFIO(ImageIOTester):
 	def test_read_write_tiff(self):
 		"""test write-read tiff ............................."""
 		self.do_test_read_write("tiff")  
-		
+
+	def test_tiff_frame_sums(self):
+		"""test frame group sums of a multi-frame tiff ......"""
+		filename = 'test_tiff_frame_sums_%d.tif' % os.getpid()
+		rnd = numpy.random.RandomState(20)
+		for dtype in (numpy.uint8, numpy.uint16, numpy.float32):
+			frames = [numpy.floor(rnd.rand(20, 24) * 200).astype(dtype) for i in range(8)]
+			write_tiff_frames(filename, frames, 6)
+			try:
+				self.assertEqual(EMUtil.get_image_count(filename), 8)
+				single = [EMData(filename, i) for i in range(8)]
+				# rows are stored top down, EMAN images bottom up
+				self.assertTrue(numpy.array_equal(single[3].numpy(), numpy.flipud(frames[3]).astype(numpy.float32)))
+
+				for nthreads in (1, 2, 4):
+					sums = EMData.read_frame_sums(filename, 1, 7, 3, nthreads)
+					self.assertEqual(len(sums), 3)
+					for s, group in zip(sums, (single[1:4], single[4:7], single[7:8])):
+						total = group[0].copy()
+						for e in group[1:]: total.add(e)
+						self.assertTrue(numpy.array_equal(s.numpy(), total.numpy()))
+			finally:
+				testlib.safe_unlink(filename)
+		
+def write_tiff_frames(filename, frames, rows_per_strip):
+	"""write numpy arrays as the uncompressed greyscale frames of a little
+	endian TIFF, in strips of rows_per_strip rows"""
+	sample_format = {'u': 1, 'i': 2, 'f': 3}
+	out = bytearray(b'II*\x00\x00\x00\x00\x00')
+	prev = 4
+	for a in frames:
+		ny, nx = a.shape
+		raw = a.astype(a.dtype.newbyteorder('<')).tobytes()
+		rowlen = nx * a.dtype.itemsize
+		offsets, counts = [], []
+		for y in range(0, ny, rows_per_strip):
+			strip = raw[y * rowlen:min(y + rows_per_strip, ny) * rowlen]
+			offsets.append(len(out))
+			counts.append(len(strip))
+			out += strip + b'\x00' * (len(strip) % 2)
+		arrays = len(out)
+		out += struct.pack('<%dI' % len(offsets), *offsets) + struct.pack('<%dI' % len(counts), *counts)
+		tags = [(256, 4, 1, nx), (257, 4, 1, ny), (258, 3, 1, a.dtype.itemsize * 8), (259, 3, 1, 1),
+			(262, 3, 1, 1), (273, 4, len(offsets), arrays if len(offsets) > 1 else offsets[0]),
+			(277, 3, 1, 1), (278, 4, 1, rows_per_strip),
+			(279, 4, len(counts), arrays + 4 * len(offsets) if len(counts) > 1 else counts[0]),
+			(284, 3, 1, 1), (339, 3, 1, sample_format[a.dtype.kind])]
+		struct.pack_into('<I', out, prev, len(out))
+		out += struct.pack('<H', len(tags))
+		for tag, typ, count, value in tags:
+			if typ == 3 and count == 1: out += struct.pack('<HHIHH', tag, typ, count, value, 0)
+			else: out += struct.pack('<HHII', tag, typ, count, value)
+		prev = len(out)
+		out += b'\x00\x00\x00\x00'
+	with open(filename, 'wb') as f: f.write(out)
+
+def write_eer(filename, frames, metadata=b'<metadata><item name="sensorPixelSize">5e-11</item></metadata>'):
+	"""write a minimal EER movie, one strip per frame of 7 bit run lengths
+	and 4 bit sub-pixel positions. frames is a list of lists of
+	(y*4096+x, subpix) electron events in increasing pixel order"""
+	end = 4096 * 4096
+	strips = []
+	for events in frames:
+		bits = []
+		def put(v, n):
+			for b in range(n): bits.append((v >> b) & 1)
+		def put_rle(v):
+			while v >= 127:
+				put(127, 7)
+				v -= 127
+			put(v, 7)
+		last = -1
+		for pix, sub in events + [(end, 0)]:
+			put_rle(pix - last - 1)
+			put(sub, 4)
+			last = pix
+		bits += [0] * (-len(bits) % 8)
+		strips.append(bytes(sum(bits[i + j] << j for j in range(8)) for i in range(0, len(bits), 8)))
+
+	# little endian classic TIFF: header, then per frame the strip and its directory
+	out = bytearray(b'II*\x00\x00\x00\x00\x00')
+	prev = 4
+	for i, strip in enumerate(strips):
+		if i == 0:
+			meta_off = len(out)
+			out += metadata + b'\x00' * (len(metadata) % 2)
+		strip_off = len(out)
+		out += strip + b'\x00' * (len(strip) % 2)
+		tags = [(256, 4, 1, 4096), (257, 4, 1, 4096), (258, 3, 1, 1), (259, 3, 1, 65001),
+			(262, 3, 1, 1), (273, 4, 1, strip_off), (277, 3, 1, 1), (278, 4, 1, 4096),
+			(279, 4, 1, len(strip))]
+		if i == 0: tags.append((65001, 7, len(metadata), meta_off))
+		struct.pack_into('<I', out, prev, len(out))
+		out += struct.pack('<H', len(tags))
+		for tag, typ, count, value in tags:
+			if typ == 3: out += struct.pack('<HHIHH', tag, typ, count, value, 0)
+			else: out += struct.pack('<HHII', tag, typ, count, value)
+		prev = len(out)
+		out += b'\x00\x00\x00\x00'
+	with open(filename, 'wb') as f: f.write(out)
+
+class TestEerIO(unittest.TestCase):
+	"""EER file IO test"""
+
+	def setUp(self):
+		self.filename = 'test_eer_%d.eer' % os.getpid()
+		rnd = random.Random(14)
+		self.frames = []
+		for i in range(6):
+			pix = sorted(rnd.sample(range(4096 * 4096 - 1), 40)) + [4096 * 4096 - 1]
+			self.frames.append([(p, rnd.randrange(16)) for p in pix])
+		self.frames[2] = []
+		write_eer(self.filename, self.frames)
+
+	def tearDown(self):
+		testlib.safe_unlink(self.filename)
+
+	def counts(self, frames):
+		a = numpy.zeros(4096 * 4096, numpy.float32)
+		for events in frames:
+			for pix, sub in events: a[pix] += 1
+		return a.reshape(4096, 4096)
+
+	def test_eer_read_frames(self):
+		"""test decoding single eer frames .................."""
+		self.assertEqual(EMUtil.get_image_count(self.filename), len(self.frames))
+		for i, events in enumerate(self.frames):
+			e = EMData(self.filename, i)
+			self.assertEqual((e['nx'], e['ny'], e['nz']), (4096, 4096, 1))
+			self.assertEqual(e['EER.sensor_pixel_size'], '5e-11')
+			self.assertTrue(numpy.array_equal(e.numpy(), self.counts([events])))
+
+	def test_eer_frame_sum(self):
+		"""test summing groups of eer frames ................"""
+		for nthreads in (1, 3, 0):
+			s = EMData()
+			s.read_frame_sum(self.filename, 1, 5, nthreads)
+			self.assertTrue(numpy.array_equal(s.numpy(), self.counts(self.frames[1:6])))
+
+		s = EMData()
+		self.assertRaises(RuntimeError, s.read_frame_sum, self.filename, 3, 4)
+
+	def test_eer_fixture(self):
+		"""test a recorded eer movie ........................"""
+		fixture = os.environ.get('EMAN2_TEST_EER')
+		if not fixture or not os.path.isfile(fixture):
+			self.skipTest('set EMAN2_TEST_EER to a recorded .eer movie')
+
+		n = min(EMUtil.get_image_count(fixture), 8)
+		total = EMData(fixture, 0)
+		for i in range(1, n):
+			total.add(EMData(fixture, i))
+
+		s = EMData()
+		s.read_frame_sum(fixture, 0, n, 4)
+		self.assertTrue(numpy.array_equal(s.numpy(), total.numpy()))
+
 class TestVTKIO(ImageIOTester):
 	"""VTK file IO test"""
 
@@ -549,6 +708,60 @@ class TestHdfIO(ImageIOTester):
 		#self.assertAlmostEquals(d2, (5.5,6.6,7.7), 3)
 		os.unlink(hdffile)	
 
+	def test_hdf_packed_stack(self):
+		"""test packed hdf particle stack ..................."""
+		hdffile = 'test_packed_stack.hdf'
+		n = 5
+		imgs = []
+		for i in range(n):
+			e = EMData(16, 16)
+			e.process_inplace('testimage.noise.uniform.rand')
+			e.set_attr('xform.projection', Transform({"type":"eman", "az":10.0*i, "alt":5.0, "phi":1.0}))
+			ctf = EMAN2Ctf()
+			ctf.from_vector((1.0+i, 0.1, 30.0, 50.0, 10.0, 300.0, 2.7, 1.5, 0.5, 0, 0))
+			e.set_attr('ctf', ctf)
+			e.set_attr('class_id', i % 2)
+			e.set_attr('score', -0.5*i)
+			e.set_attr('ptcl_note', 'p%d' % i)
+			if i == 0:
+				e.set_attr('hdf_packed', 1)
+			e.write_image(hdffile, i)
+			imgs.append(e)
+
+		self.assertEqual(EMUtil.get_image_count(hdffile), n)
+		stack = EMData.read_images(hdffile)
+		for i in range(n):
+			e = EMData(hdffile, i)
+			for d in (e, stack[i]):
+				self.assertEqual(d.get_xsize(), 16)
+				self.assertAlmostEqual(d.cmp('sqeuclidean', imgs[i]), 0.0, 5)
+				self.assertEqual(d['class_id'], i % 2)
+				self.assertAlmostEqual(d['score'], -0.5*i, 5)
+				self.assertEqual(d['ptcl_note'], 'p%d' % i)
+				self.assertAlmostEqual(d['ctf'].defocus, 1.0+i, 5)
+				self.assertAlmostEqual(d['xform.projection'].get_rotation("eman")["az"], 10.0*i, 3)
+		testlib.safe_unlink(hdffile)
+
+	def test_hdf_chunked_region(self):
+		"""test region read of chunked compressed hdf ......."""
+		hdffile = 'test_chunked.hdf'
+		for mode in ('brick', 'slice'):
+			e = EMData(40, 36, 30)
+			e.process_inplace('testimage.noise.uniform.rand')
+			e.set_attr('render_bits', 0)
+			e.set_attr('hdf_chunk', mode)
+			e.set_attr('hdf_chunk_size', 16)
+			e.write_image(hdffile, 0, EMUtil.ImageType.IMAGE_HDF, False, None, EMUtil.EMDataType.EM_COMPRESSED)
+
+			full = EMData(hdffile, 0)
+			self.assertAlmostEqual(full.cmp('sqeuclidean', e), 0.0, 5)
+			r = EMData()
+			r.read_image(hdffile, 0, False, Region(5, 7, 9, 20, 18, 12))
+			clip = e.get_clip(Region(5, 7, 9, 20, 18, 12))
+			self.assertEqual(r.get_zsize(), 12)
+			self.assertAlmostEqual(r.cmp('sqeuclidean', clip), 0.0, 5)
+			testlib.safe_unlink(hdffile)
+
 	def test_hdf_attr_boolean(self):
 		"""test hdf file boolean attribute .................."""
 		hdffile = 'testfile.hdf'
@@ -689,6 +902,194 @@ class TestHdfIO(ImageIOTester):
 			self.assertEqual(1, f[i])
 		testlib.safe_unlink(file)
 
+	def test_hdf_cache_mode_switch(self):
+		"""test cached HDF5 handles across open modes ......."""
+		file = 'cache_mode_switch.hdf'
+		imgs = []
+		for i in range(4):
+			e = EMData(8,8)
+			e.to_value(float(i+1))
+			imgs.append(e)
+
+		# read-write handles stay idle in the cache, and also serve readers
+		for i in range(3):
+			imgs[i].write_image(file, i)
+		self.assertEqual(EMUtil.get_image_count(file), 3)
+
+		# write-only beside the idle read-write handle, which must be closed first
+		EMData.write_images(file, imgs[2:], EMUtil.ImageType.IMAGE_UNKNOWN, False, None, EMUtil.EMDataType.EM_FLOAT, True, 0)
+		# read-only after write-only, then read-write after read-only
+		self.assertEqual(EMUtil.get_image_count(file), 3)
+		self.assertTrue(EMData(file, 0).equal(imgs[2]))
+		imgs[0].write_image(file, -1)
+		self.assertEqual(EMUtil.get_image_count(file), 4)
+		for i, j in enumerate((2, 3, 2, 0)):
+			self.assertTrue(EMData(file, i).equal(imgs[j]))
+		testlib.safe_unlink(file)
+
+class TestLstIO(unittest.TestCase):
+	"""LST and LSX file IO test"""
+
+	def setUp(self):
+		self.prefix = 'test_lst_%d_' % os.getpid()
+		self.files = []
+
+	def tearDown(self):
+		for f in self.files:
+			testlib.safe_unlink(f)
+
+	def make_stacks(self, nstacks, nimg=4):
+		"""stack s image i has class_id 10*s+i and a constant value of the same"""
+		stacks = []
+		for s in range(nstacks):
+			name = '%sstack%d.hdf' % (self.prefix, s)
+			for i in range(nimg):
+				e = EMData(8, 8)
+				e.to_value(10 * s + i)
+				e.set_attr('class_id', 10 * s + i)
+				e.write_image(name, i)
+			stacks.append(name)
+		self.files.extend(stacks)
+		return stacks
+
+	def write_lst(self, name, lines, eol='\n'):
+		"""an old style .lst file, read through LstIO"""
+		with open(name, 'w', newline='') as f:
+			f.write('#LST' + eol)
+			for n, path in lines:
+				f.write('%d\t%s%s' % (n, path, eol))
+		self.files.extend([name, name + '.idx'])
+
+	def test_lsx_overrides(self):
+		"""test lsx reads with line overrides ..............."""
+		stacks = self.make_stacks(3)
+		lsxfile = self.prefix + 'over.lst'
+		self.files.extend([lsxfile, lsxfile + '.idx'])
+
+		n = 1200
+		lsx = LSXFile(lsxfile)
+		for i in range(n):
+			if i % 2: lsx.write(-1, i % 4, stacks[i % 3], {"class_id": 1000 + i})
+			else: lsx.write(-1, i % 4, stacks[i % 3])
+		lsx = None
+
+		ids = EMUtil.read_header_column(lsxfile, 'class_id')
+		src = EMUtil.read_header_column(lsxfile, 'data_source', [5, 7])
+		self.assertEqual(ids, [1000 + i if i % 2 else 10 * (i % 3) + i % 4 for i in range(n)])
+		self.assertEqual(src, [stacks[2], stacks[1]])
+
+		for i in (0, 1, 2, 3, 1198, 1199):
+			e = EMData(lsxfile, i)
+			self.assertEqual(e['class_id'], 1000 + i if i % 2 else 10 * (i % 3) + i % 4)
+			self.assertEqual(e['data_source'], stacks[i % 3])
+			self.assertEqual(e['data_n'], i % 4)
+			self.assertEqual(e['maximum'], 10 * (i % 3) + i % 4)
+
+		# LSX lines are found from the line length, nothing is written beside the file
+		self.assertFalse(os.path.isfile(lsxfile + '.idx'))
+
+	def test_lsx_rewrite(self):
+		"""test lsx reads after a line is rewritten ........."""
+		stacks = self.make_stacks(2)
+		lsxfile = self.prefix + 'rewrite.lst'
+		self.files.append(lsxfile)
+
+		lsx = LSXFile(lsxfile)
+		for i in range(20):
+			lsx.write(-1, i % 4, stacks[0], {"class_id": 500 + i})
+		lsx = None
+		self.assertEqual(EMData(lsxfile, 7, True)['class_id'], 507)
+
+		lsx = LSXFile(lsxfile)
+		lsx.write(7, 2, stacks[1], {"class_id": 777})
+		lsx.write(8, 3, stacks[1])
+		lsx = None
+
+		e = EMData(lsxfile, 7)
+		self.assertEqual((e['class_id'], e['data_source'], e['data_n']), (777, stacks[1], 2))
+		self.assertEqual(e['maximum'], 12)
+		self.assertEqual(EMUtil.read_header_column(lsxfile, 'class_id', [6, 7, 8]), [506, 777, 13])
+
+	def test_lst_read(self):
+		"""test reading an old style lst file ..............."""
+		stacks = self.make_stacks(2)
+		lstfile = self.prefix + 'old.lst'
+		for eol in ('\n', '\r\n'):
+			self.write_lst(lstfile, [(3, stacks[0]), (1, stacks[1]), (0, stacks[1])], eol)
+			self.assertEqual(EMUtil.get_image_count(lstfile), 3)
+			e = EMData(lstfile, 1)
+			self.assertEqual((e['class_id'], e['source_path']), (11, stacks[1]))
+			self.assertEqual(e['maximum'], 11)
+			self.assertEqual(EMUtil.read_header_column(lstfile, 'class_id'), [3, 11, 10])
+
+	def test_lst_stale_sidecar(self):
+		"""test a lst sidecar index goes stale on rewrite ..."""
+		stacks = self.make_stacks(2)
+		lstfile = self.prefix + 'stale.lst'
+		n = 1200
+		lines = [(i % 4, stacks[i % 2]) for i in range(n)]
+		self.write_lst(lstfile, lines)
+		expect = [10 * (i % 2) + i % 4 for i in range(n)]
+		self.assertEqual(EMUtil.read_header_column(lstfile, 'class_id'), expect)
+		self.assertTrue(os.path.isfile(lstfile + '.idx'))
+
+		# rewrite the last line in place, with the same length and modification time
+		st = os.stat(lstfile)
+		with open(lstfile, 'r+') as f:
+			f.seek(st.st_size - len(stacks[1]) - 3)
+			f.write('%d\t%s\n' % (2, stacks[0]))
+		os.utime(lstfile, ns=(st.st_atime_ns, st.st_mtime_ns))
+		self.assertEqual(os.stat(lstfile).st_size, st.st_size)
+		expect[-1] = 2
+		self.assertEqual(EMUtil.read_header_column(lstfile, 'class_id'), expect)
+
+		# and a line in the middle, which changes the modification time
+		lines[600] = (1, stacks[1])
+		self.write_lst(lstfile, lines)
+		expect[600] = 11
+		self.assertEqual(EMUtil.read_header_column(lstfile, 'class_id'), expect)
+		self.assertEqual(EMData(lstfile, 600, True)['class_id'], 11)
+
+	def test_lst_many_files(self):
+		"""test lst reads across more files than stay open .."""
+		stacks = self.make_stacks(11, 2)
+		lstfile = self.prefix + 'many.lst'
+		lsxfile = self.prefix + 'many.lsx'
+		self.files.append(lsxfile)
+		lines = [(i % 2, stacks[(i * 7) % 11]) for i in range(50)]
+		self.write_lst(lstfile, lines)
+		lsx = LSXFile(lsxfile)
+		for n, path in lines:
+			lsx.write(-1, n, path)
+		lsx = None
+
+		expect = [10 * ((i * 7) % 11) + i % 2 for i in range(50)]
+		for f in (lstfile, lsxfile):
+			for rep in range(2):
+				for i in range(50):
+					e = EMData(f, i)
+					self.assertEqual(e['class_id'], expect[i])
+					self.assertEqual(e['maximum'], expect[i])
+			self.assertEqual(EMUtil.read_header_column(f, 'class_id'), expect)
+			imgs = EMData.read_images(f)
+			self.assertEqual([e['class_id'] for e in imgs], expect)
+
+	def test_lst_frame_sums(self):
+		"""test frame sums of a lsx list of hdf images ......"""
+		stacks = self.make_stacks(3)
+		lsxfile = self.prefix + 'frames.lst'
+		self.files.append(lsxfile)
+		lsx = LSXFile(lsxfile)
+		for i in range(12):
+			lsx.write(-1, i % 4, stacks[i % 3])
+		lsx = None
+
+		# the HDF images behind the list are summed on one thread whatever is asked
+		for nthreads in (1, 4):
+			sums = EMData.read_frame_sums(lsxfile, 0, 12, 5, nthreads)
+			self.assertEqual([s['maximum'] for s in sums],
+				[sum(10 * (i % 3) + i % 4 for i in range(g, min(g + 5, 12))) for g in (0, 5, 10)])
+
 class TestMrcIO(ImageIOTester):
 	"""mrc file IO test"""
 	def test_negative_image_index(self):
@@ -785,6 +1186,100 @@ class TestMrcIO(ImageIOTester):
 		os.unlink(imgfile2)
    
 	test_complex_image.broken = True
+
+	def test_mrcs_stack_read(self):
+		"""test whole-image mrcs stack reads ................"""
+		filename = "test_mrcs_stack_read_" + str(os.getpid()) + ".mrcs"
+		imgs = []
+		for i in range(4):
+			e = EMData()
+			e.set_size(32,32)
+			e.process_inplace('testimage.noise.uniform.rand')
+			e.write_image(filename, i)
+			imgs.append(e)
+
+		# whole images may come from a memory mapping, regions always use stdio
+		for i in range(4):
+			e = EMData(filename, i)
+			r = EMData()
+			r.read_image(filename, i, False, Region(0,0,32,32))
+			self.assertTrue(e.equal(imgs[i]))
+			self.assertTrue(e.equal(r))
+
+		os.unlink(filename)
+
+	def test_mrcs_stack_read_int(self):
+		"""test whole-image integer mrcs stack reads ........"""
+		# modes 0, 17, 1 and 6 are converted straight from the mapping, compare with the stdio region path
+		for dtype in (EMUtil.EMDataType.EM_UCHAR, EMUtil.EMDataType.EM_CHAR, EMUtil.EMDataType.EM_SHORT, EMUtil.EMDataType.EM_USHORT):
+			filename = "test_mrcs_stack_read_int_" + str(os.getpid()) + ".mrcs"
+			imgs = []
+			for i in range(3):
+				e = EMData()
+				e.set_size(32,32)
+				e.process_inplace('testimage.noise.uniform.rand')
+				e.write_image(filename, i, EMUtil.ImageType.IMAGE_MRC, False, None, dtype)
+				imgs.append(e)
+
+			for i in range(3):
+				e = EMData(filename, i)
+				r = EMData()
+				r.read_image(filename, i, False, Region(0,0,32,32))
+				self.assertEqual(e["datatype"], dtype)
+				self.assertTrue(e.equal(r))
+				# the integer values are a linear rescaling of the written image
+				self.assertLess(e.cmp("ccc", imgs[i]), -0.99)
+
+			os.unlink(filename)
+
+	def test_mrcs_frame_sum(self):
+		"""test summing a group of mrcs frames .............."""
+		filename = "test_mrcs_frame_sum_" + str(os.getpid()) + ".mrcs"
+		total = EMData(32,32)
+		total.to_zero()
+		for i in range(5):
+			e = EMData(32,32)
+			e.process_inplace('testimage.noise.uniform.rand')
+			e.write_image(filename, i)
+			if i >= 1: total.add(e)
+
+		s = EMData()
+		s.read_frame_sum(filename, 1, 4)
+		self.assertAlmostEqual(s.cmp('sqeuclidean', total), 0.0, 5)
+		self.assertRaises(RuntimeError, s.read_frame_sum, filename, 2, 4)
+
+		os.unlink(filename)
+
+	def test_mrcs_frame_sums(self):
+		"""test threaded frame group sums with a gain ......."""
+		filename = "test_mrcs_frame_sums_" + str(os.getpid()) + ".mrcs"
+		frames = []
+		for i in range(7):
+			e = EMData(32,32)
+			e.process_inplace('testimage.noise.uniform.rand')
+			e.write_image(filename, i)
+			frames.append(e)
+		gain = EMData(32,32)
+		gain.process_inplace('testimage.noise.uniform.rand')
+		gain.set_value_at(3, 5, 0.0)
+
+		sums = EMData.read_frame_sums(filename, 1, 6, 4, 3, IMAGE_UNKNOWN, gain)
+		self.assertEqual(len(sums), 2)
+		for s, group in zip(sums, (frames[1:5], frames[5:7])):
+			total = EMData(32,32)
+			total.to_zero()
+			for e in group: total.add(e)
+			total.mult(gain)
+			self.assertAlmostEqual(s.cmp('sqeuclidean', total), 0.0, 5)
+			self.assertEqual(s.get_value_at(3, 5), 0.0)
+
+		s = EMData()
+		s.read_frame_sum(filename, 1, 4, 2, IMAGE_UNKNOWN, gain)
+		self.assertAlmostEqual(s.cmp('sqeuclidean', sums[0]), 0.0, 5)
+		self.assertRaises(RuntimeError, EMData.read_frame_sums, filename, 0, 7, 0)
+		self.assertRaises(RuntimeError, EMData.read_frame_sums, filename, 0, 7, 1, 2, IMAGE_UNKNOWN, EMData(16,16))
+
+		os.unlink(filename)
 	
 	def test_mrcio_label(self):
 		"""test mrc file label .............................."""
@@ -1491,6 +1986,12 @@ def test_main():
 	
 	suite14 = unittest.TestLoader().loadTestsFromTestCase(TestDF3IO)	
 	unittest.TextTestRunner(verbosity=2).run(suite14) 
+
+	suite15 = unittest.TestLoader().loadTestsFromTestCase(TestEerIO)
+	unittest.TextTestRunner(verbosity=2).run(suite15)
+
+	suite16 = unittest.TestLoader().loadTestsFromTestCase(TestLstIO)
+	unittest.TextTestRunner(verbosity=2).run(suite16)
 	
 if __name__ == '__main__':
 	test_main()
@@ -1563,6 +1563,80 @@ class TestProcessor(unittest.TestCase):
             except RuntimeError as runtime_err:
                 self.assertEqual(exception_type(runtime_err), "ImageFormatException")
     
+    def test_xform_interp(self):
+        """test xform real space paths ......................"""
+        e = EMData()
+        e.set_size(48,40,36)
+        e.process_inplace('testimage.noise.uniform.rand')
+
+        # whole pixel moves are exact
+        t = Transform({'type':'eman', 'tx':3.0, 'ty':-2.0, 'tz':1.0})
+        e2 = e.process('xform', {'transform':t})
+        self.assertEqual(e2.get_value_at(10,10,10), e.get_value_at(7,12,9))
+        self.assertEqual(e2.get_value_at(1,20,20), 0)
+        t = Transform({'type':'eman', 'az':90.0})
+        e2 = e.copy()
+        for i in range(4):
+            e2.process_inplace('xform', {'transform':t})
+        self.assertEqual(e2.get_value_at(24,20,18), e.get_value_at(24,20,18))
+
+        # threading doesn't change the result
+        t = Transform({'type':'eman', 'az':23.0, 'alt':41.0, 'phi':-70.0, 'tx':1.5})
+        for interp in ('linear', 'bspline', 'sinc'):
+            e1 = e.process('xform', {'transform':t, 'interp':interp, 'nthreads':1})
+            e3 = e.process('xform', {'transform':t, 'interp':interp, 'nthreads':3})
+            self.assertTrue(e1.equal(e3))
+
+        # a subpixel shift of a smooth image and back returns close to the original
+        g = EMData(48,40,36)
+        g.process_inplace('testimage.gaussian', {'sigma':4.0})
+        peak = g['maximum']
+        t = Transform({'type':'eman', 'tx':0.4, 'ty':-0.3, 'tz':0.25})
+        err = {}
+        for interp in ('linear', 'bspline', 'sinc'):
+            b = g.process('xform', {'transform':t, 'interp':interp}).process('xform', {'transform':t.inverse(), 'interp':interp})
+            b.sub(g)
+            err[interp] = max(b['maximum'], -b['minimum']) / peak
+        self.assertLess(err['linear'], 0.1)
+        self.assertLess(err['bspline'], 0.005)
+        self.assertLess(err['sinc'], 0.005)
+
+        self.assertRaises(RuntimeError, e.process, 'xform', {'transform':t, 'interp':'cubic'})
+
+    def test_xform_interp_2d(self):
+        """test xform real space paths on 2D images ........."""
+        nx, ny = 40, 36
+        e = EMData(nx,ny)
+        e.process_inplace('testimage.noise.uniform.rand')
+
+        # linear interpolation gives what the bilinear code it replaced gave
+        t = Transform({'type':'2d', 'alpha':23.0, 'tx':1.3, 'ty':-0.7})
+        inv = t.inverse()
+        e2 = e.process('xform', {'transform':t})
+        for j in range(ny):
+            for i in range(nx):
+                v = inv.transform(float(i-nx//2), float(j-ny//2))
+                x, y = v[0]+nx//2, v[1]+ny//2
+                if x < 0 or x >= nx or y < 0 or y >= ny:
+                    self.assertEqual(e2.get_value_at(i,j), 0)
+                    continue
+                ii, jj = int(x), int(y)
+                i1, j1 = min(ii+1,nx-1), min(jj+1,ny-1)
+                tx, ty = x-ii, y-jj
+                a = e.get_value_at(ii,jj)*(1-tx) + e.get_value_at(i1,jj)*tx
+                b = e.get_value_at(ii,j1)*(1-tx) + e.get_value_at(i1,j1)*tx
+                self.assertAlmostEqual(e2.get_value_at(i,j), a*(1-ty) + b*ty, 4)
+
+        # a shift just over the whole pixel tolerance interpolates, and the B-spline
+        # reproduces the samples up to the edges
+        t = Transform({'type':'2d', 'tx':0.02/nx})
+        for interp in ('linear', 'bspline', 'sinc'):
+            e2 = e.process('xform', {'transform':t, 'interp':interp})
+            self.assertEqual(e2.get_value_at(0,10), 0)
+            for j in range(ny):
+                for i in range(1,nx):
+                    self.assertAlmostEqual(e2.get_value_at(i,j), e.get_value_at(i,j), 2)
+
     def test_xform_fourierorigin(self):
         """test xform.fourierorigin processor ..............."""
         e = EMData()
@@ -2036,6 +2110,31 @@ class TestProcessor(unittest.TestCase):
             except RuntimeError as runtime_err:
                 self.assertEqual(exception_type(runtime_err), "ImageFormatException")
 
+    def test_processor_chain(self):
+        """test ProcessorChain against single processors ...."""
+        steps = [('normalize', {}),
+                 ('filter.highpass.gauss', {'cutoff_pixels':2}),
+                 ('filter.linearfourier', {}),
+                 ('filter.linearfourier', {}),
+                 ('filter.lowpass.gauss', {'cutoff_abs':0.2}),
+                 ('mask.soft', {'outer_radius':24, 'width':3}),
+                 ('normalize', {})]
+        chain = ProcessorChain()
+        for name, params in steps:
+            chain.add(name, params)
+        self.assertEqual(chain.size(), len(steps))
+
+        for i in range(2):
+            e = EMData()
+            e.set_size(64,64,1)
+            e.process_inplace('testimage.noise.uniform.rand')
+            e2 = chain.process(e)
+            for name, params in steps:
+                e.process_inplace(name, params)
+            self.assertAlmostEqual(e2.cmp('sqeuclidean', e), 0.0, 3)
+
+        self.assertRaises(RuntimeError, chain.add, 'filter.nosuchfilter')
+
 def test_main():
     p = OptionParser()
     p.add_option('--t', action='store_true', help='test exception', default=False )
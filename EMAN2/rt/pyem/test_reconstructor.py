@@ -115,6 +115,34 @@ class TestReconstructor(unittest.TestCase):
 		result = r.finish(True)
 		
 		testlib.safe_unlink('density.mrc')
+
+	def test_FourierReconstructor_threads(self):
+		"""test FourierReconstructor threaded insertion ....."""
+		n = 32
+		imgs = []
+		for i in range(3):
+			e = EMData()
+			e.set_size(n,n,1)
+			e.process_inplace('testimage.noise.uniform.rand')
+			imgs.append(e)
+
+		def reconstruct(threads, accumvols):
+			r = Reconstructors.get('fourier', {'size':(n,n,n), 'mode':'gauss_2', 'sym':'d2', 'quiet':True, 'threads':threads, 'accumvols':accumvols})
+			r.setup()
+			for i,e in enumerate(imgs):
+				r.insert_slice(e, Transform({'type':'eman', 'alt':1.56+i, 'az':2.56+i, 'phi':3.56+i}), 1.0)
+			return r.finish(True)
+
+		results = [reconstruct(threads, 4) for threads in (1,2,4)]
+
+		# the result may depend on accumvols, but never on the number of threads
+		for result in results[1:]:
+			self.assertEqual(results[0].numpy().tolist(), result.numpy().tolist())
+
+		# and the private volumes only change the summation order of the serial reconstruction
+		serial = reconstruct(1, 1)
+		a, b = serial.numpy(), results[2].numpy()
+		self.assertTrue(numpy.allclose(a, b, rtol=1e-4, atol=1e-5*numpy.abs(a).max()))
 	
 	def no_test_WienerFourierReconstructor(self):
 		"""test WienerFourierReconstructor .................."""
@@ -851,6 +851,27 @@ class TestSymmetry(unittest.TestCase):
 		else:
 			self.assertAlmostEqual(old_div(result["alt"],alt),1.0, 3)
 	
+	def test_sym_ops_cache(self):
+		"""test cached symmetry operators ..................."""
+		def fresh(name, params):
+			sym = Symmetries.get(name, params)
+			return [sym.get_sym(i).get_matrix() for i in range(sym.get_nsym())]
+
+		for name, params in (("c", {"nsym":4}), ("d", {"nsym":3}), ("icos", {}), ("oct", {})):
+			sym = Symmetries.get(name, params)
+			ref = fresh(name, params)
+			for repeat in range(2):
+				self.assertEqual([t.get_matrix() for t in sym.get_syms()], ref)
+				self.assertEqual([sym.get_sym(i).get_matrix() for i in range(sym.get_nsym())], ref)
+
+		# changing the parameters of an object must not return the operators cached for the old ones
+		sym = Symmetries.get("c", {"nsym":4})
+		sym.get_syms()
+		sym.insert_params({"nsym":6})
+		self.assertEqual([t.get_matrix() for t in sym.get_syms()], fresh("c", {"nsym":6}))
+		self.assertEqual([t.get_matrix() for t in Symmetry3D.get_symmetries("c6")], fresh("c", {"nsym":6}))
+		self.assertEqual([t.get_matrix() for t in Symmetry3D.get_symmetries("c4")], fresh("c", {"nsym":4}))
+
 	def test_symc_reduce(self):
 		"""test csym reduce ................................."""
 		syms = []
@@ -363,6 +363,23 @@ class TestTypeConverter(unittest.TestCase):
         e.set_attr('Nothing', None)
         self.assertEqual(e.get_attr('Nothing'), None)
 
+    def test_header_copy(self):
+        """test header values survive image copies ..........."""
+        e = EMData(16,16)
+        t = Transform({"type":"eman", "az":10.0, "alt":20.0})
+        vals = {"i":3, "f":1.5, "s":"some/path.hdf", "fa":[1.0,2.0], "ia":[4,5],
+                "sa":["a","bb"], "xf":t}
+        for k, v in vals.items():
+            e.set_attr(k, v)
+        c = e.copy()
+        c.set_attr("s", "other")
+        c.set_attr("ia", [6])
+        for k, v in vals.items():
+            self.assertEqual(e.get_attr(k), v)
+        self.assertEqual(c.get_attr("s"), "other")
+        self.assertEqual(c.get_attr("ia"), [6])
+        self.assertEqual(c.get_attr("xf"), t)
+
 def test_main():
     p = OptionParser()
     p.add_option('--t', action='store_true', help='test exception', default=False )
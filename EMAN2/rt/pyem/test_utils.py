@@ -336,6 +336,85 @@ class TestEMUtils(unittest.TestCase):
         self.assertEqual(l, ['Tom', 'Sam', None])
         
         testlib.safe_unlink('test.hdf')
+
+    def test_read_header_column(self):
+        """test read_header_column function ................."""
+        for i, name in enumerate(('Tom', 'Sam', None)):
+            e = test_image()
+            if name: e.set_attr('name', name)
+            e.set_attr('class_id', i)
+            e.write_image('test.hdf', i)
+
+        self.assertEqual(EMUtil.read_header_column('test.hdf', 'name'), ['Tom', 'Sam', None])
+        self.assertEqual(EMUtil.read_header_column('test.hdf', 'class_id', [2, 0]), [2, 0])
+        self.assertEqual(EMUtil.read_header_column('test.hdf', 'nx', [1]), [e.get_xsize()])
+        self.assertRaises(RuntimeError, EMUtil.read_header_column, 'test.hdf', 'name', [3])
+
+        testlib.safe_unlink('test.hdf')
+
+    def check_header_column(self, filename, keys):
+        n = EMUtil.get_image_count(filename)
+        for key in keys:
+            hdr = [EMData(filename, i, True).get_attr_default(key, None) for i in range(n)]
+            self.assertEqual(EMUtil.read_header_column(filename, key), hdr, key)
+
+    def test_read_header_column_datatype(self):
+        """test read_header_column datatype matches header ..."""
+        hdffile = 'test_column_%d.hdf' % os.getpid()
+        for i in range(3):
+            e = test_image()
+            e.write_image(hdffile, i, EMUtil.ImageType.IMAGE_HDF, False, None, EMUtil.EMDataType.EM_USHORT)
+
+        self.check_header_column(hdffile, ['datatype', 'nx'])
+        self.assertEqual(EMUtil.read_header_column(hdffile, 'datatype', [1]), [EMUtil.EMDataType.EM_USHORT])
+
+        testlib.safe_unlink(hdffile)
+
+    def test_read_header_column_mrc(self):
+        """test read_header_column on an mrc stack ..........."""
+        mrcfile = 'test_column_%d.mrcs' % os.getpid()
+        for i in range(3):
+            e = test_image()
+            e.set_attr('apix_x', 2.5)
+            e.set_attr('apix_y', 2.5)
+            e.write_image(mrcfile, i)
+
+        self.check_header_column(mrcfile, ['nx', 'ny', 'nz', 'datatype', 'apix_x', 'class_id'])
+        self.assertEqual(EMUtil.read_header_column(mrcfile, 'nz', [2, 0]), [1, 1])
+        self.assertRaises(RuntimeError, EMUtil.read_header_column, mrcfile, 'nx', [3])
+
+        testlib.safe_unlink(mrcfile)
+
+    def test_read_header_column_lst(self):
+        """test read_header_column on lst and lsx files ......"""
+        pid = os.getpid()
+        hdffile = 'test_column_%d.hdf' % pid
+        mrcfile = 'test_column_%d.mrcs' % pid
+        lstfile = 'test_column_%d.lst' % pid
+        lsxfile = 'test_column_%d.lsx' % pid
+        for i in range(3):
+            e = test_image()
+            e.set_attr('class_id', i)
+            e.write_image(hdffile, i)
+            e.write_image(mrcfile, i)
+
+        refs = [(2, hdffile), (0, mrcfile), (1, hdffile), (2, mrcfile)]
+        with open(lstfile, 'w') as f:
+            f.write('#LST\n')
+            for n, path in refs:
+                f.write('%d\t%s\n' % (n, path))
+
+        lsx = LSXFile(lsxfile)
+        for n, path in refs:
+            lsx.write(-1, n, path)
+        lsx = None
+
+        for filename in (lstfile, lsxfile):
+            self.check_header_column(filename, ['nx', 'datatype', 'class_id'])
+            self.assertEqual(EMUtil.read_header_column(filename, 'class_id', [3, 0]), [None, 2])
+
+        for f in (hdffile, mrcfile, lstfile, lsxfile, lsxfile + '.idx'):
+            testlib.safe_unlink(f)
     
     def test_is_same_size(self):
         """test is_same_size function ......................."""
@@ -39,9 +39,36 @@ from EMAN2 import *
 from math import *
 from random import *
 from time import *
+import sys
 
 def main():
-	precision_test()
+	if len(sys.argv) > 1 and sys.argv[1] == "fft":
+		fft_threads_test()
+	else:
+		precision_test()
+
+def fft_threads_test(sizes=(128,256,384,512), threads=(1,2,4,8), it=5):
+	"""Wall time of forward+inverse 3D FFTs for several box sizes and EMfft thread counts"""
+	
+	nthr0 = EMfft.get_num_threads()
+	print("%6s %8s %12s %8s" %("box","threads","sec/fft+ift","speedup"))
+	for n in sizes:
+		a = test_image_3d(0, (n,n,n))
+		base = None
+		for nt in threads:
+			EMfft.set_num_threads(nt)
+			b = a.do_fft()			# plan creation is not timed
+			c = b.do_ift()
+			
+			time1 = time()
+			for j in range(it):
+				b = a.do_fft()
+				c = b.do_ift()
+			dt = old_div(time() - time1, it)
+			if base is None: base = dt
+			
+			print("%6d %8d %12.4f %8.2f" %(n,nt,dt,old_div(base,dt)))
+	EMfft.set_num_threads(nthr0)
 
 def timetest():
 	n = 10000000